@@ -0,0 +1,219 @@
+/* Micro-benchmark of the EMP VM dispatch loop.
+ *
+ * A counting loop is assembled directly in the bytecode of an EMP VM and
+ * executed. The loop increment is either the superinstruction emitted by the
+ * compiler or the equivalent sequence of simple instructions. For each variant,
+ * the best time over the repetitions, the number of instructions per second and
+ * the time per iteration are written as JSON.
+ *
+ * No GAMS installation is required: the loop does not access any GAMS data.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "arg_cauldron.h"
+#include "empinterp.h"
+#include "empinterp_vm.h"
+#include "empinterp_vm_utils.h"
+#include "reshop.h"
+#include "status.h"
+#include "timings.h"
+
+typedef struct {
+   const char *name;
+   bool fused;
+   unsigned instrs_per_iter;
+} BenchVariant;
+
+static const BenchVariant variants[] = {
+   {"superinstruction", true, 4},
+   {"simple", false, 8},
+};
+
+static void print_stderr(UNUSED void *data, UNUSED unsigned mode, const char *buf)
+{
+   fputs(buf, stderr);
+}
+
+static void flush_stderr(UNUSED void *env)
+{
+   fflush(stderr);
+}
+
+static int emit(EmpVm *vm, unsigned byte)
+{
+   return vmcode_add(&vm->code, (uint8_t)byte, 0);
+}
+
+static int emit_u16(EmpVm *vm, unsigned val)
+{
+   S_CHECK(emit(vm, (val >> 8) & 0xff));
+   return emit(vm, val & 0xff);
+}
+
+/* lvar@0 is the loop index, lvar@1 receives a copy of it in the loop body */
+static int assemble(EmpVm *vm, const BenchVariant *variant, unsigned niters)
+{
+   S_CHECK(rhp_uint_add(&vm->uints, niters));
+   unsigned uidx_max = vm->uints.len-1;
+
+   S_CHECK(emit(vm, OP_LVAR_COPYFROM_GIDX));
+   S_CHECK(emit(vm, 0));
+   S_CHECK(emit_u16(vm, CstZeroUInt));
+
+   unsigned loop_start = vm->code.len;
+
+   S_CHECK(emit(vm, OP_PUSH_LIDX));
+   S_CHECK(emit(vm, 0));
+   S_CHECK(emit(vm, OP_POP));
+   S_CHECK(emit(vm, OP_LVAR_COPYTO_LVAR));
+   S_CHECK(emit(vm, 0));
+   S_CHECK(emit(vm, 1));
+
+   if (variant->fused) {
+      S_CHECK(emit(vm, OP_LOOP_NEXT_VMUINT));
+      S_CHECK(emit(vm, 0));
+      S_CHECK(emit_u16(vm, uidx_max));
+   } else {
+      S_CHECK(emit(vm, OP_LVAR_INC));
+      S_CHECK(emit(vm, 0));
+      S_CHECK(emit(vm, OP_PUSH_LIDX));
+      S_CHECK(emit(vm, 0));
+      S_CHECK(emit(vm, OP_PUSH_VMUINT));
+      S_CHECK(emit_u16(vm, uidx_max));
+      S_CHECK(emit(vm, OP_EQUAL));
+      S_CHECK(emit(vm, OP_JUMP_BACK_IF_FALSE));
+   }
+
+   S_CHECK(emit_u16(vm, vm->code.len + 2 - loop_start));
+
+   return emit(vm, OP_END);
+}
+
+static int bench_variant(Interpreter *interp, const BenchVariant *variant, unsigned niters,
+                         unsigned nreps, bool disassemble, double *wall_best)
+{
+   int status = OK;
+   EmpVm *vm = empvm_new(interp);
+   if (!vm) { return Error_InsufficientMemory; }
+
+   S_CHECK_EXIT(assemble(vm, variant, niters));
+
+   if (disassemble) {
+      fprintf(stderr, "Bytecode of variant '%s':\n", variant->name);
+      S_CHECK_EXIT(empvm_dissassemble(vm, PO_INFO));
+   }
+
+   *wall_best = INFINITY;
+
+   for (unsigned r = 0; r < nreps; ++r) {
+      double start = get_walltime();
+      S_CHECK_EXIT(empvm_run(vm));
+      double wall = get_walltime() - start;
+
+      if (wall < *wall_best) { *wall_best = wall; }
+
+      if (AS_UINT(vm->locals[1]) != niters - 1) {
+         fprintf(stderr, "%s: wrong loop count %u, expected %u\n", variant->name,
+                 AS_UINT(vm->locals[1]) + 1, niters);
+         status = Error_RuntimeError;
+         goto _exit;
+      }
+   }
+
+_exit:
+   empvm_free(vm);
+   return status;
+}
+
+int main(int argc, char **argv)
+{
+   unsigned niters = 10000000, nreps = 5;
+   const char *output = NULL;
+   bool disassemble = false;
+
+   char *argv0 = argv[0];
+
+	ARG_BEGIN {
+		if (0) {
+		} else if (ARG_LONG("iterations")) case 'n': {
+			niters = (unsigned)strtoul(ARG_VAL(), NULL, 10);
+		} else if (ARG_LONG("repetitions")) case 'r': {
+			nreps = (unsigned)strtoul(ARG_VAL(), NULL, 10);
+		} else if (ARG_LONG("output")) case 'O': {
+			output = ARG_VAL();
+		} else if (ARG_LONG("disassemble")) case 'd': {
+			disassemble = true;
+			ARG_FLAG();
+		} else if (ARG_LONG("help")) case 'h': case '?': {
+			printf("Usage: %s [OPTION...]\n", argv0);
+			puts("Throughput benchmark of the EMP VM. Results are written in JSON\n");
+			puts("Options:");
+			puts("  -n, --iterations=N      number of loop iterations (default is 10000000)");
+			puts("  -r, --repetitions=N     number of runs, the best one is kept (default is 5)");
+			puts("  -O, --output=FILE       write the JSON in FILE (default is stdout)");
+			puts("  -d, --disassemble       print the bytecode of each variant on stderr");
+			puts("  -h, --help              display this help and exit");
+			return EXIT_SUCCESS;
+		} else {FALLTHRU default:
+			(void)fprintf(stderr,
+			        "%s: invalid option '%s'\n"
+			        "Try '%s --help' for more information.\n",
+			        argv0, *argv, argv0);
+			return EXIT_FAILURE;
+		}
+	} ARG_END;
+
+   if (niters == 0 || nreps == 0) {
+      fprintf(stderr, "%s: the number of iterations and repetitions must be positive\n", argv0);
+      return EXIT_FAILURE;
+   }
+
+   FILE *f = stdout;
+   if (output) {
+      f = fopen(output, "w");
+      if (!f) { perror("fopen"); return EXIT_FAILURE; }
+   }
+
+   /* Keep the JSON output on stdout clean, and the bytecode with the other messages */
+   if (!output || disassemble) { rhp_set_printops(NULL, print_stderr, flush_stderr, 0); }
+
+   /* The VM only needs the interpreter to report errors */
+   Interpreter *interp = calloc(1, sizeof(Interpreter));
+   if (!interp) { perror("calloc"); return EXIT_FAILURE; }
+   interp->buf = "";
+
+   fprintf(f, "{\n  \"benchmark\": \"empvm_throughput\",\n  \"reshop_version\": \"%s\",\n"
+           "  \"iterations\": %u,\n  \"results\": [\n", rhp_version(), niters);
+
+   int rc = EXIT_SUCCESS;
+
+   for (unsigned i = 0; i < ARRAY_SIZE(variants); ++i) {
+      const BenchVariant *variant = &variants[i];
+      double wall;
+
+      int status = bench_variant(interp, variant, niters, nreps, disassemble, &wall);
+      if (status != OK) {
+         fprintf(stderr, "%s: variant '%s' failed with status %d\n", argv0, variant->name, status);
+         rc = EXIT_FAILURE;
+         continue;
+      }
+
+      double ninstrs = (double)niters * variant->instrs_per_iter;
+
+      fprintf(f, "%s    {\"variant\": \"%s\", \"instrs_per_iter\": %u, \"wall\": %.6e, "
+              "\"minstrs_per_sec\": %.3f, \"ns_per_iter\": %.3f}", i > 0 ? ",\n" : "",
+              variant->name, variant->instrs_per_iter, wall, ninstrs / wall / 1e6,
+              wall / niters * 1e9);
+   }
+
+   fprintf(f, "\n  ]\n}\n");
+
+   if (output) { fclose(f); }
+   free(interp);
+
+   return rc;
+}
@@ -0,0 +1,504 @@
+/* Scale-out benchmark for the OVF/CCF reformulations.
+ *
+ * For each OVF in src/ovf/functions, each reformulation and each problem size,
+ * a model with an OVF variable over a vector of affine arguments is built with
+ * the ReSHOP backend and processed (reformulation + export to a ReSHOP solver
+ * model). The per-phase timings from mdl_timings, the total wall time and the
+ * peak memory are then written as JSON.
+ *
+ * The cases known to fail on this tree are listed in known_failures. They are
+ * skipped, and reported as such in the JSON, unless --all is given.
+ *
+ * No GAMS installation is required. On POSIX systems, each case is run in a
+ * child process so that the peak memory usage is per case.
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#define BENCH_USE_FORK 1
+#endif
+
+#include "arg_cauldron.h"
+#include "mdl.h"
+#include "mdl_timings.h"
+#include "ovf_parameter.h"
+#include "ovfinfo.h"
+#include "reshop.h"
+#include "status.h"
+#include "timings.h"
+
+#define BENCH_MAX_SIZES 32
+
+static const char * const reformulations[] = {"equilibrium", "fenchel", "conjugate"};
+
+/* Cases that are known to fail on this tree. They are left out of the default
+ * matrix, so that it can be used in CI and for before/after comparisons, and
+ * are run with --all. A NULL OVF name matches every OVF. */
+typedef struct {
+   const char *ovf_name;
+   const char *reformulation;
+   unsigned min_size;
+   const char *reason;
+} KnownFailure;
+
+static const KnownFailure known_failures[] = {
+   /* nlnode_reserve() grows the children array of a node by exactly the
+    * requested length and leaves the previous array in the tree arena. Adding
+    * the n terms of the objective one at a time uses O(n^2) memory: about 4GB
+    * at n = 10000, and twice that for the OVFs with a set of dimension 2n. */
+   {NULL, "equilibrium", 10000, "O(n^2) memory in nlnode_reserve"},
+
+   /* No closed-form V-representation: the generators come from libvrepr */
+   {"cvarlo", "conjugate", 1, "needs libvrepr"},
+   {"cvarup", "conjugate", 1, "needs libvrepr"},
+   {"ecvarlo", "conjugate", 1, "needs libvrepr"},
+   {"ecvarup", "conjugate", 1, "needs libvrepr"},
+   {"huber", "conjugate", 1, "needs libvrepr"},
+   {"huber_scaled", "conjugate", 1, "needs libvrepr"},
+
+   /* The closed-form box has at most 2^16 vertices (GENERATORS_BOX_MAXDIM) */
+   {"l1", "conjugate", 17, "needs libvrepr above dimension 16"},
+   {"sum_pos_part", "conjugate", 17, "needs libvrepr above dimension 16"},
+   {"vapnik", "conjugate", 9, "needs libvrepr above dimension 16"},
+
+   /* The set_A generator only builds the transposed (CSC) matrix, while the
+    * conjugate reformulation asks for A itself */
+   {"hinge", "conjugate", 17, "set_A only supports the transposed matrix"},
+   {"hubnik", "conjugate", 1, "set_A only supports the transposed matrix"},
+   {"hubnik_scaled", "conjugate", 1, "set_A only supports the transposed matrix"},
+   {"soft_hinge", "conjugate", 1, "set_A only supports the transposed matrix"},
+   {"soft_hinge_scaled", "conjugate", 1, "set_A only supports the transposed matrix"},
+
+   {"elastic_net", "conjugate", 1, "not implemented"},
+};
+
+typedef struct {
+   const char *ovf_name;
+   const char *reformulation;
+   unsigned size;
+   bool solve;
+} BenchCase;
+
+typedef struct {
+   int status;
+   unsigned n_user, m_user;
+   unsigned n_solver, m_solver;
+   double wall_build;
+   double wall_process;
+   double wall_solve;
+   long peak_rss_kb;
+   Timings timings;
+} BenchResult;
+
+/* Values used for the mandatory scalar parameters of the OVFs */
+static double param_value(const char *name)
+{
+   if (!strcmp(name, "tail"))    { return .2; }
+   if (!strcmp(name, "risk_wt")) { return .5; }
+   if (!strcmp(name, "kappa"))   { return 1.; }
+   if (!strcmp(name, "epsilon")) { return .1; }
+   if (!strcmp(name, "lambda"))  { return .5; }
+
+   return 1.;
+}
+
+static void print_stderr(UNUSED void *data, UNUSED unsigned mode, const char *buf)
+{
+   fputs(buf, stderr);
+}
+
+static void flush_stderr(UNUSED void *env)
+{
+   fflush(stderr);
+}
+
+static long peak_rss_kb(void)
+{
+#ifdef BENCH_USE_FORK
+   struct rusage usage;
+   if (getrusage(RUSAGE_SELF, &usage)) { return -1; }
+#ifdef __APPLE__
+   return usage.ru_maxrss / 1024;
+#else
+   return usage.ru_maxrss;
+#endif
+
+#else
+   return -1;
+#endif
+}
+
+/* Model: min  ovfvar + sum_i x_i / n  (max if the OVF is in inf form)
+ *        s.t. arg_i = a_i x_i - b_i,  ovfvar = ovf(arg)  */
+static int build_mdl(rhp_mdl_t *mdl, const BenchCase *bc)
+{
+   int status = RHP_OK;
+   unsigned n = bc->size;
+   rhp_vars_t *x = rhp_avar_new(), *args = rhp_avar_new();
+   rhp_equs_t *defargs = rhp_aequ_new();
+
+   if (!x || !args || !defargs) { status = Error_InsufficientMemory; goto _exit; }
+
+   rhp_idx objequ, ovfvar;
+   if ((status = rhp_add_varnamed(mdl, &ovfvar, "ovfvar"))) { goto _exit; }
+   if ((status = rhp_add_varsnamed(mdl, n, x, "x"))) { goto _exit; }
+   if ((status = rhp_add_varsnamed(mdl, n, args, "arg"))) { goto _exit; }
+
+   if ((status = rhp_add_funcnamed(mdl, &objequ, "objequ"))) { goto _exit; }
+   if ((status = rhp_equ_addnewlvar(mdl, objequ, ovfvar, 1.))) { goto _exit; }
+
+   if ((status = rhp_add_consnamed(mdl, n, RHP_CON_EQ, defargs, "defarg"))) { goto _exit; }
+
+   for (unsigned i = 0; i < n; ++i) {
+      rhp_idx ei, xi, ai;
+      double a = 1. + (double)(i % 7) / 7., b = (double)(i % 11) / 11.;
+
+      if ((status = rhp_aequ_get(defargs, i, &ei))) { goto _exit; }
+      if ((status = rhp_avar_get(x, i, &xi))) { goto _exit; }
+      if ((status = rhp_avar_get(args, i, &ai))) { goto _exit; }
+
+      if ((status = rhp_equ_addnewlvar(mdl, objequ, xi, 1./n))) { goto _exit; }
+      if ((status = rhp_equ_addnewlvar(mdl, ei, ai, 1.))) { goto _exit; }
+      if ((status = rhp_equ_addnewlvar(mdl, ei, xi, -a))) { goto _exit; }
+      if ((status = rhp_mdl_setequrhs(mdl, ei, -b))) { goto _exit; }
+   }
+
+   struct rhp_ovfdef *ovf_def;
+   if ((status = rhp_ovf_add(mdl, bc->ovf_name, ovfvar, args, &ovf_def))) { goto _exit; }
+
+   /* An OVF in sup form is minimized, one in inf form is maximized */
+   unsigned sense = ovf_def->sense == RHP_MAX ? RHP_MIN : RHP_MAX;
+   if ((status = rhp_mdl_setobjequ(mdl, objequ))) { goto _exit; }
+   if ((status = rhp_mdl_setobjsense(mdl, sense))) { goto _exit; }
+
+   const OvfParamDefList *pdefs = ovf_getparamdefs(ovf_findbyname(bc->ovf_name));
+   if (!pdefs) { status = Error_NotFound; goto _exit; }
+
+   for (unsigned i = 0, len = *pdefs->s; i < len; ++i) {
+      const struct ovf_param_def *pdef = pdefs->p[i];
+      if (!pdef || !pdef->mandatory) { continue; }
+      if ((status = rhp_ovf_param_add_scalar(ovf_def, pdef->name, param_value(pdef->name)))) {
+         goto _exit;
+      }
+   }
+
+   if ((status = rhp_ovf_setreformulation(ovf_def, bc->reformulation))) { goto _exit; }
+   if ((status = rhp_ovf_check(mdl, ovf_def))) { goto _exit; }
+
+_exit:
+   rhp_avar_free(x);
+   rhp_avar_free(args);
+   rhp_aequ_free(defargs);
+
+   return status;
+}
+
+static void run_case(const BenchCase *bc, BenchResult *res)
+{
+   rhp_mdl_t *mdl = NULL, *mdl_solver = NULL;
+
+   memset(res, 0, sizeof(*res));
+   res->peak_rss_kb = -1;
+
+   double start = get_walltime();
+
+   mdl = rhp_mdl_new(RhpBackendReSHOP);
+   if (!mdl) { res->status = Error_InsufficientMemory; goto _exit; }
+
+   if ((res->status = build_mdl(mdl, bc))) { goto _exit; }
+
+   res->wall_build = get_walltime() - start;
+   res->n_user = rhp_mdl_nvars(mdl);
+   res->m_user = rhp_mdl_nequs(mdl);
+
+   mdl_solver = rhp_newsolvermdl(mdl);
+   if (!mdl_solver) { res->status = Error_InsufficientMemory; goto _exit; }
+
+   start = get_walltime();
+   if ((res->status = rhp_process(mdl, mdl_solver))) { goto _exit; }
+   res->wall_process = get_walltime() - start;
+
+   res->n_solver = rhp_mdl_nvars(mdl_solver);
+   res->m_solver = rhp_mdl_nequs(mdl_solver);
+
+   if (bc->solve) {
+      start = get_walltime();
+      if ((res->status = rhp_mdl_setsolvername(mdl_solver, "PATH"))) { goto _exit; }
+      if ((res->status = rhp_solve(mdl_solver))) { goto _exit; }
+      if ((res->status = rhp_postprocess(mdl_solver))) { goto _exit; }
+      res->wall_solve = get_walltime() - start;
+   }
+
+_exit:
+   if (mdl) { res->timings = *mdl->timings; }
+   res->peak_rss_kb = peak_rss_kb();
+
+   rhp_mdl_free(mdl_solver);
+   rhp_mdl_free(mdl);
+}
+
+static void json_simpletiming(FILE *f, const char *name, const SimpleTiming *t, bool last)
+{
+   fprintf(f, "        \"%s\": {\"number\": %u, \"total\": %.6e, \"min\": %.6e, "
+           "\"mean\": %.6e, \"max\": %.6e}%s\n", name, t->number, t->number*t->mean,
+           t->number > 0 ? t->min : 0., t->mean, t->max, last ? "" : ",");
+}
+
+static void json_result(FILE *f, const BenchCase *bc, const BenchResult *res, bool first)
+{
+   const Timings *t = &res->timings;
+
+   fprintf(f, "%s    {\n", first ? "" : ",\n");
+   fprintf(f, "      \"ovf\": \"%s\",\n", bc->ovf_name);
+   fprintf(f, "      \"reformulation\": \"%s\",\n", bc->reformulation);
+   fprintf(f, "      \"size\": %u,\n", bc->size);
+   fprintf(f, "      \"status\": %d,\n", res->status);
+   fprintf(f, "      \"status_descr\": \"%s\",\n", rhp_status_descr(res->status));
+   fprintf(f, "      \"user_model\": {\"nvars\": %u, \"nequs\": %u},\n", res->n_user, res->m_user);
+   fprintf(f, "      \"solver_model\": {\"nvars\": %u, \"nequs\": %u},\n", res->n_solver, res->m_solver);
+   fprintf(f, "      \"peak_rss_kb\": %ld,\n", res->peak_rss_kb);
+   fprintf(f, "      \"wall\": {\"build\": %.6e, \"process\": %.6e, \"solve\": %.6e},\n",
+           res->wall_build, res->wall_process, res->wall_solve);
+   fprintf(f, "      \"phases\": {\n");
+   json_simpletiming(f, "mdl_creation", &t->rhp.mdl_creation, false);
+   json_simpletiming(f, "empdag_analysis", &t->empdag.analysis, false);
+   json_simpletiming(f, "ccf_equilibrium", &t->reformulation.CCF.equilibrium, false);
+   json_simpletiming(f, "ccf_fenchel", &t->reformulation.CCF.fenchel, false);
+   json_simpletiming(f, "ccf_conjugate", &t->reformulation.CCF.conjugate.stats, false);
+   json_simpletiming(f, "ccf_conjugate_vrepr", &t->reformulation.CCF.conjugate.PPL, false);
+   fprintf(f, "        \"ccf_total\": %.6e,\n", t->reformulation.CCF.total);
+   fprintf(f, "        \"container_total\": %.6e,\n", t->reformulation.equvar.total);
+   fprintf(f, "        \"empdag_total\": %.6e,\n", t->reformulation.empdag.total);
+   fprintf(f, "        \"presolve_wall\": %.6e,\n", t->solve.presolve_wall);
+   fprintf(f, "        \"fooc\": %.6e,\n", t->solve.fooc);
+   fprintf(f, "        \"solver_wall\": %.6e,\n", t->solve.solver_wall);
+   fprintf(f, "        \"postprocessing\": %.6e\n", t->postprocessing);
+   fprintf(f, "      }\n    }");
+}
+
+/* Run a case, if possible in a child process to get a per-case peak memory */
+static void run_case_isolated(const BenchCase *bc, BenchResult *res)
+{
+#ifdef BENCH_USE_FORK
+   int fds[2];
+   if (pipe(fds)) { run_case(bc, res); return; }
+
+   fflush(NULL);
+   pid_t pid = fork();
+
+   if (pid == 0) {
+      close(fds[0]);
+      run_case(bc, res);
+      size_t len = sizeof(*res);
+      const char *buf = (const char *)res;
+      while (len > 0) {
+         ssize_t w = write(fds[1], buf, len);
+         if (w <= 0) { _exit(EXIT_FAILURE); }
+         buf += w; len -= (size_t)w;
+      }
+      _exit(EXIT_SUCCESS);
+   }
+
+   close(fds[1]);
+
+   if (pid < 0) {
+      close(fds[0]);
+      run_case(bc, res);
+      return;
+   }
+
+   size_t len = sizeof(*res), rd = 0;
+   char *buf = (char *)res;
+   while (rd < len) {
+      ssize_t r = read(fds[0], buf + rd, len - rd);
+      if (r <= 0) { break; }
+      rd += (size_t)r;
+   }
+   close(fds[0]);
+
+   int wstatus;
+   waitpid(pid, &wstatus, 0);
+
+   if (rd != len) {
+      memset(res, 0, sizeof(*res));
+      res->peak_rss_kb = -1;
+      /* The child crashed: report it as a runtime error */
+      res->status = Error_RuntimeError;
+   }
+
+#else
+   run_case(bc, res);
+#endif
+}
+
+static const char *known_failure(const BenchCase *bc)
+{
+   for (unsigned i = 0; i < ARRAY_SIZE(known_failures); ++i) {
+      const KnownFailure *kf = &known_failures[i];
+      if (kf->ovf_name && strcmp(kf->ovf_name, bc->ovf_name)) { continue; }
+      if (strcmp(kf->reformulation, bc->reformulation)) { continue; }
+      if (bc->size >= kf->min_size) { return kf->reason; }
+   }
+
+   return NULL;
+}
+
+static void json_skipped(FILE *f, const BenchCase *bc, const char *reason, bool first)
+{
+   fprintf(f, "%s    {\"ovf\": \"%s\", \"reformulation\": \"%s\", \"size\": %u, "
+           "\"reason\": \"%s\"}", first ? "" : ",\n", bc->ovf_name, bc->reformulation,
+           bc->size, reason);
+}
+
+static unsigned parse_sizes(char *str, unsigned *sizes)
+{
+   unsigned nsizes = 0;
+   char *tok = strtok(str, ",");
+
+   while (tok && nsizes < BENCH_MAX_SIZES) {
+      char *endptr;
+      errno = 0;
+      long val = strtol(tok, &endptr, 10);
+      if (errno || endptr == tok || *endptr != '\0' || val <= 0) {
+         fprintf(stderr, "invalid size '%s'\n", tok);
+         exit(EXIT_FAILURE);
+      }
+      sizes[nsizes++] = (unsigned)val;
+      tok = strtok(NULL, ",");
+   }
+
+   return nsizes;
+}
+
+int main(int argc, char **argv)
+{
+   unsigned sizes[BENCH_MAX_SIZES] = {10, 100, 1000, 10000};
+   unsigned nsizes = 4;
+   const char *ovf_filter = NULL, *reform_filter = NULL, *output = NULL;
+   bool solve = false, ignore_failures = false, all = false;
+
+   char *argv0 = argv[0];
+
+	ARG_BEGIN {
+		if (0) {
+		} else if (ARG_LONG("sizes")) case 'S': {
+			nsizes = parse_sizes(ARG_VAL(), sizes);
+		} else if (ARG_LONG("ovf")) case 'o': {
+			ovf_filter = ARG_VAL();
+		} else if (ARG_LONG("formulation")) case 'f': {
+			reform_filter = ARG_VAL();
+		} else if (ARG_LONG("output")) case 'O': {
+			output = ARG_VAL();
+		} else if (ARG_LONG("solve")) case 's': {
+			solve = true;
+			ARG_FLAG();
+		} else if (ARG_LONG("ignore-failures")) case 'i': {
+			ignore_failures = true;
+			ARG_FLAG();
+		} else if (ARG_LONG("all")) case 'a': {
+			all = true;
+			ARG_FLAG();
+		} else if (ARG_LONG("help")) case 'h': case '?': {
+			printf("Usage: %s [OPTION...]\n", argv0);
+			puts("Scaling benchmark of the OVF reformulations. Results are written in JSON\n");
+			puts("Options:");
+			puts("  -S, --sizes=N1,N2,...   problem sizes (default is 10,100,1000,10000)");
+			puts("  -o, --ovf=STR           only benchmark this OVF");
+			puts("  -f, --formulation=STR   only benchmark this reformulation");
+			puts("  -O, --output=FILE       write the JSON in FILE (default is stdout)");
+			puts("  -s, --solve             also solve the models with PATH");
+			puts("  -i, --ignore-failures   return success even if some cases fail");
+			puts("  -a, --all               also run the cases known to fail");
+			puts("  -h, --help              display this help and exit");
+			return EXIT_SUCCESS;
+		} else {FALLTHRU default:
+			(void)fprintf(stderr,
+			        "%s: invalid option '%s'\n"
+			        "Try '%s --help' for more information.\n",
+			        argv0, *argv, argv0);
+			return EXIT_FAILURE;
+		}
+	} ARG_END;
+
+   FILE *f = stdout;
+   if (output) {
+      f = fopen(output, "w");
+      if (!f) { perror("fopen"); return EXIT_FAILURE; }
+   }
+
+   /* Keep the JSON output on stdout clean */
+   if (!output) { rhp_set_printops(NULL, print_stderr, flush_stderr, 0); }
+
+   fprintf(f, "{\n  \"benchmark\": \"ovf_scaling\",\n  \"reshop_version\": \"%s\",\n"
+           "  \"results\": [\n", rhp_version());
+
+   unsigned nfailed = 0, nskipped = 0;
+   bool first = true, first_skipped = true;
+   FILE *fskipped = tmpfile();
+   if (!fskipped) { perror("tmpfile"); return EXIT_FAILURE; }
+
+   for (unsigned i = 0; i < ovf_numbers; ++i) {
+      if (ovf_filter && strcmp(ovf_filter, ovf_names[i])) { continue; }
+
+      for (unsigned j = 0; j < ARRAY_SIZE(reformulations); ++j) {
+         if (reform_filter && strcmp(reform_filter, reformulations[j])) { continue; }
+
+         for (unsigned k = 0; k < nsizes; ++k) {
+            BenchCase bc = {.ovf_name = ovf_names[i], .reformulation = reformulations[j],
+                            .size = sizes[k], .solve = solve};
+            BenchResult res;
+
+            const char *reason = all ? NULL : known_failure(&bc);
+            if (reason) {
+               json_skipped(fskipped, &bc, reason, first_skipped);
+               first_skipped = false;
+               nskipped++;
+               continue;
+            }
+
+            run_case_isolated(&bc, &res);
+            json_result(f, &bc, &res, first);
+            first = false;
+
+            if (res.status) {
+               nfailed++;
+               /* No need to try larger sizes */
+               break;
+            }
+         }
+      }
+   }
+
+   fprintf(f, "\n  ],\n  \"skipped\": [\n");
+
+   /* The skipped cases are listed after the results */
+   rewind(fskipped);
+   int c;
+   while ((c = fgetc(fskipped)) != EOF) { fputc(c, f); }
+   fclose(fskipped);
+
+   fprintf(f, "\n  ],\n  \"failed\": %u\n}\n", nfailed);
+
+   if (nskipped > 0) {
+      (void)fprintf(stderr, "%s: %u case(s) known to fail were skipped, use --all to run them\n",
+                    argv0, nskipped);
+   }
+
+   if (output) { fclose(f); }
+
+   if (nfailed > 0) {
+      (void)fprintf(stderr, "%s: %u case(s) failed\n", argv0, nfailed);
+      if (!ignore_failures) { return EXIT_FAILURE; }
+   }
+
+   return EXIT_SUCCESS;
+}
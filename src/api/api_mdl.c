@@ -4,6 +4,7 @@
 #include "macros.h"
 #include "mdl.h"
 #include "mdl_gams.h"
+#include "mdl_warmstart.h"
 #include "reshop-gams.h"
 #include "reshop.h"
 #include "sys_utils.h"
@@ -230,3 +231,46 @@ _exit:
    return status;
 }
 
+
+/**
+ * @brief Warm-start the next solves of a model from the previous solution
+ *
+ * The levels and multipliers of the model are always used as starting point.
+ * When the warm-start is active, the values of the variables and equations
+ * introduced by the reformulations (OVF dual variables, ...) are also kept
+ * after a solve and used as starting point of the next one, instead of being
+ * recomputed by the presolve. The model data (coefficients, bounds, ...) may
+ * change between the solves. If the structure of the reformulation changes,
+ * the new variables and equations are not warm-started.
+ *
+ * @ingroup publicAPI
+ *
+ * @param mdl     the model
+ * @param active  if true, activate the warm-start; otherwise deactivate it
+ *
+ * @return        the error code
+ */
+int rhp_mdl_setwarmstart(Model *mdl, bool active)
+{
+   S_CHECK(chk_mdl(mdl, __func__));
+
+   return mdl_warmstart_setactive(mdl, active);
+}
+
+/**
+ * @brief Discard the values kept for the warm-start of a model
+ *
+ * @ingroup publicAPI
+ *
+ * @param mdl  the model
+ *
+ * @return     the error code
+ */
+int rhp_mdl_resetwarmstart(Model *mdl)
+{
+   S_CHECK(chk_mdl(mdl, __func__));
+
+   mdl_warmstart_reset(mdl);
+
+   return OK;
+}
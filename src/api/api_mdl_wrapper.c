@@ -1,3 +1,6 @@
+#include <assert.h>
+#include <string.h>
+
 #include "checks.h"
 #include "container.h"
 #include "container_ops.h"
@@ -7,6 +10,8 @@
 #include "mdl_data.h"
 #include "mdl_ops.h"
 #include "mdl_rhp.h"
+#include "mdl_timings.h"
+#include "printout.h"
 #include "reshop.h"
 
 /** @copydoc mdl_setsolvername
@@ -37,6 +42,63 @@ int rhp_mdl_getsolvername(const Model *mdl, char const ** solvername)
    return mdl->ops->getsolvername(mdl, solvername);
 }
 
+static_assert(RHP_CALLBACK_HIST_LEN == CALLBACK_HIST_LEN,
+              "The public and internal latency histograms must have the same length");
+
+/**
+ * @brief Get the statistics on the calls of a solver callback
+ *
+ * The statistics are accumulated over all the solves of the model and of the
+ * models sharing its timings. The share of the solver time spent in the
+ * callbacks tells whether a slow solve is bound by the evaluations or by the
+ * solver itself.
+ *
+ * @ingroup publicAPI
+ *
+ * @param      mdl       the model
+ * @param      callback  the callback, see ::rhp_solver_callback
+ * @param[out] stats     the statistics
+ *
+ * @return               the error code
+ */
+int rhp_mdl_getcallbackstats(const Model *mdl, unsigned callback,
+                             struct rhp_callback_stats *stats)
+{
+   S_CHECK(chk_mdl(mdl, __func__));
+   S_CHECK(chk_arg_nonnull(stats, 3, __func__));
+
+   memset(stats, 0, sizeof(*stats));
+
+   if (!mdl->timings) { return OK; }
+
+   const CallbackStats *s;
+   switch (callback) {
+   case RhpCallbackFunc:
+      s = &mdl->timings->solve.func_evals;
+      break;
+   case RhpCallbackJacobian:
+      s = &mdl->timings->solve.jacobian_evals;
+      break;
+   default:
+      error("%s ERROR: unknown callback %u\n", __func__, callback);
+      return Error_InvalidValue;
+   }
+
+   stats->calls = s->calls;
+   stats->errors = s->errors;
+   stats->nnz = s->nnz;
+   stats->nlnodes = s->nlnodes;
+   stats->bytes = s->bytes;
+   stats->wall = s->wall;
+   stats->solver_wall = mdl->timings->solve.solver_wall;
+
+   for (unsigned i = 0; i < RHP_CALLBACK_HIST_LEN; ++i) {
+      stats->hist[i] = s->hist[i];
+   }
+
+   return OK;
+}
+
 /** @copydoc mdl_gettype
  *  @ingroup publicAPI */
 int rhp_mdl_gettype(const Model *mdl, unsigned *type)
@@ -95,6 +95,31 @@ enum rhp_print_flags {
    RhpPrintNoStdOutErr  = 2,     /**< print does not go to default stdout/stderr */
 };
 
+/** @brief Solver callbacks */
+enum rhp_solver_callback {
+   RhpCallbackFunc      = 0,     /**< Function evaluation   */
+   RhpCallbackJacobian  = 1,     /**< Jacobian evaluation   */
+};
+
+/** @brief Number of buckets in the latency histogram of a solver callback */
+#define RHP_CALLBACK_HIST_LEN 32
+
+/** @brief Statistics on the calls of a solver callback
+ *
+ *  Bucket 0 of the latency histogram counts the calls faster than 1us,
+ *  bucket k those in [2^(k-1), 2^k) us and the last bucket the slower ones.
+ */
+struct rhp_callback_stats {
+   unsigned long long calls;      /**< Number of calls                       */
+   unsigned long long errors;     /**< Number of evaluation errors           */
+   unsigned long long nnz;        /**< Number of nonzeros evaluated          */
+   unsigned long long nlnodes;    /**< Number of expression nodes visited    */
+   unsigned long long bytes;      /**< Estimated number of bytes touched     */
+   double wall;                   /**< Total wall time (in sec)              */
+   double solver_wall;            /**< Total wall time of the solver         */
+   unsigned long long hist[RHP_CALLBACK_HIST_LEN]; /**< Latency histogram    */
+};
+
 /** @brief Custom print function */
 typedef void (*rhp_print_fn)(void *data, unsigned mode, const char *buf);
 /** @brief Custom flush function */
@@ -260,6 +285,8 @@ RHP_PUBLIB int rhp_mdl_getobjequs(const rhp_mdl_t *mdl, rhp_equs_t *objs);
 RHP_PUBLIB int rhp_mdl_getsense(const rhp_mdl_t *mdl, unsigned *sense);
 RHP_PUBLIB int rhp_mdl_getobjvar(const rhp_mdl_t *mdl, rhp_idx *objvar);
 RHP_PUBLIB int rhp_mdl_gettype(const rhp_mdl_t *mdl, unsigned *type);
+RHP_PUBLIB int rhp_mdl_getcallbackstats(const rhp_mdl_t *mdl, unsigned callback,
+                                        struct rhp_callback_stats *stats);
 RHP_PUBLIB int rhp_mdl_getsolvername(const rhp_mdl_t *mdl, char const ** solvername);
 RHP_PUBLIB int rhp_mdl_getsolvestat(const rhp_mdl_t *mdl, int *solvestat);
 RHP_PUBLIB int rhp_mdl_getspecialfloats(const rhp_mdl_t *mdl, double *minf, double *pinf,
@@ -301,6 +328,8 @@ RHP_PUBLIB int rhp_mdl_setvarname(rhp_mdl_t *mdl, rhp_idx vi, const char *name);
 RHP_PUBLIB int rhp_mdl_setvartype(rhp_mdl_t *mdl, rhp_idx vi, unsigned type);
 RHP_PUBLIB int rhp_mdl_setvarub(rhp_mdl_t *mdl, rhp_idx vi, double ub);
 RHP_PUBLIB int rhp_mdl_setvarlevel(rhp_mdl_t *mdl, rhp_idx vi, double level);
+RHP_PUBLIB int rhp_mdl_setwarmstart(rhp_mdl_t *mdl, bool active);
+RHP_PUBLIB int rhp_mdl_resetwarmstart(rhp_mdl_t *mdl);
 RHP_PUBLIB int rhp_mdl_exportmodel(rhp_mdl_t *mdl, rhp_mdl_t *mdl_dst);
 RHP_PUBLIB const char *rhp_mdl_modelstattxt(const rhp_mdl_t *mdl, int modelstat);
 RHP_PUBLIB const char *rhp_mdl_solvestattxt(const rhp_mdl_t *mdl, int solvestat);
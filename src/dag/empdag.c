@@ -16,6 +16,7 @@
 #include "macros.h"
 #include "mathprgm.h"
 #include "ctrdat_rhp.h"
+#include "dfs_engine.h"
 #include "mdl.h"
 #include "printout.h"
 #include "print_utils.h"
@@ -127,6 +128,8 @@ void empdag_init(EmpDag *empdag, Model *mdl)
    empdag->type = EmpDag_Unset;
    empdag->stage = EmpDagStage_Unset;
    empdag->finalized = false;
+   empdag_csr_init(&empdag->csr);
+   empdag->analysis_cache = NULL;
    empdag->arcs_fully_resolved = true;  /* Set by false at the start of the empinterp */
    empdag->features.istree = false;
 
@@ -311,6 +314,8 @@ int empdag_fini(EmpDag *empdag)
    * Second Part: check EMPDAG, infer the type
    * ---------------------------------------------------------------------- */
 
+   S_CHECK(empdag_csr_build(&empdag->csr, empdag));
+
    S_CHECK(empdag_check(empdag));
 
    S_CHECK(empdag_infertype(empdag));
@@ -359,6 +364,8 @@ void empdag_rel(EmpDag *empdag)
 
    dagmp_array_free(&empdag->mps);
    dagnash_array_free(&empdag->nashs);
+   empdag_csr_free(&empdag->csr);
+   empdag_analysis_cache_free(&empdag->analysis_cache);
 
    if (empdag->empdag_next) {
       empdag_rel(empdag->empdag_next);
@@ -524,6 +531,7 @@ int empdag_dup(EmpDag * restrict empdag, const EmpDag * restrict empdag_up, Mode
    memcpy(&empdag->arc_stats, &empdag_up->arc_stats, sizeof(EmpDagEdgeStats));
 
    empdag->finalized = false;
+   empdag->csr.valid = false;
    empdag->uid_root = empdag_up->uid_root;
 
    /* Do not borrow to avoid circular reference */
@@ -550,6 +558,9 @@ int empdag_dup(EmpDag * restrict empdag, const EmpDag * restrict empdag_up, Mode
 
    S_CHECK(daguidarray_copy(&empdag->roots, &empdag_up->roots));
 
+   /* The analysis results are valid as long as the container is not modified */
+   S_CHECK(empdag_analysis_cache_dup(&empdag->analysis_cache, empdag_up->analysis_cache));
+
    /* HACK: remove this */
    S_CHECK(mpidarray_copy(&empdag->transformations.fooc.vi, &empdag_up->transformations.fooc.vi));
    S_CHECK(mpidarray_copy(&empdag->transformations.fooc.src, &empdag_up->transformations.fooc.src));
@@ -607,6 +618,7 @@ int empdag_addnash(EmpDag *empdag, unsigned *id)
    *id = nash->id;
 
    empdag->finalized = false;
+   empdag->csr.valid = false;
 
    return OK;
 }
@@ -623,6 +635,7 @@ int empdag_addnashnamed(EmpDag *empdag, const char *name, unsigned *id)
    assert((name_cpy && name) || (!name_cpy && !name));
 
    empdag->finalized = false;
+   empdag->csr.valid = false;
 
    return dagnash_array_add(&empdag->nashs, nash, name_cpy);
 }
@@ -633,6 +646,7 @@ Nash* empdag_newnash(EmpDag *empdag)
    SN_CHECK(empdag_addnash(empdag, &nash_id));
 
    empdag->finalized = false;
+   empdag->csr.valid = false;
 
    return empdag->nashs.arr[nash_id];
 }
@@ -643,6 +657,7 @@ Nash* empdag_newnashnamed(EmpDag *empdag, char* name)
    SN_CHECK(empdag_addnashnamed(empdag, name, &nashid));
 
    empdag->finalized = false;
+   empdag->csr.valid = false;
 
    return empdag->nashs.arr[nashid];
 }
@@ -652,6 +667,7 @@ int empdag_rootsaddnash(EmpDag *empdag, nashid_t nashid)
    S_CHECK(chk_nashid_(empdag, nashid));
 
    empdag->finalized = false;
+   empdag->csr.valid = false;
 
    return rhp_uint_addsorted(&empdag->roots, nashid2uid(nashid));
 }
@@ -661,6 +677,7 @@ int empdag_rootsaddmp(EmpDag *empdag, mpid_t mpid)
    S_CHECK(chk_mpid_(empdag, mpid));
 
    empdag->finalized = false;
+   empdag->csr.valid = false;
 
    return rhp_uint_addsorted(&empdag->roots, mpid2uid(mpid));
 }
@@ -733,6 +750,7 @@ int empdag_nashaddmpbyid(EmpDag *empdag, nashid_t nashid, mpid_t mpid)
                 empdag_getmpname(empdag, mpid));
 
    empdag->finalized = false;
+   empdag->csr.valid = false;
 
    return OK;
 }
@@ -756,6 +774,7 @@ int empdag_mpVFmpbyid(EmpDag *empdag, mpid_t mpid_parent, const ArcVFData *arc)
    S_CHECK(arcVFs_add(&empdag->mps.Varcs[mpid_parent], *arc));
 
    empdag->finalized = false;
+   empdag->csr.valid = false;
 
    return OK;
 }
@@ -774,6 +793,7 @@ int empdag_mpCTRLmpbyid(EmpDag *empdag, mpid_t mpid_parent, mpid_t mpid_child)
                 empdag_getmpname(empdag, mpid_child));
 
    empdag->finalized = false;
+   empdag->csr.valid = false;
 
    return OK;
 }
@@ -791,9 +811,44 @@ int empdag_mpCTRLnashbyid(EmpDag *empdag, mpid_t mp_id, nashid_t nashid)
                 empdag_getnashname(empdag, nashid));
 
    empdag->finalized = false;
+   empdag->csr.valid = false;
 
    return OK;
 }
+/**
+ * @brief Remove all the VF arcs of an MP
+ *
+ * The reverse arcs of the children are not modified.
+ *
+ * @param empdag  the EMPDAG
+ * @param mpid    the MP
+ */
+void empdag_mpVFresetarcs(EmpDag *empdag, mpid_t mpid)
+{
+   assert(mpid < empdag->mps.len);
+
+   empdag->mps.Varcs[mpid].len = 0;
+   empdag->csr.valid = false;
+}
+
+/**
+ * @brief Change the child of a CTRL arc of an MP
+ *
+ * The reverse arcs of the children are not modified.
+ *
+ * @param empdag  the EMPDAG
+ * @param mpid    the MP
+ * @param idx     the index of the arc
+ * @param uid     the new child
+ */
+void empdag_mpCTRLsetarc(EmpDag *empdag, mpid_t mpid, unsigned idx, daguid_t uid)
+{
+   assert(mpid < empdag->mps.len && idx < empdag->mps.Carcs[mpid].len);
+
+   empdag->mps.Carcs[mpid].arr[idx] = uid;
+   empdag->csr.valid = false;
+}
+
 /* TODO: empdag->nashs.arcs contains daguid_t not mpid_t */
 //int empdag_nashaddmpsbyid(EmpDag *empdag, nashid_t nashid,
 //                         const MpIdArray *arr)
@@ -1227,57 +1282,91 @@ int empdag_single_MP_to_Nash(EmpDag* empdag, const char *name)
    return OK;
 }
 
-static int dfs_mplist(const EmpDag *empdag, daguid_t uid, UIntArray *mplist)
-{
-   daguid_t * restrict children;
-   VarcArray * restrict Varcs;
-   unsigned num_children;
+typedef struct {
+   const EmpDagCsr *csr;
+   UIntArray *mplist;
+} DfsMpListData;
 
-   if (uidisMP(uid)) {
-      mpid_t id = uid2id(uid);
-      S_CHECK(rhp_uint_addsorted(mplist, id));
-      UIntArray *Carcs = &empdag->mps.Carcs[id];
-      children = Carcs->arr;
-      num_children = Carcs->len;
+static int dfs_mplist_pre(void *ctx, DfsFrame *frame, void *state, bool *visit)
+{
+   const DfsMpListData *dat = ctx;
+   daguid_t uid = *(daguid_t*)state;
 
-      Varcs = &empdag->mps.Varcs[id];
+   *visit = true;
 
+   if (uidisMP(uid)) {
+      S_CHECK(rhp_uint_addsorted(dat->mplist, uid2id(uid)));
    } else {
+      assert(dat->csr->Nstart[uid2id(uid)+1] > dat->csr->Nstart[uid2id(uid)]);
+   }
 
-      nashid_t id = uid2id(uid);
-      UIntArray *nash_children = &empdag->nashs.arcs[id];
-      children = nash_children->arr;
-      num_children = nash_children->len;
+   return OK;
+}
 
-      assert(num_children > 0);
+/* The children on CTRL arcs (or of a Nash node) come first, then the ones on
+ * VF arcs */
+static int dfs_mplist_next(void *ctx, DfsFrame *frame, void *state, bool *has_child,
+                           void *child_state)
+{
+   const DfsMpListData *dat = ctx;
+   const EmpDagCsr *csr = dat->csr;
+   daguid_t uid = *(daguid_t*)state, *uid_child = child_state;
+   dagid_t id = uid2id(uid);
+   unsigned pos = frame->pos, nchildren, nVarcs = 0;
+   const daguid_t *children;
+   const Varc *Varcs = NULL;
 
-      Varcs = NULL;
+   if (uidisMP(uid)) {
+      children = empdag_csr_Carcs(csr, id, &nchildren);
+      Varcs = empdag_csr_Varcs(csr, id, &nVarcs);
+   } else {
+      children = empdag_csr_nasharcs(csr, id, &nchildren);
    }
 
-
-   for (unsigned i = 0; i < num_children; ++i) {
-      S_CHECK(dfs_mplist(empdag, children[i], mplist));
+   if (pos < nchildren) {
+      *uid_child = children[pos];
+   } else if (pos - nchildren < nVarcs) {
+      *uid_child = mpid2uid(Varcs[pos - nchildren].mpid_child);
+   } else {
+      *has_child = false;
+      return OK;
    }
 
-   if (!Varcs) { return OK; }
-
-   struct rhp_empdag_arcVF *Vlist = Varcs->arr;
-   for (unsigned i = 0, len = Varcs->len; i < len; ++i) {
-      S_CHECK(dfs_mplist(empdag, mpid2uid(Vlist[i].mpid_child), mplist));
-   }
+   frame->pos++;
+   *has_child = true;
 
    return OK;
 }
 
+static const DfsOps dfs_mplist_ops = {
+   .pre  = dfs_mplist_pre,
+   .next = dfs_mplist_next,
+};
+
 int empdag_subdag_getmplist(const EmpDag *empdag, daguid_t subdag_root,
                             UIntArray *mplist) 
 {
+   DfsMpListData dat = {.mplist = mplist};
+   S_CHECK(empdag_csr_get(empdag, &dat.csr));
+
+   DfsEngine dfs;
+   dfs_engine_init(&dfs, &dfs_mplist_ops, &dat, sizeof(daguid_t));
+
+   int rc = dfs_engine_run(&dfs, &subdag_root);
 
+   dfs_engine_free(&dfs);
 
-   return dfs_mplist(empdag, subdag_root, mplist);
+   return rc;
 }
 
 //FIXME: looks unused!!
+/**
+ * @brief Finalize the MPs and freeze the adjacency of the EMPDAG
+ *
+ * @param mdl  the model
+ *
+ * @return     the error code
+ */
 int empdag_finalize(Model *mdl)
 {
    EmpDag *empdag = &mdl->empinfo.empdag;
@@ -1291,7 +1380,8 @@ int empdag_finalize(Model *mdl)
       S_CHECK(mp_finalize(mp));
    }
 
-   return OK;
+   /* Freeze the adjacency for the traversals */
+   return empdag_csr_build(&empdag->csr, empdag);
 }
 
 int empdag_check_hidable_roots(EmpDag *empdag)
@@ -1486,6 +1576,7 @@ int empdag_substitute_mp_parents_arcs(EmpDag* empdag, mpid_t mpid_old, mpid_t mp
    }
 
    empdag->finalized = false;
+   empdag->csr.valid = false;
 
    return OK;
 }
@@ -1548,6 +1639,7 @@ int empdag_substitute_mp_child_arcs(EmpDag* empdag, mpid_t mpid_old, mpid_t mpid
    }
 
    empdag->finalized = false;
+   empdag->csr.valid = false;
 
    return OK;
 }
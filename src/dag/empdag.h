@@ -4,6 +4,7 @@
 #include <limits.h>
 
 #include "empdag_common.h"
+#include "empdag_csr.h"
 #include "empdag_uid.h"
 #include "mdl_data.h"
 #include "reshop_data.h"
@@ -157,6 +158,8 @@ typedef struct empdag {
    DagMpArray mps;                        /**< MP nodes                            */
    DagNashArray nashs;                    /**< Nash nodes                          */
    DagUidArray roots;                     /**< Roots of the EMPDAG                 */
+   EmpDagCsr csr;                         /**< Frozen adjacency, once finalized    */
+   struct empdag_analysis_cache *analysis_cache; /**< Results of the last analysis */
 
    MpIdArray mps_newly_created;           /**< Newly created MPs                   */
 
@@ -264,6 +267,8 @@ int empdag_getnashidbyname(const EmpDag *empdag, const char *name,
 int empdag_mpVFmpbyid(EmpDag *empdag, mpid_t mpid_parent, const ArcVFData *arcVF) NONNULL;
 int empdag_mpCTRLmpbyid(EmpDag *empdag, mpid_t mpid_parent, mpid_t mpid_child) NONNULL;
 int empdag_mpCTRLnashbyid(EmpDag *empdag, mpid_t mpid, nashid_t nashid) NONNULL;
+void empdag_mpVFresetarcs(EmpDag *empdag, mpid_t mpid) NONNULL;
+void empdag_mpCTRLsetarc(EmpDag *empdag, mpid_t mpid, unsigned idx, daguid_t uid) NONNULL;
 int empdag_nashaddmpbyid(EmpDag *empdag, nashid_t nashid, mpid_t mpid) NONNULL;
 int empdag_nashaddmpsbyid(EmpDag *empdag, nashid_t nashid, const UIntArray *mps) NONNULL;
 
@@ -4,8 +4,10 @@
 
 #include "compat.h"
 #include "ctr_rhp.h"
+#include "dfs_engine.h"
 #include "empdag.h"
 #include "empdag_alg.h"
+#include "empdag_lca.h"
 #include "empdag_uid.h"
 #include "equvar_metadata.h"
 #include "filter_ops.h"
@@ -136,9 +138,21 @@ typedef struct {
    unsigned Narc;
 } AncestorCount;
 
+/** Signature of an MP at the last analysis */
+typedef struct {
+   bool exists;
+   bool hidden;
+   unsigned nvars;
+   unsigned nequs;
+   unsigned level;
+   uint64_t fingerprint;     /**< Hash of the variables and equations, and of
+                                  the variables in each equation             */
+} MpSignature;
+
 typedef struct empdag_dfs {
    Model *mdl;
    EmpDag *empdag;
+   const EmpDagCsr *csr;                  /**< Adjacency of the EMPDAG           */
 
    bool isTree;
    unsigned timestamp;
@@ -158,13 +172,38 @@ typedef struct empdag_dfs {
    AncestorCount * restrict num_ancestors;   /**< Number of ancestors */
    DagMpPpty * restrict mp_ppty;
    DagNashPpty * restrict nash_ppty;
+   LcaIndex lca_idx;                      /**< Forest of the unique-parent arcs  */
    bool * restrict processed_vi;
+   bool * restrict dirty;                 /**< Nodes to analyze, NULL if all are */
+   MpSignature *sig;                      /**< MP signatures, NULL if not computed */
+   MpIdArray * restrict mp_refs;          /**< MPs owning a variable of each MP  */
    MpIdArray adversarial_mps;
    MpIdArray saddle_path_starts;
    unsigned processed_vi_len;
    bool hasVFPath;
 } EmpDagDfsData;
 
+/** @brief Results of the last successful analysis of an EMPDAG
+ *
+ *  An MP is analyzed again only if its signature or its parents changed, if
+ *  one of its ancestors is analyzed again, or if one of its equations has a
+ *  variable from such an MP. The signature catches a change of ownership or
+ *  a variable added to an existing equation. Any change in the size of the
+ *  container triggers a full analysis.
+ */
+struct empdag_analysis_cache {
+   unsigned num_mps;
+   unsigned num_nashs;
+   size_t total_n;              /**< Number of variables in the container  */
+   size_t total_m;              /**< Number of equations in the container  */
+   unsigned *rstart;            /**< Reverse arcs, as in EmpDagCsr         */
+   daguid_t *rarcs;             /**< Reverse arcs, as in EmpDagCsr         */
+   MpSignature *sig;            /**< Signature of each MP                  */
+   MpIdArray *refs;             /**< MPs owning a variable of each MP      */
+   unsigned *preorder;          /**< DFS preorder timestamp of each node   */
+   unsigned *postorder;         /**< DFS postorder timestamp of each node  */
+};
+
 typedef struct {
    unsigned ctrl_edges;
    unsigned len;
@@ -293,16 +332,11 @@ DfsState get_state(EmpDagDfsData *dfsdata, nidx_t node_idx)
 NONNULL static inline
 nidx_t nidx_parent(const EmpDagDfsData *dfsdata, nidx_t node_idx)
 {
-   UIntArray *parents;
-   if (node_idx < dfsdata->num_mps) {
-      parents = &dfsdata->empdag->mps.rarcs[node_idx];
-   } else {
-      parents = &dfsdata->empdag->nashs.rarcs[node_idx-dfsdata->num_mps];
-   }
-   unsigned num_parents = parents->len;
+   const EmpDagCsr *csr = dfsdata->csr;
+   unsigned num_parents = csr->rstart[node_idx+1] - csr->rstart[node_idx];
 
    if (num_parents == 1) {
-      daguid_t uid_parent = parents->arr[0];
+      daguid_t uid_parent = csr->rarcs[csr->rstart[node_idx]];
       unsigned id = uid2id(uid_parent);
       return uidisMP(uid_parent) ? id : id + dfsdata->num_mps;
    }
@@ -371,11 +405,40 @@ void report_error_badlca(const EmpDag *empdag, rhp_idx vi, rhp_idx ei,
          empdag_getname(empdag, uid_lca));
 }
 
+/**
+ * @brief Build the binary lifting tables used by lca()
+ *
+ * Only the arcs to a unique parent are considered: the nodes without parent,
+ * or with more than one, are the tops of the trees of the forest. An arc
+ * closing a cycle is dropped, the DFS reports the cycle later on.
+ *
+ * @param dfsdata  the DFS data
+ *
+ * @return         the error code
+ */
+NONNULL static
+int lca_init(EmpDagDfsData *dfsdata)
+{
+   unsigned num_nodes = dfsdata->num_nodes;
+   if (num_nodes == 0) { return OK; }
+
+   unsigned *parent;
+   MALLOC_(parent, unsigned, num_nodes);
+
+   for (unsigned i = 0; i < num_nodes; ++i) {
+      nidx_t p = nidx_parent(dfsdata, i);
+      parent[i] = valid_nidx(p) && p < num_nodes ? p : i;
+   }
+
+   return lca_index_build(&dfsdata->lca_idx, num_nodes, parent);
+}
+
 NONNULL static
 int dfsdata_init(EmpDagDfsData *dfsdata, EmpDag * restrict empdag)
 {
    dfsdata->mdl = empdag->mdl;
    dfsdata->empdag = empdag;
+   S_CHECK(empdag_csr_get(empdag, &dfsdata->csr));
 
    dfsdata->isTree = true;
    dfsdata->hasVFPath = false;
@@ -406,11 +469,16 @@ int dfsdata_init(EmpDagDfsData *dfsdata, EmpDag * restrict empdag)
    MALLOC_(dfsdata->mp_ppty, DagMpPpty, num_mps);
    MALLOC_(dfsdata->nash_ppty, DagNashPpty, num_nash);
    MALLOC_(dfsdata->processed_vi, bool, dfsdata->processed_vi_len);
+   CALLOC_(dfsdata->mp_refs, MpIdArray, num_mps);
+   dfsdata->dirty = NULL;
+   dfsdata->sig = NULL;
 
 
    rhp_uint_init(&dfsdata->adversarial_mps);
    rhp_uint_init(&dfsdata->saddle_path_starts);
 
+   lca_index_init(&dfsdata->lca_idx);
+   S_CHECK(lca_init(dfsdata));
 
    return OK;
 }
@@ -421,6 +489,15 @@ void dfsdata_free(EmpDagDfsData *dfsdata)
    FREE(dfsdata->mp_ppty);
    FREE(dfsdata->nash_ppty);
    FREE(dfsdata->processed_vi);
+   FREE(dfsdata->dirty);
+   FREE(dfsdata->sig);
+
+   if (dfsdata->mp_refs) {
+      for (unsigned i = 0, len = dfsdata->num_mps; i < len; ++i) {
+         rhp_uint_empty(&dfsdata->mp_refs[i]);
+      }
+      FREE(dfsdata->mp_refs);
+   }
 
    FREE(dfsdata->nodes_stat);
    FREE(dfsdata->num_ancestors);
@@ -428,6 +505,7 @@ void dfsdata_free(EmpDagDfsData *dfsdata)
    FREE(dfsdata->preorder);
    FREE(dfsdata->topo_order);
    FREE(dfsdata->topo_order_nidx2tidx);
+   lca_index_free(&dfsdata->lca_idx);
 
    rhp_uint_empty(&dfsdata->adversarial_mps);
    /* DO not empty dfsdata->saddle_path_starts, it is passed to the empdag */
@@ -449,35 +527,24 @@ void dfsdata_free(EmpDagDfsData *dfsdata)
 NONNULL static
 nidx_t lca(nidx_t u, nidx_t v, const EmpDagDfsData * dfsdata) {
    /* ---------------------------------------------------------------------
-    * The gist of the algorithm is as follow:
-    * - The [ preorder, postorder ] guarantees that any successor node has
-    *   an interval which is a subset of its parent node.
-    * - GOAL: find the node which interval is a superset of both original nodes
-    * - The first two checks look for this.
-    * - If they fail, then we move up the ancestor of the node with the largest
-    *   preorder
-    *
-    * This is close to the "binary lifting", running in O(log N), see
-    * https://cp-algorithms.com/graph/lca_binary_lifting.html#implementation
+    * Query the forest built by lca_init(). If u and v are not in the same
+    * tree, there is no LCA and we report why the top of the tree has no
+    * (unique) parent
     * --------------------------------------------------------------------- */
 
+   const LcaIndex *idx = &dfsdata->lca_idx;
 
-   if (dfsdata->preorder[u] < dfsdata->preorder[v]) {
+   if (u >= idx->num_nodes || v >= idx->num_nodes) { return NodeIdxErrGeneric; }
 
-      if (dfsdata->postorder[u] > dfsdata->postorder[v]) { return u; }
+   unsigned res = lca_index_query(idx, u, v);
+   if (res != LCA_NONE) { return res; }
 
-      nidx_t parent_v = nidx_parent(dfsdata, v);
-      return valid_nidx(parent_v) ? lca(u, parent_v, dfsdata) : parent_v;
+   if (nidx_parent(dfsdata, lca_index_top(idx, u)) == NodeIdxErrDAG ||
+       nidx_parent(dfsdata, lca_index_top(idx, v)) == NodeIdxErrDAG) {
+      return NodeIdxErrDAG;
    }
 
-   /* we have dfsdata->preorder[v] <= dfsdata->preorder[u] */
-
-   /* Test for >= to avoid issues if u and v are the same node */
-   if (dfsdata->postorder[v] >= dfsdata->postorder[u]) { return v; }
-
-   /* */
-   nidx_t parent_u = nidx_parent(dfsdata, u);
-   return valid_nidx(parent_u) ? lca(v, parent_u, dfsdata) : parent_u;
+   return NodeIdxErrNoParent;
 }
 
 typedef enum {
@@ -497,10 +564,35 @@ typedef struct {
    mpid_t      saddle_path_start;
 } DfsPathDataFwd;
 
-static int dfs_mpC(mpid_t mpid, EmpDagDfsData *dfsdata, DfsPathDataFwd pathdata);
-static int dfs_mpV(mpid_t mpid, EmpDagDfsData *dfsdata, DfsPathDataFwd pathdata);
-static int dfs_nash(nashid_t id_parent, EmpDagDfsData *dfsdata, DfsPathDataFwd pathdata);
-static int dfs_mpInNashOrRoot(mpid_t mpid, EmpDagDfsData *dfsdata, DfsPathDataFwd pathdata);
+/* ---------------------------------------------------------------------------
+ * The analysis is a DFS over the EMPDAG, run by the DFS engine. An MP is
+ * processed differently depending on the arc that led to it, hence the node
+ * kind in the frame state.
+ * --------------------------------------------------------------------------- */
+
+typedef enum {
+   DfsNodeMpCtrl,              /**< MP reached via a CTRL arc               */
+   DfsNodeMpVF,                /**< MP reached via a VF arc                 */
+   DfsNodeMpInNashOrRoot,      /**< MP child of a Nash node, or root MP     */
+   DfsNodeNash,                /**< Nash node                               */
+} DfsNodeKind;
+
+typedef enum {
+   DfsStageFirst,
+   DfsStageSecond,
+   DfsStageDone,
+} DfsStage;
+
+typedef struct {
+   DfsNodeKind    kind;
+   DfsStage       stage;            /**< Which arcs are being visited        */
+   bool           redirect;         /**< Dual MP: visit the primal MP        */
+   dagid_t        id;               /**< MP or Nash ID                       */
+   int            last_rc;          /**< Code of the last child on a CTRL arc */
+   DfsPathDataFwd pathdata;         /**< Path data of the node               */
+   DfsPathDataFwd pathdata_child;   /**< Path data given to the children     */
+   DfsPathDataFwd pathdata_varcs;   /**< Path data given to VF children      */
+} DfsAnalysisState;
 
 DBGUSED static inline 
 bool pathtype_is_VF(DagPathType pathtype) {
@@ -527,362 +619,362 @@ DagPathType sense2pathtype(RhpSense sense)
    }
 }
 
-NONNULL static int process_Carcs(EmpDagDfsData *dfsdata, UIntArray *Carcs,
-                                 DfsPathDataFwd pathdata_child, mpid_t mpid_parent)
+NONNULL static inline
+nidx_t dfsstate_nidx(const DfsAnalysisState *st, const EmpDagDfsData *dfsdata)
 {
-   int rc = 0;
-
-   for (unsigned i = 0, Clen = Carcs->len; i < Clen; ++i) {
-      daguid_t uid_child = Carcs->arr[i];
-      dagid_t id_child = uid2id(uid_child);
-
-      pathdata_child.pathtype = DfsPathCtrl;
-      pathdata_child.saddle_path_start = UINT_MAX;
-
-      if (uidisMP(uid_child)) {
-         dfsdata->num_ancestors[id_child].Carc += 1;
-         rc = dfs_mpC(id_child, dfsdata, pathdata_child);
-      } else {
-         dfsdata->num_ancestors[id_child+dfsdata->num_mps].Carc += 1;
-         rc = dfs_nash(id_child, dfsdata, pathdata_child);
-      }
-
-      if (rc == 0) continue;
-      if (rc > 0) { return rc; }
-      if (rc == -DagErrDagCycle) {
-         error("MP(%s)\n", empdag_getname(dfsdata->empdag, uid_child));
-         DfsState stat = get_state(dfsdata, mpid_parent);
-         if (stat == CycleStart) { return -DagErrGeneric; }
-         return rc;
-      }
-
-   }
-
-   /* Catch all error */
-   if (rc == 0) return OK;
+   return st->kind == DfsNodeNash ? st->id + dfsdata->num_mps : st->id;
+}
 
-   return runtime_error_rc(rc);
+NONNULL static inline
+daguid_t dfsstate_uid(const DfsAnalysisState *st)
+{
+   return st->kind == DfsNodeNash ? nashid2uid(st->id) : mpid2uid(st->id);
 }
 
-NONNULL static int process_Varcs(EmpDagDfsData *dfsdata, VarcArray *Varcs,
-                                 DfsPathDataFwd pathdata, mpid_t mpid_parent)
+NONNULL static
+int dfs_analysis_pre(void *ctx, DfsFrame *frame, void *state, bool *visit)
 {
-   EmpDag *empdag = dfsdata->empdag;
-   DagPathType cur_pathtype = pathdata.pathtype;
-   const Model *mdl = dfsdata->mdl;
+   EmpDagDfsData *dfsdata = ctx;
+   DfsAnalysisState *st = state;
+   const EmpDag * restrict empdag = dfsdata->empdag;
+   nidx_t nidx = dfsstate_nidx(st, dfsdata);
 
-   dfsdata->hasVFPath = true;
+   *visit = false;
+   st->stage = DfsStageFirst;
+   st->redirect = false;
+   st->last_rc = 0;
+   st->pathdata_child = st->pathdata;
+   st->pathdata_child.depth++;
 
-   assert(Varcs->len > 0);
+   DfsState state_node = process_node_state(dfsdata, dfsstate_uid(st), nidx);
+   switch (state_node) {
+   case InProgress:
+      break;
+   case CycleStart:
+      return -DagErrDagCycle;
+   case Processed:
+      return OK;
+   default:
+      return runtime_error_state(state_node);
+   }
 
-   for (unsigned i = 0, len = Varcs->len; i < len; ++i) {
+   *visit = true;
 
-      const ArcVFData *arcVF = &Varcs->arr[i];
-      mpid_t mpid_child = arcVF->mpid_child;
+   if (st->kind == DfsNodeNash) {
+      dfsdata->preorder[nidx] = ++dfsdata->timestamp;
 
-      dfsdata->num_ancestors[mpid_child].Varc += 1;
+      unsigned narcs;
+      empdag_csr_nasharcs(dfsdata->csr, st->id, &narcs);
 
-      /* -------------------------------------------------------------------
-       * First check: are the equations in the Varc assigned to the parent mp?
-       * ------------------------------------------------------------------- */
+      dfsdata->arc_stats.num_equil += narcs;
 
-      if (!arcVF_chk_equ(arcVF, mpid_parent, mdl)) {
-         error("[empdag] ERROR: The VF arc between MP(%s) and MP(%s) involves "
-               "at least one equation that does not belong to the parent MP(%s)\n",
-               empdag_getmpname(empdag, mpid_parent),
-               empdag_getmpname(empdag, mpid_child),
-               empdag_getmpname(empdag, mpid_parent));
-         return Error_EMPIncorrectInput;
+      if (narcs == 0) {
+         error("[empdag] ERROR: Nash(%s) has no child.\n", empdag_getnashname(empdag, st->id));
+         return -DagErrNashNoChild;
       }
 
+      st->pathdata_child.pathtype = DfsPathEquil;
 
-      /* ------------------------------------------------------------------
-       * If we have an adversarial MP, we add it to a list of MP to reformulate.
-       * This occurs when the sense of the path and the child MP are opposite.
-       * ------------------------------------------------------------------ */
-
-      const MathPrgm *mp_child = empdag->mps.arr[mpid_child];
-      RhpSense sense = mp_getsense(mp_child);
+      return OK;
+   }
 
-      if ((sense == RhpMax && cur_pathtype == DfsPathVFMin) ||
-          (sense == RhpMin && cur_pathtype == DfsPathVFMax)) {
+   mpid_t mpid = st->id;
+   assert(mpid < empdag->mps.len);
 
-         S_CHECK(mpidarray_add(&dfsdata->adversarial_mps, mpid_child));
+   /* Dual MPs are specials */
+   if (st->kind != DfsNodeMpInNashOrRoot) {
+      MathPrgm *mp;
+      S_CHECK(empdag_getmpbyid(empdag, mpid, &mp));
 
-         if (!pathdata.saddle_path_registered) {
-            S_CHECK(mpidarray_add(&dfsdata->saddle_path_starts, pathdata.saddle_path_start));
-            pathdata.saddle_path_registered = true;
-         }
-      } else if (sense == RhpFeasibility) {
+      if (mp->type == MpTypeDual) {
+         /* Mark node as processed so that no further exploration is required */
+         mark_as_processed(dfsdata, nidx);
 
-         error("[empdag] ERROR: MP(%s), of type %s, is linked via a VF arc to "
-               "its parent MP(%s). This is nonsensical.\n",
-               empdag_getmpname(empdag, mpid_child), mp_gettypestr(mp_child),
-               empdag_getmpname(empdag, mpid_parent));
-         return Error_EMPIncorrectInput;
+         dfsdata->num_visited_dual++;
+         st->redirect = true;
 
-      } else if (sense != RhpMax && sense != RhpMin) {
+         return OK;
+      }
+   }
 
-         error("[empdag] ERROR: MP(%s) has unknown/unsupported sense %s\n",
-               empdag_getmpname(empdag, mpid_child), sense2str(sense));
-         return Error_EMPRuntimeError;
+   dfsdata->preorder[nidx] = ++dfsdata->timestamp;
 
-      }
+   unsigned Vlen, Clen;
+   empdag_csr_Varcs(dfsdata->csr, mpid, &Vlen);
+   empdag_csr_Carcs(dfsdata->csr, mpid, &Clen);
 
-      int rc = dfs_mpV(mpid_child, dfsdata, pathdata);
+   if (st->kind == DfsNodeMpCtrl) {
+      assert(st->pathdata.pathtype == DfsPathCtrl);
+      dfsdata->arc_stats.num_ctrl += Clen;
+      dfsdata->arc_stats.num_vf += Vlen;
+   }
 
-      if (rc == 0) continue;
-      if (rc > 0) { return rc; }
-      if (rc == -DagErrDagCycle) {
-         error("MP(%s)\n", empdag_getmpname(empdag, mpid_child));
-         DfsState stat = get_state(dfsdata, mpid_child);
-         if (stat == CycleStart) { return -DagErrGeneric; }
-         return rc;
-      }
+   /* We are at a leaf node */
+   if (Clen == 0 && Vlen == 0) {
+      dfsdata->max_depth = MAX(dfsdata->max_depth, st->pathdata.depth);
    }
 
    return OK;
-
 }
 
+/* Start the visit of the children on VF arcs */
 NONNULL static
-int dfs_mpC(mpid_t mpid, EmpDagDfsData *dfsdata, DfsPathDataFwd pathdata)
+void dfs_analysis_startVarcs(EmpDagDfsData *dfsdata, DfsAnalysisState *st)
 {
-   const EmpDag * restrict empdag = dfsdata->empdag;
-   unsigned nidx = mpid; assert(mpid < empdag->mps.len);
-   UIntArray *Carcs = &empdag->mps.Carcs[mpid];
-   VarcArray *Varcs = &empdag->mps.Varcs[mpid];
-
-   assert(pathdata.pathtype == DfsPathCtrl);
-   DfsPathDataFwd pathdata_child = pathdata;
-   pathdata_child.depth++;
+   dfsdata->hasVFPath = true;
 
+   /* From a MP that is not on a VF path: we need to determine whether we
+    * have a saddle path */
+   if (st->kind != DfsNodeMpVF) {
+      assert(!pathtype_is_VF(st->pathdata.pathtype));
+      RhpSense sense = mp_getsense(dfsdata->empdag->mps.arr[st->id]);
+      assert(sense == RhpMax || sense == RhpMin);
 
-   DfsState state = process_node_state(dfsdata, mpid2uid(mpid), nidx);
-   switch (state) {
-   case InProgress:
-      break;
-   case CycleStart:
-      return -DagErrDagCycle;
-   case Processed:
-      return OK;
-   default:
-      return runtime_error_state(state);
+      st->pathdata_child.pathtype = sense2pathtype(sense);
+      st->pathdata_child.saddle_path_start = st->id;
+      st->pathdata_child.saddle_path_registered = false;
    }
 
-   MathPrgm *mp;
-   S_CHECK(empdag_getmpbyid(empdag, mpid, &mp));
-
-   /* Dual MPs are specials */
-   if (mp->type == MpTypeDual) {
-      /* Mark node as processed so that no further exploration is required */
-      mark_as_processed(dfsdata, nidx);
-
-      dfsdata->num_visited_dual++;
+   st->pathdata_varcs = st->pathdata_child;
+}
 
-      mpid_t mpid_primal = mp->dual.mpid_primal;
-      return dfs_mpC(mpid_primal, dfsdata, pathdata);
-   }
- 
-   dfsdata->preorder[nidx] = ++dfsdata->timestamp;
+NONNULL static
+int dfs_analysis_nextVarc(EmpDagDfsData *dfsdata, DfsAnalysisState *st,
+                          const ArcVFData *arcVF, DfsAnalysisState *child)
+{
+   EmpDag *empdag = dfsdata->empdag;
+   mpid_t mpid_parent = st->id, mpid_child = arcVF->mpid_child;
+   DagPathType cur_pathtype = st->pathdata_varcs.pathtype;
 
-   /* We are at a leaf node */
-   unsigned Vlen = Varcs->len, Clen = Carcs->len;
+   dfsdata->num_ancestors[mpid_child].Varc += 1;
 
-   dfsdata->arc_stats.num_ctrl += Clen;
-   dfsdata->arc_stats.num_vf += Vlen;
+   /* -------------------------------------------------------------------
+    * First check: are the equations in the Varc assigned to the parent mp?
+    * ------------------------------------------------------------------- */
 
-   if (Clen == 0 && Vlen == 0) {
-      dfsdata->max_depth = MAX(dfsdata->max_depth, pathdata.depth);
+   if (!arcVF_chk_equ(arcVF, mpid_parent, dfsdata->mdl)) {
+      error("[empdag] ERROR: The VF arc between MP(%s) and MP(%s) involves "
+            "at least one equation that does not belong to the parent MP(%s)\n",
+            empdag_getmpname(empdag, mpid_parent),
+            empdag_getmpname(empdag, mpid_child),
+            empdag_getmpname(empdag, mpid_parent));
+      return Error_EMPIncorrectInput;
    }
 
-   /* ---------------------------------------------------------------------
-    * Children on CTRL edge do not require further analysis, just visit them
-    * --------------------------------------------------------------------- */
+   /* ------------------------------------------------------------------
+    * If we have an adversarial MP, we add it to a list of MP to reformulate.
+    * This occurs when the sense of the path and the child MP are opposite.
+    * ------------------------------------------------------------------ */
 
-   if (Clen > 0) {
-      S_CHECK(process_Carcs(dfsdata, Carcs, pathdata_child, mpid));
-   }
+   const MathPrgm *mp_child = empdag->mps.arr[mpid_child];
+   RhpSense sense = mp_getsense(mp_child);
 
-   /* ---------------------------------------------------------------------
-    * Children on VF arc: we need to determine whether we have a saddle path
-    * --------------------------------------------------------------------- */
+   if ((sense == RhpMax && cur_pathtype == DfsPathVFMin) ||
+       (sense == RhpMin && cur_pathtype == DfsPathVFMax)) {
 
-   assert(!pathtype_is_VF(pathdata.pathtype));
+      S_CHECK(mpidarray_add(&dfsdata->adversarial_mps, mpid_child));
 
-   if (Vlen > 0) {
-      RhpSense sense_parent = mp_getsense(empdag->mps.arr[mpid]);
-      assert(sense_parent == RhpMax || sense_parent == RhpMin);
-      DagPathType cur_pathtype = sense2pathtype(sense_parent);
+      if (!st->pathdata_varcs.saddle_path_registered) {
+         S_CHECK(mpidarray_add(&dfsdata->saddle_path_starts, st->pathdata_varcs.saddle_path_start));
+         st->pathdata_varcs.saddle_path_registered = true;
+      }
+   } else if (sense == RhpFeasibility) {
 
-      pathdata_child.pathtype = cur_pathtype;
-      pathdata_child.saddle_path_start = mpid;
-      pathdata_child.saddle_path_registered = false;
+      error("[empdag] ERROR: MP(%s), of type %s, is linked via a VF arc to "
+            "its parent MP(%s). This is nonsensical.\n",
+            empdag_getmpname(empdag, mpid_child), mp_gettypestr(mp_child),
+            empdag_getmpname(empdag, mpid_parent));
+      return Error_EMPIncorrectInput;
 
-      S_CHECK(process_Varcs(dfsdata, Varcs, pathdata_child, mpid));
-   }
+   } else if (sense != RhpMax && sense != RhpMin) {
 
-   /* ---------------------------------------------------------------------
-    * Post order: set the topo order
-    * --------------------------------------------------------------------- */
+      error("[empdag] ERROR: MP(%s) has unknown/unsupported sense %s\n",
+            empdag_getmpname(empdag, mpid_child), sense2str(sense));
+      return Error_EMPRuntimeError;
 
-   dfsdata->topo_order_nidx2tidx[nidx] = dfsdata->num_visited;
-   dfsdata->topo_order[dfsdata->num_visited++] = nidx;
+   }
 
-   dfsdata->postorder[nidx] = ++dfsdata->timestamp;
-
-   /* Mark node as processed so that no further exploration is required */
-   mark_as_processed(dfsdata, nidx);
+   child->kind = DfsNodeMpVF;
+   child->id = mpid_child;
+   child->pathdata = st->pathdata_varcs;
 
    return OK;
 }
 
-/* ---------------------------------------------------------------------
- * This function processes a node that was accessed via a VF arc
- * --------------------------------------------------------------------- */
-
 NONNULL static
-int dfs_mpV(mpid_t mpid, EmpDagDfsData *dfsdata, DfsPathDataFwd pathdata)
+int dfs_analysis_next(void *ctx, DfsFrame *frame, void *state, bool *has_child,
+                      void *child_state)
 {
-   const EmpDag * restrict empdag = dfsdata->empdag;
-   nidx_t nidx = mpid;
-   assert(mpid < empdag->mps.len);
-   UIntArray *Carcs = &empdag->mps.Carcs[mpid];
-   VarcArray *Varcs = &empdag->mps.Varcs[mpid];
+   EmpDagDfsData *dfsdata = ctx;
+   DfsAnalysisState *st = state, *child = child_state;
+   EmpDag * restrict empdag = dfsdata->empdag;
 
-   assert(pathtype_is_VF(pathdata.pathtype));
-   DfsPathDataFwd pathdata_child = pathdata;
-   pathdata_child.depth++;
+   *has_child = false;
+
+   if (st->redirect) {
+      if (frame->pos > 0) { return OK; }
+      frame->pos++;
+
+      child->kind = st->kind;
+      child->id = empdag->mps.arr[st->id]->dual.mpid_primal;
+      child->pathdata = st->pathdata;
+      *has_child = true;
 
-   DfsState state = process_node_state(dfsdata, mpid2uid(mpid), nidx);
-   switch (state) {
-   case InProgress:
-      break;
-   case CycleStart:
-      return -DagErrDagCycle;
-   case Processed:
       return OK;
-   default:
-      return runtime_error_state(state);
    }
 
-   MathPrgm *mp;
-   S_CHECK(empdag_getmpbyid(empdag, mpid, &mp));
+   if (st->kind == DfsNodeNash) {
+      nashid_t nashid = st->id;
+      unsigned narcs;
+      const daguid_t *arcs = empdag_csr_nasharcs(dfsdata->csr, nashid, &narcs);
+      if (frame->pos >= narcs) { return OK; }
 
-   /* Dual MPs are specials */
-   if (mp->type == MpTypeDual) {
-      /* Mark node as processed so that no further exploration is required */
-      mark_as_processed(dfsdata, nidx);
+      daguid_t uid_child = arcs[frame->pos++];
+      dagid_t id_child = uid2id(uid_child);
+
+      if (!(uidisMP(uid_child))) {
+         error("[empdag/analysis] ERROR: Nash(%s) has Nash(%s) as child. A Nash node can "
+               "not have a Nash node among its children\n",
+               empdag_getnashname(empdag, nashid), empdag_getnashname(empdag, id_child));
+         return Error_EMPIncorrectInput;
+      }
 
-      dfsdata->num_visited_dual++;
+      assert(empdag->mps.arr[id_child]);
 
-      mpid_t mpid_primal = mp->dual.mpid_primal;
-      return dfs_mpV(mpid_primal, dfsdata, pathdata);
-   }
+      dfsdata->num_ancestors[id_child].Narc += 1;
 
-    dfsdata->preorder[nidx] = ++dfsdata->timestamp;
+      child->kind = DfsNodeMpInNashOrRoot;
+      child->id = id_child;
+      child->pathdata = st->pathdata_child;
+      *has_child = true;
 
-   /* We are at a leaf node */
-   unsigned Vlen = Varcs->len;
-   unsigned Clen = Carcs->len;
-   if (Clen == 0 && Vlen == 0) {
-      dfsdata->max_depth = MAX(dfsdata->max_depth, pathdata.depth);
+      return OK;
    }
 
    /* ---------------------------------------------------------------------
-    * Children on VF arc: we need to determine whether we have a saddle path
-    * Also, we can mark that there exists a VFpath that would need to be
-    * collapsed
+    * For an MP reached via a CTRL arc, the children on CTRL arcs are visited
+    * first, then the ones on VF arcs. Otherwise, the VF arcs come first.
     * --------------------------------------------------------------------- */
 
-   if (Vlen > 0 ) {
-      S_CHECK(process_Varcs(dfsdata, Varcs, pathdata_child, mpid));
-   }
+   mpid_t mpid = st->id;
 
-   /* ---------------------------------------------------------------------
-    * Children on CTRL arc: reset pathtype
-    * --------------------------------------------------------------------- */
+   while (st->stage != DfsStageDone) {
+      bool ctrl_stage = (st->stage == DfsStageFirst) == (st->kind == DfsNodeMpCtrl);
 
-   if (Clen > 0) {
-      pathdata_child.pathtype = DfsPathCtrl;
-      S_CHECK(process_Carcs(dfsdata, Carcs, pathdata_child, mpid));
-   }
+      if (ctrl_stage) {
+         unsigned Clen;
+         const daguid_t *Carcs = empdag_csr_Carcs(dfsdata->csr, mpid, &Clen);
 
-   dfsdata->topo_order_nidx2tidx[nidx] = dfsdata->num_visited;
-   dfsdata->topo_order[dfsdata->num_visited++] = nidx;
+         if (frame->pos < Clen) {
+            daguid_t uid_child = Carcs[frame->pos++];
+            dagid_t id_child = uid2id(uid_child);
 
-   dfsdata->postorder[nidx] = ++dfsdata->timestamp;
+            child->pathdata = st->pathdata_child;
+            child->pathdata.pathtype = DfsPathCtrl;
+            child->pathdata.saddle_path_start = UINT_MAX;
+            child->id = id_child;
 
-   /* Mark node as processed so that no further exploration is required */
-   mark_as_processed(dfsdata, nidx);
+            if (uidisMP(uid_child)) {
+               dfsdata->num_ancestors[id_child].Carc += 1;
+               child->kind = DfsNodeMpCtrl;
+            } else {
+               dfsdata->num_ancestors[id_child+dfsdata->num_mps].Carc += 1;
+               child->kind = DfsNodeNash;
+            }
+
+            *has_child = true;
+            return OK;
+         }
+
+         /* Catch all error */
+         if (st->last_rc != 0) { return runtime_error_rc(st->last_rc); }
+
+      } else {
+         unsigned Vlen;
+         const Varc *Varcs = empdag_csr_Varcs(dfsdata->csr, mpid, &Vlen);
+
+         if (frame->pos == 0 && Vlen > 0) {
+            dfs_analysis_startVarcs(dfsdata, st);
+         }
+
+         if (frame->pos < Vlen) {
+            S_CHECK(dfs_analysis_nextVarc(dfsdata, st, &Varcs[frame->pos++], child));
+            *has_child = true;
+            return OK;
+         }
+      }
+
+      st->stage++;
+      frame->pos = 0;
+   }
 
    return OK;
 }
 
 NONNULL static
-int dfs_mpInNashOrRoot(mpid_t mpid, EmpDagDfsData *dfsdata, DfsPathDataFwd pathdata)
+int dfs_analysis_in(void *ctx, DfsFrame *frame, void *state, const void *child_state,
+                    int rc)
 {
+   EmpDagDfsData *dfsdata = ctx;
+   DfsAnalysisState *st = state;
+   const DfsAnalysisState *child = child_state;
    const EmpDag * restrict empdag = dfsdata->empdag;
-   nidx_t nidx = mpid;
-   assert(mpid < empdag->mps.len);
 
-   assert(pathdata.pathtype == DfsPathEquil || pathdata.pathtype == DfsPathUnset);
-   DfsPathDataFwd pathdata_child = pathdata;
-   pathdata_child.depth++;
+   /* A dual MP returns the code of its primal MP */
+   if (st->redirect) { return rc; }
 
-   DfsState state = process_node_state(dfsdata, mpid2uid(mpid), nidx);
-   switch (state) {
-   case InProgress:
-      break;
-   case CycleStart:
-      return -DagErrDagCycle;
-   case Processed:
-      return OK;
-   default:
-      return runtime_error_state(state);
-   }
+   bool ctrl_child = st->kind != DfsNodeNash && child->kind != DfsNodeMpVF;
+   if (ctrl_child) { st->last_rc = rc; }
 
-   dfsdata->preorder[nidx] = ++dfsdata->timestamp;
+   if (rc == 0) { return OK; }
+   if (rc > 0) { return rc; }
 
-   UIntArray *Carcs = &empdag->mps.Carcs[mpid];
-   VarcArray *Varcs = &empdag->mps.Varcs[mpid];
-   /* Are we at a leaf node? */
-   unsigned Vlen = Varcs->len, Clen = Carcs->len;
-   if (Clen == 0 && Vlen == 0) {
-      dfsdata->max_depth = MAX(dfsdata->max_depth, pathdata.depth);
-   }
+   if (rc == -DagErrDagCycle) {
+      DfsState stat;
 
-   /* VF arcs: look for saddle path */
-   if (Vlen > 0) {
-      RhpSense sense = mp_getsense(empdag->mps.arr[mpid]);
-      assert(sense == RhpMax || sense == RhpMin);
-
-      DagPathType cur_pathtype = sense2pathtype(sense);
-      pathdata_child.pathtype = cur_pathtype;
-      pathdata_child.saddle_path_start = mpid;
-      pathdata_child.saddle_path_registered = false;
+      if (st->kind == DfsNodeNash) {
+         error("Nash(%s)\n", empdag_getnashname(empdag, st->id));
+         stat = get_state(dfsdata, dfsstate_nidx(st, dfsdata));
+      } else if (ctrl_child) {
+         error("MP(%s)\n", empdag_getname(empdag, dfsstate_uid(child)));
+         stat = get_state(dfsdata, st->id);
+      } else {
+         error("MP(%s)\n", empdag_getmpname(empdag, child->id));
+         stat = get_state(dfsdata, child->id);
+      }
 
-      S_CHECK(process_Varcs(dfsdata, Varcs, pathdata_child, mpid));
+      if (stat == CycleStart) { return -DagErrGeneric; }
+      return rc;
    }
 
-   /* Children on CTRL arc: reset pathtype */
-   if (Clen > 0) {
-      pathdata_child.pathtype = DfsPathCtrl;
-      S_CHECK(process_Carcs(dfsdata, Carcs, pathdata_child, mpid));
-   }
+   /* Other codes do not stop the visit of the siblings */
+   return OK;
+}
+
+NONNULL static
+int dfs_analysis_post(void *ctx, DfsFrame *frame, void *state)
+{
+   EmpDagDfsData *dfsdata = ctx;
+   DfsAnalysisState *st = state;
+   const EmpDag * restrict empdag = dfsdata->empdag;
+   nidx_t nidx = dfsstate_nidx(st, dfsdata);
+
+   if (st->redirect) { return OK; }
 
    /* Make sure there between nodes there is only ONE arc */
-   const DagUidArray * restrict rarcs = &empdag->mps.rarcs[mpid];
-   if (rarcs->len > 1) {
+   const EmpDagCsr *csr = dfsdata->csr;
+   unsigned rlen = csr->rstart[nidx+1] - csr->rstart[nidx];
+   const daguid_t * restrict rarcs_arr = &csr->rarcs[csr->rstart[nidx]];
+
+   if (st->kind == DfsNodeMpInNashOrRoot && rlen > 1) {
+      mpid_t mpid = st->id;
       size_t sz = (dfsdata->num_nodes)*sizeof(bool);
       bool * restrict mp_parents;
       A_CHECK(mp_parents, ctr_memtmp_get(&dfsdata->mdl->ctr, sz));
 
       memset(mp_parents, 0, (dfsdata->num_nodes)*sizeof(bool));
       nidx_t nmps = dfsdata->num_mps;
-      daguid_t * restrict rarcs_arr = rarcs->arr;
-
-      for (unsigned i = 0, len = rarcs->len; i < len; ++i) {
+      for (unsigned i = 0; i < rlen; ++i) {
          daguid_t uid = rarcs_arr[i];
          nidx_t nidx_parent = uidisMP(uid) ? uid2id(uid) : uid2id(uid) + nmps;
 
@@ -902,6 +994,10 @@ int dfs_mpInNashOrRoot(mpid_t mpid, EmpDagDfsData *dfsdata, DfsPathDataFwd pathd
       ctr_memtmp_rel(&dfsdata->mdl->ctr, sz);
    }
 
+   /* ---------------------------------------------------------------------
+    * Post order: set the topo order
+    * --------------------------------------------------------------------- */
+
    dfsdata->topo_order_nidx2tidx[nidx] = dfsdata->num_visited;
    dfsdata->topo_order[dfsdata->num_visited++] = nidx;
 
@@ -913,81 +1009,12 @@ int dfs_mpInNashOrRoot(mpid_t mpid, EmpDagDfsData *dfsdata, DfsPathDataFwd pathd
    return OK;
 }
 
-NONNULL static
-int dfs_nash(nashid_t id_parent, EmpDagDfsData *dfsdata, DfsPathDataFwd pathdata)
-{
-   const EmpDag * restrict empdag = dfsdata->empdag;
-   dagid_t node_idx = id_parent + dfsdata->num_mps;
-
-   UIntArray *arcs = &empdag->nashs.arcs[id_parent];
-   DfsPathDataFwd pathdata_child = pathdata;
-   pathdata_child.depth++;
-
-   DfsState state = process_node_state(dfsdata, nashid2uid(id_parent), node_idx);
-   switch (state) {
-   case InProgress:
-      break;
-   case CycleStart:
-      return -DagErrDagCycle;
-   case Processed:
-      return OK;
-   default:
-      return runtime_error_state(state);
-   }
-
-   dfsdata->preorder[node_idx] = ++dfsdata->timestamp;
-
-   /* We are at a leaf node */
-
-   unsigned narcs = arcs->len;
-
-   dfsdata->arc_stats.num_equil += narcs;
-
-   if (narcs == 0) {
-      error("[empdag] ERROR: Nash(%s) has no child.\n", empdag_getnashname(empdag, id_parent));
-      return -DagErrNashNoChild;
-   }
-
-
-   pathdata_child.pathtype = DfsPathEquil;
-
-   for (unsigned i = 0; i < narcs; ++i) {
-      daguid_t uid_child = arcs->arr[i];
-      dagid_t id_child = uid2id(uid_child);
-
-      if (!(uidisMP(uid_child))) {
-         error("[empdag/analysis] ERROR: Nash(%s) has Nash(%s) as child. A Nash node can "
-               "not have a Nash node among its children\n",
-               empdag_getnashname(empdag, id_parent), empdag_getnashname(empdag, id_child));
-         return Error_EMPIncorrectInput;
-      }
-
-      assert(uidisMP(uid_child)); assert(empdag->mps.arr[id_child]);
-
-      dfsdata->num_ancestors[id_child].Narc += 1;
-
-      int rc = dfs_mpInNashOrRoot(id_child, dfsdata, pathdata_child);
-
-      if (rc == 0) continue;
-      if (rc > 0) { return rc; }
-      if (rc == -DagErrDagCycle) {
-         error("Nash(%s)\n", empdag_getnashname(empdag, id_parent));
-          DfsState stat = get_state(dfsdata, node_idx);
-         if (stat == CycleStart) { return -DagErrGeneric; }
-         return rc;
-      }
-   }
-
-   dfsdata->topo_order_nidx2tidx[node_idx] = dfsdata->num_visited;
-   dfsdata->topo_order[dfsdata->num_visited++] = node_idx;
-
-   dfsdata->postorder[node_idx] = ++dfsdata->timestamp;
-
-   /* Mark node as processed so that no further exploration is required */
-   mark_as_processed(dfsdata, node_idx);
-
-   return OK;
-}
+static const DfsOps dfs_analysis_ops = {
+   .pre  = dfs_analysis_pre,
+   .next = dfs_analysis_next,
+   .in   = dfs_analysis_in,
+   .post = dfs_analysis_post,
+};
 
 DBGUSED NONNULL static inline
 bool empdag_chk_vitype(const VarMeta *varmeta)
@@ -1398,6 +1425,10 @@ int analyze_mp(EmpDagDfsData *dfsdata, mpid_t mpid, AnalysisData *data)
 
          assert(mp_var < mps->len);
 
+         if (mp_var != mpid) {
+            S_CHECK(rhp_uint_adduniqnofail(&dfsdata->mp_refs[mpid], mp_var));
+         }
+
          /* Simplest case: the MP owns the variable */
          if (mp_var == mpid) {
             mp_ppty->num_ownvar++;
@@ -1519,8 +1550,10 @@ int analyze_mp(EmpDagDfsData *dfsdata, mpid_t mpid, AnalysisData *data)
           * that it is an Nash node
           * ---------------------------------------------------------------- */
          nidx_t nidx_lca = lca(mpid, mp_var, dfsdata);
-         if (!valid_uid(nidx_lca)) {
+         if (!valid_nidx(nidx_lca)) {
             report_error_nolca(dfsdata->empdag, vi, ei, mp_var, mpid);
+            num_err++;
+            continue;
          }
          daguid_t nidx_uid = nidx2uid(nidx_lca, dfsdata);
          if (!uidisNash(nidx_uid)) {
@@ -1637,12 +1670,347 @@ int analyze_nash(EmpDagDfsData *dfsdata, nashid_t nashid, AnalysisData *data)
  *
  * @return        the error code
  */
+void empdag_analysis_cache_free(struct empdag_analysis_cache **cache)
+{
+   struct empdag_analysis_cache *c = *cache;
+   if (!c) { return; }
+
+   if (c->refs) {
+      for (unsigned i = 0, len = c->num_mps; i < len; ++i) {
+         rhp_uint_empty(&c->refs[i]);
+      }
+   }
+
+   FREE(c->rstart);
+   FREE(c->rarcs);
+   FREE(c->sig);
+   FREE(c->refs);
+   FREE(c->preorder);
+   FREE(c->postorder);
+   FREE(*cache);
+}
+
+/**
+ * @brief Copy the analysis cache of an EMPDAG
+ *
+ * @param[out] dst  the copy
+ * @param      src  the cache to copy, may be NULL
+ *
+ * @return          the error code
+ */
+int empdag_analysis_cache_dup(struct empdag_analysis_cache **dst,
+                              const struct empdag_analysis_cache *src)
+{
+   int status = OK;
+   empdag_analysis_cache_free(dst);
+   if (!src) { return OK; }
+
+   struct empdag_analysis_cache *c;
+   CALLOC_(c, struct empdag_analysis_cache, 1);
+   *dst = c;
+
+   unsigned num_mps = src->num_mps, num_nodes = src->num_mps + src->num_nashs;
+   unsigned nrarcs = src->rstart[num_nodes];
+
+   c->num_mps = num_mps;
+   c->num_nashs = src->num_nashs;
+   c->total_n = src->total_n;
+   c->total_m = src->total_m;
+
+   MALLOC_EXIT(c->rstart, unsigned, num_nodes+1);
+   MALLOC_EXIT(c->rarcs, daguid_t, MAX(nrarcs, 1));
+   MALLOC_EXIT(c->sig, MpSignature, MAX(num_mps, 1));
+   CALLOC_EXIT(c->refs, MpIdArray, MAX(num_mps, 1));
+   MALLOC_EXIT(c->preorder, unsigned, MAX(num_nodes, 1));
+   MALLOC_EXIT(c->postorder, unsigned, MAX(num_nodes, 1));
+
+   memcpy(c->rstart, src->rstart, (num_nodes+1)*sizeof(unsigned));
+   memcpy(c->rarcs, src->rarcs, nrarcs*sizeof(daguid_t));
+   memcpy(c->sig, src->sig, num_mps*sizeof(MpSignature));
+   memcpy(c->preorder, src->preorder, num_nodes*sizeof(unsigned));
+   memcpy(c->postorder, src->postorder, num_nodes*sizeof(unsigned));
+
+   for (unsigned i = 0; i < num_mps; ++i) {
+      S_CHECK_EXIT(rhp_uint_copy(&c->refs[i], &src->refs[i]));
+   }
+
+   return OK;
+
+_exit:
+   empdag_analysis_cache_free(dst);
+   return status;
+}
+
+/**
+ * @brief Get the results of the last analysis for a node of the EMPDAG
+ *
+ * @param      empdag     the EMPDAG
+ * @param      uid        the node
+ * @param[out] level      the number of control arcs above the node, UINT_MAX
+ *                        for a Nash node
+ * @param[out] preorder   the DFS preorder timestamp of the node
+ * @param[out] postorder  the DFS postorder timestamp of the node
+ *
+ * @return                the error code
+ */
+int empdag_analysis_getnode(const EmpDag *empdag, daguid_t uid, unsigned *level,
+                            unsigned *preorder, unsigned *postorder)
+{
+   const struct empdag_analysis_cache *c = empdag->analysis_cache;
+
+   if (!c) {
+      errormsg("[empdag] ERROR: the EMPDAG has not been analyzed\n");
+      return Error_EMPRuntimeError;
+   }
+
+   bool is_mp = uidisMP(uid);
+   unsigned id = uid2id(uid);
+
+   if (id >= (is_mp ? c->num_mps : c->num_nashs)) {
+      error("[empdag] ERROR: %s #%u is not part of the last analysis\n",
+            is_mp ? "MP" : "Nash", id);
+      return Error_NotFound;
+   }
+
+   unsigned nidx = is_mp ? id : id + c->num_mps;
+
+   *level = is_mp ? c->sig[id].level : UINT_MAX;
+   *preorder = c->preorder[nidx];
+   *postorder = c->postorder[nidx];
+
+   return OK;
+}
+
+/* 64-bit FNV-1a */
+#define FNV_OFFSET  UINT64_C(14695981039346656037)
+#define FNV_PRIME   UINT64_C(1099511628211)
+
+static inline uint64_t sig_add(uint64_t h, uint64_t v)
+{
+   for (unsigned i = 0; i < 8; ++i, v >>= 8) {
+      h = (h ^ (v & 0xff)) * FNV_PRIME;
+   }
+
+   return h;
+}
+
+/**
+ * @brief Compute the signature of an MP
+ *
+ * The fingerprint covers the indices of the variables and equations of the MP
+ * and of the variables in each equation, not the coefficients.
+ *
+ * @param      mp   the MP, may be NULL
+ * @param[out] sig  the signature
+ *
+ * @return          the error code
+ */
+static int mp_signature(const MathPrgm *mp, MpSignature *sig)
+{
+   if (!mp) { *sig = (MpSignature){.exists = false}; return OK; }
+
+   *sig = (MpSignature){.exists = true, .hidden = mp_ishidden(mp),
+                        .nvars = mp->vars.len, .nequs = mp->equs.len};
+
+   Model *mdl = mp->mdl;
+   bool mdl_is_rhp_ = mdl_is_rhp(mdl);
+   uint64_t h = FNV_OFFSET;
+
+   h = sig_add(h, (uint64_t)(int64_t)mp_getobjequ(mp));
+   h = sig_add(h, (uint64_t)(int64_t)mp_getobjvar(mp));
+
+   for (unsigned i = 0, len = mp->vars.len; i < len; ++i) {
+      h = sig_add(h, (uint64_t)mp->vars.arr[i]);
+   }
+
+   for (unsigned i = 0, len = mp->equs.len; i < len; ++i) {
+      rhp_idx ei = mp->equs.arr[i];
+      h = sig_add(h, (uint64_t)ei);
+
+      void *iterator = NULL;
+      double jacval;
+      rhp_idx vi;
+      int nlflags;
+
+      do {
+         if (mdl_is_rhp_) {
+            S_CHECK(rctr_walkequ(&mdl->ctr, ei, &iterator, &jacval, &vi, &nlflags));
+         } else {
+            assert(mdl->backend == RhpBackendGamsGmo);
+            S_CHECK(ctr_equ_itervars(&mdl->ctr, ei, &iterator, &jacval, &vi, &nlflags));
+         }
+
+         /* Constant equation */
+         if (!valid_vi(vi)) { break; }
+
+         h = sig_add(h, (uint64_t)vi);
+
+      } while (iterator);
+   }
+
+   sig->fingerprint = h;
+
+   return OK;
+}
+
+/**
+ * @brief Find the nodes to analyze again since the last analysis
+ *
+ * @param dfsdata  the DFS data, after the DFS
+ * @param cache    the results of the last analysis
+ *
+ * @return         the error code
+ */
+NONNULL static
+int analysis_cache_setdirty(EmpDagDfsData *dfsdata, const struct empdag_analysis_cache *cache)
+{
+   const EmpDag *empdag = dfsdata->empdag;
+   const EmpDagCsr *csr = dfsdata->csr;
+   unsigned num_mps = dfsdata->num_mps, num_nodes = dfsdata->num_nodes;
+
+   bool * restrict dirty;
+   MALLOC_(dirty, bool, num_nodes);
+   dfsdata->dirty = dirty;
+
+   /* The signatures are kept for the cache update */
+   MpSignature * restrict sigs;
+   MALLOC_(sigs, MpSignature, MAX(num_mps, 1));
+   dfsdata->sig = sigs;
+
+   for (unsigned i = 0; i < num_mps; ++i) {
+      S_CHECK(mp_signature(empdag->mps.arr[i], &sigs[i]));
+   }
+
+   /* Nodes that are new, whose parents changed or MPs whose content changed */
+   for (unsigned nidx = 0; nidx < num_nodes; ++nidx) {
+      bool is_mp = nidx < num_mps;
+      unsigned id = is_mp ? nidx : nidx - num_mps;
+
+      if (id >= (is_mp ? cache->num_mps : cache->num_nashs)) {
+         dirty[nidx] = true;
+         continue;
+      }
+
+      unsigned nidx_old = is_mp ? id : id + cache->num_mps;
+      unsigned len = csr->rstart[nidx+1] - csr->rstart[nidx];
+      unsigned len_old = cache->rstart[nidx_old+1] - cache->rstart[nidx_old];
+
+      dirty[nidx] = len != len_old ||
+         memcmp(&csr->rarcs[csr->rstart[nidx]], &cache->rarcs[cache->rstart[nidx_old]],
+                len*sizeof(daguid_t));
+
+      if (is_mp && !dirty[nidx]) {
+         const MpSignature *sig = &sigs[id], *sig_old = &cache->sig[id];
+         dirty[nidx] = sig->exists != sig_old->exists || sig->hidden != sig_old->hidden ||
+                       sig->nvars != sig_old->nvars || sig->nequs != sig_old->nequs ||
+                       sig->fingerprint != sig_old->fingerprint;
+      }
+   }
+
+   /* Propagate to the descendants: parents come first in reverse topological order */
+   for (unsigned len = dfsdata->num_visited, i = len-1; i < len; --i) {
+      nidx_t nidx = dfsdata->topo_order[i];
+      if (dirty[nidx]) { continue; }
+
+      for (unsigned j = csr->rstart[nidx], end = csr->rstart[nidx+1]; j < end; ++j) {
+         daguid_t uid = csr->rarcs[j];
+         nidx_t nidx_parent = uidisMP(uid) ? uid2id(uid) : uid2id(uid) + num_mps;
+         if (dirty[nidx_parent]) { dirty[nidx] = true; break; }
+      }
+   }
+
+   /* MPs with a variable owned by an MP to analyze again */
+   for (unsigned i = 0, len = MIN(num_mps, cache->num_mps); i < len; ++i) {
+      if (dirty[i]) { continue; }
+
+      const MpIdArray *refs = &cache->refs[i];
+      for (unsigned j = 0, jlen = refs->len; j < jlen; ++j) {
+         mpid_t mpid = refs->arr[j];
+         if (mpid >= num_mps || dirty[mpid]) { dirty[i] = true; break; }
+      }
+   }
+
+   return OK;
+}
+
+/**
+ * @brief Save the results of a successful analysis
+ *
+ * @param dfsdata  the DFS data
+ * @param cache    the cache to update
+ *
+ * @return         the error code
+ */
+NONNULL static
+int analysis_cache_update(EmpDagDfsData *dfsdata, struct empdag_analysis_cache **cache)
+{
+   const EmpDag *empdag = dfsdata->empdag;
+   const EmpDagCsr *csr = dfsdata->csr;
+   const Container *ctr = &empdag->mdl->ctr;
+   unsigned num_mps = dfsdata->num_mps, num_nodes = dfsdata->num_nodes;
+   unsigned nrarcs = csr->rstart[num_nodes];
+
+   struct empdag_analysis_cache *c = *cache;
+
+   if (!c) {
+      CALLOC_(c, struct empdag_analysis_cache, 1);
+      *cache = c;
+   }
+
+   /* Refs of the MPs not analyzed again are kept */
+   for (unsigned i = num_mps, len = c->num_mps; i < len; ++i) {
+      rhp_uint_empty(&c->refs[i]);
+   }
+
+   REALLOC_(c->refs, MpIdArray, MAX(num_mps, 1));
+   for (unsigned i = c->num_mps; i < num_mps; ++i) {
+      rhp_uint_init(&c->refs[i]);
+   }
+
+   for (unsigned i = 0; i < num_mps; ++i) {
+      if (dfsdata->dirty && !dfsdata->dirty[i] && i < c->num_mps) { continue; }
+
+      rhp_uint_empty(&c->refs[i]);
+      c->refs[i] = dfsdata->mp_refs[i];
+      rhp_uint_init(&dfsdata->mp_refs[i]);
+   }
+
+   REALLOC_(c->rstart, unsigned, num_nodes+1);
+   REALLOC_(c->rarcs, daguid_t, MAX(nrarcs, 1));
+   REALLOC_(c->sig, MpSignature, MAX(num_mps, 1));
+   REALLOC_(c->preorder, unsigned, MAX(num_nodes, 1));
+   REALLOC_(c->postorder, unsigned, MAX(num_nodes, 1));
+
+   memcpy(c->rstart, csr->rstart, (num_nodes+1)*sizeof(unsigned));
+   memcpy(c->rarcs, csr->rarcs, nrarcs*sizeof(daguid_t));
+   memcpy(c->preorder, dfsdata->preorder, num_nodes*sizeof(unsigned));
+   memcpy(c->postorder, dfsdata->postorder, num_nodes*sizeof(unsigned));
+
+   for (unsigned i = 0; i < num_mps; ++i) {
+      MpSignature *sig = &c->sig[i];
+      if (dfsdata->sig) {
+         *sig = dfsdata->sig[i];
+      } else {
+         S_CHECK(mp_signature(empdag->mps.arr[i], sig));
+      }
+      sig->level = sig->exists && !sig->hidden ? dfsdata->mp_ppty[i].level : 0;
+   }
+
+   c->num_mps = num_mps;
+   c->num_nashs = dfsdata->num_nashs;
+   c->total_n = ctr_nvars_total(ctr);
+   c->total_m = ctr_nequs_total(ctr);
+
+   return OK;
+}
+
 int empdag_analysis(EmpDag * restrict empdag)
 {
    int status = OK;
    double start = get_thrdtime();
    EmpDagDfsData dfsdata;
    S_CHECK(dfsdata_init(&dfsdata, empdag));
+   unsigned span = mdl_prof_begin(empdag->mdl, "EMPDAG analysis");
    AnalysisData analysis_data = {0};
 
    /* For now we assume that there is only 1 root, could be multiple ones.
@@ -1694,23 +2062,30 @@ int empdag_analysis(EmpDag * restrict empdag)
                 mdl_fmtargs(empdag->mdl));
 
 
+   DfsEngine dfs;
+   dfs_engine_init(&dfs, &dfs_analysis_ops, &dfsdata, sizeof(DfsAnalysisState));
+
    for (unsigned i = 0, len = empdag->roots.len; i < len; ++i) {
       daguid_t uid = empdag->roots.arr[i], idx = uid2id(uid);
 
-      DfsPathDataFwd pathdata = {.depth = 0, .has_ctrl_edges = false,
-                                 .pathtype = DfsPathUnset,
-                                 .saddle_path_start = UINT_MAX};
+      DfsAnalysisState root = {
+         .kind = uidisMP(uid) ? DfsNodeMpInNashOrRoot : DfsNodeNash,
+         .id = idx,
+         .pathdata = {.depth = 0, .has_ctrl_edges = false,
+                      .pathtype = DfsPathUnset,
+                      .saddle_path_start = UINT_MAX},
+      };
 
-      int rc;
-      if (uidisMP(uid)) {
-         rc = dfs_mpInNashOrRoot(idx, &dfsdata, pathdata);
-      } else {
-         rc = dfs_nash(idx, &dfsdata, pathdata);
-      }
+      int rc = dfs_engine_run(&dfs, &root);
 
-      if (rc != 0) return error_rc(rc);
+      if (rc != 0) {
+         dfs_engine_free(&dfs);
+         return error_rc(rc);
+      }
    }
 
+   dfs_engine_free(&dfs);
+
    /* ---------------------------------------------------------------------
     * If we did not visit all the nodes, report the ones that not connected
     * to the DAG
@@ -1816,7 +2191,26 @@ int empdag_analysis(EmpDag * restrict empdag)
    S_CHECK(analysis_data_init(&analysis_data, &dfsdata));
 
    // HACK
-   if (dfsdata.num_visited_dual > 0) { goto _hack_skip_analysis_dual; }
+   if (dfsdata.num_visited_dual > 0) {
+      empdag_analysis_cache_free(&empdag->analysis_cache);
+      goto _hack_skip_analysis_dual;
+   }
+
+   /* ---------------------------------------------------------------------
+    * If the EMPDAG was analyzed before and the container did not change
+    * size, only the MPs affected by the edits are analyzed again
+    * --------------------------------------------------------------------- */
+
+   const struct empdag_analysis_cache *cache = empdag->analysis_cache;
+   const Container *ctr = &empdag->mdl->ctr;
+
+   if (cache && cache->total_n == ctr_nvars_total(ctr) &&
+       cache->total_m == ctr_nequs_total(ctr)) {
+      status = analysis_cache_setdirty(&dfsdata, cache);
+      if (status != OK) { goto _exit_analysis_loop; }
+   }
+
+   unsigned num_analyzed = 0;
 
    // HACK: num_visited vs num_nodes
    for (unsigned len = dfsdata.num_visited, i = len-1; i < len; --i) {
@@ -1824,8 +2218,14 @@ int empdag_analysis(EmpDag * restrict empdag)
       assert(node_idx < dfsdata.num_nodes);
 
       int rc;
-      if (node_idx < num_mps)  { rc = analyze_mp(&dfsdata, node_idx, &analysis_data); }
-      else { rc = analyze_nash(&dfsdata, node_idx-num_mps, &analysis_data); }
+      if (node_idx < num_mps)  {
+         if (dfsdata.dirty && !dfsdata.dirty[node_idx]) {
+            dfsdata.mp_ppty[node_idx].level = cache->sig[node_idx].level;
+            continue;
+         }
+         num_analyzed++;
+         rc = analyze_mp(&dfsdata, node_idx, &analysis_data);
+      } else { rc = analyze_nash(&dfsdata, node_idx-num_mps, &analysis_data); }
 
       if (rc > 0) { status = rc; goto _exit_analysis_loop; }
       if (rc < 0) { num_issues++; }
@@ -1835,6 +2235,16 @@ int empdag_analysis(EmpDag * restrict empdag)
       goto _exit_analysis_loop;
    }
 
+   if (dfsdata.dirty) {
+      trace_empdag("[empdag/analysis] incremental analysis: %u MPs out of %u analyzed\n",
+                   num_analyzed, num_mps);
+   }
+
+   mdl_prof_additems(empdag->mdl, span, num_analyzed);
+
+   status = analysis_cache_update(&dfsdata, &empdag->analysis_cache);
+   if (status != OK) { goto _exit_analysis_loop; }
+
 _hack_skip_analysis_dual: ;
 
    /* ---------------------------------------------------------------------
@@ -1930,6 +2340,7 @@ _exit_analysis_loop:
       S_CHECK(empdag_export(empdag->mdl));
    }
 
+   mdl_prof_end(empdag->mdl, span);
    simple_timing_add(&empdag->mdl->timings->empdag.analysis, get_thrdtime() - start);
 
    return status;
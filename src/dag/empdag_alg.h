@@ -2,11 +2,20 @@
 #define EMPDAG_ALG_H
 
 #include "compat.h"
+#include "empdag_data.h"
 #include "rhp_fwd.h"
 
 //int empdag_determine_roots(EmpDag *empdag);
 //int empdag_ppty_dfs(EmpDag *empdag);
 
+struct empdag_analysis_cache;
+
 int empdag_analysis(EmpDag *empdag) NONNULL;
+int empdag_analysis_getnode(const EmpDag *empdag, daguid_t uid, unsigned *level,
+                            unsigned *preorder, unsigned *postorder) NONNULL;
+
+void empdag_analysis_cache_free(struct empdag_analysis_cache **cache) NONNULL;
+int empdag_analysis_cache_dup(struct empdag_analysis_cache **dst,
+                              const struct empdag_analysis_cache *src) NONNULL_AT(1);
 
 #endif /* EMPDAG_ALG_H */
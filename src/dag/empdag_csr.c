@@ -0,0 +1,152 @@
+#include <string.h>
+
+#include "empdag.h"
+#include "empdag_csr.h"
+#include "macros.h"
+#include "mdl.h"
+#include "printout.h"
+#include "status.h"
+
+void empdag_csr_init(EmpDagCsr *csr)
+{
+   memset(csr, 0, sizeof(*csr));
+}
+
+void empdag_csr_free(EmpDagCsr *csr)
+{
+   FREE(csr->Cstart);
+   FREE(csr->Carcs);
+   FREE(csr->Vstart);
+   FREE(csr->Varcs);
+   FREE(csr->Nstart);
+   FREE(csr->Narcs);
+   FREE(csr->rstart);
+   FREE(csr->rarcs);
+   csr->valid = false;
+   csr->num_mps = csr->num_nashs = 0;
+}
+
+/**
+ * @brief Copy the adjacency lists of the EMPDAG into flat arrays
+ *
+ * The arrays of csr are reused if they already exist.
+ *
+ * @param csr     the CSR adjacency
+ * @param empdag  the EMPDAG
+ *
+ * @return        the error code
+ */
+int empdag_csr_build(EmpDagCsr *csr, const EmpDag *empdag)
+{
+   const DagMpArray *mps = &empdag->mps;
+   const DagNashArray *nashs = &empdag->nashs;
+   unsigned num_mps = mps->len, num_nashs = nashs->len;
+   unsigned num_nodes = num_mps + num_nashs;
+
+   csr->valid = false;
+
+   unsigned nC = 0, nV = 0, nN = 0, nR = 0;
+   for (unsigned i = 0; i < num_mps; ++i) {
+      nC += mps->Carcs[i].len;
+      nV += mps->Varcs[i].len;
+      nR += mps->rarcs[i].len;
+   }
+   for (unsigned i = 0; i < num_nashs; ++i) {
+      nN += nashs->arcs[i].len;
+      nR += nashs->rarcs[i].len;
+   }
+
+   /* Always allocate something, to have valid pointers */
+   REALLOC_(csr->Cstart, unsigned, num_mps+1);
+   REALLOC_(csr->Vstart, unsigned, num_mps+1);
+   REALLOC_(csr->Nstart, unsigned, num_nashs+1);
+   REALLOC_(csr->rstart, unsigned, num_nodes+1);
+   REALLOC_(csr->Carcs, daguid_t, MAX(nC, 1));
+   REALLOC_(csr->Varcs, Varc, MAX(nV, 1));
+   REALLOC_(csr->Narcs, daguid_t, MAX(nN, 1));
+   REALLOC_(csr->rarcs, daguid_t, MAX(nR, 1));
+
+   unsigned * restrict Cstart = csr->Cstart, * restrict Vstart = csr->Vstart;
+   unsigned * restrict Nstart = csr->Nstart, * restrict rstart = csr->rstart;
+   unsigned posC = 0, posV = 0, posN = 0, posR = 0;
+
+   for (unsigned i = 0; i < num_mps; ++i) {
+      const DagUidArray *Carcs = &mps->Carcs[i], *rarcs = &mps->rarcs[i];
+      const VarcArray *Varcs = &mps->Varcs[i];
+
+      Cstart[i] = posC;
+      if (Carcs->len > 0) {
+         memcpy(&csr->Carcs[posC], Carcs->arr, Carcs->len*sizeof(daguid_t));
+      }
+      posC += Carcs->len;
+
+      Vstart[i] = posV;
+      if (Varcs->len > 0) {
+         memcpy(&csr->Varcs[posV], Varcs->arr, Varcs->len*sizeof(Varc));
+      }
+      posV += Varcs->len;
+
+      rstart[i] = posR;
+      if (rarcs->len > 0) {
+         memcpy(&csr->rarcs[posR], rarcs->arr, rarcs->len*sizeof(daguid_t));
+      }
+      posR += rarcs->len;
+   }
+
+   Cstart[num_mps] = posC;
+   Vstart[num_mps] = posV;
+
+   for (unsigned i = 0; i < num_nashs; ++i) {
+      const DagUidArray *arcs = &nashs->arcs[i], *rarcs = &nashs->rarcs[i];
+
+      Nstart[i] = posN;
+      if (arcs->len > 0) {
+         memcpy(&csr->Narcs[posN], arcs->arr, arcs->len*sizeof(daguid_t));
+      }
+      posN += arcs->len;
+
+      rstart[num_mps+i] = posR;
+      if (rarcs->len > 0) {
+         memcpy(&csr->rarcs[posR], rarcs->arr, rarcs->len*sizeof(daguid_t));
+      }
+      posR += rarcs->len;
+   }
+
+   Nstart[num_nashs] = posN;
+   rstart[num_nodes] = posR;
+
+   csr->num_mps = num_mps;
+   csr->num_nashs = num_nashs;
+   csr->valid = true;
+
+   trace_empdag("[empdag] frozen adjacency of %s model '%.*s' #%u: %u CTRL, %u VF, "
+                "%u Nash arcs\n", mdl_fmtargs(empdag->mdl), nC, nV, nN);
+
+   return OK;
+}
+
+/**
+ * @brief Get the CSR adjacency of an EMPDAG
+ *
+ * If the frozen adjacency of the EMPDAG is not valid, it is rebuilt in place,
+ * reusing its arrays. It is a cache of the arcs, hence this is also done for a
+ * const EMPDAG. The adjacency stays valid until the arcs are modified.
+ *
+ * @param       empdag   the EMPDAG
+ * @param[out]  csr      the CSR adjacency
+ *
+ * @return               the error code
+ */
+int empdag_csr_get(const EmpDag *empdag, const EmpDagCsr **csr)
+{
+   EmpDagCsr *csr_dag = (EmpDagCsr *)&empdag->csr;
+
+   if (!csr_dag->valid || csr_dag->num_mps != empdag->mps.len ||
+       csr_dag->num_nashs != empdag->nashs.len) {
+      S_CHECK(empdag_csr_build(csr_dag, empdag));
+   }
+
+   *csr = csr_dag;
+
+   return OK;
+}
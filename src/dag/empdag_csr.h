@@ -0,0 +1,93 @@
+#ifndef EMPDAG_CSR_H
+#define EMPDAG_CSR_H
+
+#include <assert.h>
+#include <stdbool.h>
+
+#include "compat.h"
+#include "empdag_data.h"
+#include "rhp_fwd.h"
+
+/** @file empdag_csr.h
+ *
+ *  @brief Frozen adjacency of the EMPDAG in compressed sparse row format
+ *
+ *  The arcs of the EMPDAG are stored per node, each list in its own
+ *  allocation. Once the EMPDAG is finalized, they are copied into flat arrays:
+ *  the arcs of node i are arcs[start[i]] to arcs[start[i+1]-1]. The VF arc
+ *  payloads are shallow copies of the ones in the EMPDAG.
+ *
+ *  The frozen adjacency is invalidated by any modification of the arcs, and
+ *  rebuilt in place on its next use.
+ */
+
+struct empdag;
+
+typedef struct empdag_csr {
+   bool valid;              /**< True if the arrays match the EMPDAG          */
+   unsigned num_mps;        /**< Number of MPs                               */
+   unsigned num_nashs;      /**< Number of Nash nodes                        */
+   unsigned *Cstart;        /**< Start of the CTRL arcs of each MP            */
+   daguid_t *Carcs;         /**< CTRL arcs (children)                         */
+   unsigned *Vstart;        /**< Start of the VF arcs of each MP              */
+   Varc *Varcs;             /**< VF arcs, with their payload                  */
+   unsigned *Nstart;        /**< Start of the arcs of each Nash node          */
+   daguid_t *Narcs;         /**< Nash arcs (children)                         */
+   unsigned *rstart;        /**< Start of the reverse arcs of each node       */
+   daguid_t *rarcs;         /**< Reverse arcs (parents), MPs then Nash nodes  */
+} EmpDagCsr;
+
+void empdag_csr_init(EmpDagCsr *csr) NONNULL;
+void empdag_csr_free(EmpDagCsr *csr) NONNULL;
+int empdag_csr_build(EmpDagCsr *csr, const struct empdag *empdag) NONNULL;
+
+int empdag_csr_get(const struct empdag *empdag, const EmpDagCsr **csr) NONNULL;
+
+/** @brief Mark the adjacency as stale, after an in-place change of the arcs */
+static inline void empdag_csr_invalidate(EmpDagCsr *csr)
+{
+   csr->valid = false;
+}
+
+static inline const daguid_t *empdag_csr_Carcs(const EmpDagCsr *csr, mpid_t mpid,
+                                               unsigned *len)
+{
+   assert(mpid < csr->num_mps);
+   *len = csr->Cstart[mpid+1] - csr->Cstart[mpid];
+   return &csr->Carcs[csr->Cstart[mpid]];
+}
+
+static inline const Varc *empdag_csr_Varcs(const EmpDagCsr *csr, mpid_t mpid,
+                                           unsigned *len)
+{
+   assert(mpid < csr->num_mps);
+   *len = csr->Vstart[mpid+1] - csr->Vstart[mpid];
+   return &csr->Varcs[csr->Vstart[mpid]];
+}
+
+static inline const daguid_t *empdag_csr_nasharcs(const EmpDagCsr *csr, nashid_t nashid,
+                                                  unsigned *len)
+{
+   assert(nashid < csr->num_nashs);
+   *len = csr->Nstart[nashid+1] - csr->Nstart[nashid];
+   return &csr->Narcs[csr->Nstart[nashid]];
+}
+
+static inline const daguid_t *empdag_csr_mprarcs(const EmpDagCsr *csr, mpid_t mpid,
+                                                 unsigned *len)
+{
+   assert(mpid < csr->num_mps);
+   *len = csr->rstart[mpid+1] - csr->rstart[mpid];
+   return &csr->rarcs[csr->rstart[mpid]];
+}
+
+static inline const daguid_t *empdag_csr_nashrarcs(const EmpDagCsr *csr, nashid_t nashid,
+                                                   unsigned *len)
+{
+   assert(nashid < csr->num_nashs);
+   unsigned nidx = csr->num_mps + nashid;
+   *len = csr->rstart[nidx+1] - csr->rstart[nidx];
+   return &csr->rarcs[csr->rstart[nidx]];
+}
+
+#endif /* EMPDAG_CSR_H */
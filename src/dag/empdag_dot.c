@@ -100,26 +100,28 @@ static int arcVF_basic_arcdat(const ArcVFBasicData *dat, const MathPrgm *mp,
    return OK;
 }
 
-static int print_mp_arcs(const EmpDag* empdag, FILE* f)
+static int print_mp_arcs(const EmpDag* empdag, const EmpDagCsr *csr, FILE* f)
 {
    const struct mp_namedarray* mps = &empdag->mps;
 
    for (unsigned i = 0, len = mps->len; i < len; ++i) {
       const MathPrgm *mp = mps->arr[i];
+      unsigned clen, vlen;
+      const daguid_t *Carcs = empdag_csr_Carcs(csr, i, &clen);
+      const Varc *Varcs = empdag_csr_Varcs(csr, i, &vlen);
 
-      if (!mp || (mps->Carcs[i].len == 0 && mps->Varcs[i].len == 0)) continue;
+      if (!mp || (clen == 0 && vlen == 0)) continue;
 
       /* Poor man's detection of truly hidden MPs */
       if (mp_ishidden(mp) && !mp_ishidable(mp)) {
          continue;
       }
 
-      const UIntArray *Carcs = &mps->Carcs[i];
       mpid_t mpid = mp->id;
 
-      for (unsigned j = 0, clen = Carcs->len; j < clen; ++j) {
+      for (unsigned j = 0; j < clen; ++j) {
 
-         daguid_t uid = Carcs->arr[j];
+         daguid_t uid = Carcs[j];
          bool isMP = uidisMP(uid);
          unsigned id = uid2id(uid);
  
@@ -128,11 +130,9 @@ static int print_mp_arcs(const EmpDag* empdag, FILE* f)
                           arcstyle_CTRL));
       }
 
-      const VarcArray *Varcs = &mps->Varcs[i];
+      for (unsigned j = 0; j < vlen; ++j) {
 
-      for (unsigned j = 0, vlen = Varcs->len; j < vlen; ++j) {
-
-         const struct rhp_empdag_arcVF* arcVF = &Varcs->arr[j];
+         const struct rhp_empdag_arcVF* arcVF = &Varcs[j];
          unsigned mpid_child = arcVF->mpid_child;
          const char *labelcolor;
 
@@ -173,18 +173,20 @@ static int print_mp_arcs(const EmpDag* empdag, FILE* f)
    return OK;
 }
 
-static int print_nash_arcs(const struct nash_namedarray* mpes, FILE* f)
+static int print_nash_arcs(const struct nash_namedarray* mpes, const EmpDagCsr *csr,
+                           FILE* f)
 {
    for (unsigned i = 0, len = mpes->len; i < len; ++i) {
-      if (mpes->arcs[i].len == 0) continue;
+      unsigned alen;
+      const daguid_t *arcs = empdag_csr_nasharcs(csr, i, &alen);
+      if (alen == 0) continue;
 
-      const UIntArray *arcs = &mpes->arcs[i];
       unsigned mpe_id = mpes->arr[i]->id;
 
 
-      for (unsigned j = 0, alen = arcs->len; j < alen; ++j) {
+      for (unsigned j = 0; j < alen; ++j) {
 
-         unsigned uid = arcs->arr[j];
+         unsigned uid = arcs[j];
          bool isMP = uidisMP(uid);
          assert(isMP);
          unsigned id = uid2id(uid);
@@ -321,8 +323,11 @@ int empdag2dot(const EmpDag *empdag, FILE *f)
    S_CHECK(print_mp_nodes(&empdag->mps, f, &empdag->mdl->ctr));
    S_CHECK(print_nash_nodes(&empdag->nashs, f, &empdag->mdl->ctr));
 
-   S_CHECK(print_mp_arcs(empdag, f));
-   S_CHECK(print_nash_arcs(&empdag->nashs, f));
+   const EmpDagCsr *csr;
+   S_CHECK(empdag_csr_get(empdag, &csr));
+
+   S_CHECK(print_mp_arcs(empdag, csr, f));
+   S_CHECK(print_nash_arcs(&empdag->nashs, csr, f));
 
    IO_PRINT(fputs("\n}\n", f));
    IO_CALL(fflush(f));
@@ -0,0 +1,155 @@
+#include <string.h>
+
+#include "empdag_lca.h"
+#include "macros.h"
+#include "status.h"
+
+void lca_index_init(LcaIndex *idx)
+{
+   memset(idx, 0, sizeof(*idx));
+   idx->log = 1;
+}
+
+void lca_index_free(LcaIndex *idx)
+{
+   FREE(idx->depth);
+   FREE(idx->top);
+   FREE(idx->up);
+   lca_index_init(idx);
+}
+
+/**
+ * @brief Build the binary lifting tables of a forest
+ *
+ * @param idx        the index
+ * @param num_nodes  the number of nodes
+ * @param parent     the parent of each node, a top being its own parent. The
+ *                   index takes ownership of this array, and modifies it to cut
+ *                   the loops.
+ *
+ * @return           the error code
+ */
+int lca_index_build(LcaIndex *idx, unsigned num_nodes, unsigned *parent)
+{
+   int status = OK;
+   unsigned *stack = NULL;
+
+   lca_index_free(idx);
+   idx->num_nodes = num_nodes;
+   idx->up = parent;
+
+   if (num_nodes == 0) { return OK; }
+
+   const unsigned depth_unset = UINT_MAX, depth_onstack = UINT_MAX-1;
+   MALLOC_EXIT(idx->depth, unsigned, num_nodes);
+   MALLOC_EXIT(idx->top, unsigned, num_nodes);
+   MALLOC_EXIT(stack, unsigned, num_nodes);
+
+   unsigned * restrict depth = idx->depth, * restrict top = idx->top;
+   unsigned max_depth = 0;
+
+   for (unsigned i = 0; i < num_nodes; ++i) {
+      assert(parent[i] < num_nodes);
+      depth[i] = depth_unset;
+   }
+
+   for (unsigned i = 0; i < num_nodes; ++i) {
+      if (depth[i] != depth_unset) { continue; }
+
+      /* Climb until a node with a known depth or a top is reached */
+      unsigned len = 0, n = i;
+      while (depth[n] == depth_unset) {
+         depth[n] = depth_onstack;
+         stack[len++] = n;
+         if (parent[n] == n) { break; }
+         n = parent[n];
+      }
+
+      unsigned d, t;
+      unsigned last = stack[--len];
+      if (depth[n] == depth_onstack) {
+         /* Either a top or a loop: the last node becomes a top */
+         parent[last] = last;
+         d = 0;
+         t = last;
+      } else {
+         d = depth[n] + 1;
+         t = top[n];
+      }
+
+      depth[last] = d;
+      top[last] = t;
+
+      while (len > 0) {
+         unsigned m = stack[--len];
+         depth[m] = ++d;
+         top[m] = t;
+      }
+
+      max_depth = MAX(max_depth, d);
+   }
+
+   unsigned log = 1;
+   while ((1U << log) <= max_depth && log < 31) { log++; }
+   idx->log = log;
+
+   REALLOC_EXIT(idx->up, unsigned, (size_t)log*num_nodes);
+   unsigned *up = idx->up;
+
+   for (unsigned k = 1; k < log; ++k) {
+      const unsigned * restrict prev = &up[(size_t)(k-1)*num_nodes];
+      unsigned * restrict cur = &up[(size_t)k*num_nodes];
+      for (unsigned i = 0; i < num_nodes; ++i) {
+         cur[i] = prev[prev[i]];
+      }
+   }
+
+_exit:
+   FREE(stack);
+
+   return status;
+}
+
+/**
+ * @brief Get the lowest common ancestor of two nodes
+ *
+ * The deepest node is lifted to the depth of the other one, then both nodes
+ * are lifted as long as their ancestors differ. See
+ * https://cp-algorithms.com/graph/lca_binary_lifting.html#implementation
+ *
+ * @param idx  the index
+ * @param u    the first node
+ * @param v    the second node
+ *
+ * @return     the lowest common ancestor, or LCA_NONE if the nodes are in
+ *             different trees
+ */
+unsigned lca_index_query(const LcaIndex *idx, unsigned u, unsigned v)
+{
+   const unsigned * restrict depth = idx->depth;
+   const unsigned * restrict up = idx->up;
+   unsigned num_nodes = idx->num_nodes;
+
+   assert(u < num_nodes && v < num_nodes);
+
+   if (idx->top[u] != idx->top[v]) { return LCA_NONE; }
+
+   if (depth[u] < depth[v]) { unsigned tmp = u; u = v; v = tmp; }
+
+   unsigned diff = depth[u] - depth[v];
+   for (unsigned k = 0; diff > 0; ++k, diff >>= 1) {
+      if (diff & 1) { u = up[(size_t)k*num_nodes + u]; }
+   }
+
+   if (u == v) { return u; }
+
+   for (unsigned k = idx->log; k-- > 0;) {
+      const unsigned *upk = &up[(size_t)k*num_nodes];
+      if (upk[u] != upk[v]) {
+         u = upk[u];
+         v = upk[v];
+      }
+   }
+
+   return up[u];
+}
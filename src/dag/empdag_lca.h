@@ -0,0 +1,46 @@
+#ifndef EMPDAG_LCA_H
+#define EMPDAG_LCA_H
+
+#include <assert.h>
+#include <limits.h>
+
+#include "compat.h"
+
+/** @file empdag_lca.h
+ *
+ *  @brief Lowest common ancestor queries on a forest, by binary lifting
+ *
+ *  The forest is given by the parent of each node, a top being its own parent.
+ *  A parent chain that loops is cut: the last node reached before the loop
+ *  closes becomes a top. Each query runs in O(log depth).
+ */
+
+/** No common ancestor: the nodes are in different trees */
+#define LCA_NONE  UINT_MAX
+
+typedef struct lca_index {
+   unsigned num_nodes;      /**< Number of nodes                               */
+   unsigned log;            /**< Number of levels in up                        */
+   unsigned *depth;         /**< Depth of each node in its tree                */
+   unsigned *top;           /**< Top node of the tree of each node             */
+   unsigned *up;            /**< up[k*num_nodes+n] is the 2^k-th ancestor of n */
+} LcaIndex;
+
+void lca_index_init(LcaIndex *idx) NONNULL;
+void lca_index_free(LcaIndex *idx) NONNULL;
+int lca_index_build(LcaIndex *idx, unsigned num_nodes, unsigned *parent) NONNULL;
+unsigned lca_index_query(const LcaIndex *idx, unsigned u, unsigned v) NONNULL;
+
+static inline unsigned lca_index_top(const LcaIndex *idx, unsigned u)
+{
+   assert(u < idx->num_nodes);
+   return idx->top[u];
+}
+
+static inline unsigned lca_index_depth(const LcaIndex *idx, unsigned u)
+{
+   assert(u < idx->num_nodes);
+   return idx->depth[u];
+}
+
+#endif /* EMPDAG_LCA_H */
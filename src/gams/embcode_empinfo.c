@@ -294,8 +294,8 @@ static int emb_read_param(Interpreter *interp, unsigned *p, IdentData *data,
    return OK;
 }
 
-static int emb_read_elt_vector(Interpreter *interp, const char *identstr,
-                               IdentData *ident, GmsIndicesData *gmsindices, double *val)
+static int emb_read_elt_vector(Interpreter *interp, IdentData *ident,
+                               GmsIndicesData *gmsindices, double *val)
 {
    return OK;
 }
@@ -1,9 +1,21 @@
+#include "reshop_config.h"
+
 #include <stdarg.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define RHP_EMPINFO_MMAP
+#endif
+
 #include "compat.h"
 #include "ctrdat_gams.h"
 #include "empinfo.h"
 #include "empinterp.h"
+#include "empinterp_cache.h"
 #include "empinterp_linkresolver.h"
 #include "empinterp_priv.h"
 #include "empinterp_vm_compiler.h"
@@ -14,6 +26,7 @@
 #include "mathprgm.h"
 #include "mdl.h"
 #include "mdl_gams.h"
+#include "rhp_options.h"
 
 #include "dctmcc.h"
 #include "gmdcc.h"
@@ -63,6 +76,7 @@ void empinterp_init(Interpreter *interp, Model *mdl, const char *fname)
    interp->linestart = NULL;
    interp->linestart_old = NULL;
    interp->buf = NULL;
+   interp->buf_maplen = 0;
    // HACK UNUSED?
    interp->tmpstr = NULL;
    interp->empinfo_fname = fname;
@@ -107,6 +121,7 @@ void empinterp_init(Interpreter *interp, Model *mdl, const char *fname)
    gdxreaders_init(&interp->gdx_readers);
    namedints_init(&interp->globals.sets);
    multisets_init(&interp->globals.multisets);
+   params_init(&interp->globals.params);
    aliases_init(&interp->globals.aliases);
    namedscalar_init(&interp->globals.scalars);
    namedvec_init(&interp->globals.vectors);
@@ -143,7 +158,7 @@ NONNULL void empinterp_free(Interpreter *interp)
    }
 #endif
 
-   FREE(interp->buf);
+   interp_free_empinfo(interp);
    empvm_compiler_free(interp->compiler);
 
    for (unsigned i = 0, len = interp->gdx_readers.len; i < len; ++i) {
@@ -175,6 +190,7 @@ NONNULL void empinterp_free(Interpreter *interp)
    aliases_free(&interp->globals.aliases);
    namedints_freeall(&interp->globals.sets);
    multisets_free(&interp->globals.multisets);
+   params_free(&interp->globals.params);
 
    namedscalar_free(&interp->globals.scalars);
    namedints_free(&interp->globals.localsets);
@@ -197,9 +213,83 @@ NONNULL void empinterp_free(Interpreter *interp)
 
 }
 
+#ifdef RHP_EMPINFO_MMAP
+
+/* ---------------------------------------------------------------------
+ * The file is mapped over an anonymous mapping that is at least one byte
+ * larger. The bytes past the end of the file are zero, which provides the
+ * NUL terminator expected by the parser without copying the file. The mapping
+ * is private: the file must not be truncated while it is being parsed.
+ * --------------------------------------------------------------------- */
+
+static int interp_map_empinfo(Interpreter *interp, const char *fname)
+{
+   int status = OK;
+   int fd = open(fname, O_RDONLY);
+   if (fd < 0) { return Error_FileOpenFailed; }
+
+   struct stat st;
+   if (fstat(fd, &st) || !S_ISREG(st.st_mode)) {
+      status = Error_SystemError;
+      goto _exit;
+   }
+
+   size_t size = (size_t)st.st_size;
+   size_t pagesize = (size_t)sysconf(_SC_PAGESIZE);
+   size_t maplen = (size / pagesize + 1) * pagesize;
+
+   void *base = mmap(NULL, maplen, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+   if (base == MAP_FAILED) {
+      status = Error_SystemError;
+      goto _exit;
+   }
+
+   if (size > 0 && mmap(base, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+                        fd, 0) == MAP_FAILED) {
+      munmap(base, maplen);
+      status = Error_SystemError;
+      goto _exit;
+   }
+
+#ifdef MADV_SEQUENTIAL
+   madvise(base, maplen, MADV_SEQUENTIAL);
+#endif
+
+   interp->buf = base;
+   interp->buf_maplen = maplen;
+   interp->read = size;
+   interp->linestart = interp->buf;
+
+   trace_empinterp("[empinterp] mapped %zu bytes of empinfo file '%s'\n", size, fname);
+
+_exit:
+   close(fd);
+
+   return status;
+}
+
+#endif
+
+void interp_free_empinfo(Interpreter *interp)
+{
+#ifdef RHP_EMPINFO_MMAP
+   if (interp->buf_maplen > 0) {
+      munmap(interp->buf, interp->buf_maplen);
+      interp->buf = NULL;
+      interp->buf_maplen = 0;
+      return;
+   }
+#endif
+
+   FREE(interp->buf);
+}
+
 /**
  * @brief Read the empinfo file
  *
+ * When possible, the file is memory-mapped rather than copied. The tokens are
+ * views into this buffer.
+ *
  * @param interp the empinfo interpreter
  *
  * @return       the error code
@@ -211,6 +301,12 @@ int interp_read_empinfo(Interpreter *interp)
 
    const char *fname = interp->empinfo_fname;
 
+#ifdef RHP_EMPINFO_MMAP
+   if (interp_map_empinfo(interp, fname) == OK) { return OK; }
+
+   trace_empinterp("[empinterp] could not map empinfo file '%s', reading it\n", fname);
+#endif
+
    FILE *fptr = fopen(fname, RHP_READ_TEXT);
 
    if (!fptr) {
@@ -463,8 +559,27 @@ int empinterp_process(Model *mdl, const char *empinfo_fname, const char *gmd_fna
       interp.gmd_fromgdx = true;
       interp.gmd_own = true;
 
-      S_CHECK_EXIT(interp_loadgmdsets(&interp));
-      S_CHECK_EXIT(interp_loadgmdparams(&interp));
+      /* The global table only depends on the GMD: try the cache first */
+      EmpInterpCache cache;
+      bool cached;
+      char *cachedir = optvals(mdl, Options_EMPInfo_CacheDir);
+      if (!cachedir) { status = Error_InsufficientMemory; goto _exit; }
+
+      empcache_init(&cache, cachedir, gmd_fname);
+      free(cachedir);
+
+      status = empcache_load(&cache, &interp, &cached);
+
+      if (status == OK && !cached) {
+         status = interp_loadgmdsets(&interp);
+         if (status == OK) { status = interp_loadgmdparams(&interp); }
+
+         /* Failing to write the cache is not fatal */
+         if (status == OK) { empcache_save(&cache, &interp); }
+      }
+
+      empcache_free(&cache);
+      if (status != OK) { goto _exit; }
    }
 
 #ifdef RHP_EXPERIMENTAL 
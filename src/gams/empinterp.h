@@ -171,8 +171,9 @@ typedef struct AliasArray {
 #include "namedlist_generic.inc"
 
 typedef struct gdxparam {
-   int idx;
-   int dim;
+   int idx;                       /**< 1-based index in GDX file                 */
+   int dim;                       /**< Symbol dimension                          */
+   struct gdx_reader *gdxreader;  /**< struct where this parameter has been found */
 } GdxParam;
 
 typedef struct ParamArray {
@@ -186,7 +187,7 @@ typedef struct ParamArray {
 #define RHP_LIST_PREFIX params
 #define RHP_LIST_TYPE ParamArray
 #define RHP_ELT_TYPE struct gdxparam
-#define RHP_ELT_INVALID ((struct gdxparam) {.idx = -1, .dim = -1})
+#define RHP_ELT_INVALID ((struct gdxparam) {.idx = -1, .dim = -1, .gdxreader = NULL})
 #include "namedlist_generic.inc"
 
 typedef struct {
@@ -409,6 +410,7 @@ typedef struct interpreter {
    const char *linestart;
    const char *linestart_old;
    char *buf;
+   size_t buf_maplen;            /**< Length of the mapping of buf, 0 if allocated */
    char *tmpstr;
    const char *empinfo_fname;
    unsigned tmpstrlen;
@@ -510,9 +512,8 @@ typedef struct interp_ops {
    const char *(*ovf_getname)   (Interpreter* restrict interp, void *ovfdef_data);
 
 
-   int (*read_elt_vector)(Interpreter *interp, const char *vectorname,
-                          IdentData *ident, GmsIndicesData *gmsindices,
-                          double *val);
+   int (*read_elt_vector)(Interpreter *interp, IdentData *ident,
+                          GmsIndicesData *gmsindices, double *val);
    int (*read_gms_symbol)(Interpreter* restrict interp, unsigned *p); 
    int (*read_param)(Interpreter *interp, unsigned *p, IdentData *data,
                       unsigned *param_gidx);
@@ -0,0 +1,484 @@
+#include "reshop_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <process.h>
+#define rhp_getpid _getpid
+#else
+#include <unistd.h>
+#define rhp_getpid getpid
+#endif
+
+#include "asprintf.h"
+#include "empinterp.h"
+#include "empinterp_cache.h"
+#include "lequ.h"
+#include "macros.h"
+#include "printout.h"
+#include "status.h"
+
+/* ---------------------------------------------------------------------
+ * The cache file consists of a header followed by the payload. All values
+ * are in the native byte order, which is recorded in the header.
+ *
+ * Payload:
+ *   u32 nsets,    then for each: name, u32 len, i32 uels[len]
+ *   u32 nscalars, then for each: name, f64 value
+ *   u32 nvectors, then for each: name, u32 len, i32 uels[len], f64 vals[len]
+ *
+ * A name is stored as a u32 length followed by its characters.
+ * --------------------------------------------------------------------- */
+
+#define EMPCACHE_MAGIC      "RHPEMPC"
+#define EMPCACHE_VERSION    1
+#define EMPCACHE_BYTEORDER  0x01020304u
+
+typedef struct {
+   char magic[8];
+   uint32_t version;
+   uint32_t byteorder;
+   uint64_t key;
+   uint64_t payload_size;
+   uint64_t payload_hash;
+} EmpCacheHeader;
+
+typedef struct {
+   size_t len;
+   size_t max;
+   uint8_t *data;
+} EmpCacheBuf;
+
+typedef struct {
+   const uint8_t *data;
+   size_t len;
+   size_t pos;
+} EmpCacheReader;
+
+/* 64-bit FNV-1a */
+#define FNV_OFFSET  UINT64_C(14695981039346656037)
+#define FNV_PRIME   UINT64_C(1099511628211)
+
+static uint64_t hash_bytes(uint64_t h, const uint8_t *data, size_t len)
+{
+   for (size_t i = 0; i < len; ++i) {
+      h = (h ^ data[i]) * FNV_PRIME;
+   }
+
+   return h;
+}
+
+static int hash_file(const char *fname, uint64_t *key)
+{
+   FILE *f = fopen(fname, "rb");
+   if (!f) { return Error_FileOpenFailed; }
+
+   uint8_t chunk[1 << 16];
+   uint64_t h = hash_bytes(FNV_OFFSET, (const uint8_t *)EMPCACHE_MAGIC, sizeof(EMPCACHE_MAGIC));
+   uint32_t version = EMPCACHE_VERSION;
+   h = hash_bytes(h, (const uint8_t *)&version, sizeof(version));
+
+   /* FNV-1a is bound by the latency of the multiplication: the file is hashed
+    * in 4 interleaved lanes, which are then folded into the key */
+   uint64_t lanes[4] = {h, h, h, h};
+   size_t nread, offset = 0;
+
+   while ((nread = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+      size_t i = 0;
+
+      for (; i < nread && ((offset + i) & 3); ++i) {
+         lanes[(offset + i) & 3] = (lanes[(offset + i) & 3] ^ chunk[i]) * FNV_PRIME;
+      }
+
+      for (; i + 4 <= nread; i += 4) {
+         lanes[0] = (lanes[0] ^ chunk[i]) * FNV_PRIME;
+         lanes[1] = (lanes[1] ^ chunk[i+1]) * FNV_PRIME;
+         lanes[2] = (lanes[2] ^ chunk[i+2]) * FNV_PRIME;
+         lanes[3] = (lanes[3] ^ chunk[i+3]) * FNV_PRIME;
+      }
+
+      for (; i < nread; ++i) {
+         lanes[(offset + i) & 3] = (lanes[(offset + i) & 3] ^ chunk[i]) * FNV_PRIME;
+      }
+
+      offset += nread;
+   }
+
+   int status = ferror(f) ? Error_SystemError : OK;
+   fclose(f);
+
+   *key = hash_bytes(h, (const uint8_t *)lanes, sizeof(lanes));
+
+   return status;
+}
+
+/**
+ * @brief Initialize the cache entry for a GMD file
+ *
+ * If the cache directory is empty or the GMD file cannot be read, the cache is
+ * disabled and the other functions do nothing.
+ *
+ * @param cache      the cache entry
+ * @param cachedir   the cache directory, from the empinfo_cachedir option
+ * @param gmd_fname  the GMD filename
+ */
+void empcache_init(EmpInterpCache *cache, const char *cachedir, const char *gmd_fname)
+{
+   cache->fname = NULL;
+   cache->key = 0;
+
+   if (cachedir[0] == '\0') { return; }
+
+   if (hash_file(gmd_fname, &cache->key) != OK) {
+      trace_empinterp("[empcache] could not hash '%s', the cache is disabled\n", gmd_fname);
+      return;
+   }
+
+   if (asprintf(&cache->fname, "%s" DIRSEP "empinfo_%016llx.rhpc", cachedir,
+                (unsigned long long)cache->key) < 0) {
+      cache->fname = NULL;
+   }
+}
+
+void empcache_free(EmpInterpCache *cache)
+{
+   FREE(cache->fname);
+}
+
+static int buf_put(EmpCacheBuf *buf, const void *data, size_t len)
+{
+   if (buf->len + len > buf->max) {
+      buf->max = MAX(2*buf->max, buf->len + len);
+      REALLOC_(buf->data, uint8_t, buf->max);
+   }
+
+   memcpy(&buf->data[buf->len], data, len);
+   buf->len += len;
+
+   return OK;
+}
+
+static int buf_putu32(EmpCacheBuf *buf, size_t val)
+{
+   if (val > UINT32_MAX) {
+      error("[empcache] ERROR: value %zu is too large for the cache\n", val);
+      return Error_SizeTooLarge;
+   }
+
+   uint32_t v = (uint32_t)val;
+   return buf_put(buf, &v, sizeof(v));
+}
+
+static int buf_putname(EmpCacheBuf *buf, const char *name)
+{
+   size_t len = strlen(name);
+   S_CHECK(buf_putu32(buf, len));
+   return buf_put(buf, name, len);
+}
+
+static int buf_putints(EmpCacheBuf *buf, const int *arr, unsigned len)
+{
+   for (unsigned i = 0; i < len; ++i) {
+      int32_t v = arr[i];
+      S_CHECK(buf_put(buf, &v, sizeof(v)));
+   }
+
+   return OK;
+}
+
+static int serialize_globals(EmpCacheBuf *buf, const CompilerGlobals *globals)
+{
+   const NamedIntsArray *sets = &globals->sets;
+   S_CHECK(buf_putu32(buf, sets->len));
+   for (unsigned i = 0, len = sets->len; i < len; ++i) {
+      S_CHECK(buf_putname(buf, sets->names[i]));
+      S_CHECK(buf_putu32(buf, sets->list[i].len));
+      S_CHECK(buf_putints(buf, sets->list[i].arr, sets->list[i].len));
+   }
+
+   const NamedScalarArray *scalars = &globals->scalars;
+   S_CHECK(buf_putu32(buf, scalars->len));
+   for (unsigned i = 0, len = scalars->len; i < len; ++i) {
+      S_CHECK(buf_putname(buf, scalars->names[i]));
+      S_CHECK(buf_put(buf, &scalars->list[i], sizeof(double)));
+   }
+
+   const NamedVecArray *vectors = &globals->vectors;
+   S_CHECK(buf_putu32(buf, vectors->len));
+   for (unsigned i = 0, len = vectors->len; i < len; ++i) {
+      const Lequ *v = &vectors->list[i];
+      S_CHECK(buf_putname(buf, vectors->names[i]));
+      S_CHECK(buf_putu32(buf, v->len));
+      S_CHECK(buf_putints(buf, v->vis, v->len));
+      if (v->len > 0) {
+         S_CHECK(buf_put(buf, v->coeffs, v->len * sizeof(double)));
+      }
+   }
+
+   return OK;
+}
+
+static bool rd_get(EmpCacheReader *rd, void *data, size_t len)
+{
+   if (len > rd->len - rd->pos) { return false; }
+
+   memcpy(data, &rd->data[rd->pos], len);
+   rd->pos += len;
+
+   return true;
+}
+
+static bool rd_getu32(EmpCacheReader *rd, uint32_t *val)
+{
+   return rd_get(rd, val, sizeof(*val));
+}
+
+static bool rd_getname(EmpCacheReader *rd, const char **name, uint32_t *len)
+{
+   if (!rd_getu32(rd, len) || *len > rd->len - rd->pos) { return false; }
+
+   *name = (const char *)&rd->data[rd->pos];
+   rd->pos += *len;
+
+   return true;
+}
+
+static bool rd_getints(EmpCacheReader *rd, int *arr, uint32_t len)
+{
+   for (uint32_t i = 0; i < len; ++i) {
+      int32_t v;
+      if (!rd_get(rd, &v, sizeof(v))) { return false; }
+      if (arr) { arr[i] = v; }
+   }
+
+   return true;
+}
+
+static bool rd_skip(EmpCacheReader *rd, uint64_t len)
+{
+   if (len > rd->len - rd->pos) { return false; }
+
+   rd->pos += len;
+
+   return true;
+}
+
+/* Check the structure of the payload, without allocating anything */
+static bool payload_valid(const uint8_t *data, size_t len)
+{
+   EmpCacheReader rd = {.data = data, .len = len, .pos = 0};
+   const char *name = NULL;
+   uint32_t n = 0, namelen = 0, elen = 0;
+
+   if (!rd_getu32(&rd, &n)) { return false; }
+   for (uint32_t i = 0; i < n; ++i) {
+      if (!rd_getname(&rd, &name, &namelen) || !rd_getu32(&rd, &elen) ||
+          !rd_skip(&rd, (uint64_t)elen * sizeof(int32_t))) { return false; }
+   }
+
+   if (!rd_getu32(&rd, &n)) { return false; }
+   for (uint32_t i = 0; i < n; ++i) {
+      if (!rd_getname(&rd, &name, &namelen) || !rd_skip(&rd, sizeof(double))) { return false; }
+   }
+
+   if (!rd_getu32(&rd, &n)) { return false; }
+   for (uint32_t i = 0; i < n; ++i) {
+      if (!rd_getname(&rd, &name, &namelen) || !rd_getu32(&rd, &elen) ||
+          !rd_skip(&rd, (uint64_t)elen * (sizeof(int32_t) + sizeof(double)))) { return false; }
+   }
+
+   return rd.pos == rd.len;
+}
+
+static char *dupname(const char *name, uint32_t len)
+{
+   char *str;
+   MALLOC_NULL(str, char, (size_t)len + 1);
+   memcpy(str, name, len);
+   str[len] = '\0';
+
+   return str;
+}
+
+/* Fill the global table from a payload validated by payload_valid() */
+static int deserialize_globals(const uint8_t *data, size_t len, CompilerGlobals *globals)
+{
+   EmpCacheReader rd = {.data = data, .len = len, .pos = 0};
+   const char *name = NULL;
+   char *namestr;
+   uint32_t n = 0, namelen = 0, elen = 0;
+
+   rd_getu32(&rd, &n);
+   for (uint32_t i = 0; i < n; ++i) {
+      rd_getname(&rd, &name, &namelen);
+      rd_getu32(&rd, &elen);
+
+      IntArray set;
+      rhp_int_init(&set);
+      if (elen > 0) { S_CHECK(rhp_int_reserve(&set, elen)); }
+      rd_getints(&rd, set.arr, elen);
+      set.len = elen;
+
+      A_CHECK(namestr, dupname(name, namelen));
+      S_CHECK(namedints_add(&globals->sets, set, namestr));
+   }
+
+   rd_getu32(&rd, &n);
+   for (uint32_t i = 0; i < n; ++i) {
+      double val;
+      rd_getname(&rd, &name, &namelen);
+      rd_get(&rd, &val, sizeof(val));
+
+      A_CHECK(namestr, dupname(name, namelen));
+      S_CHECK(namedscalar_add(&globals->scalars, val, namestr));
+   }
+
+   rd_getu32(&rd, &n);
+   for (uint32_t i = 0; i < n; ++i) {
+      rd_getname(&rd, &name, &namelen);
+      rd_getu32(&rd, &elen);
+
+      Lequ v;
+      lequ_init(&v);
+      if (elen > 0) { S_CHECK(lequ_reserve(&v, elen)); }
+      rd_getints(&rd, v.vis, elen);
+      rd_get(&rd, v.coeffs, (size_t)elen * sizeof(double));
+      v.len = elen;
+
+      A_CHECK(namestr, dupname(name, namelen));
+      S_CHECK(namedvec_add(&globals->vectors, v, namestr));
+   }
+
+   return OK;
+}
+
+/**
+ * @brief Load the global table from the cache
+ *
+ * A missing, truncated or inconsistent cache file is not an error: loaded is
+ * then set to false and the global table is left untouched.
+ *
+ * @param cache   the cache entry
+ * @param interp  the interpreter, whose global table must be empty
+ * @param loaded  true if the global table was loaded from the cache
+ *
+ * @return        the error code
+ */
+int empcache_load(EmpInterpCache *cache, Interpreter *interp, bool *loaded)
+{
+   int status = OK;
+   uint8_t *payload = NULL;
+   *loaded = false;
+
+   if (!cache->fname) { return OK; }
+
+   FILE *f = fopen(cache->fname, "rb");
+   if (!f) {
+      trace_empinterp("[empcache] no cache file '%s'\n", cache->fname);
+      return OK;
+   }
+
+   EmpCacheHeader hdr;
+   if (fread(&hdr, sizeof(hdr), 1, f) != 1 || memcmp(hdr.magic, EMPCACHE_MAGIC,
+       sizeof(EMPCACHE_MAGIC)) || hdr.version != EMPCACHE_VERSION ||
+       hdr.byteorder != EMPCACHE_BYTEORDER || hdr.key != cache->key) {
+      goto _invalid;
+   }
+
+   size_t size = (size_t)hdr.payload_size;
+   MALLOC_EXIT(payload, uint8_t, MAX(size, 1));
+
+   if (fread(payload, 1, size, f) != size || fgetc(f) != EOF ||
+       hash_bytes(FNV_OFFSET, payload, size) != hdr.payload_hash ||
+       !payload_valid(payload, size)) {
+      goto _invalid;
+   }
+
+   S_CHECK_EXIT(deserialize_globals(payload, size, &interp->globals));
+
+   trace_empinterp("[empcache] loaded %u sets, %u scalars and %u vectors from '%s'\n",
+                   interp->globals.sets.len, interp->globals.scalars.len,
+                   interp->globals.vectors.len, cache->fname);
+
+   *loaded = true;
+   goto _exit;
+
+_invalid:
+   printout(PO_INFO, "[empcache] ignoring invalid cache file '%s'\n", cache->fname);
+
+_exit:
+   fclose(f);
+   FREE(payload);
+
+   return status;
+}
+
+/**
+ * @brief Save the global table in the cache
+ *
+ * The file is written under a temporary name and then renamed, so that
+ * concurrent runs never read a partial file.
+ *
+ * @param cache   the cache entry
+ * @param interp  the interpreter
+ *
+ * @return        the error code
+ */
+int empcache_save(const EmpInterpCache *cache, const Interpreter *interp)
+{
+   int status = OK;
+   char *tmpname = NULL;
+   FILE *f = NULL;
+   EmpCacheBuf buf = {.len = 0, .max = 0, .data = NULL};
+
+   if (!cache->fname) { return OK; }
+
+   S_CHECK_EXIT(serialize_globals(&buf, &interp->globals));
+
+   EmpCacheHeader hdr;
+   memset(&hdr, 0, sizeof(hdr));
+   memcpy(hdr.magic, EMPCACHE_MAGIC, sizeof(EMPCACHE_MAGIC));
+   hdr.version = EMPCACHE_VERSION;
+   hdr.byteorder = EMPCACHE_BYTEORDER;
+   hdr.key = cache->key;
+   hdr.payload_size = buf.len;
+   hdr.payload_hash = hash_bytes(FNV_OFFSET, buf.data, buf.len);
+
+   IO_PRINT_EXIT(asprintf(&tmpname, "%s.%d.tmp", cache->fname, (int)rhp_getpid()));
+
+   f = fopen(tmpname, "wb");
+   if (!f) {
+      error("[empcache] ERROR: could not open file '%s' for writing\n", tmpname);
+      status = Error_FileOpenFailed;
+      goto _exit;
+   }
+
+   if (fwrite(&hdr, sizeof(hdr), 1, f) != 1 ||
+       (buf.len > 0 && fwrite(buf.data, 1, buf.len, f) != buf.len)) {
+      status = Error_SystemError;
+   }
+
+   if (fclose(f) && status == OK) { status = Error_SystemError; }
+   f = NULL;
+
+   if (status != OK) {
+      error("[empcache] ERROR: could not write the cache file '%s'\n", tmpname);
+      remove(tmpname);
+      goto _exit;
+   }
+
+   if (rename(tmpname, cache->fname)) {
+      /* Another run may have written the same file in the meantime */
+      remove(tmpname);
+   } else {
+      trace_empinterp("[empcache] saved the global table in '%s'\n", cache->fname);
+   }
+
+_exit:
+   FREE(tmpname);
+   FREE(buf.data);
+
+   return status;
+}
@@ -0,0 +1,35 @@
+#ifndef EMPINTERP_CACHE_H
+#define EMPINTERP_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "compat.h"
+#include "empinterp_fwd.h"
+
+/** @file empinterp_cache.h
+ *
+ *  @brief On-disk cache of the global table of the EMP interpreter
+ *
+ *  When a GMD file is given, the interpreter resolves the one-dimensional
+ *  sets, the scalars and the one-dimensional parameters into its global table.
+ *  This requires a UEL lookup for each record. The cache stores the resolved
+ *  table, keyed by a hash of the content of the GMD file.
+ *
+ *  The cache is enabled by setting the empinfo_cachedir option to an existing
+ *  directory. A cache file that cannot be validated is ignored.
+ */
+
+/** Cache entry for a GMD file */
+typedef struct empinterp_cache {
+   char *fname;           /**< Cache filename, NULL if the cache is disabled */
+   uint64_t key;          /**< Hash of the GMD file                          */
+} EmpInterpCache;
+
+void empcache_init(EmpInterpCache *cache, const char *cachedir,
+                   const char *gmd_fname) NONNULL;
+void empcache_free(EmpInterpCache *cache) NONNULL;
+int empcache_load(EmpInterpCache *cache, Interpreter *interp, bool *loaded) NONNULL;
+int empcache_save(const EmpInterpCache *cache, const Interpreter *interp) NONNULL;
+
+#endif
@@ -578,32 +578,35 @@ static int imm_read_param(Interpreter *interp, unsigned *p, IdentData *data,
    TO_IMPLEMENT("read_param in immediate mode");
 }
 
-static int imm_read_elt_vector(Interpreter *interp, const char *identstr,
-                               IdentData *ident, GmsIndicesData *gmsindices, double *val)
+static int imm_read_elt_vector(Interpreter *interp, IdentData *ident,
+                               GmsIndicesData *gmsindices, double *val)
 {
    unsigned idx;
    const NamedVecArray *container = ident->type == IdentVector ? 
       &interp->globals.vectors : &interp->globals.localvectors;
+   const char *identstr = ident->lexeme.start;
+   unsigned identlen = ident->lexeme.len;
 
-   idx = namedvec_findbyname_nocase(container, identstr);
+   idx = namedvec_findbyname_nocasen(container, identstr, identlen);
    if (idx == UINT_MAX) {
-      error("[empinterp] unexpected runtime error: couldn't find vector '%s'\n", identstr);
+      error("[empinterp] unexpected runtime error: couldn't find vector '%.*s'\n",
+            identlen, identstr);
       return Error_EMPRuntimeError;
    }
 
    const Lequ * vec = &container->list[idx];
    
    if (gmsindices->nargs != 1) {
-      error("[empinterp] ERROR on line %u: GAMS indices for symbol '%s' has dimension %u, expected 1\n", 
-            interp->linenr, identstr, gmsindices->nargs);
+      error("[empinterp] ERROR on line %u: GAMS indices for symbol '%.*s' has dimension %u, expected 1\n", 
+            interp->linenr, identlen, identstr, gmsindices->nargs);
       return Error_EMPRuntimeError;
    }
 
    IdentData *id = &gmsindices->idents[0];
 
    if (id->type != IdentUEL) {
-      error("[empinterp] ERROR on line %u: GAMS indices for symbol '%s' has dimension %u, expected 1\n", 
-            interp->linenr, identstr, gmsindices->nargs);
+      error("[empinterp] ERROR on line %u: GAMS indices for symbol '%.*s' has dimension %u, expected 1\n", 
+            interp->linenr, identlen, identstr, gmsindices->nargs);
       return Error_EMPRuntimeError;
    }
 
@@ -617,8 +620,8 @@ static int imm_read_elt_vector(Interpreter *interp, const char *identstr,
       }
    }
 
-   error("[empinterp] ERROR on line %u: could not find UEL '%*s' #%u in vector '%s'\n",
-         interp->linenr, id->lexeme.len, id->lexeme.start, uel, identstr);
+   error("[empinterp] ERROR on line %u: could not find UEL '%*s' #%u in vector '%.*s'\n",
+         interp->linenr, id->lexeme.len, id->lexeme.start, uel, identlen, identstr);
 
    return Error_EMPIncorrectInput;
 }
@@ -230,6 +230,81 @@ int gmd_boolean_test(void *gmdh, VmGmsSymIterator *filter, bool *res)
    return OK;
 }
 
+/**
+ * @brief Read the records of a GMD set
+ *
+ * The tuples use the GMD UEL indices, like the filters in gmd_boolean_test().
+ * The records are in the GMD order.
+ *
+ * @param      gmdh    the GMD handle
+ * @param      symptr  the GMD symbol pointer
+ * @param      dim     the dimension of the set
+ * @param[out] len     the number of tuples
+ * @param[out] tuples  the tuples, stored contiguously (len * dim UELs). To be freed
+ *
+ * @return             the error code
+ */
+int gmd_set_tuples(void *gmdh, void *symptr, uint8_t dim, unsigned *len, int **tuples)
+{
+   gmdHandle_t gmd = gmdh;
+   int status = OK, nrecs;
+   void *symiterptr = NULL;
+
+   *len = 0;
+   *tuples = NULL;
+
+   GMD_CHK_RET(gmdSymbolInfo, gmd, symptr, GMD_NRRECORDS, &nrecs, NULL, NULL);
+
+   MALLOC_(*tuples, int, (size_t)MAX(nrecs, 1) * dim);
+
+   if (nrecs > 0 && gmdFindFirstRecord(gmd, symptr, &symiterptr)) {
+      do {
+         double values[GMS_VAL_MAX];
+         assert(*len < (unsigned)nrecs);
+         GMD_CHK_EXIT(gmdGetRecordRaw, gmd, symiterptr, dim, &(*tuples)[(size_t)*len * dim],
+                      values);
+         (*len)++;
+      } while (*len < (unsigned)nrecs && gmdRecordMoveNext(gmd, symiterptr));
+   }
+
+_exit:
+   if (symiterptr) {
+      gmdFreeSymbolIterator(gmd, symiterptr);
+   }
+
+   if (status != OK) {
+      FREE(*tuples);
+      *len = 0;
+   }
+
+   return status;
+}
+
+/**
+ * @brief Build the membership index of a GMD set
+ *
+ * @param      gmdh    the GMD handle
+ * @param      symptr  the GMD symbol pointer
+ * @param      dim     the dimension of the set
+ * @param[out] index   the membership index
+ *
+ * @return             the error code
+ */
+int gmd_set_index(void *gmdh, void *symptr, uint8_t dim, UelSetIndex *index)
+{
+   int status = OK;
+   unsigned len;
+   int *tuples;
+
+   uelset_index_init(index, dim);
+
+   S_CHECK(gmd_set_tuples(gmdh, symptr, dim, &len, &tuples));
+   status = uelset_index_build(index, len, tuples);
+   FREE(tuples);
+
+   return status;
+}
+
 NONNULL_AT(1,3) static int
 dct_find_symbol(dctHandle_t dct, const char sym_name[GMS_SSSIZE], IdentData *ident,
                 int *domindices)
@@ -7,6 +7,7 @@
 #include "empinterp_fwd.h"
 #include "gclgms.h"
 #include "macros.h"
+#include "uelset_index.h"
 
 struct origins {
    IdentOrigin uel;
@@ -16,6 +17,8 @@ struct origins {
 int resolve_lexeme_as_gms_symbol(Interpreter * restrict interp, Token * restrict tok) NONNULL;
 int gmd_search_ident(Interpreter * restrict interp, IdentData * restrict ident) NONNULL;
 int gmd_boolean_test(void *gmdh, VmGmsSymIterator *filter, bool *res) NONNULL;
+int gmd_set_tuples(void *gmdh, void *symptr, uint8_t dim, unsigned *len, int **tuples) NONNULL;
+int gmd_set_index(void *gmdh, void *symptr, uint8_t dim, UelSetIndex *index) NONNULL;
 
 int get_uelstr_for_empdag_node(Interpreter *interp, int uelidx, unsigned uelstrlen, char *uelstr) NONNULL;
 
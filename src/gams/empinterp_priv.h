@@ -27,6 +27,7 @@ const char * identtype2str(IdentType type);
 
 int skip_spaces_commented_lines(Interpreter *interp, unsigned *p) NONNULL;
 int interp_read_empinfo(Interpreter *interp) NONNULL;
+void interp_free_empinfo(Interpreter *interp) NONNULL;
 NONNULL_AT(1,3)
 void empinterp_init(Interpreter *interp, Model *mdl, const char *fname);
 NONNULL void empinterp_free(Interpreter *interp);
@@ -53,6 +53,19 @@
    (vm->code.ip += 2, \
       (uint16_t)((vm->code.ip[-2] << 8) | vm->code.ip[-1]))
 
+/* Read a jump offset, which is in the far jump table if it does not fit in 16 bits */
+static inline unsigned READ_JUMP(EmpVm *vm)
+{
+   unsigned offset = READ_SHORT(vm);
+
+   if (RHP_UNLIKELY(offset == JUMP_FAR)) {
+      offset = vmcode_farjump_get(&vm->code, (unsigned)(vm->code.ip - vm->instr_start) - 2);
+      assert(offset < UINT_MAX);
+   }
+
+   return offset;
+}
+
 #ifndef NDEBUG
 
 static inline VmValue read_global(EmpVm *vm)
@@ -103,12 +116,12 @@ printout(PO_TRACE_EMPINTERP, "[%s] " fmt, opcodes_name(instr), __VA_ARGS__);
  * --------------------------------------------------------------------- */
 #define BINARY_CMP(vm, valueType, op) \
     do { \
-      vmstack_push(vm, BOOL_VAL(valueType(vmstack_pop(vm)) op valueType(vmstack_pop(vm)))); \
+      VM_PUSH(vm, BOOL_VAL(valueType(VM_POP(vm)) op valueType(VM_POP(vm)))); \
     } while (false)
 
 #define BINARY_OP(vm, op) \
     do { \
-      vmstack_push(vm, NUMBER_VAL(AS_NUMBER((vmstack_pop(vm)) op AS_NUMBER(vmstack_pop(vm))))); \
+      VM_PUSH(vm, NUMBER_VAL(AS_NUMBER((VM_POP(vm)) op AS_NUMBER(VM_POP(vm))))); \
     } while (false)
 
 
@@ -336,26 +349,26 @@ static const char *vrole2keyword(VarRole vrole)
 
 #define PADDING_VERBOSE 60
 
-DBGUSED static int getpadding(int offset)
+static int getpadding(int offset)
 {
    return offset < PADDING_VERBOSE ? PADDING_VERBOSE - offset : 0;
 }
 
-DBGUSED static void print_symiter(VmGmsSymIterator *symiter, EmpVm *vm)
+static void print_symiter(VmGmsSymIterator *symiter, EmpVm *vm)
 {
-   DBGUSED Lexeme *lexeme = &symiter->ident.lexeme;
-   DEBUGVMRUN("%.*s", lexeme->len, lexeme->start);
+   Lexeme *lexeme = &symiter->ident.lexeme;
+   trace_empinterp("%.*s", lexeme->len, lexeme->start);
    int dim = symiter->ident.dim;
    if (dim > 0) {
       int *uels = symiter->uels;
-      DEBUGVMRUN("%s", "(");
+      trace_empinterp("%s", "(");
       for (unsigned ii = 0; ii < dim; ++ii) {
-         if (ii > 0) { DEBUGVMRUN(", "); }
+         if (ii > 0) { trace_empinterp(", "); }
          int dummyoffset;
          vm_printuel(&vm->data, uels[ii], PO_TRACE_EMPINTERP,
                       &dummyoffset);
       }
-      DEBUGVMRUN("%s", ")");
+      trace_empinterp("%s", ")");
    }
 }
 
@@ -412,20 +425,29 @@ static inline unsigned vm_linenr(EmpVm * restrict vm)
 }
 
 
+NONNULL static inline void vmstack_push_notrace(struct empvm *vm, VmValue val) {
+   *vm->stack_top = val;
+   vm->stack_top++;
+}
+
+NONNULL static inline VmValue vmstack_pop_notrace(struct empvm * restrict vm) {
+  vm->stack_top--;
+  assert(vm->stack_top >= vm->stack);
+  return *vm->stack_top;
+}
+
 NONNULL static inline void vmstack_push(struct empvm *vm, VmValue val) {
    if (O_Output & PO_TRACE_EMPINTERP) {
       trace_empinterp(" --> pushed     ");
       print_vmval_full(val, vm);
    }
-   *vm->stack_top = val;
-   vm->stack_top++;
+   vmstack_push_notrace(vm, val);
 }
 
 NONNULL static inline VmValue vmstack_pop(struct empvm * restrict vm) {
-  vm->stack_top--;
-  assert(vm->stack_top >= vm->stack);
-  DEBUGVMRUN_EXEC(print_vmval_full(*vm->stack_top, vm));
-  return *vm->stack_top;
+  VmValue val = vmstack_pop_notrace(vm);
+  print_vmval_full(val, vm);
+  return val;
 }
 
 NONNULL static inline void vmstack_mvback(struct empvm *vm, unsigned nb) {
@@ -631,6 +653,63 @@ static int gms_equvar_sync(VmData *vmdata, IdentType type)
    return OK;
 }
 
+/**
+ * @brief Translate a GMD UEL into a DCT (or GMDDCT) UEL
+ *
+ * The translations are memoized in a table indexed by the GMD UEL. The table
+ * is allocated for all the GMD UELs on first use and an entry is filled the
+ * first time the UEL is translated. Each UEL thus goes through the string
+ * conversion and the DCT lookup at most once per interpreter run.
+ *
+ * @param      vmdata   the VM data
+ * @param      uel      the GMD UEL
+ * @param[out] uel_dct  the DCT UEL, or a nonpositive value if the UEL is not in the DCT
+ *
+ * @return              the error code
+ */
+static int vm_uel_gmd2dct(VmData *vmdata, int uel, int *uel_dct)
+{
+   gmdHandle_t gmd = vmdata->gmd;
+   UelTranslation *gmd2dct = &vmdata->uels_gmd2dct;
+
+   if (RHP_UNLIKELY(uel <= 0)) {
+      *uel_dct = uel;
+      return OK;
+   }
+
+   if (RHP_UNLIKELY((unsigned)uel >= gmd2dct->len)) {
+      int nuels;
+      GMD_CHK_RET(gmdInfo, gmd, GMD_NRUELS, &nuels, NULL, NULL);
+
+      unsigned len = MAX((unsigned)nuels, (unsigned)uel) + 1;
+      REALLOC_(gmd2dct->arr, int, len);
+      memset(&gmd2dct->arr[gmd2dct->len], 0, (len - gmd2dct->len) * sizeof(int));
+      gmd2dct->len = len;
+   }
+
+   int val = gmd2dct->arr[uel];
+   if (RHP_LIKELY(val != 0)) {
+      *uel_dct = val;
+      return OK;
+   }
+
+   char uelstr[GLOBAL_UEL_IDENT_SIZE];
+   GMD_CHK_RET(gmdGetUelByIndex, gmd, uel, uelstr);
+#ifdef RHP_EXPERIMENTAL
+   GMD_CHK_RET(gmdFindUel, vmdata->gmddct, uelstr, &val);
+#else
+   val = dctUelIndex(vmdata->dct, uelstr);
+#endif
+
+   /* A zero entry means not translated yet */
+   if (val <= 0) { val = -1; }
+
+   gmd2dct->arr[uel] = val;
+   *uel_dct = val;
+
+   return OK;
+}
+
 static inline
 int vm_multiset_membership_test(VmData *vmdata, VmGmsSymIterator *filter, bool *res)
 {
@@ -643,6 +722,113 @@ int vm_multiset_membership_test(VmData *vmdata, VmGmsSymIterator *filter, bool *
    }
 }
 
+static int vm_intarray_index(const IntArray *set, UelSetIndex *index)
+{
+   unsigned npos = 0;
+   for (unsigned i = 0, len = set->len; i < len; ++i) {
+      if (set->arr[i] > 0) { npos++; }
+   }
+
+   if (npos == set->len) {
+      return uelset_index_build(index, set->len, set->arr);
+   }
+
+   /* Invalid UELs are not indexed. Tests with such a UEL use a linear search */
+   int status = OK;
+   int *uels = NULL;
+   MALLOC_(uels, int, MAX(npos, 1));
+
+   for (unsigned i = 0, j = 0, len = set->len; i < len; ++i) {
+      if (set->arr[i] > 0) { uels[j++] = set->arr[i]; }
+   }
+
+   S_CHECK_EXIT(uelset_index_build(index, npos, uels));
+
+_exit:
+   FREE(uels);
+   return status;
+}
+
+/**
+ * @brief Get the membership index of the set of a symbol iterator
+ *
+ * The index is built on the first membership test of the set and then shared
+ * by all the tests on the same set. Sets and multisets are not modified once
+ * loaded, contrary to the local sets which are not indexed.
+ *
+ * @param vmdata   the VM data
+ * @param symiter  the symbol iterator
+ *
+ * @return         the error code
+ */
+static int vm_setindex_get(VmData *vmdata, VmGmsSymIterator *symiter)
+{
+   const IdentData *ident = &symiter->ident;
+   VmSetIndices *setindices = &vmdata->setindices;
+   unsigned symidx = ident->type == IdentMultiSet ? ident->idx : 0;
+
+   for (unsigned i = 0, len = setindices->len; i < len; ++i) {
+      if (setindices->arr[i].set == ident->ptr && setindices->arr[i].symidx == symidx) {
+         symiter->index = setindices->arr[i].index;
+         return OK;
+      }
+   }
+
+   if (setindices->len >= setindices->max) {
+      setindices->max = MAX(2*setindices->max, 4);
+      REALLOC_(setindices->arr, VmSetIndex, setindices->max);
+   }
+
+   UelSetIndex *index;
+   MALLOC_(index, UelSetIndex, 1);
+   uelset_index_init(index, ident->type == IdentSet ? 1 : ident->dim);
+
+   int status;
+   switch (ident->type) {
+   case IdentSet:
+      status = vm_intarray_index(ident->ptr, index);
+      break;
+   case IdentMultiSet:
+      switch (ident->origin) {
+      case IdentOriginGdx:
+         status = gdx_reader_set_index(ident->ptr, (int)ident->idx, ident->dim, index);
+         break;
+      case IdentOriginGmd:
+         status = gmd_set_index(vmdata->gmd, ident->ptr, ident->dim, index);
+         break;
+      default:
+         status = runtime_error(ident->lexeme.linenr);
+      }
+      break;
+   default:
+      status = runtime_error(ident->lexeme.linenr);
+   }
+
+   if (status != OK) {
+      uelset_index_free(index);
+      FREE(index);
+      return status;
+   }
+
+   setindices->arr[setindices->len++] = (VmSetIndex){.set = ident->ptr, .symidx = symidx,
+                                                     .index = index};
+   symiter->index = index;
+
+   trace_empinterp("[empvm_run] Built the membership index of set '%.*s' with %u elements\n",
+                   lexeme_fmtargs(ident->lexeme), index->len);
+
+   return OK;
+}
+
+static bool uels_arevalid(const int *uels, unsigned dim)
+{
+   for (unsigned i = 0; i < dim; ++i) {
+      if (uels[i] <= 0) { return false; }
+   }
+
+   return true;
+}
+
 static int vm_membership_test(VmData *vmdata, VmGmsSymIterator *symiter, bool *res)
 {
    IdentType type = symiter->ident.type;
@@ -650,9 +836,25 @@ static int vm_membership_test(VmData *vmdata, VmGmsSymIterator *symiter, bool *r
    switch (type) {
    case IdentMultiSet:
       assert(symiter->ident.ptr);
+      if (!symiter->index) { S_CHECK(vm_setindex_get(vmdata, symiter)); }
+
+      /* Filters with wildcards are answered by the backend */
+      if (uels_arevalid(symiter->uels, symiter->ident.dim)) {
+         *res = uelset_index_has(symiter->index, symiter->uels);
+         return OK;
+      }
+
       return vm_multiset_membership_test(vmdata, symiter, res);
-   case IdentLocalSet:
-   case IdentSet: {
+   case IdentSet:
+      assert(symiter->ident.ptr);
+      if (!symiter->index) { S_CHECK(vm_setindex_get(vmdata, symiter)); }
+
+      if (symiter->uels[0] > 0) {
+         *res = uelset_index_has(symiter->index, symiter->uels);
+         return OK;
+      }
+      FALLTHRU
+   case IdentLocalSet: {
       IntArray *obj = symiter->ident.ptr; assert(obj);
       int uel = symiter->uels[0];
       unsigned idx = rhp_int_find(obj, uel);
@@ -699,6 +901,21 @@ NONNULL static int vmdata_init(VmData *data)
 
    arcvfobjs_init(&data->arcvfobjs);
 
+   data->setindices.len = 0;
+   data->setindices.max = 0;
+   data->setindices.arr = NULL;
+
+   data->setjoins.len = 0;
+   data->setjoins.max = 0;
+   data->setjoins.arr = NULL;
+
+   data->mp_staged.mp = NULL;
+   rhp_int_init(&data->mp_staged.vars);
+   rhp_int_init(&data->mp_staged.equs);
+
+   data->uels_gmd2dct.len = 0;
+   data->uels_gmd2dct.arr = NULL;
+
    data->linklabel_ws = NULL;
 
       return OK;
@@ -790,1107 +1007,66 @@ void empvm_free(EmpVm *vm)
    free(vmdata->linklabel_ws);
    arcvfobjs_free(&vmdata->arcvfobjs);
 
+   for (unsigned i = 0, len = vmdata->setindices.len; i < len; ++i) {
+      uelset_index_free(vmdata->setindices.arr[i].index);
+      free(vmdata->setindices.arr[i].index);
+   }
+   free(vmdata->setindices.arr);
+
+   for (unsigned i = 0, len = vmdata->setjoins.len; i < len; ++i) {
+      free(vmdata->setjoins.arr[i].pos);
+      free(vmdata->setjoins.arr[i].uels);
+   }
+   free(vmdata->setjoins.arr);
+   rhp_int_empty(&vmdata->mp_staged.vars);
+   rhp_int_empty(&vmdata->mp_staged.equs);
+   free(vmdata->uels_gmd2dct.arr);
+
    free(vm);
 }
 
-int empvm_run(struct empvm *vm)
+/**
+ * @brief Print the stack and the instruction about to be executed
+ *
+ * @param vm     the EMP VM
+ * @param instr  the instruction
+ */
+static void empvm_trace_instr(EmpVm *vm, uint8_t instr)
 {
-   S_CHECK(empvm_dissassemble(vm, PO_TRACE_EMPINTERP));
-
-   int status = OK, poffset;
-   unsigned linenr;
-   vm->instr_start = vm->code.ip;
-   vm->stack_top = vm->stack;
-
-   trace_empinterp("\n\n");
-
-   while (true) {
+   if (!(O_Output & PO_TRACE_EMPINTERP)) { return; }
 
-      assert(vm->code.ip -  vm->instr_start < vm->code.len);
+   int poffset;
 
-      uint8_t instr = READ_BYTE(vm);
-
-
-      /* ---------------------------------------------------------------------
-      * Display the stack 
-      * --------------------------------------------------------------------- */
-
-      if (O_Output & PO_TRACE_EMPINTERP) {
-
-         if (vm->stack_top > vm->stack) {
-            trace_empinterp("\nstack%n", &poffset);
-            for (VmValue *val = vm->stack; val < vm->stack_top; val++, poffset = 0) {
-               trace_empinterp("%*s", 50-poffset, "");
-               print_vmval_full(*val, vm);
-               trace_empinterp("\n");
-            }
-
-         trace_empinterp("[%5td] %30s%10s",
-                         (vm->code.ip - vm->instr_start) - 1, opcodes_name(instr), "");
-
-         } else {
-
-            trace_empinterp("\n[%5td] %30s%10s",
-                            (vm->code.ip - vm->instr_start) - 1, opcodes_name(instr), "");
-
-         }
-      }
-
-      switch (instr) {
-
-      case OP_PUSH_GIDX: {
-         VmValue val = read_global(vm);
-         vmstack_push(vm, val);
-         break;
-      }
-
-      case OP_PUSH_BYTE: {
-         uint8_t val = READ_BYTE(vm);
-         vmstack_push(vm, UINT_VAL(val));
-         break;
-      }
-
-      case OP_PUSH_LIDX: {
-         uint8_t slot = READ_BYTE(vm);
-         vmstack_push(vm, vm->locals[slot]);
-         break;
-      }
-
-      case OP_PUSH_VMUINT: {
-         vmstack_push(vm, UINT_VAL(READ_VMUINT(vm)));
-         break;
-      }
-
-      case OP_PUSH_VMINT: {
-         vmstack_push(vm, INT_VAL(READ_VMINT(vm)));
-         break;
-      }
-
-      case OP_PUSH_FALSE: {
-         vmstack_push(vm, BOOL_VAL(false));
-         break;
-      }
-
-      case OP_PUSH_TRUE: {
-         vmstack_push(vm, BOOL_VAL(true));
-         break;
-      }
-
-      case OP_LOOPVAR_UPDATE: {
-         uint8_t lidx_loopvar = READ_BYTE(vm);
-         uint8_t lidx_idxvar = READ_BYTE(vm);
-         IdentType type = READ_BYTE(vm);
-         GIDX_TYPE gidx = READ_GIDX(vm);
-
-         unsigned idx = AS_UINT(vm->locals[lidx_idxvar]);
-         DBGUSED int offset0, offset1, offset2;
-         DEBUGVMRUN("loopvar@%u of %n", lidx_loopvar, &offset0);
-
-         IntArray set;
-         switch (type) {
-         case IdentLocalSet: {
-            assert(gidx < vm->data.globals->localsets.len);
-            set = namedints_at(&vm->data.globals->localsets, gidx);
-            DEBUGVMRUN("'%s' <- %n", vm->data.globals->localsets.names[gidx], &offset1);
-            break;
-         }
-         case IdentSet: {
-            assert(gidx < vm->data.globals->sets.len);
-            set = namedints_at(&vm->data.globals->sets, gidx);
-            DEBUGVMRUN("'%s' <- %n", vm->data.globals->sets.names[gidx], &offset1);
-            break;
-         }
-         default:
-            error("\n[empvm_run] ERROR in %s: unexpected ident type %s\n", opcodes_name(instr),
-                  identtype2str(type));
-            status = Error_EMPRuntimeError;
-            goto _exit;
-         }
-
-         assert(valid_set(set) && idx < set.len);
-         vm->locals[lidx_loopvar] = LOOPVAR_VAL(set.arr[idx]);
-         DEBUGVMRUN_EXEC({vm_printuel(&vm->data, (set.arr[idx]), PO_TRACE_EMPINTERP, &offset2);});
-         DEBUGVMRUN("%*s%s#%u[lvar%u = %u]", getpadding(offset0 + offset1 + offset2), "",
-                    type == IdentSet ? "sets" : "localsets", gidx, lidx_idxvar, idx);
-         break;
-      }
-      case OP_LVAR_COPYFROM_GIDX: {
-         uint8_t slot = READ_BYTE(vm);
-         vm->locals[slot] = read_global(vm);
-         DEBUGVMRUN("lvar@%u = %" PRIu64, slot, vm->locals[slot] & MASK_PAYLOAD_32);
-         break;
-      }
-      case OP_LVAR_COPYOBJLEN: {
-         uint8_t slot = READ_BYTE(vm);
-         IdentType type = READ_BYTE(vm);
-         GIDX_TYPE gidx = READ_GIDX(vm);
-
-         unsigned len;
-         switch (type) {
-         case IdentLocalSet: {
-            IntArray obj = namedints_at(&vm->data.globals->localsets, gidx);
-            assert(valid_set(obj));
-            len = obj.len;
-            DEBUGVMRUN("objname is %s of type localset", vm->data.globals->localsets.names[gidx]);
-            break;
-         }
-         case IdentLocalVector: {
-            Lequ obj = namedvec_at(&vm->data.globals->localvectors, gidx);
-            assert(valid_vector(obj));
-            len = obj.len;
-            DEBUGVMRUN("objname is %s of type localvector", vm->data.globals->localvectors.names[gidx]);
-            break;
-         }
-         default:
-            error("\n[empvm_run] ERROR in %s: unexpected ident type %s\n", opcodes_name(instr),
-                  identtype2str(type));
-            status = Error_EMPRuntimeError;
-            goto _exit;
-         }
-         vm->locals[slot] = UINT_VAL(len);
-         DEBUGVMRUN("lvar@%u <- %u = len(obj[%u])", slot, len, gidx);
-         break;
-
-      }
-
-      case OP_GMSSYMITER_SETFROM_LOOPVAR: {
-         GIDX_TYPE gidx = READ_GIDX(vm);
-         uint8_t idx = READ_BYTE(vm);
-         uint8_t lidx = READ_BYTE(vm);
-
-         VmGmsSymIterator *symiter;
-         N_CHECK_EXIT(symiter, getgmssymiter(&vm->globals, gidx));
-
-         assert(idx < symiter->ident.dim && symiter->ident.dim <= GMS_MAX_INDEX_DIM);
-         assert(IS_LOOPVAR(vm->locals[lidx]));
-
-         int uel = AS_LOOPVAR(vm->locals[lidx]);
-
-         /* Print output before possible uel idx translation */
-         DBGUSED int offset1, offset2;
-         DBGUSED Lexeme *lexeme = &symiter->ident.lexeme;
-         DEBUGVMRUN("%.*s[%u] <- %n", lexeme->len, lexeme->start, idx, &offset1);
-         DEBUGVMRUN_EXEC({vm_printuel(&vm->data, uel, PO_TRACE_EMPINTERP, &offset2);})
-         DEBUGVMRUN(" #%u%n", uel, &offset2);
-         DEBUGVMRUN("%*sloopvar@%u", getpadding(offset1 + offset2), "", lidx);
-
-      /* -------------------------------------------------------------------
-       * If the GAMS symbol is an equation or variable, one needs to convert
-       * the GMD uel to a GMDDCT uel
-       * ------------------------------------------------------------------- */
-
-         IdentType gmssym_type = symiter->ident.type;
-         gmdHandle_t gmd = vm->data.gmd;
-         if ((gmssym_type == IdentEqu || gmssym_type == IdentVar) && gmd) {
-            char uelstr[GLOBAL_UEL_IDENT_SIZE];
-            GMD_CHK_EXIT(gmdGetUelByIndex, gmd, uel, uelstr);
-#ifdef RHP_EXPERIMENTAL
-            GMD_CHK_EXIT(gmdFindUel, vm->data.gmddct, uelstr, &uel);
-#else
-            uel = dctUelIndex(vm->data.dct, uelstr);
-#endif
-
-            if (RHP_UNLIKELY(uel <= 0)) {
-               int offset;
-               error("\n\n[empvm] ERROR: %nset element '%s' not found in the model instance, "
-                     "but it is part of the GAMS database.\n", &offset, uelstr);
-               offset -= 2;
-               error("%*sThis happened while selecting said element at dim %u for %s %.*s\n",
-                     offset, "", idx+1, ident_fmtargs(&symiter->ident));
-
-               if (gmssym_type == IdentVar) {
-                  error("%*sA potential source is that the record for the above variable "
-                        "is not included in the model instance.\n%*sCheck that it appears in "
-                        "at least one equation.\n", offset, "", offset, "");
-               } else if (gmssym_type == IdentEqu) {
-                  error("%*sA potential source is that the record for the above equation "
-                        "is not included in the model instance.\n%*sCheck the equation "
-                        "definition.\n", offset, "", offset, "");
-                  }
-
-               status = Error_EMPRuntimeError;
-               goto _exit;
-            }
-         }
-
-         symiter->uels[idx] = uel;
-
-         if (uel > 0) symiter->compact = false;
-
-         break;
-      }
-
-#ifdef HACK
-      case OP_DUALSLABEL_ADD: {
-         GIDX_TYPE gidx = READ_GIDX(vm);
-
-         DualsLabel *dualslabel;
-         N_CHECK_EXIT(dualslabel, dualslabel_arr_at(vm->data.dualslabels, gidx));
-
-S_CHECK_EXIT(dualslabel_add(dualslabel, mpid_dual));
-
-         break;
-      }
-#endif 
-
-// HACK: it's unclear this is any kind of good idea. 
-// Review OP_LINKLABELS_SETFROM_LOOPVAR 
-#ifdef HACK
-      case OP_DUALSLABEL_SETFROM_LOOPVAR: {
-         GIDX_TYPE gidx = READ_GIDX(vm);
-         uint8_t idx = READ_BYTE(vm);
-         uint8_t lidx = READ_BYTE(vm);
-
-         DualsLabel *dualslabel;
-         N_CHECK_EXIT(dualslabel, dualslabel_arr_at(vm->data.dualslabels, gidx));
-
-         assert(idx < dualslabel->dim);
-         assert(IS_LOOPVAR(vm->locals[lidx]));
-
-         int uel = AS_LOOPVAR(vm->locals[lidx]);
-         assert(dualslabel->mpid_duals.len > 0); assert(dualslabel->num_var > 0);
-
-         unsigned offset = dualslabel->mpid_duals.len - 1;
-         int *uels = &dualslabel->uels_var[(size_t)offset*dualslabel->num_var];
-         uels[idx] = uel;
-
-         DBGUSED int offset1, offset2;
-         DEBUGVMRUN("%.*s[%u] <- %n", dualslabel->label_len, dualslabel->label, idx, &offset1);
-         DEBUGVMRUN_EXEC({vm_printuel(&vm->data, uel, PO_TRACE_EMPINTERP, &offset2);})
-         DEBUGVMRUN("%*sloopvar@%u\n", getpadding(offset1 + offset2), "", lidx);
-
-         break;
-      }
-#endif
-      case OP_DUALSLABEL_STORE: {
-         GIDX_TYPE gidx = READ_GIDX(vm);
-
-         DualsLabel *dualslabel;
-         N_CHECK_EXIT(dualslabel, dualslabel_arr_at(vm->data.dualslabels, gidx));
-
-         /* This is a dummy read. Otherwise the VM dissassembler is lost */
-         uint8_t nargs = READ_BYTE(vm);
-
-         // HACK: loopiterators are not given here, but count as num_var ...
-         assert(dualslabel->nvaridxs >= nargs);
-
-         int *uels = NULL;
-         if (nargs > 0) {
-            S_CHECK_EXIT(scratchint_ensure(&vm->data.equvar.e_data, nargs));
-            uels = vm->data.equvar.e_data.data;
-
-            for (unsigned i = 0; i < nargs; ++i) {
-               uint8_t slot = READ_BYTE(vm);
-               int uel_lidx = AS_INT(vm->locals[slot]);
-               uels[i] = uel_lidx;
-            }
-         }
-
-         mpid_t mpid_dual = vm->data.state.mpid_dual;
-         if (!mpid_regularmp(mpid_dual)) {
-            error("\n[empvm] ERROR: invalid value %s #%u\n", mpid_specialvalue(mpid_dual), mpid_dual);
-            status = Error_EMPRuntimeError;
-            goto _exit;
-         }
-
-         S_CHECK_EXIT(dualslabel_add(dualslabel, uels, nargs, mpid_dual));
-
-         DEBUGVMRUN("#%u: ", dualslabel->mpid_duals.len-1);
-         DEBUGVMRUN_EXEC({ for (unsigned i = 0; i < nargs; ++i) {
-            int dummy; if (i == 0) {DEBUGVMRUN("(");}
-            vm_printuel(&vm->data, uels[i], PO_TRACE_EMPINTERP, &dummy);
-            if (i == nargs-1) { DEBUGVMRUN(")");}}
-            });
- 
-         break;
-      }
-
-      /* ---------------------------------------------------------------------
-       * Update a fixed uel in a linklabel from a loop variable
-       * args: gidx dim_idx lidx
-       *
-       * FIXME: this modifies a global object. An alternative would be to modify
-       * the current VM linklabel. This may have big benefits when parsing sum
-       * where ALL indices are "resolved" (no set to iterate over)
-       * ---------------------------------------------------------------------- */
-      case OP_LINKLABELS_SETFROM_LOOPVAR: {
-         GIDX_TYPE gidx = READ_GIDX(vm);
-         uint8_t uel_pos = READ_BYTE(vm);
-         uint8_t lidx = READ_BYTE(vm);
-
-         LinkLabels *linklabels;
-         N_CHECK_EXIT(linklabels, getlinklabels(&vm->globals, gidx));
-
-         assert(uel_pos < linklabels->dim);
-         assert(IS_LOOPVAR(vm->locals[lidx]));
-
-         int uel = AS_LOOPVAR(vm->locals[lidx]);
-         linklabels->data[uel_pos] = uel;
-
-         DBGUSED int offset1, offset2;
-         DEBUGVMRUN("%.*s[%u] <- %n", linklabels->label_len, linklabels->label, uel_pos, &offset1);
-         DEBUGVMRUN_EXEC({vm_printuel(&vm->data, uel, PO_TRACE_EMPINTERP, &offset2);})
-         DEBUGVMRUN("%*sloopvar@%u", getpadding(offset1 + offset2), "", lidx);
-
-         break;
-      }
-
-      case OP_REGENTRY_SETFROM_LOOPVAR: {
-         GIDX_TYPE gidx = READ_GIDX(vm);
-         uint8_t dim_idx = READ_BYTE(vm);
-         uint8_t lidx = READ_BYTE(vm);
-
-         DagRegisterEntry *regentry;
-         N_CHECK_EXIT(regentry, getregentry(&vm->globals, gidx));
-
-         assert(dim_idx < regentry->dim);
-         assert(IS_LOOPVAR(vm->locals[lidx]));
-
-         int uel = AS_LOOPVAR(vm->locals[lidx]);
-         regentry->uels[dim_idx] = uel;
-
-         DBGUSED int offset1, offset2; 
-         DEBUGVMRUN("%.*s[%u] <- %n", regentry->label_len, regentry->label, dim_idx, &offset1);
-         DEBUGVMRUN_EXEC({vm_printuel(&vm->data, uel, PO_TRACE_EMPINTERP, &offset2);})
-         DEBUGVMRUN("%*sloopvar@%u", getpadding(offset1 + offset2), "", lidx);
-
-         break;
-      }
-
-      case OP_LVAR_COPYTO_LVAR: {
-         uint8_t src = READ_BYTE(vm);
-         uint8_t dst = READ_BYTE(vm);
-         vm->locals[dst] = vm->locals[src];
-         break;
-      }
-      case OP_LVAR_INC: {
-         uint8_t lidx = READ_BYTE(vm);
-         assert(IS_UINT(vm->locals[lidx]));
-         VM_VALUE_INC(vm->locals[lidx]);
-         DEBUGVMRUN("lidx@%u <- %u", lidx, AS_UINT(vm->locals[lidx]));
-         break;
-      }
-
-      case OP_STACKTOP_COPYTO_LVAR: {
-         uint8_t lidx = READ_BYTE(vm);
-         vm->locals[lidx] = vmstack_peek(vm, 0);
-         DEBUGVMRUN("lidx@%u <- %u", lidx, AS_UINT(vm->locals[lidx]));
-         break;
-      }
-
-      case OP_STACKTOP_INC: {
-         VmValue stacktop = vmstack_pop(vm);
-         if (IS_INT(stacktop)) {
-            vmstack_push(vm, INT_VAL(AS_INT(stacktop) + 1));
-         } else if (IS_UINT(stacktop)) {
-            vmstack_push(vm, UINT_VAL(AS_UINT(stacktop) + 1));
-         } else {
-            errormsg("\n\n[empvm] ERROR: stack stop is not an (unsigned int)\n");
-            goto _exit;
-         }
-         break;
-      }
-
-      case OP_LSET_ADD: {
-         GIDX_TYPE gidx = READ_GIDX(vm);
-         uint8_t slot = READ_BYTE(vm);
-         assert(gidx < vm->data.globals->localsets.len);
-         IntArray *set = &vm->data.globals->localsets.list[gidx];
-
-         assert(valid_set(*set));
-         assert(IS_LOOPVAR(vm->locals[slot]));
-
-         int val = AS_INT(vm->locals[slot]);
-         S_CHECK_EXIT(rhp_int_add(set, val));
-         break;
-      }
-      case OP_LSET_RESET: {
-         GIDX_TYPE gidx = READ_GIDX(vm);
-         assert(gidx < vm->data.globals->localsets.len);
-         IntArray *set = &vm->data.globals->localsets.list[gidx];
-         assert(valid_set(*set));
-         set->len = 0;
-         break;
-      }
-      case OP_LVEC_ADD: {
-         TO_IMPLEMENT("OP_LVEC_ADD");
-      }
-      case OP_LVEC_RESET: {
-         GIDX_TYPE gidx = READ_GIDX(vm);
-         assert(gidx < vm->data.globals->vectors.len);
-         Lequ *vec = &vm->data.globals->vectors.list[gidx];
-         assert(valid_vector(*vec));
-         vec->len = 0;
-         break;
-      }
-      case OP_OVFPARAM_SYNC: {
-         unsigned vmvec_lidx = READ_BYTE(vm);
-         unsigned param_gidx = READ_GIDX(vm);
-
-         assert(vm->data.equvar.dscratch.data);
-         assert(param_gidx < vm->globals.len);
-
-         VmVector * restrict vmvec = AS_OBJ(VmVector *, vm->locals[vmvec_lidx]);
-         OvfParam * param = AS_OBJ(OvfParam *, vm->globals.arr[param_gidx]);
-         unsigned size = vmvec->len;
-         param->type = ARG_TYPE_VEC;
-         param->size_vector = size;
-         MALLOC_EXIT(param->vec, double, size);
-         memcpy(param->vec, vm->data.equvar.dscratch.data, size * sizeof(double));
-
-         /* Reset the length for the next use */
-         vmvec->len = 0;
-
-         DEBUGVMRUN("param %p has now value\n", (void*)param);
-         DEBUGVMRUN_EXEC({ for (unsigned i = 0; i < size; ++i) { trace_empinterp("[%5u] %e\n", i, param->vec[i]); }});
-         break;
-      }
-
-      case OP_VECTOR_EXTEND: {
-         unsigned vmvec_lidx = READ_BYTE(vm);
-         unsigned vecidx_lidx = READ_BYTE(vm);
-
-         assert(IS_PTR(vm->locals[vmvec_lidx]));
-         assert(IS_LOOPVAR(vm->locals[vecidx_lidx]));
-
-         VmVector * restrict vmvec = AS_OBJ(VmVector *, vm->locals[vmvec_lidx]);
-         unsigned len = vmvec->len;
-         DblScratch *dscratch = &vm->data.equvar.dscratch;
-         assert(dscratch->data);
-
-         if (len >= dscratch->size) {
-            unsigned size = MAX(2*dscratch->size, len+1);
-            REALLOC_EXIT(dscratch->data, double, len);
-            dscratch->size = size;
-         }
-
-         unsigned pos;
-         int vecidx = AS_LOOPVAR(vm->locals[vecidx_lidx]);
-         lequ_find(vmvec->data, vecidx, &dscratch->data[len], &pos);
-
-         if (pos == UINT_MAX || !isfinite(dscratch->data[len])) {
-            char buf[GMS_SSSIZE] = " ";
-
-            gmdGetUelByIndex(vm->data.gmd, vecidx, buf);
-            error("[empvm_run] runtime error: in '%.*s', no UEL '%s' (#%u)\n",
-                  vmvec->lexeme.len, vmvec->lexeme.start, buf, vecidx);
-            print_vector(vmvec->data, PO_ERROR, vm->data.gmd);
-            status = Error_EMPIncorrectInput;
-            goto _exit;
-         }
-
-         DEBUGVMRUN("vec[%u] <- %e = %.*s(", len, dscratch->data[len],
-                    vmvec->lexeme.len, vmvec->lexeme.start);
-         DEBUGVMRUN_EXEC({
-               int dummyoffset;
-               vm_printuel(&vm->data, (vecidx), PO_TRACE_EMPINTERP, &dummyoffset);
-               trace_empinterpmsg(")\n");});
-
-         vmvec->len++;
-         break;
-      }
-      case OP_NIL:      vmstack_push(vm, NULL_VAL);              break;
-      case OP_TRUE:     vmstack_push(vm, BOOL_VAL(true));       break;
-      case OP_FALSE:    vmstack_push(vm, BOOL_VAL(false));      break;
-      case OP_POP:      vmstack_pop(vm);                        break;
-      case OP_EQUAL: {
-         VmValue val1 = vmstack_pop(vm);
-         VmValue val2 = vmstack_pop(vm);
-         if (IS_LOOPVAR(val1)) {
-            val1 = INT_VAL(AS_LOOPVAR(val1));
-         }
-         if (IS_LOOPVAR(val2)) {
-            val1 = INT_VAL(AS_LOOPVAR(val1));
-         }
-         vmstack_push(vm, BOOL_VAL(val1 == val2));
-         break;
-      }
-
-      case OP_GREATER:  BINARY_CMP(vm, BOOL_VAL,   >);  break;
-      case OP_LESS:     BINARY_CMP(vm, BOOL_VAL,   <);  break;
-      case OP_ADD:      BINARY_OP(vm,  +);              break;
-      case OP_SUBTRACT: BINARY_OP(vm,  -);              break;
-      case OP_MULTIPLY: BINARY_OP(vm,  *);              break;
-      case OP_DIVIDE:   BINARY_OP(vm,  /);              break;
-      case OP_NOT: {
-         assert(IS_BOOL(vm->stack_top[-1]));
-         vmstack_push(vm, BOOL_VAL(! AS_BOOL(vmstack_pop(vm))));
-         break;
-      }
-
-      case OP_NEGATE:
-         vmstack_push(vm, NUMBER_VAL(-AS_NUMBER(vmstack_pop(vm))));
-         break;
-
-      case OP_JUMP: {
-         uint16_t offset = READ_SHORT(vm);
-         vm->code.ip += offset;
-         break;
-      }
-
-      case OP_JUMP_IF_TRUE: {
-         uint16_t offset = READ_SHORT(vm);
-         if (AS_BOOL(vmstack_pop(vm))) vm->code.ip += offset;
-         break;
-      }
-
-      case OP_JUMP_IF_FALSE: {
-         uint16_t offset = READ_SHORT(vm);
-         if (!AS_BOOL(vmstack_pop(vm))) vm->code.ip += offset;
-         break;
-      }
-
-      case OP_JUMP_IF_TRUE_NOPOP: {
-         uint16_t offset = READ_SHORT(vm);
-         if (AS_BOOL(vmstack_peek(vm, 0))) vm->code.ip += offset;
-         break;
-      }
-
-      case OP_JUMP_IF_FALSE_NOPOP: {
-         uint16_t offset = READ_SHORT(vm);
-         if (!AS_BOOL(vmstack_peek(vm, 0))) vm->code.ip += offset;
-         break;
-      }
-
-      case OP_JUMP_BACK: {
-         uint16_t offset = READ_SHORT(vm);
-         vm->code.ip -= offset;
-         break;
-      }
-
-      case OP_JUMP_BACK_IF_FALSE: {
-         uint16_t offset = READ_SHORT(vm);
-         if (!AS_BOOL(vmstack_pop(vm))) vm->code.ip -= offset;
-         break;
-      }
-
-      case OP_GMS_SYMBOL_READ_SIMPLE: {
-         GIDX_TYPE gidx = READ_GIDX(vm);
-         VmGmsSymIterator *symiter;
-
-         N_CHECK_EXIT(symiter, getgmssymiter(&vm->globals, gidx));
-
-         DEBUGVMRUN_EXEC({print_symiter(symiter, vm); DEBUGVMRUN("%s", "\n"); })
-
-         status = vm_gms_read_symbol(&vm->data, symiter);
-         if (status != OK) { goto _exit; }
-
-         break;
-      }
-
-      case OP_GMS_SYMBOL_READ_EXTEND: {
-         GIDX_TYPE gidx = READ_GIDX(vm);
-         VmGmsSymIterator *symiter;
-
-         N_CHECK_EXIT(symiter, getgmssymiter(&vm->globals, gidx));
-
-         DEBUGVMRUN_EXEC({print_symiter(symiter, vm); DEBUGVMRUN("%s", "\n"); })
-
-         status = gms_read_extend_symb(&vm->data, symiter);
-         if (status != OK) { goto _exit; }
-
-         break;
-      }
-
-      case OP_GMS_EQUVAR_READ_INIT: {
-         uint8_t identtype = READ_BYTE(vm);
-         S_CHECK_EXIT(gms_extend_init(&vm->data, identtype));
-         break;
-      }
-
-      case OP_GMS_EQUVAR_READ_SYNC: {
-         uint8_t identtype = READ_BYTE(vm);
-         S_CHECK_EXIT(gms_equvar_sync(&vm->data, identtype));
-         break;
-      }
-
-      case OP_GMS_MEMBERSHIP_TEST: {
-         GIDX_TYPE gidx = READ_GIDX(vm);
-         VmGmsSymIterator *symiter;
-
-         N_CHECK_EXIT(symiter, getgmssymiter(&vm->globals, gidx));
-
-         bool res;
-         status = vm_membership_test(&vm->data, symiter, &res);
-
-         if (status != OK) { goto _exit; }
-
-         DEBUGVMRUN_EXEC({print_symiter(symiter, vm);
-         DEBUGVMRUN("%s", "  -->  ");
-         })
-
-         vmstack_push(vm, BOOL_VAL(res));
-         break;
-      }
-
-      case OP_EMPAPI_CALL: {
-         uint8_t api_idx = READ_BYTE(vm);
-         assert(api_idx < empapis_len);
-         const EmpApiCall callobj = empapis[api_idx];
-         const empapi fn = callobj.fn;
-         ptrdiff_t argc = callobj.argc;
-         assert(argc <= vm->stack_top - vm->stack);
-         DEBUGVMRUN("%s with %td stack args\n", empapis_names[api_idx], argc);
-
-         int rc = fn(&vm->data, argc, vm->stack_top - argc);
-         if (rc != OK) {
-            error("\n\n[empvm_run] ERROR: return code %d after calling '%s'\n", rc,
-                  empapis_names[api_idx]);
-            status = rc;
-            goto _exit;
-         }
-         /* By convention, the "top" of the call stack is the object worked on
-          * and we keep it here to avoid pushing it later on*/
-         if (argc > 1) vmstack_mvback(vm, argc-1);
-         break;
-      }
-
-      case OP_NEW_OBJ: {
-         uint8_t newobj_call_idx = READ_BYTE(vm);
-         assert(newobj_call_idx < empnewobjs_len);
-
-         const EmpNewObjCall callobj = empnewobjs[newobj_call_idx];
-         const empnewobj fn = callobj.fn;
-         ptrdiff_t argc = callobj.argc;
-         assert(argc <= vm->stack_top - vm->stack);
-         DEBUGVMRUN("%s with %td stack args\n", empnewobjs_names[newobj_call_idx],
-                    argc);
-
-         void *o = fn(&vm->data, argc, vm->stack_top - argc);
-         if (!o) {
-            error("\n\n[empvm_run] ERROR: allocation failed in '%s'\n",
-                  empnewobjs_names[newobj_call_idx]);
-            status = Error_RuntimeError;
-            goto _exit;
-         }
-
-         vmstack_mvback(vm, argc);
-         vmstack_push(vm, callobj.obj2vmval(o));
-
-         if (callobj.get_uid) {
-            vm->data.state.uid_parent = callobj.get_uid(o);
-         }
-         break;
-      }
-
-      /* ---------------------------------------------------------------------
-       * This initializes a LinkLabels based on the stored global object.
-       * - The parent UID is taken from the VM state
-       * ---------------------------------------------------------------------- */
-      case OP_LINKLABELS_INIT: {
-         GIDX_TYPE gidx = READ_GIDX(vm);
-         assert(gidx < vm->globals.len);
-         assert(IS_ARCOBJ(vm->globals.arr[gidx]));
-
-         LinkLabels *linklabels = AS_ARCOBJ(vm->globals.arr[gidx]);
-         LinkLabels *linklabels_cpy;
-         A_CHECK_EXIT(linklabels_cpy, linklabels_dup(linklabels));
-         linklabels_cpy->daguid_parent = vm->data.state.uid_parent;
-
-         S_CHECK_EXIT(linklabels2arcs_add(vm->data.linklabels2arcs, linklabels_cpy));
-
-
-         // HACK: reset variable and double counter
-         avar_reset(&vm->data.equvar.v);
-
-         vm->data.state.linklabels = linklabels_cpy;
-
-         // FIXME: delete code?
-         unsigned nvardims = linklabels_cpy->nvardims;
-         if (nvardims > 0) {
-            REALLOC_EXIT(vm->data.linklabel_ws, int, linklabels_cpy->nvardims);
-         }
-
-         DEBUGVMRUN("DAGUID parent %u", linklabels_cpy->daguid_parent);
-         break;
-      }
-
-      case OP_LINKLABELS_DUP: {
-         GIDX_TYPE gidx = READ_GIDX(vm);
-         assert(gidx < vm->globals.len);
-         assert(IS_ARCOBJ(vm->globals.arr[gidx]));
-
-         LinkLabels *linklabels_src = AS_ARCOBJ(vm->globals.arr[gidx]);
-         LinkLabel *linklabel_cpy;
-
-         double coeff;
-         rhp_idx vi = IdxNA;
-         S_CHECK_EXIT(vmdata_consume_scalardata(&vm->data, &coeff));
-         // HACK
-         S_CHECK_EXIT(vmdata_consume_scalarvar(&vm->data, &vi));
-
-         A_CHECK_EXIT(linklabel_cpy, linklabels_dupaslabel(linklabels_src, coeff, vi));
-         linklabel_cpy->daguid_parent = vm->data.state.uid_parent;
-
-         S_CHECK_EXIT(linklabel2arc_add(vm->data.linklabel2arc, linklabel_cpy));
-
-         DEBUGVMRUN("#%u: ", vm->data.linklabel2arc->len-1);
-         DEBUGVMRUN("#%u <- %.*s", vm->data.linklabel2arc->len-1, linklabel_cpy->label_len,
-                    linklabel_cpy->label);
-         DEBUGVMRUN_EXEC({
-            u8 dim = linklabel_cpy->dim;
-            int * restrict uels = linklabel_cpy->uels;
-
-            for (u8 i = 0; i < dim; ++i) {
-               int dummy; if (i == 0) {DEBUGVMRUN("(");}
-               if (i > 0) { DEBUGVMRUN(",");}
-
-               vm_printuel(&vm->data, uels[i], PO_TRACE_EMPINTERP, &dummy);
-               if (i == dim-1) { DEBUGVMRUN(")");}
-            }
-            if (valid_vi(vi)) {DEBUGVMRUN(" vi = %s", mdl_printvarname(vm->data.mdl, vi));}
-            if (isfinite(coeff) && coeff != 1.) {DEBUGVMRUN(" c = %e", coeff);}
-            });
-         break;
-      }
-
-      /* ---------------------------------------------------------------------
-       * args: N lidx1 ... lidxN
-       * ---------------------------------------------------------------------- */
-      case OP_LINKLABELS_STORE: {
-         assert(vm->data.state.linklabels);
-         LinkLabels *linklabels = vm->data.state.linklabels;
-         assert(linklabels);
-
-         /* This is a dummy read. Otherwise the VM dissassembler is lost */
-         uint8_t nvardims = READ_BYTE(vm);
-         assert(linklabels->nvardims == nvardims);
-
-         int *vardims = NULL;
-         if (nvardims > 0) {
-            S_CHECK_EXIT(scratchint_ensure(&vm->data.equvar.iscratch, nvardims));
-            vardims = vm->data.equvar.iscratch.data;
-
-            for (u8 i = 0; i < nvardims; ++i) {
-               u8 slot = READ_BYTE(vm);
-               int uel_lidx = AS_INT(vm->locals[slot]);
-               vardims[i] = uel_lidx;
-            }
-         }
-
-         double coeff;
-         rhp_idx vi;
-         S_CHECK_EXIT(vmdata_consume_scalardata(&vm->data, &coeff));
-         S_CHECK_EXIT(vmdata_consume_scalarvar(&vm->data, &vi));
-
-         S_CHECK_EXIT(linklabels_add(linklabels, vardims, coeff, vi));
-
-         DEBUGVMRUN("#%u <- %.*s", linklabels->nrecs-1, linklabels->label_len, linklabels->label);
-         DEBUGVMRUN_EXEC({
-            u8 dim = linklabels->dim;
-            int uels[GMS_MAX_INDEX_DIM];
-            int * restrict positions = &linklabels->data[dim];
-            memcpy(uels, linklabels->data, dim*sizeof(*uels));
-
-            for (u8 k = 0; k < nvardims; ++k) {
-               assert(positions[k] < dim);
-               uels[positions[k]] = vardims[k];
-            }
-
-            for (u8 i = 0; i < dim; ++i) {
-               int dummy; if (i == 0) {DEBUGVMRUN("(");}
-               if (i > 0) { DEBUGVMRUN(",");}
-
-               vm_printuel(&vm->data, uels[i], PO_TRACE_EMPINTERP, &dummy);
-               if (i == dim-1) { DEBUGVMRUN(")");}
-            }
-            if (valid_vi(vi)) {DEBUGVMRUN(" vi = %s", mdl_printvarname(vm->data.mdl, vi));}
-            if (isfinite(coeff) && coeff != 1.) {DEBUGVMRUN(" c = %e", coeff);}
-            });
- 
-         break;
-      }
-
-      case OP_LINKLABELS_FINI: {
-         assert(vm->data.state.linklabels);
-         LinkLabels *linklabels = vm->data.state.linklabels;
-
-         /* ---------------------------------------------------------------
-          * If there are no child, then delete the label
-          * --------------------------------------------------------------- */
-
-         if (linklabels->nrecs == 0) {
-            linklabels_free(linklabels);
-            vm->data.linklabels2arcs->len--;
-         }
-
-         vm->data.state.linklabels = NULL;
-         break;
-      }
-
-      case OP_LINKLABELS_KEYWORDS_UPDATE: {
-         assert(vm->data.state.linklabels);
-         LinkLabels *linklabels = vm->data.state.linklabels;
-         unsigned num_children = linklabels->nrecs;
-
-         if (linklabels->nrecs == 0) {
-            errormsg("\n\n[empvm] ERROR: empty linklabels!\n");
-            status = Error_EMPRuntimeError;
-            goto _exit;
-         }
-
-         switch (linklabels->linktype) {
-         case LinkObjAddMapSmoothed: {
-            double param;
-            S_CHECK_EXIT(vmdata_consume_scalardata(&vm->data, &param));
-            SmoothingOperatorData *opdat;
-            A_CHECK_EXIT(opdat, smoothing_operator_data_new(param));
-            linklabels->extras[num_children-1] = opdat;
-            DEBUGVMRUN("log-sum-exp: coeff = %e", param);
-         }
-         default: ;
-
-         }
-         break;
-      }
-
-      case OP_VARC_DUAL: {
-         assert(valid_uid(vm->data.state.uid_parent));
-         assert(valid_mpid(vm->data.state.mpid_dual));
-
-         daguid_t uid_parent = vm->data.state.uid_parent;
-         mpid_t mpid_dual = vm->data.state.mpid_dual;
-
-         /* We don't need it afterwards, reset it */
-         vm->data.state.mpid_dual = MpId_NA;
-
-        double coeff;
-        S_CHECK(vmdata_consume_scalardata(&vm->data, &coeff));
- 
-         ptrdiff_t line_idx = vm->code.ip - vm->instr_start;
-        S_CHECK(Varc_dual(vm->data.mdl, vm->code.line[line_idx], uid_parent,
-                          mpid2uid(mpid_dual), coeff));
-
-
-         break;
-      }
-
-      // FIXME: Delete?
-      case OP_SET_DAGUID_FROM_REGENTRY: {
-         DagRegister *dagregister = vm->data.dagregister;
-         unsigned reglen = dagregister->len;
-
-         if (reglen == 0) {
-            errormsg("\n\n[empvm_run] ERROR: dagregister is empty. Please report this\n");
-            status = Error_EMPRuntimeError;
-            goto _exit;
-         }
-         vm->data.state.uid_parent = dagregister->list[reglen-1]->daguid_parent;
-         assert(valid_uid(vm->data.state.uid_parent));
-
-         break;
-      }
-
-      /* Set the scalar tracker value to zero */
-      case OP_SCALAR_SYMBOL_TRACKER_INIT:
-         switch (vm->data.scalar_tracker) {
-         case ScalarSymbolInactive:
-         case ScalarSymbolRead:
-            vm->data.scalar_tracker = ScalarSymbolZero;
-            break;
-         default:
-            errbugmsg("\n\n[empvm] ERROR: scalar symbol tracker has the wrong value");
-            status = Error_BugPleaseReport;
-            goto _exit;
-         }
-
-         break;
-
-      /* Check that only one value has been read */
-      case OP_SCALAR_SYMBOL_TRACKER_CHECK: {
-         ScalarSymbolStatus symbol_tracker = vm->data.scalar_tracker;
-
-         switch (symbol_tracker) {
-         case ScalarSymbolInactive:
-            errbugmsg("\n\n[empvm] ERROR: scalar symbol tracker is inactive.");
-            status = Error_BugPleaseReport;
-            goto _exit;
-
-         case ScalarSymbolRead:
-            // TODO: improve to provide the user better error message
-            // TODO: TEST!
-            errormsg("\n\n[empvm] ERROR: More than one value read for a given symbol! "
-                     "Exactly one value was expected\n");
-            status = Error_EMPIncorrectInput;
-            goto _exit;
- 
-         case ScalarSymbolZero:
-            vm->data.scalar_tracker = ScalarSymbolRead;
-            break;
-         default:
-            errbug("\n\n[empvm] ERROR: unexpected value %u for symbol tracker.\n", symbol_tracker);
-            status = Error_BugPleaseReport;
-            goto _exit;
-         }
-
-         break;
-      }
-
-      case OP_TAG_EQUVAR_PAIRS: {
-
-         u8 val = READ_BYTE(vm);
-         VarRole vrole = val & 0x7f;
-         bool flipped = val & 0x80, noNL, chk_var_in_equ;
-
-         switch (vrole) {
-         case VarDefiningMap:
-            noNL = true; 
-            chk_var_in_equ = true;
-            break;
-         case VarExplicitMap:
-         case VarImplicitMap:
-            noNL = false;
-            chk_var_in_equ = true;
-            break;
-         case VarMarginal:
-            noNL = false;
-            chk_var_in_equ = false;
-            break;
-         default:
-            errbug("\n\n[empvm] ERROR: unexpected value %u for the equvar pair type\n", vrole);
-            status = Error_BugPleaseReport;
-            goto _exit;
-         }
-
-         Model *mdl = vm->data.mdl;
-         Container *ctr = &mdl->ctr;
-         VarMeta * restrict vmeta = ctr->varmeta;
-         EquMeta * restrict emeta = ctr->equmeta;
-
-         Avar * restrict v = vm->data.v_current;
-         Aequ * restrict e = vm->data.e_current;
-
-         unsigned nvars = ctr_nvars(ctr);
-         unsigned nequs = ctr_nequs(ctr);
-
-         if (v->size != e->size) {
-            error("[empinterp] ERROR on line %u: the %s keyword expects the variable and "
-                  "equation to be of the same size. Here we have %u vs %u\n", vm_linenr(vm),
-                  vrole2keyword(vrole), v->size, e->size);
-            return Error_EMPIncorrectInput;
-         }
-
-         for (unsigned i = 0, len = v->size; i < len; ++i) {
-            rhp_idx vi = avar_fget(v, i);
-            rhp_idx ei = aequ_fget(e, i);
-
-            if (RHP_UNLIKELY(!chk_vi_(vi, nvars))) {
-               error("[empinterp] ERROR on line %u: the index %u of variable is outside of "
-                     "the range [0,%u). Position is %u.\n", vm_linenr(vm), vi, nvars, i);
-               return Error_EMPRuntimeError;
-            }
-
-            if (RHP_UNLIKELY(!chk_ei_(ei, nequs))) {
-               error("[empinterp] ERROR on line %u: the index %u of equation is outside of "
-                     "the range [0,%u). Position is %u\n", vm_linenr(vm), ei, nequs, i);
-               return Error_EMPRuntimeError;
-            }
-
-            double dummy;
-            int nlflag;
-            if (chk_var_in_equ && !ctr_equ_findvar(ctr, ei, vi, &dummy, &nlflag)) {
-               error("[empinterp] ERROR on line %u: while processing a %s statement"
-                     "the variable '%s' is not present in equation '%s'\n", vm_linenr(vm),
-                     vrole2keyword(vrole), ctr_printvarname(ctr, vi), ctr_printequname(ctr, ei));
-               return Error_EMPIncorrectInput;
-            }
-
-            assert((noNL && chk_var_in_equ) || !(noNL && !chk_var_in_equ));
-            if (noNL && nlflag) {
-               error("[empinterp] ERROR on line %u: while processing a %s statement. "
-                     "The variable '%s' in equation '%s' appears nonlinearly."
-                     "This is now allowed\n", vm_linenr(vm), vrole2keyword(vrole),
-                     ctr_printvarname(ctr, vi), ctr_printequname(ctr, ei));
-               return Error_EMPIncorrectInput;
-            }
-
-            vmeta[vi].type  = vrole;
-
-            if (vrole == VarDefiningMap || vrole == VarExplicitMap || vrole == VarImplicitMap) {
-               emeta[ei].role  = EquIsMap;
-
-               vmeta[vi].ppty |= nlflag ? VarIsImplicitlyDefined : VarIsExplicitlyDefined;
-               emeta[ei].ppty |= nlflag ? EquPptyIsImplicit : EquPptyIsExplicit;
-
-            } else if (vrole == VarMarginal) {
-
-               S_CHECK(rhp_idx_addsorted(&mdl->empinfo.equvar.marginalVars, vi));
-               emeta[ei].role = EquDualizedConstraint;
-               emeta[ei].dual = vi;
-               vmeta[vi].dual = ei;
-               ctr->equs[ei].object = Mapping; /* FIXME: ugly, but otw we get into trouble in FOOC */
-
-
-            }
-
-            if (flipped) {
-               emeta[ei].ppty |= EquPptyIsFlipped;
-            }
-
-         }
-
-         switch (vrole) {
-         case VarDefiningMap:
-            mdl->empinfo.equvar.num_deffn += v->size;
-            break;
-         case VarExplicitMap:
-            mdl->empinfo.equvar.num_explicit += v->size;
-            break;
-         case VarImplicitMap:
-            mdl->empinfo.equvar.num_implicit += v->size;
-            break;
-         default: ;
-         }
-
-         break;
-      }
-
-      /* Put a scalar into the read values */
-      case OP_HACK_SCALAR2VMDATA: {
-         GIDX_TYPE gidx = READ_GIDX(vm); assert(gidx < vm->data.globals->scalars.len);
-         double val = vm->data.globals->scalars.list[gidx];
-         DEBUGVMRUN("stored %e", val);
-         vm->data.equvar.dval = val;
-         break;
-      }
-
-      /* FIXME: Delete scalar variable. This avoid it being taking into account when storing or
-       * duplicating a linklabel */
-      case OP_HACK_DEL_SCALARVAR: {
-         avar_reset(&vm->data.equvar.v);
-         break;
-      }
-
-      /* FIXME: Delete scalar. This avoid it being taking into account when storing or
-       * duplicating a linklabel */
-      case OP_HACK_DEL_SCALARPARAM: {
-         vm->data.equvar.dnrecs = UINT_MAX;
-         vm->data.equvar.dval = NAN;
-         break;
-      }
-
-      case OP_END: {
-         // HACK: turn this into an error?
-         if (vm->stack != vm->stack_top) {
-            errormsg("\n\n[empvm_run]: ERROR: stack non-empty at the end.\n");
-         }
-         vm->code.ip = vm->instr_start;
+   if (vm->stack_top > vm->stack) {
+      trace_empinterp("\nstack%n", &poffset);
+      for (VmValue *val = vm->stack; val < vm->stack_top; val++, poffset = 0) {
+         trace_empinterp("%*s", 50-poffset, "");
+         print_vmval_full(*val, vm);
          trace_empinterp("\n");
-         return OK;
       }
 
-      default:
-         errbug("\n\n[empvm_run]: ERROR: unhandled instruction %s #%u\n", opcodes_name(instr), instr);
-         status = Error_BugPleaseReport;
-         goto _exit;
-      }
-   }
-
+      trace_empinterp("[%5td] %30s%10s",
+                      (vm->code.ip - vm->instr_start) - 1, opcodes_name(instr), "");
 
+   } else {
 
-_exit:
+      trace_empinterp("\n[%5td] %30s%10s",
+                      (vm->code.ip - vm->instr_start) - 1, opcodes_name(instr), "");
+   }
+}
 
-   linenr = getlinenr(vm);
+/**
+ * @brief Report a runtime error with the offending line of the empinfo file
+ *
+ * @param vm      the EMP VM
+ * @param status  the error code
+ *
+ * @return        the error code
+ */
+static int empvm_runtime_error(EmpVm *vm, int status)
+{
+   int poffset;
+   unsigned linenr = getlinenr(vm);
    error("\n\n[empvm_run] %nERROR on line %u:\n", &poffset, linenr);
 
    const char * restrict start = vm->data.interp->buf, * restrict end;
@@ -1915,3 +1091,75 @@ _exit:
 
    return status;
 }
+
+/* ---------------------------------------------------------------------
+ * The main loop is instantiated twice from empinterp_vm_run.inc:
+ * - empvm_run_fast() does not check the trace flag at all
+ * - empvm_run_traced() prints the stack and the effect of each instruction
+ *
+ * Computed gotos are used for the dispatch whenever the compiler supports
+ * labels as values. Define RHP_EMPVM_SWITCH_DISPATCH to use a switch.
+ * --------------------------------------------------------------------- */
+
+#if defined(__GNUC__) && !defined(RHP_EMPVM_SWITCH_DISPATCH)
+#  define EMPVM_COMPUTED_GOTO
+#endif
+
+#define EMPVM_RUN_NAME           empvm_run_fast
+#define EMPVM_TRACE              0
+#define VMTRACE(...)
+#define VMTRACE_EXEC(EXPR)
+#define VM_PUSH(vm, val)         vmstack_push_notrace(vm, val)
+#define VM_POP(vm)               vmstack_pop_notrace(vm)
+
+#include "empinterp_vm_run.inc"
+
+#undef EMPVM_RUN_NAME
+#undef EMPVM_TRACE
+#undef VMTRACE
+#undef VMTRACE_EXEC
+#undef VM_PUSH
+#undef VM_POP
+
+#define EMPVM_RUN_NAME           empvm_run_traced
+#define EMPVM_TRACE              1
+#define VMTRACE(...)             trace_empinterp(__VA_ARGS__);
+#define VMTRACE_EXEC(EXPR)       EXPR
+#define VM_PUSH(vm, val)         vmstack_push(vm, val)
+#define VM_POP(vm)               vmstack_pop(vm)
+
+#include "empinterp_vm_run.inc"
+
+#undef EMPVM_RUN_NAME
+#undef EMPVM_TRACE
+#undef VMTRACE
+#undef VMTRACE_EXEC
+#undef VM_PUSH
+#undef VM_POP
+
+/**
+ * @brief Execute the bytecode of the EMP VM
+ *
+ * If the EMP interpreter is traced, an instrumented loop is used. Otherwise,
+ * the untraced loop is used.
+ *
+ * @param vm  the EMP VM
+ *
+ * @return    the error code
+ */
+int empvm_run(struct empvm *vm)
+{
+   if (RHP_UNLIKELY(O_Output & PO_TRACE_EMPINTERP)) {
+      S_CHECK(empvm_dissassemble(vm, PO_TRACE_EMPINTERP));
+      trace_empinterp("\n\n");
+
+      return empvm_run_traced(vm);
+   }
+
+#ifndef NDEBUG
+   /* This validates the bytecode */
+   S_CHECK(empvm_dissassemble(vm, PO_TRACE_EMPINTERP));
+#endif
+
+   return empvm_run_fast(vm);
+}
@@ -25,6 +25,7 @@
 #ifndef EMPPARSER_VM_H
 #define EMPPARSER_VM_H
 
+#include <limits.h>
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -32,6 +33,7 @@
 #include "empinterp.h"
 #include "equ.h"
 #include "reshop_data.h"
+#include "uelset_index.h"
 #include "var.h"
 
 typedef enum {
@@ -43,6 +45,7 @@ typedef enum {
    OP_PUSH_FALSE,         // 0 arg
    OP_PUSH_TRUE,         // 0 arg
    OP_LOOPVAR_UPDATE,
+   OP_LOOPVARS_SETFROM_JOIN,  // 2 args: lidx of the record index, join index
    OP_POP,
    OP_NIL,
    OP_TRUE,
@@ -77,15 +80,20 @@ typedef enum {
    OP_JUMP_IF_FALSE_NOPOP,   // 1 arg: 16 bits offset
    OP_JUMP_BACK,             // 1 arg: 16 bits offset
    OP_JUMP_BACK_IF_FALSE,    // 1 arg: 16 bits offset
+   OP_LOOP_NEXT_VMUINT,      // 3 args: lidx, uint idx of the max, 16 bits offset
+   OP_LOOP_NEXT_LIDX,        // 3 args: lidx, lidx of the max, 16 bits offset
    OP_GMS_EQUVAR_READ_INIT,       // 1 arg: IdentType
    OP_GMS_EQUVAR_READ_SYNC,       // 1 arg: IdentType
    OP_GMS_SYMBOL_READ_SIMPLE, // 1 arg: a global idx
    OP_GMS_SYMBOL_READ_EXTEND,    // 1 arg: a global idx
    OP_GMS_MEMBERSHIP_TEST,   // 1 arg: a global idx; PUSH a BOOL on the stack
+   OP_GMS_MEMBERSHIP_TEST_JUMP_IF_TRUE, // 2 args: a global idx and a 16 bits offset
    OP_GMS_SET_FIRST,         //
    OP_GMS_SET_LAST,          //
    OP_EMPAPI_CALL,           // 2 args: api_idx in enum EmpApi and argc
    OP_NEW_OBJ,               // 1 arg is in enum EmpNewObj
+   OP_MP_STAGE_VARS,         // 0 arg: the MP is on top of the stack
+   OP_MP_STAGE_CONS,         // 0 arg: the MP is on top of the stack
    OP_LINKLABELS_INIT,
    OP_LINKLABELS_DUP,
    OP_LINKLABELS_KEYWORDS_UPDATE,
@@ -131,11 +139,17 @@ typedef union {
 
 
 
-/* This is a hack to make sure the compiler and the VM read the same data */
-#define READ_GIDX      READ_SHORT
-#define GIDX_TYPE      uint16_t
-#define GIDX_MAX       UINT16_MAX
-#define EMIT_GIDX(tape, gidx)   emit_short(tape, gidx); assert((gidx) < GIDX_MAX);
+/* Global indices are encoded on 16 bits. Larger indices are encoded as the
+ * GIDX_WIDE escape value followed by the index on 32 bits. READ_GIDX is defined
+ * below, so that the compiler and the VM read the same data. */
+#define GIDX_TYPE      uint32_t
+#define GIDX_MAX       UINT32_MAX
+#define GIDX_WIDE      UINT16_MAX
+#define EMIT_GIDX(tape, gidx)   emit_gidx(tape, gidx)
+
+/* Jump offsets are encoded on 16 bits. A jump whose offset does not fit has the
+ * JUMP_FAR operand, and its offset is stored in the far jump table of the code */
+#define JUMP_FAR       UINT16_MAX
 
 #define INSTR_MAX      UINT8_MAX
 #define LIDX_TYPE      uint8_t
@@ -200,6 +214,51 @@ typedef struct arcvfobj_array {
 #define RHP_ELT_INVALID ((ArcVFObj){.id_parent = MpId_NA, .id_child = MpId_NA})
 #include "array_generic.inc"
 
+/** Membership index of a GAMS set, shared by all the membership tests */
+typedef struct {
+   const void *set;             /**< Set object (IntArray, GDX reader or GMD symbol) */
+   unsigned symidx;             /**< Symbol index for GDX sets                        */
+   UelSetIndex *index;          /**< Membership index                                 */
+} VmSetIndex;
+
+typedef struct {
+   unsigned len;
+   unsigned max;
+   VmSetIndex *arr;
+} VmSetIndices;
+
+/** Records of the set filtering a loop, as in loop((i,j)$s(i,j), ...).
+ *  The loop goes over these records instead of the product of the loop sets. */
+typedef struct {
+   uint8_t dim;                            /**< Number of loop sets                    */
+   unsigned nrecs;                         /**< Number of records                      */
+   LIDX_TYPE idx_lidx[GMS_MAX_INDEX_DIM];  /**< Local variables for the set positions  */
+   LIDX_TYPE iter_lidx[GMS_MAX_INDEX_DIM]; /**< Local variables for the set elements   */
+   unsigned *pos;                          /**< Positions in the loop sets (nrecs*dim) */
+   int *uels;                              /**< Elements of the loop sets (nrecs*dim)  */
+} VmSetJoin;
+
+typedef struct {
+   unsigned len;
+   unsigned max;
+   VmSetJoin *arr;
+} VmSetJoins;
+
+/** Variables and constraints to add to an MP. They are collected over the
+ *  statements of the MP and added in one call before the next EMP API call. */
+typedef struct {
+   MathPrgm *mp;                /**< MP of the staged elements, NULL if none */
+   IntArray vars;               /**< Staged variables                        */
+   IntArray equs;               /**< Staged constraints                      */
+} VmMpStaging;
+
+/** Memoized translation of GMD UELs into DCT UELs: 0 if not translated yet,
+ *  negative if the UEL is not in the DCT */
+typedef struct {
+   unsigned len;
+   int *arr;
+} UelTranslation;
+
 /** Help ensure that exactly 1 record of a symbol has been read */
 typedef enum {
    ScalarSymbolInactive,  /**<  No tracking is happening    */
@@ -243,6 +302,10 @@ typedef struct {
    int *linklabel_ws;           /* why is this not iscratch ?*/
 
    ArcVFObjArray arcvfobjs;
+   VmSetIndices setindices;     /**< Membership indices of the GAMS sets */
+   VmSetJoins setjoins;         /**< Records driving the filtered loops  */
+   VmMpStaging mp_staged;       /**< MP additions not yet performed      */
+   UelTranslation uels_gmd2dct; /**< Translation of GMD UELs into DCT UELs */
 
    /* Borrowed data follow */
    Model *mdl;
@@ -284,11 +347,20 @@ const char* opcodes_name(EmpVmOpCode op);
 #define UINT8_COUNT (UINT8_MAX + 1)
 #define STACK_MAX   UINT8_COUNT
 
+/** Jump whose offset does not fit in the 16 bits operand */
+typedef struct {
+   unsigned addr;                 /**< Address of the jump operand  */
+   unsigned offset;               /**< Jump offset                  */
+} VmFarJump;
+
 typedef struct {
    unsigned len;
    unsigned max;
    uint8_t* ip;
    unsigned* line;
+   unsigned nfarjumps;            /**< Number of far jumps             */
+   unsigned maxfarjumps;          /**< Size of the far jumps array     */
+   VmFarJump *farjumps;           /**< Far jumps, sorted by address    */
 } VmCode;
 
 typedef struct VmValueArray {
@@ -358,13 +430,22 @@ static inline void vmcode_init(VmCode *code)
    code->max = 0;
    code->ip = NULL;
    code->line = NULL;
+   code->nfarjumps = 0;
+   code->maxfarjumps = 0;
+   code->farjumps = NULL;
+}
+
+static inline void vmcode_reset(VmCode *code)
+{
+   code->len = 0;
+   code->nfarjumps = 0;
 }
 
 static inline int vmcode_resize(VmCode *code, unsigned size)
 {
    MALLOC_(code->ip, uint8_t, size);
    MALLOC_(code->line, unsigned, size);
-   code->len = 0;
+   vmcode_reset(code);
    code->max = size;
 
    return OK;
@@ -400,6 +481,74 @@ static inline void vmcode_free(VmCode *code)
 {
    FREE(code->ip);
    FREE(code->line);
+   FREE(code->farjumps);
 }
 
+/**
+ * @brief Record the offset of a far jump
+ *
+ * @param code    the bytecode
+ * @param addr    the address of the jump operand
+ * @param offset  the jump offset
+ *
+ * @return        the error code
+ */
+static inline int vmcode_farjump_add(VmCode *code, unsigned addr, unsigned offset)
+{
+   if (code->nfarjumps >= code->maxfarjumps) {
+      code->maxfarjumps = MAX(2*code->maxfarjumps, 4);
+      REALLOC_(code->farjumps, VmFarJump, code->maxfarjumps);
+   }
+
+   /* Forward jumps are patched out of order: keep the array sorted */
+   unsigned i = code->nfarjumps++;
+   while (i > 0 && code->farjumps[i-1].addr > addr) {
+      code->farjumps[i] = code->farjumps[i-1];
+      i--;
+   }
+
+   code->farjumps[i] = (VmFarJump){.addr = addr, .offset = offset};
+
+   return OK;
+}
+
+/**
+ * @brief Get the offset of a far jump
+ *
+ * @param code  the bytecode
+ * @param addr  the address of the jump operand
+ *
+ * @return      the jump offset, or UINT_MAX if there is no far jump at addr
+ */
+static inline unsigned vmcode_farjump_get(const VmCode *code, unsigned addr)
+{
+   unsigned lo = 0, hi = code->nfarjumps;
+
+   while (lo < hi) {
+      unsigned mid = lo + (hi - lo) / 2;
+      unsigned mid_addr = code->farjumps[mid].addr;
+
+      if (mid_addr == addr) { return code->farjumps[mid].offset; }
+      if (mid_addr < addr) { lo = mid + 1; } else { hi = mid; }
+   }
+
+   return UINT_MAX;
+}
+
+static inline unsigned vmcode_read_gidx(uint8_t **ip)
+{
+   const uint8_t *p = *ip;
+   unsigned gidx = ((unsigned)p[0] << 8) | p[1];
+
+   if (RHP_LIKELY(gidx != GIDX_WIDE)) {
+      *ip += 2;
+      return gidx;
+   }
+
+   *ip += 6;
+   return ((unsigned)p[2] << 24) | ((unsigned)p[3] << 16) | ((unsigned)p[4] << 8) | p[5];
+}
+
+#define READ_GIDX(vm) vmcode_read_gidx(&(vm)->code.ip)
+
 #endif // !EMPPARSER_VM_H
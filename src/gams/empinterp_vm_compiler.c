@@ -10,6 +10,7 @@
 #include "empinterp_utils.h"
 #include "empinterp_vm.h"
 #include "empinterp_vm_compiler.h"
+#include "empinterp_vm_tape.h"
 #include "empinterp_vm_utils.h"
 #include "empparser_priv.h"
 #include "empparser_utils.h"
@@ -118,11 +119,6 @@ typedef struct empvm_compiler {
    EmpVm *vm;
 } Compiler;
 
-typedef struct empvm_tape {
-   VmCode *code;
-   unsigned linenr;
-} Tape;
-
 const char * identtype2str(IdentType type)
 {
    const char *identtype_str_[IdentTypeMaxValue] = {
@@ -325,10 +321,6 @@ static int c_normalize_jumps_depth(Compiler *c)
    (c)->state.vmstack_max = MAX((c)->state.vmstack_max, (c)->state.vmstack_depth + (argc))
 
 
-static inline int emit_byte(Tape *tape, uint8_t byte) {
-   return vmcode_add(tape->code, byte, tape->linenr);
-}
-
 static inline int _emit_bytes(Tape *tape, unsigned argc, ...) {
    int status = OK;
    va_list ap;
@@ -364,38 +356,16 @@ NONNULL static Compiler* ensure_vm_mode(Interpreter *interp)
 
 #define emit_bytes(tape, ...) _emit_bytes(tape, VA_NARG_TYPED(u8, __VA_ARGS__), __VA_ARGS__); 
 
-static inline int emit_short(Tape *tape, uint16_t short_) {
-   S_CHECK(emit_byte(tape, (short_ >> 8) & 0xff));
-   return emit_byte(tape, short_ & 0xff);
-}
-
-static inline int _emit_jumpback_len(Tape *tape, unsigned loop_start)
-{
-   unsigned offset = tape->code->len - loop_start + 2;
-   if (offset > UINT16_MAX) errormsg("Loop body too large.");
-
-   return emit_short(tape, offset);
-}
-
-UNUSED static inline int emit_jump_back(Tape *tape, unsigned loop_start) {
-   S_CHECK(emit_byte(tape, OP_JUMP_BACK));
-   return _emit_jumpback_len(tape, loop_start);
-}
-
-static inline int emit_jump_back_false(Tape *tape, unsigned loop_start) {
-   S_CHECK(emit_byte(tape, OP_JUMP_BACK_IF_FALSE));
-   return _emit_jumpback_len(tape, loop_start);
-}
-
-static inline int emit_jump(Tape *tape, uint8_t instr, unsigned *jump_addr) {
-   S_CHECK(emit_byte(tape, instr));
+/* Membership test followed by a jump if true, as a single superinstruction */
+static inline int emit_membership_test_jump(Tape *tape, unsigned gidx, unsigned *jump_addr) {
+   S_CHECK(emit_byte(tape, OP_GMS_MEMBERSHIP_TEST_JUMP_IF_TRUE));
+   S_CHECK(EMIT_GIDX(tape, gidx));
    S_CHECK(emit_short(tape, 0xffff));
 
-   assert(tape->code->len > 2);
    *jump_addr = tape->code->len - 2;
 
-   trace_empparser("[empcompiler] EMITTING jump '%s' @%u\n", opcodes_name(instr),
-                   *jump_addr);
+   trace_empparser("[empcompiler] EMITTING jump '%s' @%u\n",
+                   opcodes_name(OP_GMS_MEMBERSHIP_TEST_JUMP_IF_TRUE), *jump_addr);
 
    return OK;
 }
@@ -420,7 +390,7 @@ UNUSED static inline int emit_patchable_short(Tape *tape, unsigned *addr) {
 UNUSED static inline int make_global(EmpVm *vm, VmValue value, GIDX_TYPE *i) {
    S_CHECK(vmvals_add(&vm->globals, value));
    unsigned idx = vm->globals.len-1;
-   if (idx > GIDX_MAX) {
+   if (idx >= GIDX_MAX) {
       errormsg("[empcompiler] Too many constants ");
       return Error_EMPRuntimeError;
    }
@@ -429,25 +399,6 @@ UNUSED static inline int make_global(EmpVm *vm, VmValue value, GIDX_TYPE *i) {
    return OK;
 }
 
-static int patch_jump(Tape *tape, unsigned jump_addr)
-{
-   // -2 to adjust for the bytecode for the jump jump_addr itself.
-   assert(jump_addr >= 2 && tape->code->len > jump_addr - 2);
-   unsigned jump_val = tape->code->len - jump_addr - 2;
-
-   if (jump_val >= UINT16_MAX) {
-      error("[empcompiler] jump %u too large, max is %u", jump_val, UINT16_MAX-1);
-      return Error_EMPRuntimeError;
-   }
-
-   trace_empparser("[empcompiler] PATCHING jump @%u to %u\n", jump_addr-1, jump_val);
-
-   tape->code->ip[jump_addr] = (jump_val >> 8) & 0xff;
-   tape->code->ip[jump_addr + 1] = jump_val & 0xff;
-
-   return OK;
-}
-
 UNUSED static int patch_byte(Tape *tape, unsigned addr, uint8_t val) {
    assert(tape->code->len > addr);
 
@@ -561,7 +512,7 @@ static inline int end_scope(Interpreter *interp, UNUSED Tape* tape) {
          S_CHECK(empvm_run(c->vm));
       }
 
-      c->vm->code.len = 0;
+      vmcode_reset(&c->vm->code);
 
       if (interp->ops->type == InterpreterOpsCompiler) {
          interp->ops = &interp_ops_imm;
@@ -709,7 +660,6 @@ static int declare_localvar(Interpreter * restrict interp, Tape *tape,
                             IdentType type, unsigned initval_gidx,
                             LIDX_TYPE * restrict idx)
 {
-   assert(initval_gidx <= GIDX_MAX);
    Lexeme lvar_lexeme = {.linenr = interp->linenr};
    Compiler * restrict c = interp->compiler;
    LIDX_TYPE lidx;
@@ -983,7 +933,8 @@ int loop_increment(Tape * restrict tape, LoopIterators* restrict iterators)
    const IdentData* restrict idents = iterators->idents;
    CodegenIteratorData* restrict iters = iterators->iters;
 
-   /* a_idx++; if (a_idx < a_max); jump to loop_start */
+   /* a_idx++; if (a_idx < a_max); jump to loop_start
+    * This is done by a single superinstruction */
    for (unsigned i = niters-1; i < niters; --i) {
 
       const IdentData * restrict ident = &idents[i];
@@ -992,24 +943,22 @@ int loop_increment(Tape * restrict tape, LoopIterators* restrict iterators)
 
       if (ident->type == IdentLoopIterator) { continue; }
 
-      S_CHECK(emit_bytes(tape, OP_LVAR_INC, idx_i, OP_PUSH_LIDX, idx_i));
-
       switch (ident->type) {
       case IdentSet:
-         S_CHECK(emit_byte(tape, OP_PUSH_VMUINT));
+      case IdentInternalIndex:
+         S_CHECK(emit_bytes(tape, OP_LOOP_NEXT_VMUINT, idx_i));
          S_CHECK(EMIT_GIDX(tape, iter->idxmax_gidx));
          break;
       case IdentLocalSet:
-         S_CHECK(emit_bytes(tape, OP_PUSH_LIDX, iter->idxmax_lidx));
+         S_CHECK(emit_bytes(tape, OP_LOOP_NEXT_LIDX, idx_i, iter->idxmax_lidx));
          break;
       default:
          error("%s :: unsupported loop index %s", __func__, identtype2str(ident->type));
          return Error_NotImplemented;
       }
-      S_CHECK(emit_byte(tape, OP_EQUAL));
 
       assert(iter->tapepos_at_loopstart < UINT_MAX);
-      S_CHECK(emit_jump_back_false(tape, iter->tapepos_at_loopstart));
+      S_CHECK(_emit_jumpback_len(tape, iter->tapepos_at_loopstart));
 
       if (i > 0) {
          S_CHECK(emit_bytes(tape, OP_LVAR_COPYFROM_GIDX, idx_i));
@@ -1054,6 +1003,7 @@ static int vm_gmssymiter_alloc(Compiler* restrict c, const IdentData *ident,
 
    symiter->ident = *ident;
    symiter->compact = true;
+   symiter->index = NULL;
 
    memset(symiter->uels, 0, dim*sizeof(int));
    S_CHECK(vmvals_add(&c->vm->globals, GMSSYMITER_VAL(symiter)));
@@ -1433,11 +1383,8 @@ static int membership_test_start(Interpreter * restrict interp, unsigned * restr
     * if true.
     * --------------------------------------------------------------------- */
 
-   S_CHECK(emit_byte(tape, OP_GMS_MEMBERSHIP_TEST));
-   S_CHECK(EMIT_GIDX(tape, gmsfilter_gidx));
-
    Jump jump = { .depth = jump_depth(c) + 1}; //increase depth just here
-   S_CHECK(emit_jump(tape, OP_JUMP_IF_TRUE, &jump.addr));
+   S_CHECK(emit_membership_test_jump(tape, gmsfilter_gidx, &jump.addr));
    S_CHECK(jumps_add_verbose(&interp->compiler->truey_jumps, jump));
 
    return OK;
@@ -1724,6 +1671,171 @@ static int parse_sameas(Interpreter * restrict interp, unsigned * restrict p,
    return OK;
 }
 
+/**
+ * @brief Check whether the loop conditional is a single set over the loop sets
+ *
+ * We are at the position
+ *         v
+ * loop((i,j)$s(i,j), ...)
+ *
+ * The tokens are only peeked. The loop sets must be global sets, and each of
+ * them must appear once as an index of s, which has to be a global set or
+ * multiset. The conditional must not contain anything else.
+ *
+ * @param      interp    the EMP interpreter
+ * @param      p         the position index
+ * @param      iterators the loop iterators
+ * @param[out] set       the set filtering the loop
+ * @param[out] loop2set  for each loop set, the position of its index in the filter
+ * @param[out] p_end     the position after the conditional, UINT_MAX if the
+ *                       conditional is not a single set
+ *
+ * @return               the error code
+ */
+static int loop_filter_getset(Interpreter * restrict interp, unsigned * restrict p,
+                              const LoopIterators *iterators, IdentData *set,
+                              uint8_t *loop2set, unsigned *p_end)
+{
+   unsigned p2 = *p, niters = iterators->niters;
+   const IdentData *loopidents = iterators->idents;
+   bool seen[GMS_MAX_INDEX_DIM] = {false};
+   TokenType toktype;
+
+   *p_end = UINT_MAX;
+
+   if (niters == 0) { return OK; }
+
+   for (unsigned i = 0; i < niters; ++i) {
+      if (loopidents[i].type != IdentSet || !loopidents[i].ptr) { return OK; }
+   }
+
+   S_CHECK(peek(interp, &p2, &toktype));
+   if (toktype != TOK_IDENT) { return OK; }
+
+   interp_peekseqstart(interp);
+   int status = interp->ops->resolve_tokasident(interp, set);
+   interp_peekseqend(interp);
+   S_CHECK(status);
+
+   switch (set->type) {
+   case IdentSet:
+      if (niters != 1 || !set->ptr) { return OK; }
+      break;
+   case IdentMultiSet:
+      if (set->dim != niters || !set->ptr) { return OK; }
+      if (set->origin != IdentOriginGdx && set->origin != IdentOriginGmd) { return OK; }
+      break;
+   default:
+      return OK;
+   }
+
+   S_CHECK(peek(interp, &p2, &toktype));
+   if (toktype != TOK_LPAREN) { return OK; }
+
+   for (unsigned k = 0; k < niters; ++k) {
+      S_CHECK(peek(interp, &p2, &toktype));
+      if (toktype != TOK_IDENT) { return OK; }
+
+      const char *idxname = emptok_getstrstart(&interp->peek);
+      unsigned idxname_len = emptok_getstrlen(&interp->peek);
+      unsigned loopidx = UINT_MAX;
+
+      for (unsigned i = 0; i < niters; ++i) {
+         const Lexeme *lexeme = &loopidents[i].lexeme;
+         if (!seen[i] && lexeme->len == idxname_len &&
+             !strncasecmp(lexeme->start, idxname, idxname_len)) {
+            loopidx = i;
+            break;
+         }
+      }
+
+      if (loopidx == UINT_MAX) { return OK; }
+
+      seen[loopidx] = true;
+      loop2set[loopidx] = (uint8_t)k;
+
+      S_CHECK(peek(interp, &p2, &toktype));
+      if (toktype != (k+1 < niters ? TOK_COMMA : TOK_RPAREN)) { return OK; }
+   }
+
+   unsigned p_rparen = p2;
+
+   S_CHECK(peek(interp, &p2, &toktype));
+   if (toktype != TOK_COMMA) { return OK; }
+
+   *p_end = p_rparen;
+
+   return OK;
+}
+
+/**
+ * @brief Codegen the start of a loop filtered by a single set
+ *
+ * Rather than iterating over the product of the loop sets and testing whether
+ * each tuple is in the filter, the loop goes over the records of the filter.
+ * The cost then depends on the number of records and not on the size of the
+ * product of the loop sets.
+ *
+ * On output, the iterators consist of the single index over the records.
+ *
+ * @param interp     the EMP interpreter
+ * @param tape       the VM tape
+ * @param iterators  the loop iterators
+ * @param set        the set filtering the loop
+ * @param loop2set   for each loop set, the position of its index in the filter
+ *
+ * @return           the error code
+ */
+static int loop_initandstart_join(Interpreter * restrict interp, Tape * restrict tape,
+                                  LoopIterators * restrict iterators,
+                                  IdentData * restrict set, const uint8_t *loop2set)
+{
+   Compiler *c = interp->compiler;
+   EmpVm *vm = c->vm;
+   u8 niters = iterators->niters;
+
+   unsigned join_idx;
+   S_CHECK(vm_setjoin_new(interp, vm, set, iterators->idents, loop2set, niters, &join_idx));
+
+   /* The loop variables are the same as for the nested loops */
+   S_CHECK(loop_init(interp, tape, iterators));
+
+   VmSetJoin *join = &vm->data.setjoins.arr[join_idx];
+   for (u8 i = 0; i < niters; ++i) {
+      join->idx_lidx[i] = iterators->iters[i].idx_lidx;
+      join->iter_lidx[i] = iterators->iters[i].iter_lidx;
+   }
+
+   trace_empparser("[empcompiler] loop over the %u records of '%.*s' instead of %u nested loops\n",
+                   join->nrecs, lexeme_fmtargs(set->lexeme), niters);
+
+   CodegenIteratorData rec_iter = {.tapepos_at_loopstart = UINT_MAX};
+   S_CHECK(declare_localvar(interp, tape, &set->lexeme, "_rec", IdentInternalIndex,
+                            CstZeroUInt, &rec_iter.idx_lidx));
+
+   S_CHECK(rhp_uint_add(&vm->uints, join->nrecs));
+   rec_iter.idxmax_gidx = vm->uints.len-1;
+
+   /* Skip the loop if no record is left */
+   if (join->nrecs == 0) {
+      Jump jump = { .depth = jump_depth(c) };
+      S_CHECK(emit_jump(tape, OP_JUMP, &jump.addr));
+      S_CHECK(jumps_add_verbose(&c->truey_jumps, jump));
+   }
+
+   rec_iter.tapepos_at_loopstart = tape->code->len;
+
+   S_CHECK(emit_bytes(tape, OP_LOOPVARS_SETFROM_JOIN, rec_iter.idx_lidx));
+   S_CHECK(EMIT_GIDX(tape, join_idx));
+
+   iterators->niters = 1;
+   iterators->idents[0] = *set;
+   iterators->idents[0].type = IdentInternalIndex;
+   iterators->iters[0] = rec_iter;
+
+   return OK;
+}
+
 /**
  * @brief Parse the iterators of a loop/sum statement
  *
@@ -1787,15 +1899,44 @@ static int parse_loopiters_operator(Interpreter * restrict interp, unsigned * re
    tape->linenr = interp->linenr;
  
    iterators_init_from_gmsindices(iterators, &indices);
+
+   S_CHECK(advance(interp, p, &toktype))
+   PARSER_EXPECTS(interp, "a conditional '$' or comma ','", TOK_CONDITION, TOK_COMMA);
+
+   /* ---------------------------------------------------------------------
+    * If the conditional is a single set, as in loop((i,j)$s(i,j), ...), we
+    * iterate over its records.
+    * --------------------------------------------------------------------- */
+
+   if (toktype == TOK_CONDITION) {
+      IdentData filter;
+      uint8_t loop2set[GMS_MAX_INDEX_DIM];
+      unsigned p_end;
+
+      S_CHECK(loop_filter_getset(interp, p, iterators, &filter, loop2set, &p_end));
+
+      if (p_end < UINT_MAX) {
+         S_CHECK(loop_initandstart_join(interp, tape, iterators, &filter, loop2set));
+
+         /* Consume the conditional, which has already been checked */
+         while (*p < p_end) {
+            S_CHECK(advance(interp, p, &toktype))
+         }
+
+         S_CHECK(advance(interp, p, &toktype))
+         S_CHECK(parser_expect(interp, "a ',' after conditional", TOK_COMMA));
+
+         interp->state.read_gms_symbol = true;
+         return OK;
+      }
+   }
+
    S_CHECK(loop_initandstart(interp, tape, iterators));
 
    /* ---------------------------------------------------------------------
     * Step 2:  Parse the conditional (if present)
     * --------------------------------------------------------------------- */
 
-   S_CHECK(advance(interp, p, &toktype))
-   PARSER_EXPECTS(interp, "a conditional '$' or comma ','", TOK_CONDITION, TOK_COMMA);
-
    tape->linenr = interp->linenr;
 
    if (toktype == TOK_CONDITION) {
@@ -2032,11 +2173,8 @@ static int parse_projection_in_conditional(Interpreter * restrict interp, unsign
       LoopIterators arg2iterators;
       S_CHECK(gmssymiter_init(interp, &ident_arg2, &gmsindices, &arg2iterators, tape, &gmsfilter_gidx));
 
-      S_CHECK(emit_byte(tape, OP_GMS_MEMBERSHIP_TEST));
-      S_CHECK(EMIT_GIDX(tape, gmsfilter_gidx));
-
       Jump jump = {.depth = jump_depth(c)};
-      S_CHECK(emit_jump(tape, OP_JUMP_IF_TRUE, &jump.addr));
+      S_CHECK(emit_membership_test_jump(tape, gmsfilter_gidx, &jump.addr));
       S_CHECK(jumps_add_verbose(&c->truey_jumps, jump));
 
       if (!embmode(interp)) { //HACK
@@ -3065,7 +3203,7 @@ static int sexpr_codegen(Interpreter * restrict interp, SimpleExpr * restrict se
                          Compiler *c, Tape * restrict tape,
                          LoopIterators * restrict sum_iterators)
 {
-   unsigned linklabel_gidx = UINT16_MAX;
+   unsigned linklabel_gidx = GIDX_MAX;
 
    // FIXME: this is required, otherwise bogus variables/scalar are added
    if (!sexpr->has_var) {
@@ -4191,9 +4329,8 @@ static int c_read_param(Interpreter* restrict interp, unsigned *p,
    return OK;
 }
 
-static int c_read_elt_vector(Interpreter *interp, const char *vectorname,
-                             IdentData *ident, GmsIndicesData *gmsindices,
-                             UNUSED double *val)
+static int c_read_elt_vector(Interpreter *interp, IdentData *ident,
+                             GmsIndicesData *gmsindices, UNUSED double *val)
 {
    Compiler *c = interp->compiler;
 
@@ -4259,7 +4396,8 @@ static int c_mp_addcons(Interpreter *interp, UNUSED MathPrgm *mp)
    Tape tape_ = {.code = &vm->code, .linenr = interp->linenr};
    Tape * const tape = &tape_;
 
-   S_CHECK(emit_bytes(tape, OP_EMPAPI_CALL, FN_MP_ADDCONS));
+   /* The constraints are staged and added with the other ones in one call */
+   S_CHECK(emit_byte(tape, OP_MP_STAGE_CONS));
 
    return OK;
 }
@@ -4271,7 +4409,8 @@ static int c_mp_addvars(Interpreter *interp, UNUSED MathPrgm *mp)
    Tape tape_ = {.code = &vm->code, .linenr = interp->linenr};
    Tape * const tape = &tape_;
 
-   S_CHECK(emit_bytes(tape, OP_EMPAPI_CALL, FN_MP_ADDVARS));
+   /* The variables are staged and added with the other ones in one call */
+   S_CHECK(emit_byte(tape, OP_MP_STAGE_VARS));
 
    return OK;
 }
@@ -4467,7 +4606,7 @@ int empvm_finalize(Interpreter *interp)
       S_CHECK(empvm_run(c->vm));
    }
 
-   c->vm->code.len = 0;
+   vmcode_reset(&c->vm->code);
    return OK;
 }
 
@@ -4556,7 +4695,6 @@ void empvm_compiler_setgmd(Interpreter * restrict interp)
 int hack_scalar2vmdata(Interpreter *interp, unsigned idx)
 {
    assert(interp->ops->type == InterpreterOpsCompiler);
-   assert(idx < GIDX_MAX);
 
    Compiler *c = interp->compiler;
    EmpVm * restrict vm = c->vm;
@@ -11,6 +11,14 @@
    (vm->code.ip += 2, \
       (unsigned)((vm->code.ip[-2] << 8) | vm->code.ip[-1]))
 
+static unsigned read_jump(EmpVm *vm, const uint8_t *instr_start)
+{
+   unsigned offset = READ_SHORT(vm);
+   if (offset != JUMP_FAR) { return offset; }
+
+   return vmcode_farjump_get(&vm->code, (unsigned)(vm->code.ip - instr_start) - 2);
+}
+
 /** Opcode argument type. Only used in the dissassember */
 enum OpCodeArgType {
    OPARG_NONE,
@@ -25,6 +33,7 @@ enum OpCodeArgType {
    OPARG_LVEC_IDX,
    OPARG_UINT_IDX,
    OPARG_INT_IDX,
+   OPARG_SETJOIN_IDX,
    OPARG_APICALL,
    OPARG_NEWOBJ,
    OPARG_JUMP_BCK,
@@ -55,6 +64,7 @@ const OpCodeArg opcodes_argv[][OP_MAXCODE] = {
    [OP_PUSH_BYTE] = {{OPARG_BYTE},},
    [OP_PUSH_LIDX] = {{OPARG_LIDX},},
    [OP_LOOPVAR_UPDATE] = {{OPARG_LIDX_ASSIGN},{OPARG_LIDX},{OPARG_IDENT_TYPE},{OPARG_IDENT_IDX}},
+   [OP_LOOPVARS_SETFROM_JOIN] = {{OPARG_LIDX},{OPARG_SETJOIN_IDX}},
    [OP_PUSH_VMUINT] = {{OPARG_UINT_IDX},},
    [OP_PUSH_VMINT] = {{OPARG_INT_IDX},},
    [OP_PUSH_FALSE] = {{OPARG_NONE},},
@@ -93,13 +103,18 @@ const OpCodeArg opcodes_argv[][OP_MAXCODE] = {
    [OP_JUMP_IF_FALSE_NOPOP] = {{OPARG_JUMP_FWD},},
    [OP_JUMP_BACK] = {{OPARG_JUMP_BCK},},
    [OP_JUMP_BACK_IF_FALSE] = {{OPARG_JUMP_BCK},},
+   [OP_LOOP_NEXT_VMUINT] = {{OPARG_LIDX}, {OPARG_UINT_IDX}, {OPARG_JUMP_BCK}},
+   [OP_LOOP_NEXT_LIDX] = {{OPARG_LIDX}, {OPARG_LIDX}, {OPARG_JUMP_BCK}},
    [OP_GMS_EQUVAR_READ_INIT] = {{OPARG_BYTE},},
    [OP_GMS_EQUVAR_READ_SYNC] = {{OPARG_BYTE},},
    [OP_GMS_SYMBOL_READ_SIMPLE] = {{OPARG_GIDX},},
    [OP_GMS_SYMBOL_READ_EXTEND] = {{OPARG_GIDX},},
    [OP_GMS_MEMBERSHIP_TEST] = {{OPARG_GIDX},},
+   [OP_GMS_MEMBERSHIP_TEST_JUMP_IF_TRUE] = {{OPARG_GIDX}, {OPARG_JUMP_FWD}},
    [OP_EMPAPI_CALL] = {{OPARG_APICALL},},
    [OP_NEW_OBJ] = {{OPARG_NEWOBJ},},
+   [OP_MP_STAGE_VARS] = {{OPARG_NONE},},
+   [OP_MP_STAGE_CONS] = {{OPARG_NONE},},
    [OP_LINKLABELS_INIT] = {{OPARG_GIDX},},
    [OP_LINKLABELS_DUP] = {{OPARG_GIDX},},
    [OP_LINKLABELS_KEYWORDS_UPDATE] = {{OPARG_NONE},},
@@ -124,6 +139,7 @@ const uint8_t opcodes_argc[OP_MAXCODE] = {
    [OP_PUSH_BYTE] = 1,
    [OP_PUSH_LIDX] = 1, 
    [OP_LOOPVAR_UPDATE] = 4,
+   [OP_LOOPVARS_SETFROM_JOIN] = 2,
    [OP_PUSH_VMUINT] = 1, 
    [OP_PUSH_VMINT] = 1, 
    [OP_POP] = 0,
@@ -160,13 +176,18 @@ const uint8_t opcodes_argc[OP_MAXCODE] = {
    [OP_JUMP_IF_FALSE_NOPOP] = 1,
    [OP_JUMP_BACK] = 1,
    [OP_JUMP_BACK_IF_FALSE] = 1,
+   [OP_LOOP_NEXT_VMUINT] = 3,
+   [OP_LOOP_NEXT_LIDX] = 3,
    [OP_GMS_EQUVAR_READ_INIT] = 1,
    [OP_GMS_EQUVAR_READ_SYNC] = 1,
    [OP_GMS_SYMBOL_READ_SIMPLE] = 1,
    [OP_GMS_SYMBOL_READ_EXTEND] = 1,
    [OP_GMS_MEMBERSHIP_TEST] = 1,
+   [OP_GMS_MEMBERSHIP_TEST_JUMP_IF_TRUE] = 2,
    [OP_EMPAPI_CALL] = 1,
    [OP_NEW_OBJ] = 1,
+   [OP_MP_STAGE_VARS] = 0,
+   [OP_MP_STAGE_CONS] = 0,
    [OP_LINKLABELS_INIT] = 1,
    [OP_LINKLABELS_DUP] = 1,
    [OP_LINKLABELS_KEYWORDS_UPDATE] = 0,
@@ -195,6 +216,7 @@ const uint8_t opcodes_argc[OP_MAXCODE] = {
  DEFSTR(OP_PUSH_FALSE,"PUSH_FALSE") \
  DEFSTR(OP_PUSH_TRUE,"PUSH_TRUE") \
  DEFSTR(OP_LOOPVAR_UPDATE,"LOOPVAR_UPDATE") \
+ DEFSTR(OP_LOOPVARS_SETFROM_JOIN,"LOOPVARS_SETFROM_JOIN") \
  DEFSTR(OP_POP,"POP") \
  DEFSTR(OP_NIL,"NIL") \
  DEFSTR(OP_TRUE,"TRUE") \
@@ -229,15 +251,20 @@ const uint8_t opcodes_argc[OP_MAXCODE] = {
  DEFSTR(OP_JUMP_IF_FALSE_NOPOP,"JUMP_IF_FALSE_NOPOP") \
  DEFSTR(OP_JUMP_BACK,"JUMP_BACK") \
  DEFSTR(OP_JUMP_BACK_IF_FALSE,"JUMP_BACK_IF_FALSE") \
+ DEFSTR(OP_LOOP_NEXT_VMUINT,"LOOP_NEXT_VMUINT") \
+ DEFSTR(OP_LOOP_NEXT_LIDX,"LOOP_NEXT_LIDX") \
  DEFSTR(OP_GMS_EQUVAR_READ_INIT,"GMS_EQUVAR_READ_INIT") \
  DEFSTR(OP_GMS_EQUVAR_READ_SYNC,"GMS_EQUVAR_READ_SYNC") \
  DEFSTR(OP_GMS_SYMBOL_READ_SIMPLE,"GMS_SYMBOL_READ_SIMPLE") \
  DEFSTR(OP_GMS_SYMBOL_READ_EXTEND,"GMS_SYMBOL_READ_EXTEND") \
  DEFSTR(OP_GMS_MEMBERSHIP_TEST,"GMS_MEMBERSHIP_TEST") \
+ DEFSTR(OP_GMS_MEMBERSHIP_TEST_JUMP_IF_TRUE,"GMS_MEMBERSHIP_JUMP_IF_TRUE") \
  DEFSTR(OP_GMS_SET_FIRST,"GMS_SET_FIRST") \
  DEFSTR(OP_GMS_SET_LAST,"GMS_SET_LAST") \
  DEFSTR(OP_EMPAPI_CALL,"CALL_API") \
  DEFSTR(OP_NEW_OBJ,"NEW_OBJ") \
+ DEFSTR(OP_MP_STAGE_VARS,"MP_STAGE_VARS") \
+ DEFSTR(OP_MP_STAGE_CONS,"MP_STAGE_CONS") \
  DEFSTR(OP_LINKLABELS_INIT,"LINKLABELS_INIT") \
  DEFSTR(OP_LINKLABELS_DUP,"LINKLABELS_DUP") \
  DEFSTR(OP_LINKLABELS_KEYWORDS_UPDATE,"OP_LINKLABELS_KEYWORDS_UPDATE") \
@@ -336,7 +363,7 @@ static void print_globals(EmpVm *vm, unsigned mode)
    }
 }
 
-static void print_u16(unsigned mode, const char *category, u16 gidx)
+static void print_vmidx(unsigned mode, const char *category, unsigned gidx)
 {
    /* Just in case we want to align
    u8 ndigits;
@@ -377,7 +404,7 @@ int empvm_dissassemble(EmpVm *vm, unsigned mode)
       const OpCodeArg *argv = opcodes_argv[opcode];
       unsigned val = UINT_MAX;
       uint8_t val8 = UINT8_MAX;
-      uint16_t val16;
+      unsigned val16;
 
 
       for (unsigned j = 0; j < argc; ++j) {
@@ -419,22 +446,27 @@ int empvm_dissassemble(EmpVm *vm, unsigned mode)
          case OPARG_GSET_IDX:
             val = READ_GIDX(vm);
             VM_CHK(valid_vmidx(val, vm->data.globals->sets.len, "global sets"));
-            print_u16(mode, "gsets", val);
+            print_vmidx(mode, "gsets", val);
             break;
          case OPARG_LSET_IDX:
             val = READ_GIDX(vm);
             VM_CHK(valid_vmidx(val, vm->data.globals->localsets.len, "local sets"));
-            print_u16(mode, "lsets", val);
+            print_vmidx(mode, "lsets", val);
             break;
          case OPARG_UINT_IDX:
             val = READ_GIDX(vm);
             VM_CHK(valid_vmidx(val, vm->uints.len, "VM uints"));
-            print_u16(mode, "uints", val);
+            print_vmidx(mode, "uints", val);
             break;
          case OPARG_INT_IDX:
             val = READ_GIDX(vm);
             VM_CHK(valid_vmidx(val, vm->ints.len, "VM ints"));
-            print_u16(mode, "ints", val);
+            print_vmidx(mode, "ints", val);
+            break;
+         case OPARG_SETJOIN_IDX:
+            val = READ_GIDX(vm);
+            VM_CHK(valid_vmidx(val, vm->data.setjoins.len, "set joins"));
+            print_vmidx(mode, "setjoins", val);
             break;
          case OPARG_APICALL:
             val8 = READ_BYTE(vm);
@@ -453,7 +485,12 @@ int empvm_dissassemble(EmpVm *vm, unsigned mode)
             printout(mode, "%20s ", empnewobjs_names[val8]);
             break;
          case OPARG_JUMP_FWD: {
-            val16 = READ_SHORT(vm);
+            val16 = read_jump(vm, instr_start);
+            if (val16 == UINT_MAX) {
+               error("\n No far jump recorded at @%td\n", vm->code.ip - instr_start - 2);
+               status = Error_EMPRuntimeError;
+               break;
+            }
             if (&vm->code.ip[val16] > &instr_start[vm->code.len]) {
                error("\n Forward jump too far (%u > %td)\n", val16,
                       &instr_start[vm->code.len]-vm->code.ip);
@@ -470,12 +507,17 @@ int empvm_dissassemble(EmpVm *vm, unsigned mode)
             break;
          }
          case OPARG_JUMP_BCK: {
-            val16 = READ_SHORT(vm);
+            val16 = read_jump(vm, instr_start);
+            if (val16 == UINT_MAX) {
+               error("\n No far jump recorded at @%td\n", vm->code.ip - instr_start - 2);
+               status = Error_EMPRuntimeError;
+               break;
+            }
             if (val16 > vm->code.ip - instr_start) {
                error("Backward jump value too big %u > %td\n", val16, vm->code.ip - instr_start);
                status = Error_EMPRuntimeError;
             }
-            uint8_t opcode_ = vm->code.ip[-val16];
+            uint8_t opcode_ = *(vm->code.ip - val16);
             if (opcode >= OP_MAXCODE) {
                error("Illegal forward jump value %u\n", opcode_);
                status = Error_EMPRuntimeError;
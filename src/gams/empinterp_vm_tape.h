@@ -0,0 +1,96 @@
+#ifndef EMPINTERP_VM_TAPE_H
+#define EMPINTERP_VM_TAPE_H
+
+#include <assert.h>
+
+#include "empinterp_vm.h"
+#include "printout.h"
+#include "status.h"
+
+/* Tape of the EMP compiler: the bytecode being emitted and the current line.
+ * The emitters below produce the encoding of the global indices and jump
+ * offsets read by the VM and the dissembler. */
+
+typedef struct empvm_tape {
+   VmCode *code;
+   unsigned linenr;
+} Tape;
+
+static inline int emit_byte(Tape *tape, uint8_t byte) {
+   return vmcode_add(tape->code, byte, tape->linenr);
+}
+
+static inline int emit_short(Tape *tape, uint16_t short_) {
+   S_CHECK(emit_byte(tape, (short_ >> 8) & 0xff));
+   return emit_byte(tape, short_ & 0xff);
+}
+
+/* Emit a global index, with the GIDX_WIDE escape if it does not fit in 16 bits */
+static inline int emit_gidx(Tape *tape, unsigned gidx) {
+   assert(gidx < GIDX_MAX);
+
+   if (RHP_LIKELY(gidx < GIDX_WIDE)) {
+      return emit_short(tape, (uint16_t)gidx);
+   }
+
+   S_CHECK(emit_short(tape, GIDX_WIDE));
+   S_CHECK(emit_short(tape, (uint16_t)(gidx >> 16)));
+   return emit_short(tape, (uint16_t)(gidx & 0xffff));
+}
+
+static inline int _emit_jumpback_len(Tape *tape, unsigned loop_start)
+{
+   unsigned offset = tape->code->len - loop_start + 2;
+
+   if (offset >= JUMP_FAR) {
+      trace_empparser("[empcompiler] far jump back @%u of %u\n", tape->code->len, offset);
+      S_CHECK(vmcode_farjump_add(tape->code, tape->code->len, offset));
+      return emit_short(tape, JUMP_FAR);
+   }
+
+   return emit_short(tape, offset);
+}
+
+UNUSED static inline int emit_jump_back(Tape *tape, unsigned loop_start) {
+   S_CHECK(emit_byte(tape, OP_JUMP_BACK));
+   return _emit_jumpback_len(tape, loop_start);
+}
+
+UNUSED static inline int emit_jump_back_false(Tape *tape, unsigned loop_start) {
+   S_CHECK(emit_byte(tape, OP_JUMP_BACK_IF_FALSE));
+   return _emit_jumpback_len(tape, loop_start);
+}
+
+static inline int emit_jump(Tape *tape, uint8_t instr, unsigned *jump_addr) {
+   S_CHECK(emit_byte(tape, instr));
+   S_CHECK(emit_short(tape, 0xffff));
+
+   assert(tape->code->len > 2);
+   *jump_addr = tape->code->len - 2;
+
+   trace_empparser("[empcompiler] EMITTING jump '%s' @%u\n", opcodes_name(instr),
+                   *jump_addr);
+
+   return OK;
+}
+
+static inline int patch_jump(Tape *tape, unsigned jump_addr)
+{
+   // -2 to adjust for the bytecode for the jump jump_addr itself.
+   assert(jump_addr >= 2 && tape->code->len > jump_addr - 2);
+   unsigned jump_val = tape->code->len - jump_addr - 2;
+
+   trace_empparser("[empcompiler] PATCHING jump @%u to %u\n", jump_addr-1, jump_val);
+
+   if (jump_val >= JUMP_FAR) {
+      S_CHECK(vmcode_farjump_add(tape->code, jump_addr, jump_val));
+      jump_val = JUMP_FAR;
+   }
+
+   tape->code->ip[jump_addr] = (jump_val >> 8) & 0xff;
+   tape->code->ip[jump_addr + 1] = jump_val & 0xff;
+
+   return OK;
+}
+
+#endif // !EMPINTERP_VM_TAPE_H
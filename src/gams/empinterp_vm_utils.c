@@ -1,6 +1,12 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "empinterp_ops_utils.h"
 #include "empinterp_vm_utils.h"
 #include "empinterp_utils.h"
 #include "gamsapi_utils.h"
+#include "gdx_reader.h"
+#include "mathprgm.h"
 #include "printout.h"
 
 #include "gmdcc.h"
@@ -128,6 +134,246 @@ int vm_store_set_nrecs_gmd(Interpreter * restrict interp, EmpVm * restrict vm,
    return OK;
 }
 
+/* Records of a set, in the UEL space used by its membership test */
+static int vm_set_tuples(Interpreter * restrict interp, const IdentData * restrict set,
+                         unsigned *len, int **tuples)
+{
+   switch (set->type) {
+   case IdentSet: {
+      const IntArray *arr = set->ptr; assert(arr);
+      *len = arr->len;
+      MALLOC_(*tuples, int, MAX(arr->len, 1));
+      if (arr->len > 0) { memcpy(*tuples, arr->arr, arr->len * sizeof(int)); }
+      return OK;
+   }
+   case IdentMultiSet:
+      switch (set->origin) {
+      case IdentOriginGdx:
+         return gdx_reader_set_tuples(set->ptr, (int)set->idx, set->dim, len, tuples);
+      case IdentOriginGmd:
+         return gmd_set_tuples(interp->gmd, set->ptr, set->dim, len, tuples);
+      case IdentOriginDct:
+         return error_ident_origin_dct(set, __func__);
+      default:
+         return runtime_error(set->lexeme.linenr);
+      }
+   default:
+      return runtime_error(set->lexeme.linenr);
+   }
+}
+
+typedef struct {
+   int uel;
+   unsigned pos;
+} UelPos;
+
+static int uelpos_cmp(const void *a, const void *b)
+{
+   int uel_a = ((const UelPos *)a)->uel, uel_b = ((const UelPos *)b)->uel;
+   return (uel_a > uel_b) - (uel_a < uel_b);
+}
+
+static bool setjoin_issorted(const VmSetJoin *join, unsigned nrecs)
+{
+   uint8_t dim = join->dim;
+
+   for (unsigned r = 1; r < nrecs; ++r) {
+      const unsigned *prev = &join->pos[(size_t)(r-1) * dim], *cur = &prev[dim];
+      for (uint8_t d = 0; d < dim; ++d) {
+         if (prev[d] < cur[d]) { break; }
+         if (prev[d] > cur[d]) { return false; }
+      }
+   }
+
+   return true;
+}
+
+/**
+ * @brief Build the records of a join from the tuples of the filtering set
+ *
+ * For loop((i,j)$s(i,j), ...), the records of s whose elements are in the loop
+ * sets are stored as positions in, and elements of, the loop sets. They are
+ * sorted in the order of the nested loops over the loop sets, so that the loop
+ * over the records visits the same elements in the same order.
+ *
+ * @param[out] join      the join, whose arrays are allocated here
+ * @param      len       the number of tuples of the filtering set
+ * @param      tuples    the tuples of the filtering set (len*dim)
+ * @param      loopsets  the loop sets
+ * @param      loop2set  for each loop set, the position of its index in the filter
+ * @param      dim       the number of loop sets
+ *
+ * @return               the error code
+ */
+int vm_setjoin_build(VmSetJoin * restrict join, unsigned len, const int *tuples,
+                     const IntArray * const *loopsets, const uint8_t *loop2set,
+                     uint8_t dim)
+{
+   int status = OK;
+   unsigned nrecs = 0, maxsetlen = 0;
+   UelPos *lookups[GMS_MAX_INDEX_DIM] = {NULL};
+   unsigned *perm = NULL, *perm2 = NULL, *counts = NULL;
+
+   assert(dim > 0 && dim <= GMS_MAX_INDEX_DIM);
+
+   join->dim = dim;
+   join->nrecs = 0;
+   join->pos = NULL;
+   join->uels = NULL;
+
+   /* Positions of the elements of each loop set, sorted by UEL */
+   for (uint8_t d = 0; d < dim; ++d) {
+      const IntArray *loopset = loopsets[d]; assert(loopset);
+      MALLOC_EXIT(lookups[d], UelPos, MAX(loopset->len, 1));
+
+      for (unsigned i = 0, slen = loopset->len; i < slen; ++i) {
+         lookups[d][i] = (UelPos){.uel = loopset->arr[i], .pos = i};
+      }
+
+      qsort(lookups[d], loopset->len, sizeof(UelPos), uelpos_cmp);
+      maxsetlen = MAX(maxsetlen, loopset->len);
+   }
+
+   MALLOC_EXIT(join->pos, unsigned, (size_t)MAX(len, 1) * dim);
+   MALLOC_EXIT(join->uels, int, (size_t)MAX(len, 1) * dim);
+
+   /* Only keep the records whose elements are all in the loop sets */
+   for (unsigned r = 0; r < len; ++r) {
+      const int *tuple = &tuples[(size_t)r * dim];
+      unsigned *pos = &join->pos[(size_t)nrecs * dim];
+      int *uels = &join->uels[(size_t)nrecs * dim];
+      bool inloopsets = true;
+
+      for (uint8_t d = 0; d < dim && inloopsets; ++d) {
+         UelPos key = {.uel = tuple[loop2set[d]]};
+         const UelPos *found = bsearch(&key, lookups[d], loopsets[d]->len, sizeof(UelPos),
+                                       uelpos_cmp);
+
+         if (found) {
+            pos[d] = found->pos;
+            uels[d] = found->uel;
+         } else {
+            inloopsets = false;
+         }
+      }
+
+      if (inloopsets) { nrecs++; }
+   }
+
+   /* Sort the records by positions, with a counting sort on each loop set,
+    * starting from the innermost one */
+   if (!setjoin_issorted(join, nrecs)) {
+      MALLOC_EXIT(perm, unsigned, nrecs);
+      MALLOC_EXIT(perm2, unsigned, nrecs);
+      MALLOC_EXIT(counts, unsigned, maxsetlen + 1);
+
+      for (unsigned r = 0; r < nrecs; ++r) { perm[r] = r; }
+
+      for (uint8_t d = dim; d-- > 0; ) {
+         unsigned setlen = loopsets[d]->len;
+         memset(counts, 0, (setlen + 1) * sizeof(unsigned));
+
+         for (unsigned r = 0; r < nrecs; ++r) {
+            counts[join->pos[(size_t)perm[r] * dim + d] + 1]++;
+         }
+
+         for (unsigned k = 1; k <= setlen; ++k) { counts[k] += counts[k-1]; }
+
+         for (unsigned r = 0; r < nrecs; ++r) {
+            unsigned v = join->pos[(size_t)perm[r] * dim + d];
+            perm2[counts[v]++] = perm[r];
+         }
+
+         unsigned *tmp = perm; perm = perm2; perm2 = tmp;
+      }
+
+      unsigned *pos_sorted = NULL;
+      int *uels_sorted = NULL;
+      MALLOC_EXIT(pos_sorted, unsigned, (size_t)nrecs * dim);
+      MALLOC_EXIT(uels_sorted, int, (size_t)nrecs * dim);
+
+      for (unsigned r = 0; r < nrecs; ++r) {
+         memcpy(&pos_sorted[(size_t)r * dim], &join->pos[(size_t)perm[r] * dim],
+                dim * sizeof(unsigned));
+         memcpy(&uels_sorted[(size_t)r * dim], &join->uels[(size_t)perm[r] * dim],
+                dim * sizeof(int));
+      }
+
+      FREE(join->pos);
+      FREE(join->uels);
+      join->pos = pos_sorted;
+      join->uels = uels_sorted;
+   }
+
+   join->nrecs = nrecs;
+
+_exit:
+   for (uint8_t d = 0; d < dim; ++d) { FREE(lookups[d]); }
+   FREE(perm);
+   FREE(perm2);
+   FREE(counts);
+
+   if (status != OK) {
+      FREE(join->pos);
+      FREE(join->uels);
+   }
+
+   return status;
+}
+
+/**
+ * @brief Store the records of the set filtering a loop over some sets
+ *
+ * @param      interp    the EMP interpreter
+ * @param      vm        the EMP VM
+ * @param      set       the set filtering the loop
+ * @param      loopsets  the loop sets
+ * @param      loop2set  for each loop set, the position of its index in the filter
+ * @param      dim       the number of loop sets
+ * @param[out] join_idx  the index of the records in the VM data
+ *
+ * @return               the error code
+ *
+ * @see vm_setjoin_build()
+ */
+int vm_setjoin_new(Interpreter * restrict interp, EmpVm * restrict vm,
+                   const IdentData * restrict set, const IdentData * restrict loopsets,
+                   const uint8_t *loop2set, uint8_t dim, unsigned *join_idx)
+{
+   int status = OK;
+   unsigned len = 0;
+   int *tuples = NULL;
+   const IntArray *sets[GMS_MAX_INDEX_DIM];
+   VmSetJoin join = {.dim = dim, .nrecs = 0, .pos = NULL, .uels = NULL};
+
+   assert(dim > 0 && dim <= GMS_MAX_INDEX_DIM);
+   assert((set->type == IdentSet ? 1 : set->dim) == dim);
+
+   S_CHECK(vm_set_tuples(interp, set, &len, &tuples));
+
+   for (uint8_t d = 0; d < dim; ++d) { sets[d] = loopsets[d].ptr; }
+
+   S_CHECK_EXIT(vm_setjoin_build(&join, len, tuples, sets, loop2set, dim));
+
+   VmSetJoins *joins = &vm->data.setjoins;
+   if (joins->len >= joins->max) {
+      joins->max = MAX(2*joins->max, 4);
+      REALLOC_EXIT(joins->arr, VmSetJoin, joins->max);
+   }
+
+   *join_idx = joins->len;
+   joins->arr[joins->len++] = join;
+   join.pos = NULL;
+   join.uels = NULL;
+
+_exit:
+   FREE(tuples);
+   FREE(join.pos);
+   FREE(join.uels);
+
+   return status;
+}
+
 int vmdata_consume_scalarvar(VmData *data, rhp_idx *vi)
 {
    unsigned vlen = data->equvar.v.size;
@@ -145,3 +391,96 @@ int vmdata_consume_scalarvar(VmData *data, rhp_idx *vi)
 }
 
 
+
+/**
+ * @brief Perform the staged additions of variables and constraints to an MP
+ *
+ * @param data  the VM data
+ *
+ * @return      the error code
+ */
+int vmdata_mp_flush(VmData *data)
+{
+   VmMpStaging *staged = &data->mp_staged;
+   MathPrgm *mp = staged->mp;
+
+   if (!mp) { return OK; }
+
+   staged->mp = NULL;
+
+   if (staged->vars.len > 0) {
+      Avar v;
+      avar_setlist(&v, staged->vars.len, staged->vars.arr);
+      staged->vars.len = 0;
+
+      S_CHECK(mp_addvars(mp, &v));
+   }
+
+   if (staged->equs.len > 0) {
+      Aequ e;
+      aequ_aslist(&e, staged->equs.len, staged->equs.arr);
+      staged->equs.len = 0;
+
+      S_CHECK(mp_addconstraints(mp, &e));
+   }
+
+   return OK;
+}
+
+static int vmdata_mp_stage(VmData *data, MathPrgm *mp)
+{
+   if (data->mp_staged.mp != mp) {
+      S_CHECK(vmdata_mp_flush(data));
+      data->mp_staged.mp = mp;
+   }
+
+   return OK;
+}
+
+/**
+ * @brief Stage the current variables for an addition to an MP
+ *
+ * @param data  the VM data
+ * @param mp    the MP
+ *
+ * @return      the error code
+ */
+int vmdata_mp_stagevars(VmData *data, MathPrgm *mp)
+{
+   S_CHECK(vmdata_mp_stage(data, mp));
+
+   Avar *v = data->v_current;
+   IntArray *vars = &data->mp_staged.vars;
+
+   for (unsigned i = 0, len = v->size; i < len; ++i) {
+      S_CHECK(rhp_int_add(vars, avar_fget(v, i)));
+   }
+
+   avar_reset(v);
+
+   return OK;
+}
+
+/**
+ * @brief Stage the current equations for an addition to an MP as constraints
+ *
+ * @param data  the VM data
+ * @param mp    the MP
+ *
+ * @return      the error code
+ */
+int vmdata_mp_stagecons(VmData *data, MathPrgm *mp)
+{
+   S_CHECK(vmdata_mp_stage(data, mp));
+
+   Aequ *e = data->e_current;
+   IntArray *equs = &data->mp_staged.equs;
+
+   for (unsigned i = 0, len = e->size; i < len; ++i) {
+      S_CHECK(rhp_int_add(equs, aequ_fget(e, i)));
+   }
+
+   aequ_reset(e);
+
+   return OK;
+}
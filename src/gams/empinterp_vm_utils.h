@@ -188,6 +188,7 @@
 typedef struct vm_gms_sym_iterator {
    bool compact;
    IdentData ident;
+   const UelSetIndex *index;    /**< Membership index of the set, or NULL */
    int uels[]; // Clang-18 fails to understand __counted_by(ident.dim)
 } VmGmsSymIterator;
 
@@ -229,7 +230,19 @@ NONNULL
 int vm_store_set_nrecs_gmd(Interpreter * restrict interp, EmpVm * restrict vm,
                            const IdentData * restrict ident, GIDX_TYPE *gidx);
 
+NONNULL
+int vm_setjoin_build(VmSetJoin * restrict join, unsigned len, const int *tuples,
+                     const IntArray * const *loopsets, const uint8_t *loop2set,
+                     uint8_t dim);
+NONNULL
+int vm_setjoin_new(Interpreter * restrict interp, EmpVm * restrict vm,
+                   const IdentData * restrict set, const IdentData * restrict loopsets,
+                   const uint8_t *loop2set, uint8_t dim, unsigned *join_idx);
+
 int vmdata_consume_scalarvar(VmData *data, rhp_idx *vi) NONNULL;
+int vmdata_mp_stagevars(VmData *data, MathPrgm *mp) NONNULL;
+int vmdata_mp_stagecons(VmData *data, MathPrgm *mp) NONNULL;
+int vmdata_mp_flush(VmData *data) NONNULL;
 
 static inline 
 int vm_store_set_nrecs(Interpreter * restrict interp, EmpVm * restrict vm,
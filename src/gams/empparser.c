@@ -2517,15 +2517,17 @@ int parse_identasscalar(Interpreter *interp, unsigned *restrict p, double *val)
    S_CHECK(resolve_identas(interp, &ident, "a scalar value is expected",
                            IdentScalar, IdentLocalScalar, IdentVector));
 
-   const char *identstr = tok_dupident(&interp->cur);
+   const char *identstr = emptok_getstrstart(&interp->cur);
+   unsigned identlen = emptok_getstrlen(&interp->cur);
 
    switch (ident.type) {
 
    case IdentScalar:
    case IdentLocalScalar: {
-      unsigned idx = namedscalar_findbyname_nocase(&interp->globals.scalars, identstr);
+      unsigned idx = namedscalar_findbyname_nocasen(&interp->globals.scalars, identstr, identlen);
       if (idx == UINT_MAX) {
-         error("[empinterp] unexpected runtime error: couldn't find scalar '%s'\n", identstr);
+         error("[empinterp] unexpected runtime error: couldn't find scalar '%.*s'\n",
+               identlen, identstr);
          status = Error_EMPRuntimeError;
          goto _exit;
       }
@@ -2550,7 +2552,7 @@ int parse_identasscalar(Interpreter *interp, unsigned *restrict p, double *val)
       gmsindices_init(&indices);
 
       S_CHECK_EXIT(parse_gmsindices(interp, p, &indices));
-      S_CHECK_EXIT(interp->ops->read_elt_vector(interp, identstr, &ident, &indices, val));
+      S_CHECK_EXIT(interp->ops->read_elt_vector(interp, &ident, &indices, val));
       break;
    }
    case IdentParam: {
@@ -2562,9 +2564,8 @@ int parse_identasscalar(Interpreter *interp, unsigned *restrict p, double *val)
    }
 
 _exit:
-   trace_empparser("[empinterp] Scalar value from ident '%s' has value %e\n",
-                   identstr, *val);
-   FREE(identstr);
+   trace_empparser("[empinterp] Scalar value from ident '%.*s' has value %e\n",
+                   identlen, identstr, *val);
    return status;
 }
 
@@ -2623,13 +2624,16 @@ static int parse_ident_asgamsparam(Interpreter * interp, unsigned * restrict p,
    S_CHECK(resolve_identas(interp, &ident, "a GAMS parameter is expected",
                    IdentScalar, IdentVector, IdentLocalVector));
 
-   char *identstr = tok_dupident(&interp->cur);
+   const char *identstr = emptok_getstrstart(&interp->cur);
+   unsigned identlen = emptok_getstrlen(&interp->cur);
+
    switch (ident.type) {
 
    case IdentScalar: {
-      unsigned idx = namedscalar_findbyname_nocase(&interp->globals.scalars, identstr);
+      unsigned idx = namedscalar_findbyname_nocasen(&interp->globals.scalars, identstr, identlen);
       if (idx == UINT_MAX) {
-         error("[empinterp] unexpected runtime error: couldn't find scalar '%s'\n", identstr);
+         error("[empinterp] unexpected runtime error: couldn't find scalar '%.*s'\n",
+               identlen, identstr);
          status = Error_EMPRuntimeError;
          goto _exit;
       }
@@ -2651,9 +2655,10 @@ static int parse_ident_asgamsparam(Interpreter * interp, unsigned * restrict p,
          const NamedVecArray *container = ident.type == IdentVector ? 
             &interp->globals.vectors : &interp->globals.localvectors;
 
-         idx = namedvec_findbyname_nocase(container, identstr);
+         idx = namedvec_findbyname_nocasen(container, identstr, identlen);
          if (idx == UINT_MAX) {
-            error("[empinterp] unexpected runtime error: couldn't find vector '%s'\n", identstr);
+            error("[empinterp] unexpected runtime error: couldn't find vector '%.*s'\n",
+                  identlen, identstr);
             status = Error_EMPRuntimeError;
             goto _exit;
          }
@@ -2672,9 +2677,9 @@ static int parse_ident_asgamsparam(Interpreter * interp, unsigned * restrict p,
                if (ident_set->type != IdentSet) {
                   return runtime_error(interp->linenr);
                }
-               char *identstr_set = tok_dupident(&interp->cur);
-               unsigned idxset = namedints_findbyname_nocase(&interp->globals.sets, identstr_set);
-               free(identstr_set);
+               unsigned idxset = namedints_findbyname_nocasen(&interp->globals.sets,
+                                                              interp->cur.start,
+                                                              interp->cur.len);
 
                if (idxset == UINT_MAX) {
                   error("[empinterp] unexpected runtime error: couldn't find set '%.*s'\n",
@@ -2683,17 +2688,27 @@ static int parse_ident_asgamsparam(Interpreter * interp, unsigned * restrict p,
                }
 
                IntArray *set = &interp->globals.sets.list[idxset];
-
-               for (unsigned i = 0, len = set->len; i < len; ++i) {
-                  unsigned pos = UINT_MAX;
-                  lequ_find(vec, set->arr[i], &scratch->data[i], &pos);
-
-                  if (pos == UINT_MAX) {
-                     error("[empinterp] ERROR on line %u: UEL %d is not in parameter %s\n",
-                           interp->linenr, set->arr[i], identstr);
-                     return Error_EMPIncorrectInput;
+               unsigned idxparam = ident.type == IdentVector ?
+                  params_findbyname_nocasen(&interp->globals.params, identstr, identlen) : UINT_MAX;
+               const GdxParam *param = idxparam != UINT_MAX ?
+                  &interp->globals.params.list[idxparam] : NULL;
+
+               /* A vector loaded from a GDX file is streamed again over the set */
+               if (param && param->dim == 1 && param->gdxreader) {
+                  S_CHECK_EXIT(gdx_reader_readvector_subset(param->gdxreader, param->idx,
+                                                            set, scratch->data));
+               } else {
+                  for (unsigned i = 0, len = set->len; i < len; ++i) {
+                     unsigned pos = UINT_MAX;
+                     lequ_find(vec, set->arr[i], &scratch->data[i], &pos);
+
+                     if (pos == UINT_MAX) {
+                        error("[empinterp] ERROR on line %u: UEL %d is not in parameter %.*s\n",
+                              interp->linenr, set->arr[i], identlen, identstr);
+                        return Error_EMPIncorrectInput;
+                     }
                   }
-                }
+               }
             } else {
                S_CHECK(parser_asUEL(interp, p, '\'', &toktype));
 
@@ -2715,8 +2730,8 @@ static int parse_ident_asgamsparam(Interpreter * interp, unsigned * restrict p,
                ovfargtype = ARG_TYPE_SCALAR;
 
                if (pos == UINT_MAX) {
-                  error("[empinterp] ERROR on line %u: UEL %d is not in parameter %s\n",
-                        interp->linenr, uelidx, identstr);
+                  error("[empinterp] ERROR on line %u: UEL %d is not in parameter %.*s\n",
+                        interp->linenr, uelidx, identlen, identstr);
                   return Error_EMPIncorrectInput;
                }
  
@@ -2728,8 +2743,8 @@ static int parse_ident_asgamsparam(Interpreter * interp, unsigned * restrict p,
 
             if (size_vector != UINT_MAX && vec->len != size_vector) {
                error("[empinterp] ERROR on line %u: for OVF parameter '%s', "
-                     "expecting the vector '%s' to have length %u, got %u instead.\n",
-                     interp->linenr, pdef->name, identstr, size_vector, vec->len);
+                     "expecting the vector '%.*s' to have length %u, got %u instead.\n",
+                     interp->linenr, pdef->name, identlen, identstr, size_vector, vec->len);
                status = Error_EMPIncorrectInput;
                goto _exit;
             }
@@ -2760,8 +2775,6 @@ static int parse_ident_asgamsparam(Interpreter * interp, unsigned * restrict p,
    }
 
 _exit:
-   free(identstr);
-
    return status;
 }
 
@@ -3982,7 +3995,6 @@ static int parse_ovfparam(Interpreter * restrict interp, unsigned * restrict p,
    TokenType toktype = parser_getcurtoktype(interp);
    DblScratch *scratch = &interp->cur.dscratch;
    double *hack_dscratch = NULL;
-   const char *identstr  = NULL;
 
    unsigned param_gidx = UINT_MAX;
    unsigned size_vector = interp->ops->ovf_param_getvecsize(interp, ovfdef, pdef);
@@ -4066,14 +4078,15 @@ static int parse_ovfparam(Interpreter * restrict interp, unsigned * restrict p,
          S_CHECK(resolve_identas(interp, &ident, "a parameter is expected",
                                  IdentScalar, IdentVector, IdentLocalVector));
 
-         identstr = tok_dupident(&interp->cur);
+         const char *identstr = emptok_getstrstart(&interp->cur);
+         unsigned identlen = emptok_getstrlen(&interp->cur);
 
          switch (ident.type) {
 
          case IdentScalar: {
-            unsigned idx = namedscalar_findbyname_nocase(&interp->globals.scalars, identstr);
+            unsigned idx = namedscalar_findbyname_nocasen(&interp->globals.scalars, identstr, identlen);
             if (idx == UINT_MAX) {
-               error("[empinterp] ERROR: couldn't find scalar '%s'\n", identstr);
+               error("[empinterp] ERROR: couldn't find scalar '%.*s'\n", identlen, identstr);
                status = Error_EMPRuntimeError;
                goto _exit;
             }
@@ -4097,9 +4110,10 @@ static int parse_ovfparam(Interpreter * restrict interp, unsigned * restrict p,
                   container = &interp->globals.localvectors;
                }
 
-               idx = namedvec_findbyname_nocase(container, identstr);
+               idx = namedvec_findbyname_nocasen(container, identstr, identlen);
                if (idx == UINT_MAX) {
-                  error("[empinterp] unexpected runtime error: couldn't find vector '%s'\n", identstr);
+                  error("[empinterp] unexpected runtime error: couldn't find vector '%.*s'\n",
+                        identlen, identstr);
                   status = Error_EMPRuntimeError;
                   goto _exit;
                }
@@ -4108,8 +4122,8 @@ static int parse_ovfparam(Interpreter * restrict interp, unsigned * restrict p,
 
                if (vec->len != size_vector) {
                   error("[empinterp] ERROR on line %u: for OVF parameter '%s', "
-                        "expecting the vector '%s' to have length %u, got %u instead.\n",
-                        interp->linenr, pdef->name, identstr, size_vector, vec->len);
+                        "expecting the vector '%.*s' to have length %u, got %u instead.\n",
+                        interp->linenr, pdef->name, identlen, identstr, size_vector, vec->len);
                   status = Error_EMPIncorrectInput;
                   goto _exit;
                }
@@ -4121,15 +4135,12 @@ static int parse_ovfparam(Interpreter * restrict interp, unsigned * restrict p,
             S_CHECK_EXIT(interp->ops->read_param(interp, p, &ident, &param_gidx))
             break;
          case IdentParam: {
-            FREE(identstr);
             TO_IMPLEMENT("Generic parameter parsing");
          }
          default:
             status = runtime_error(interp->linenr);
             goto _exit;
          }
-
-      FREE(identstr);
       }
 
    } else {
@@ -4191,7 +4202,6 @@ _exit:
    scratchdbl_empty(scratch);
    free(hack_dscratch);
 
-   free((void*)identstr);
    return status;
 }
 
@@ -4705,9 +4715,14 @@ NONNULL static int parse_load(Interpreter* restrict interp, unsigned * restrict
          if (symdim == 0) {
             S_CHECK_EXIT(namedscalar_add(&interp->globals.scalars, gdxreader->scalar, symname));
          } else if (symdim == 1) {
+            /* The GDX origin is kept to read the vector over a subset */
+            GdxParam param = {.dim = symdim, .idx = gdxreader->symdat.idx, .gdxreader = gdxreader};
+            char *paramname;
+            A_CHECK_EXIT(paramname, strdup(symname));
+            S_CHECK_EXIT(params_add(&interp->globals.params, param, paramname));
             S_CHECK_EXIT(namedvec_add(&interp->globals.vectors, *gdxreader->vector, symname));
          } else if (symdim > 1) {
-            GdxParam param = {.dim = symdim, .idx = gdxreader->symdat.idx};
+            GdxParam param = {.dim = symdim, .idx = gdxreader->symdat.idx, .gdxreader = gdxreader};
             S_CHECK_EXIT(params_add(&interp->globals.params, param, symname));
          }
 
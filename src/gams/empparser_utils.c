@@ -238,7 +238,6 @@ int resolve_tokasident(Interpreter *interp, IdentData *ident)
     * 5. Look for a symbol in the GMD
     * --------------------------------------------------------------------- */
 
-   char *identstr = NULL;
    struct emptok *tok = !interp->state.peekisactive ? &interp->cur : &interp->peek;
    ident_init(ident, tok);
 
@@ -251,10 +250,13 @@ int resolve_tokasident(Interpreter *interp, IdentData *ident)
    /* Set this here, so that we don't copy this line over and over */
    ident->origin = IdentOriginGdx;
 
+   /* The identifier is looked up as a view into the empinfo buffer */
+   const char *identstr = emptok_getstrstart(tok);
+   unsigned identlen = emptok_getstrlen(tok);
+
    /* 3. alias */
-   A_CHECK(identstr, tok_dupident(tok));
    AliasArray *aliases = &interp->globals.aliases;
-   unsigned aliasidx = aliases_findbyname_nocase(aliases, identstr);
+   unsigned aliasidx = aliases_findbyname_nocasen(aliases, identstr, identlen);
 
    if (aliasidx != UINT_MAX) {
       GdxAlias alias = aliases_at(aliases, aliasidx);
@@ -266,7 +268,7 @@ int resolve_tokasident(Interpreter *interp, IdentData *ident)
 
     /* 4. Look for a GAMS set / multiset / scalar / vector / param */
    NamedIntsArray *sets = &interp->globals.sets;
-   unsigned idx = namedints_findbyname_nocase(sets, identstr);
+   unsigned idx = namedints_findbyname_nocasen(sets, identstr, identlen);
 
    if (idx != UINT_MAX) {
       ident->idx = idx;
@@ -277,7 +279,7 @@ int resolve_tokasident(Interpreter *interp, IdentData *ident)
    }
 
    NamedMultiSets *multisets = &interp->globals.multisets;
-   idx = multisets_findbyname_nocase(multisets, identstr);
+   idx = multisets_findbyname_nocasen(multisets, identstr, identlen);
 
    if (idx != UINT_MAX) {
       GdxMultiSet ms = multisets_at(multisets, idx);
@@ -289,7 +291,7 @@ int resolve_tokasident(Interpreter *interp, IdentData *ident)
    }
 
    NamedScalarArray *scalars = &interp->globals.scalars;
-   idx = namedscalar_findbyname_nocase(scalars, identstr);
+   idx = namedscalar_findbyname_nocasen(scalars, identstr, identlen);
 
    if (idx != UINT_MAX) {
       ident->idx = idx;
@@ -300,7 +302,7 @@ int resolve_tokasident(Interpreter *interp, IdentData *ident)
    }
 
    NamedVecArray *vectors = &interp->globals.vectors;
-   idx = namedvec_findbyname_nocase(vectors, identstr);
+   idx = namedvec_findbyname_nocasen(vectors, identstr, identlen);
 
    if (idx != UINT_MAX) {
       ident->idx = idx;
@@ -321,7 +323,5 @@ int resolve_tokasident(Interpreter *interp, IdentData *ident)
    ident->origin = IdentOriginUnknown;
 
 _exit:
-   free(identstr);
-
    return OK;
 }
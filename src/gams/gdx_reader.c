@@ -15,9 +15,6 @@
 static tlsvar int gdxerr = OK;
 
 static tlsvar bool test_result = false;
-static tlsvar Lequ* vector_global = NULL;
-static tlsvar unsigned vector_pos = UINT_MAX;
-static tlsvar IntArray *vector_filter = NULL;
 
 
 static tlsvar IntArray *subset = NULL;
@@ -30,14 +27,6 @@ static void GDX_CALLCONV _test_membership(UNUSED const int *Indx,
    test_result = true;
 }
 
-UNUSED static void GDX_CALLCONV store_vector(const int *Indx, const double *Vals)
-{
-   assert(vector_pos < GMS_MAX_INDEX_DIM && vector_global);
-   if (gdxerr != OK) return;
-
-   gdxerr = lequ_add(vector_global, Indx[vector_pos], Vals[GMS_VAL_LEVEL]);
-}
-
 static void GDX_CALLCONV store_subset(const int Indx[], UNUSED const double Vals[])
 {
    assert(subset_pos < GMS_MAX_INDEX_DIM && subset);
@@ -46,24 +35,6 @@ static void GDX_CALLCONV store_subset(const int Indx[], UNUSED const double Vals
    gdxerr = rhp_int_addsorted(subset, Indx[subset_pos]);
 }
 
-UNUSED static void GDX_CALLCONV store_vector_filt(const int Indx[], const double Vals[])
-{
-   assert(vector_pos < GMS_MAX_INDEX_DIM);
-   assert(vector_filter);
-
-   if (gdxerr != OK) return;
-
-   int idx = Indx[vector_pos];
-   int * restrict indices = vector_filter->arr;
-   assert(indices);
-
-   for (unsigned i = 0, len = vector_filter->len; i < len; ++i) {
-      if (idx == indices[i]) {
-         gdxerr = lequ_add(vector_global, idx, Vals[GMS_VAL_LEVEL]);
-         return;
-      }
-   }
-}
 /* END TDataStoreProc_t functions */
 
 GdxReader* gdx_readers_new(Interpreter* restrict interp)
@@ -98,12 +69,16 @@ void gdx_reader_free(GdxReader *reader)
    }
 
    FREE(reader->vector); /* Lequ content is owned by a namedlist */
+   FREE(reader->uels_gdx2dct);
+   reader->uels_len = 0;
 }
 
 int gdx_reader_init(GdxReader *reader, Model *mdl, const char *fname)
 {
    char msg[GMS_SSSIZE];
    reader->vector = NULL;
+   reader->uels_len = 0;
+   reader->uels_gdx2dct = NULL;
 
    reader->fname = fname;
    if (!gdxLibraryLoaded()) {
@@ -175,59 +150,222 @@ int gdx_reader_find(GdxReader *reader, const char *symname)
    return OK;
 }
 
-static int gdx_reader_readset(GdxReader * restrict reader, const char *setname)
+/* ------------------------------------------------------------------------
+ *  Streaming read of the records with raw UELs
+ * ------------------------------------------------------------------------ */
+
+/** Number of records read at once into temporary column buffers */
+#define GDX_STREAM_CHUNK 1024
+
+/**
+ * @brief Translate a raw GDX UEL into a DCT UEL
+ *
+ * The translations are memoized in a table indexed by the raw GDX UEL. The
+ * table is allocated for all the GDX UELs on first use and an entry is filled
+ * the first time the UEL is translated. Hence, each UEL goes through the
+ * string lookup in the DCT at most once per GDX file.
+ *
+ * @param      reader   the GDX reader
+ * @param      uel      the raw GDX UEL
+ * @param[out] uel_dct  the DCT UEL, or a nonpositive value if the UEL is not in the DCT
+ *
+ * @return              the error code
+ */
+static int gdx_reader_uel2dct(GdxReader * restrict reader, int uel, int *uel_dct)
 {
    gdxHandle_t gdxh = reader->gdxh;
-   dctHandle_t dct  = reader->dcth;
-   gdxValues_t        values;
-   gdxStrIndex_t      uels;
-   gdxStrIndexPtrs_t  uels_str;
 
-   assert(gdxh);
+   if (RHP_UNLIKELY(uel <= 0)) {
+      *uel_dct = uel;
+      return OK;
+   }
+
+   if (RHP_UNLIKELY((unsigned)uel >= reader->uels_len)) {
+      int nuels, highmap;
+      if (!gdxUMUelInfo(gdxh, &nuels, &highmap)) {
+         gdxerror(gdxUMUelInfo, gdxh);
+         return Error_GamsCallFailed;
+      }
+
+      unsigned len = MAX((unsigned)nuels, (unsigned)uel) + 1;
+      REALLOC_(reader->uels_gdx2dct, int, len);
+      memset(&reader->uels_gdx2dct[reader->uels_len], 0,
+             (len - reader->uels_len) * sizeof(int));
+      reader->uels_len = len;
+   }
+
+   int val = reader->uels_gdx2dct[uel];
+   if (RHP_LIKELY(val != 0)) {
+      *uel_dct = val;
+      return OK;
+   }
+
+   char uelstr[GMS_SSSIZE];
+   int uelmap;
+   if (!gdxUMUelGet(gdxh, uel, uelstr, &uelmap)) {
+      gdxerror(gdxUMUelGet, gdxh);
+      return Error_GamsCallFailed;
+   }
+
+   val = dctUelIndex(reader->dcth, uelstr);
+
+   /* A zero entry means not translated yet */
+   if (val <= 0) { val = -1; }
+
+   reader->uels_gdx2dct[uel] = val;
+   *uel_dct = val;
+
+   return OK;
+}
+
+/**
+ * @brief Start the streaming read of the records of a symbol
+ *
+ * @param reader  the GDX reader
+ * @param symidx  the index of the symbol in the GDX file
+ * @param dim     the dimension of the symbol
+ * @param stream  the stream
+ *
+ * @return        the error code
+ */
+int gdx_reader_stream_start(GdxReader * restrict reader, int symidx, uint8_t dim,
+                            GdxStream * restrict stream)
+{
+   gdxHandle_t gdxh = reader->gdxh;
+   int nrecs;
+
+   stream->symidx = symidx;
+   stream->dim = dim;
+   stream->filter_pos = 0;
+   stream->nrecs = 0;
+   stream->nread = 0;
+   stream->filter = NULL;
+
+   if (!gdxDataReadRawStart(gdxh, symidx, &nrecs)) {
+      gdxerror(gdxDataReadRawStart, gdxh);
+      return Error_GamsCallFailed;
+   }
+
+   stream->nrecs = nrecs > 0 ? (unsigned)nrecs : 0;
+
+   return OK;
+}
+
+/**
+ * @brief Read the next records of a symbol into column buffers
+ *
+ * The UELs at position d of the records are stored in uels[d*max, d*max+len).
+ * A UEL unknown to the DCT is stored as a nonpositive value.
+ *
+ * @param      reader  the GDX reader
+ * @param      stream  the stream
+ * @param      max     the capacity of the buffers, in records
+ * @param[out] uels    the UEL columns (dim * max)
+ * @param[out] vals    the level values (max), or NULL
+ * @param[out] len     the number of records read. It is less than max only
+ *                     when all the records have been read
+ *
+ * @return             the error code
+ */
+int gdx_reader_stream_read(GdxReader * restrict reader, GdxStream * restrict stream,
+                           unsigned max, int * restrict uels, double * restrict vals,
+                           unsigned *len)
+{
+   gdxHandle_t gdxh = reader->gdxh;
+   gdxValues_t values;
+   gdxUelIndex_t keys;
+   int dummyint;
+
+   uint8_t dim = stream->dim, filter_pos = stream->filter_pos;
+   const UelSetIndex *filter = stream->filter;
+   unsigned n = 0;
+
+   while (n < max && stream->nread < stream->nrecs) {
+      if (!gdxDataReadRaw(gdxh, keys, values, &dummyint)) {
+         gdxerror(gdxDataReadRaw, gdxh);
+         *len = n;
+         return Error_GamsCallFailed;
+      }
+      stream->nread++;
+
+      for (uint8_t d = 0; d < dim; ++d) {
+         int uel = keys[d], uel_dct;
+
+         /* Fast path: the UEL has already been translated */
+         if (RHP_LIKELY(uel > 0 && (unsigned)uel < reader->uels_len &&
+                        reader->uels_gdx2dct[uel] != 0)) {
+            uel_dct = reader->uels_gdx2dct[uel];
+         } else {
+            S_CHECK(gdx_reader_uel2dct(reader, uel, &uel_dct));
+         }
+
+         uels[(size_t)d * max + n] = uel_dct;
+      }
+
+      if (filter) {
+         int uel = uels[(size_t)filter_pos * max + n];
+         if (uel <= 0 || !uelset_index_has(filter, &uel)) { continue; }
+      }
+
+      if (vals) { vals[n] = values[GMS_VAL_LEVEL]; }
+      n++;
+   }
+
+   *len = n;
+
+   return OK;
+}
+
+void gdx_reader_stream_done(GdxReader * restrict reader, GdxStream * restrict stream)
+{
+   gdxDataReadDone(reader->gdxh);
+   stream->nread = stream->nrecs;
+}
+
+static int gdx_reader_readset(GdxReader * restrict reader, const char *setname)
+{
+   GdxStream stream;
+
+   assert(reader->gdxh);
    assert(reader->symdat.dim == 1);
 
    rhp_int_init(&reader->setobj);
 
    /* ---------------------------------------------------------------------
-    * We use gdxDataReadStr to get the string representation of the UELs
-    * and then lookup its index via the DCT interface
-    *
-    * If we have the GUARANTEE that the universal set in the gdx is the same
-    * as the dct one, then we could just use gdxDataReadRaw
+    * The raw UELs are translated via the table of the reader. The records
+    * are directly stored in the set.
     * --------------------------------------------------------------------- */
 
-   int nrecs;
-   gdx_call_rc(gdxDataReadStrStart, gdxh, reader->symdat.idx, &nrecs);
+   S_CHECK(gdx_reader_stream_start(reader, reader->symdat.idx, 1, &stream));
 
-   if (nrecs <= 0) {
-      error("%s :: Set '%s': invalid record size %d", __func__, setname, nrecs);
-      return Error_RuntimeError;
+   int status = OK;
+   unsigned nrecs = stream.nrecs;
+
+   if (nrecs == 0) {
+      error("%s :: Set '%s': invalid record size %u", __func__, setname, nrecs);
+      status = Error_RuntimeError;
+      goto _exit;
    }
 
    if (O_Output & PO_TRACE_EMPINTERP) {
-      trace_empparser("[empinterp] Reading set '%s' with %d records\n", setname, nrecs);
+      trace_empparser("[empinterp] Reading set '%s' with %u records\n", setname, nrecs);
    }
 
-   S_CHECK(rhp_int_reserve(&reader->setobj, nrecs));
-
-   int dummyint;
-   /* "magic" stuff from gdx */
-   GDXSTRINDEXPTRS_INIT(uels,uels_str);
+   S_CHECK_EXIT(rhp_int_reserve(&reader->setobj, nrecs));
 
-   for (int i = 0; i < nrecs; ++i) {
-      gdx_call_rc(gdxDataReadStr, gdxh, uels_str, values, &dummyint);
-      int uel = dctUelIndex(dct, uels_str[0]);
-      rhp_int_add(&reader->setobj, uel);
+   S_CHECK_EXIT(gdx_reader_stream_read(reader, &stream, nrecs, reader->setobj.arr, NULL,
+                                       &reader->setobj.len));
 
-      if (O_Output & PO_TRACE_EMPINTERP) {
-         trace_empparser("[empinterp] Adding uel [%5d] '%s'\n", uel, uels_str[0]);
+   if (O_Output & PO_TRACE_EMPINTERP) {
+      for (unsigned i = 0, len = reader->setobj.len; i < len; ++i) {
+         trace_empparser("[empinterp] Adding uel [%5d]\n", reader->setobj.arr[i]);
       }
-
    }
 
-   gdxDataReadDone(gdxh);
+_exit:
+   gdx_reader_stream_done(reader, &stream);
 
-   return OK;
+   return status;
 }
 
 static int gdx_reader_readscalar(GdxReader *reader, const char *symname)
@@ -260,52 +398,136 @@ static int gdx_reader_readscalar(GdxReader *reader, const char *symname)
 
 static int gdx_reader_readvector(GdxReader *reader, const char *symname)
 {
-   gdxHandle_t gdxh = reader->gdxh;
-   dctHandle_t dct  = reader->dcth;
-   gdxValues_t        values;
-   gdxStrIndex_t      uels;
-   gdxStrIndexPtrs_t  uels_str;
+   GdxStream stream;
 
-   assert(gdxh);
+   assert(reader->gdxh);
    assert(reader->symdat.dim == 1);
 
-   int nrecs;
-   gdx_call_rc(gdxDataReadStrStart, gdxh, reader->symdat.idx, &nrecs);
-   assert(nrecs >= 1);
+   S_CHECK(gdx_reader_stream_start(reader, reader->symdat.idx, 1, &stream));
 
-   A_CHECK(reader->vector, lequ_new(nrecs));
+   int status = OK;
+   unsigned nrecs = stream.nrecs;
+   assert(nrecs >= 1);
 
    /* ---------------------------------------------------------------------
-    * We use gdxDataReadStr to get the string representation of the UELs
-    * and then lookup its index via the DCT interface
-    *
-    * If we have the GUARANTEE that the universal set in the gdx is the same
-    * as the dct one, then we could just use gdxDataReadRaw
+    * The UELs and the values are read directly into the columns of the vector
     * --------------------------------------------------------------------- */
 
-   int dummyint;
-   /* "magic" stuff from gdx */
-   GDXSTRINDEXPTRS_INIT(uels,uels_str);
+   A_CHECK_EXIT(reader->vector, lequ_new(nrecs));
 
-   for (int i = 0; i < nrecs; ++i) {
-      gdx_call_rc(gdxDataReadStr, gdxh, uels_str, values, &dummyint);
-      int uel = dctUelIndex(dct, uels_str[0]);
-      reader->vector->vis[i] = uel;
-      reader->vector->coeffs[i] = values[GMS_VAL_LEVEL];
-   }
-    reader->vector->len = nrecs;
+   S_CHECK_EXIT(gdx_reader_stream_read(reader, &stream, nrecs, reader->vector->vis,
+                                       reader->vector->coeffs, &reader->vector->len));
 
    if (O_Output & PO_TRACE_EMPINTERP) {
-      trace_empparser("[empinterp] 1D parameter '%s' has %d entries:\n", symname,
+      trace_empparser("[empinterp] 1D parameter '%s' has %u entries:\n", symname,
                       nrecs);
-      print_vector(reader->vector, PO_TRACE_EMPINTERP, dct);
+      print_vector(reader->vector, PO_TRACE_EMPINTERP, reader->dcth);
 
    }
 
-   gdxDataReadDone(gdxh);
+_exit:
+   gdx_reader_stream_done(reader, &stream);
 
+   return status;
+}
 
-   return OK;
+typedef struct {
+   int uel;
+   unsigned pos;
+} UelPos;
+
+static int uelpos_cmp(const void *a, const void *b)
+{
+   int uel_a = ((const UelPos *)a)->uel, uel_b = ((const UelPos *)b)->uel;
+   return (uel_a > uel_b) - (uel_a < uel_b);
+}
+
+/**
+ * @brief Read the values of a 1D parameter over a set
+ *
+ * Only the records whose UEL belongs to the set are kept while streaming, so
+ * that the cost is linear in the number of records of the parameter.
+ *
+ * @param      reader  the GDX reader
+ * @param      symidx  the index of the parameter in the GDX file
+ * @param      set     the set, with DCT UELs
+ * @param[out] vals    the values of the parameter, in the order of the set
+ *
+ * @return             the error code
+ */
+int gdx_reader_readvector_subset(GdxReader * restrict reader, int symidx,
+                                 const IntArray * restrict set, double * restrict vals)
+{
+   int status = OK;
+   unsigned setlen = set->len;
+   UelSetIndex filter;
+   GdxStream stream;
+   UelPos *sorted = NULL;
+   int *uels = NULL;
+   double *chunk = NULL;
+   bool *found = NULL, streaming = false;
+
+   if (setlen == 0) { return OK; }
+
+   uelset_index_init(&filter, 1);
+   S_CHECK_EXIT(uelset_index_build(&filter, setlen, set->arr));
+
+   /* Position in the set of each UEL, for a binary search */
+   MALLOC_EXIT(sorted, UelPos, setlen);
+   for (unsigned i = 0; i < setlen; ++i) {
+      sorted[i].uel = set->arr[i];
+      sorted[i].pos = i;
+   }
+   qsort(sorted, setlen, sizeof(UelPos), uelpos_cmp);
+
+   MALLOC_EXIT(uels, int, GDX_STREAM_CHUNK);
+   MALLOC_EXIT(chunk, double, GDX_STREAM_CHUNK);
+   CALLOC_EXIT(found, bool, setlen);
+
+   S_CHECK_EXIT(gdx_reader_stream_start(reader, symidx, 1, &stream));
+   streaming = true;
+   gdx_reader_stream_setfilter(&stream, &filter, 0);
+
+   unsigned n;
+   do {
+      S_CHECK_EXIT(gdx_reader_stream_read(reader, &stream, GDX_STREAM_CHUNK, uels, chunk, &n));
+
+      for (unsigned i = 0; i < n; ++i) {
+         UelPos key = {.uel = uels[i]};
+         const UelPos *elt = bsearch(&key, sorted, setlen, sizeof(UelPos), uelpos_cmp);
+         assert(elt);
+
+         /* Duplicated UELs in the set share the same value */
+         while (elt > sorted && elt[-1].uel == key.uel) { elt--; }
+         for (const UelPos *end = &sorted[setlen]; elt < end && elt->uel == key.uel; ++elt) {
+            vals[elt->pos] = chunk[i];
+            found[elt->pos] = true;
+         }
+      }
+   } while (n == GDX_STREAM_CHUNK);
+
+   for (unsigned i = 0; i < setlen; ++i) {
+      if (!found[i]) {
+         char symname[GMS_SSSIZE], uelstr[GMS_SSSIZE], quote;
+         int symdim, symtype;
+         gdxSymbolInfo(reader->gdxh, symidx, symname, &symdim, &symtype);
+         dctUelLabel(reader->dcth, set->arr[i], &quote, uelstr, sizeof(uelstr));
+         error("[empinterp] ERROR in gdx file '%s': UEL '%s' is not in parameter '%s'\n",
+               reader->fname, uelstr, symname);
+         status = Error_EMPIncorrectInput;
+         goto _exit;
+      }
+   }
+
+_exit:
+   if (streaming) { gdx_reader_stream_done(reader, &stream); }
+   uelset_index_free(&filter);
+   FREE(sorted);
+   FREE(uels);
+   FREE(chunk);
+   FREE(found);
+
+   return status;
 }
 
 int gdx_reader_readsym(GdxReader *reader, const char *symname)
@@ -403,6 +625,90 @@ int gdx_reader_boolean_test(GdxReader * restrict reader, VmGmsSymIterator *filte
    return OK;
 }
 
+/**
+ * @brief Read the records of a GDX set
+ *
+ * The tuples use the DCT UEL indices, like the filters in
+ * gdx_reader_boolean_test(). Records with a UEL unknown to the DCT can never
+ * match a filter and are skipped. The records are in the GDX order.
+ *
+ * @param      reader  the GDX reader
+ * @param      symidx  the index of the set in the GDX file
+ * @param      dim     the dimension of the set
+ * @param[out] len     the number of tuples
+ * @param[out] tuples  the tuples, stored contiguously (len * dim UELs). To be freed
+ *
+ * @return             the error code
+ */
+int gdx_reader_set_tuples(GdxReader * restrict reader, int symidx, uint8_t dim,
+                          unsigned *len, int **tuples)
+{
+   int status = OK;
+   int *cols = NULL;
+   GdxStream stream;
+
+   *len = 0;
+   *tuples = NULL;
+
+   S_CHECK(gdx_reader_stream_start(reader, symidx, dim, &stream));
+
+   MALLOC_EXIT(*tuples, int, (size_t)MAX(stream.nrecs, 1) * dim);
+   MALLOC_EXIT(cols, int, (size_t)GDX_STREAM_CHUNK * dim);
+
+   unsigned n;
+   do {
+      S_CHECK_EXIT(gdx_reader_stream_read(reader, &stream, GDX_STREAM_CHUNK, cols, NULL, &n));
+
+      for (unsigned i = 0; i < n; ++i) {
+         int *tuple = &(*tuples)[(size_t)*len * dim];
+         bool known = true;
+         for (uint8_t d = 0; d < dim; ++d) {
+            tuple[d] = cols[(size_t)d * GDX_STREAM_CHUNK + i];
+            known = known && tuple[d] > 0;
+         }
+
+         if (known) { (*len)++; }
+      }
+   } while (n == GDX_STREAM_CHUNK);
+
+_exit:
+   gdx_reader_stream_done(reader, &stream);
+   FREE(cols);
+
+   if (status != OK) {
+      FREE(*tuples);
+      *len = 0;
+   }
+
+   return status;
+}
+
+/**
+ * @brief Build the membership index of a GDX set
+ *
+ * @param      reader  the GDX reader
+ * @param      symidx  the index of the set in the GDX file
+ * @param      dim     the dimension of the set
+ * @param[out] index   the membership index
+ *
+ * @return             the error code
+ */
+int gdx_reader_set_index(GdxReader * restrict reader, int symidx, uint8_t dim,
+                         UelSetIndex * restrict index)
+{
+   int status = OK;
+   unsigned len;
+   int *tuples;
+
+   uelset_index_init(index, dim);
+
+   S_CHECK(gdx_reader_set_tuples(reader, symidx, dim, &len, &tuples));
+   status = uelset_index_build(index, len, tuples);
+   FREE(tuples);
+
+   return status;
+}
+
 int gdx_reader_getsubset(GdxReader * restrict reader, GdxMultiSet * restrict set,
                          unsigned pos, IntArray * restrict res)
 {
@@ -6,6 +6,7 @@
 #include "empinterp_fwd.h"
 #include "reshop_data.h"
 #include "rhp_fwd.h"
+#include "uelset_index.h"
 
 #include "gclgms.h"
 
@@ -29,8 +30,25 @@ typedef struct gdx_reader {
    GdxMultiSet    multiset;
    double      scalar;
    Lequ * restrict vector;
+   unsigned    uels_len;          /**< Size of the UEL translation table      */
+   int        *uels_gdx2dct;      /**< Memoized translation of raw GDX UELs    */
 } GdxReader;
 
+/** Streaming read of the records of a GDX symbol.
+ *
+ *  The records are read with their raw GDX UELs, which are translated into DCT
+ *  UELs by the reader. A UEL unknown to the DCT is translated into a
+ *  nonpositive value. If a filter is set, only the records whose UEL at the
+ *  filter position belongs to the filter are kept. */
+typedef struct {
+   int symidx;                    /**< Index of the symbol in the GDX file    */
+   uint8_t dim;                   /**< Dimension of the symbol                */
+   uint8_t filter_pos;            /**< Position of the filtered index         */
+   unsigned nrecs;                /**< Number of records of the symbol        */
+   unsigned nread;                /**< Number of records read so far          */
+   const UelSetIndex *filter;     /**< One-dimensional filter, or NULL        */
+} GdxStream;
+
 typedef enum gdxSyType GdxSymType;
 
 GdxReader* gdx_readers_new(Interpreter* restrict interp) NONNULL;
@@ -46,6 +64,35 @@ int gdx_reader_getsubset(GdxReader * restrict reader, GdxMultiSet * restrict set
                          unsigned pos, IntArray * restrict res) NONNULL;
 int gdx_reader_boolean_test(GdxReader * restrict reader, struct vm_gms_sym_iterator *filter,
                             bool *res) NONNULL;
+int gdx_reader_set_tuples(GdxReader * restrict reader, int symidx, uint8_t dim,
+                          unsigned *len, int **tuples) NONNULL;
+int gdx_reader_set_index(GdxReader * restrict reader, int symidx, uint8_t dim,
+                         UelSetIndex * restrict index) NONNULL;
+int gdx_reader_stream_start(GdxReader * restrict reader, int symidx, uint8_t dim,
+                            GdxStream * restrict stream) NONNULL;
+NONNULL_AT(1,2,4,6)
+int gdx_reader_stream_read(GdxReader * restrict reader, GdxStream * restrict stream,
+                           unsigned max, int * restrict uels, double * restrict vals,
+                           unsigned *len);
+void gdx_reader_stream_done(GdxReader * restrict reader, GdxStream * restrict stream) NONNULL;
+int gdx_reader_readvector_subset(GdxReader * restrict reader, int symidx,
+                                 const IntArray * restrict set, double * restrict vals) NONNULL;
 void print_vector(const Lequ * restrict vector, unsigned mode, void *gmd) NONNULL;
 
+/**
+ * @brief Keep only the records whose UEL at a position belongs to a subset
+ *
+ * @param stream  the stream
+ * @param filter  the membership index of the subset, of dimension 1
+ * @param pos     the position of the index in the records
+ */
+NONNULL static inline
+void gdx_reader_stream_setfilter(GdxStream * restrict stream, const UelSetIndex *filter,
+                                 uint8_t pos)
+{
+   assert(filter->dim == 1 && pos < stream->dim);
+   stream->filter = filter;
+   stream->filter_pos = pos;
+}
+
 #endif // !RHP_GDX_READER_H
@@ -537,3 +537,48 @@ void gmdl_setgamshandles(struct rhp_gams_handles *ghandles)
    gams_handles.dh = ghandles->dh;
    gams_handles.ch = ghandles->ch;
 }
+
+/**
+ * @brief Get the thread-local GAMS state of the calling thread
+ *
+ * The state is borrowed: it is only valid as long as the calling thread does
+ * not change it.
+ *
+ * @param[out] tls  the GAMS state
+ */
+void gams_tls_get(GamsTls *tls)
+{
+   tls->gamsdir = gamsdir;
+   tls->gamscntr = gamscntr;
+   tls->handles = &gams_handles;
+}
+
+/**
+ * @brief Set the thread-local GAMS state of a worker thread from the one of
+ * another thread
+ *
+ * The worker must call gams_tls_release() before it exits, since the cleanup
+ * function only runs for the main thread.
+ *
+ * @param tls  the GAMS state of the other thread
+ *
+ * @return     the error code
+ */
+int gams_tls_inherit(const GamsTls *tls)
+{
+   if (tls->gamsdir)  { S_CHECK(gams_setgamsdir(tls->gamsdir)); }
+   if (tls->gamscntr) { S_CHECK(gams_setgamscntr(tls->gamscntr)); }
+   gams_handles = *tls->handles;
+
+   return OK;
+}
+
+/**
+ * @brief Release the thread-local GAMS state of a worker thread
+ */
+void gams_tls_release(void)
+{
+   FREE(gamsdir);
+   FREE(gamscntr);
+   gams_handles = (struct rhp_gams_handles) {0};
+}
@@ -55,4 +55,15 @@ bool gmdl_check_solvelink_crash_report(void);
 gevHandle_t gmdl_get_src_gev(void);
 void gmdl_setgamshandles(struct rhp_gams_handles *ghandles);
 
+/** @brief Thread-local GAMS state of a thread, to be inherited by a worker */
+typedef struct gams_tls {
+   const char *gamsdir;                        /**< GAMS directory            */
+   const char *gamscntr;                       /**< GAMS control file         */
+   const struct rhp_gams_handles *handles;     /**< GAMS handles of the thread */
+} GamsTls;
+
+void gams_tls_get(GamsTls *tls) NONNULL;
+int gams_tls_inherit(const GamsTls *tls) NONNULL;
+void gams_tls_release(void);
+
 #endif
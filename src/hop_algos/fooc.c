@@ -27,6 +27,7 @@
 #include "mathprgm.h"
 #include "mdl.h"
 #include "mdl_data.h"
+#include "mdl_timings.h"
 #include "ctrdat_rhp.h"
 #include "rhp_alg.h"
 #include "printout.h"
@@ -1969,6 +1970,7 @@ _exit:
 int fooc_create_mcp(Model *mdl)
 {
    double start = get_thrdtime();
+   unsigned span = mdl_prof_begin(mdl, "first-order conditions");
 
    assert(mdl->mdl_up && mdl_is_rhp(mdl->mdl_up));
 
@@ -1976,6 +1978,8 @@ int fooc_create_mcp(Model *mdl)
 
    S_CHECK(fooc_mcp(mdl));
 
+   mdl_prof_additems(mdl, span, ctr_nequs(&mdl->ctr));
+   mdl_prof_end(mdl, span);
    mdl->timings->solve.fooc += get_thrdtime() - start;
 
    return OK;
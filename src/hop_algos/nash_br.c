@@ -0,0 +1,374 @@
+#include "reshop_config.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "container.h"
+#include "empdag.h"
+#include "empdag_uid.h"
+#include "equvar_metadata.h"
+#include "gams_option.h"
+#include "macros.h"
+#include "mdl.h"
+#include "nash_br.h"
+#include "printout.h"
+#include "reshop_solvers.h"
+#include "rhp_options.h"
+#include "rhp_options_data.h"
+#include "rmdl_options.h"
+#include "solver_eval.h"
+#include "status.h"
+
+/* ---------------------------------------------------------------------------
+ * Best-response decomposition of a Nash equilibrium
+ *
+ * The MCP given by the first-order optimality conditions of all the agents is
+ * partitioned by agent: the primal variables of an agent and the multipliers
+ * of its constraints form its block. A best response of agent b is the
+ * solution of the sub-MCP made of the variables of the block and their
+ * matching equations, the variables of the other agents being fixed at their
+ * current values. Variables without an owner (shared ones) belong to every
+ * sub-MCP.
+ *
+ * - Jacobi: every agent responds to the iterate x^k
+ * - Gauss-Seidel: agents respond in turn, using the latest values
+ *
+ * A sub-MCP is a restriction of the joint MCP (path_submcp_init), not a model
+ * exported with the filter of the MP (fops_singleMP_activevars_new). The
+ * filter selects the variables of the MP in the upstream model: the multipliers
+ * of the agent would be missing, and each response would need an export and a
+ * new MCP. The restriction reuses the jacobian structure of the joint MCP, and
+ * keeps its variable indices, so that all agents work on the same iterate.
+ *
+ * The Jacobi responses are independent, but running them on worker threads is
+ * not implemented. They are computed sequentially, since:
+ * - PATH is not known to be reentrant
+ * - solver_path_submcp writes the model and solve status, the timings and the
+ *   solution report in the shared model
+ * - the expression trees of the container are built lazily (rctr_getnl) during
+ *   the function evaluations
+ *
+ * The convergence is measured on the natural residual of the joint MCP:
+ *     max_i | x_i - mid(l_i, u_i, x_i - F_i(x)) |
+ * --------------------------------------------------------------------------- */
+
+#define BLOCK_NONE UINT_MAX
+
+typedef struct {
+   unsigned n;           /**< Size of the MCP                            */
+   unsigned nblocks;     /**< Number of blocks (agents)                  */
+   unsigned *owner;      /**< Block of each MCP variable                 */
+   double *lb;           /**< Original lower bounds                      */
+   double *ub;           /**< Original upper bounds                      */
+   double *x;            /**< Current iterate                            */
+   double *xnext;        /**< Next iterate (Jacobi)                      */
+   double *xwork;        /**< Point of a best response (Jacobi)          */
+   double *F;            /**< Function value at the current iterate      */
+   struct path_submcp *subs; /**< Sub-MCP of each block                  */
+} NashBrData;
+
+static void nash_br_free(NashBrData *dat)
+{
+   if (dat->subs) {
+      for (unsigned b = 0; b < dat->nblocks; ++b) { path_submcp_free(&dat->subs[b]); }
+   }
+
+   FREE(dat->owner);
+   FREE(dat->lb);
+   FREE(dat->ub);
+   FREE(dat->x);
+   FREE(dat->xnext);
+   FREE(dat->xwork);
+   FREE(dat->F);
+   FREE(dat->subs);
+}
+
+/**
+ * @brief Assign each variable of the MCP to the agent owning it upstream
+ *
+ * @param mdl  the MCP model
+ * @param dat  the data
+ *
+ * @return     the error code
+ */
+static int nash_br_blocks(Model *mdl, NashBrData *dat)
+{
+   Container *ctr = &mdl->ctr;
+   Model *mdl_up = mdl->mdl_up;
+   Container *ctr_up = &mdl_up->ctr;
+   unsigned nmps = mdl_up->empinfo.empdag.mps.len;
+
+   for (unsigned i = 0; i < dat->n; ++i) { dat->owner[i] = BLOCK_NONE; }
+   dat->nblocks = 0;
+
+   if (!ctr_hasmetadata(ctr_up) || !ctr->equmeta) { return OK; }
+
+   const rhp_idx *rosetta_vars = ctr_up->rosetta_vars;
+   const rhp_idx *rosetta_equs = ctr_up->rosetta_equs;
+   unsigned *mp2block;
+   MALLOC_(mp2block, unsigned, nmps);
+   for (unsigned i = 0; i < nmps; ++i) { mp2block[i] = BLOCK_NONE; }
+
+   for (rhp_idx vi_up = 0, len = ctr_nvars_total(ctr_up); vi_up < len; ++vi_up) {
+      rhp_idx vi = rosetta_vars ? rosetta_vars[vi_up] : vi_up;
+      mpid_t mpid = ctr_up->varmeta[vi_up].mp_id;
+      if (!valid_vi(vi) || (unsigned)vi >= dat->n || !mpid_regularmp(mpid) || mpid >= nmps) {
+         continue;
+      }
+
+      if (mp2block[mpid] == BLOCK_NONE) { mp2block[mpid] = dat->nblocks++; }
+      dat->owner[vi] = mp2block[mpid];
+   }
+
+   if (rosetta_equs) {
+      for (rhp_idx ei_up = 0, len = ctr_nequs_total(ctr_up); ei_up < len; ++ei_up) {
+         rhp_idx ei = rosetta_equs[ei_up];
+         mpid_t mpid = ctr_up->equmeta[ei_up].mp_id;
+         if (!valid_ei(ei) || !mpid_regularmp(mpid) || mpid >= nmps) { continue; }
+
+         rhp_idx vi_mult = ctr->equmeta[ei].dual;
+         if (!valid_vi(vi_mult) || (unsigned)vi_mult >= dat->n) { continue; }
+
+         if (mp2block[mpid] == BLOCK_NONE) { mp2block[mpid] = dat->nblocks++; }
+         dat->owner[vi_mult] = mp2block[mpid];
+      }
+   }
+
+   FREE(mp2block);
+
+   return OK;
+}
+
+static inline double nash_br_mid(double lb, double ub, double v)
+{
+   return v < lb ? lb : (v > ub ? ub : v);
+}
+
+/**
+ * @brief Build the sub-MCP of each block
+ *
+ * @param jacdata  the jacobian data of the MCP
+ * @param dat      the data
+ *
+ * @return         the error code
+ */
+static int nash_br_subs(const struct jacdata *jacdata, NashBrData *dat)
+{
+   int status = OK;
+   unsigned *vis;
+   MALLOC_(vis, unsigned, dat->n);
+   CALLOC_EXIT(dat->subs, struct path_submcp, dat->nblocks);
+
+   for (unsigned b = 0; b < dat->nblocks; ++b) {
+      unsigned n = 0;
+      for (unsigned i = 0; i < dat->n; ++i) {
+         if (dat->owner[i] == b || dat->owner[i] == BLOCK_NONE) { vis[n++] = i; }
+      }
+
+      S_CHECK_EXIT(path_submcp_init(&dat->subs[b], jacdata, n, vis));
+   }
+
+_exit:
+   FREE(vis);
+
+   return status;
+}
+
+static int nash_br_residual(Container *ctr, NashBrData *dat, double *res)
+{
+   S_CHECK(ge_eval_func(ctr, dat->x, dat->F));
+
+   double r = 0.;
+   for (unsigned i = 0; i < dat->n; ++i) {
+      double x = dat->x[i];
+      double ri = fabs(x - nash_br_mid(dat->lb[i], dat->ub[i], x - dat->F[i]));
+      if (!isfinite(ri)) { r = INFINITY; break; }
+      r = MAX(r, ri);
+   }
+
+   *res = r;
+
+   return OK;
+}
+
+/**
+ * @brief Report the final iterate, as the PATH interface would do it
+ */
+static void nash_br_report(Container *ctr, const NashBrData *dat, size_t n_primal)
+{
+   for (unsigned i = 0; i < dat->n; ++i) {
+      Var *v = &ctr->vars[i];
+      double x = dat->x[i];
+      v->value = x;
+      ctr->equs[i].value = dat->F[i] - ctr->equs[i].p.cst;
+
+      if (dat->lb[i] == dat->ub[i]) {
+         v->basis = BasisFixed;
+      } else if (x <= dat->lb[i]) {
+         v->basis = BasisLower;
+      } else if (x >= dat->ub[i]) {
+         v->basis = BasisUpper;
+      } else {
+         v->basis = BasisBasic;
+      }
+   }
+
+   for (size_t i = 0; i < n_primal && i < dat->n; ++i) {
+      ctr->vars[i].multiplier = dat->F[i];
+   }
+
+   for (size_t i = n_primal; i < dat->n; ++i) {
+      ctr->equs[i].multiplier = dat->x[i];
+      switch (ctr->vars[i].basis) {
+      case BasisLower:
+      case BasisUpper:
+         ctr->equs[i].basis = BasisBasic;
+         break;
+      case BasisBasic:
+         ctr->equs[i].basis = dat->lb[i] == 0. ? BasisLower : BasisUpper;
+         break;
+      default:
+         ctr->equs[i].basis = BasisUnset;
+      }
+   }
+}
+
+/**
+ * @brief Solve the MCP of a Nash equilibrium by best-response iterations
+ *
+ * If the upstream model does not have at least 2 agents, the MCP is solved
+ * directly with PATH.
+ *
+ * @param mdl      the MCP model
+ * @param jacdata  the jacobian data of the MCP
+ * @param method   Opt_NashSolverJacobi or Opt_NashSolverGaussSeidel
+ *
+ * @return         the error code
+ */
+int nash_br_solve(Model *mdl, struct jacdata *jacdata, int method)
+{
+   int status = OK;
+   Container *ctr = &mdl->ctr;
+   Var * restrict vars = ctr->vars;
+   NashBrData dat;
+   memset(&dat, 0, sizeof(dat));
+
+   assert(method == Opt_NashSolverJacobi || method == Opt_NashSolverGaussSeidel);
+   const char *method_name = optnashsolver_getcurstr(method);
+   bool jacobi = method == Opt_NashSolverJacobi;
+
+   EmpDag *empdag_up = &mdl->mdl_up->empinfo.empdag;
+   if (!valid_uid(empdag_up->uid_root) || uidisMP(empdag_up->uid_root)) {
+      printout(PO_INFO, "[nash] The EMPDAG root of %s model '%.*s' #%u is not a Nash "
+               "node, solving the MCP with PATH instead of %s\n",
+               mdl_fmtargs(mdl->mdl_up), method_name);
+      return solver_path(mdl, jacdata);
+   }
+
+   dat.n = ctr->n;
+   MALLOC_(dat.owner, unsigned, dat.n);
+   S_CHECK_EXIT(nash_br_blocks(mdl, &dat));
+
+   if (dat.nblocks < 2) {
+      printout(PO_INFO, "[nash] Only %u agent(s) found in %s model '%.*s' #%u, solving "
+               "the MCP with PATH instead of %s\n", dat.nblocks,
+               mdl_fmtargs(mdl->mdl_up), method_name);
+      FREE(dat.owner);
+      return solver_path(mdl, jacdata);
+   }
+
+   MALLOC_EXIT(dat.lb, double, dat.n);
+   MALLOC_EXIT(dat.ub, double, dat.n);
+   MALLOC_EXIT(dat.x, double, dat.n);
+   MALLOC_EXIT(dat.F, double, dat.n);
+   if (jacobi) {
+      MALLOC_EXIT(dat.xnext, double, dat.n);
+      MALLOC_EXIT(dat.xwork, double, dat.n);
+   }
+
+   for (unsigned i = 0; i < dat.n; ++i) {
+      dat.lb[i] = vars[i].bnd.lb;
+      dat.ub[i] = vars[i].bnd.ub;
+      double val = vars[i].value;
+      dat.x[i] = nash_br_mid(dat.lb[i], dat.ub[i], isfinite(val) ? val : 0.);
+   }
+
+   S_CHECK_EXIT(nash_br_subs(jacdata, &dat));
+
+   double tol;
+   S_CHECK_EXIT(rmdl_getoption(mdl, "rtol", &tol));
+   int iterlimit = optvali(mdl, Options_Nash_Iteration_Limit);
+
+   printout(PO_INFO, "[nash] Solving %s model '%.*s' #%u with %s best-response "
+            "iterations over %u agents\n", mdl_fmtargs(mdl->mdl_up), method_name,
+            dat.nblocks);
+
+   double res = INFINITY;
+   int iter = 0;
+   bool converged = false;
+
+   while (iter < iterlimit) {
+      iter++;
+
+      for (unsigned b = 0; b < dat.nblocks; ++b) {
+         struct path_submcp *sub = &dat.subs[b];
+
+         /* Jacobi: every agent responds to x^k, Gauss-Seidel: to the latest point */
+         if (jacobi) {
+            memcpy(dat.xwork, dat.x, dat.n * sizeof(double));
+            sub->x = dat.xwork;
+         } else {
+            sub->x = dat.x;
+         }
+
+         S_CHECK_EXIT(solver_path_submcp(mdl, jacdata, sub));
+
+         int modelstat;
+         S_CHECK_EXIT(mdl_getmodelstat(mdl, &modelstat));
+         if (modelstat != ModelStat_OptimalLocal) {
+            printout(PO_INFO, "[nash] Iteration %d: the best response of agent #%u "
+                     "ended with model status '%s'\n", iter, b,
+                     mdl_modelstattxt(mdl, modelstat));
+         }
+
+         if (jacobi) {
+            for (unsigned k = 0; k < sub->n; ++k) {
+               unsigned vi = sub->vis[k];
+               dat.xnext[vi] = dat.xwork[vi];
+            }
+         }
+      }
+
+      /* Shared variables take the value given by the last block */
+      if (jacobi) { memcpy(dat.x, dat.xnext, dat.n * sizeof(double)); }
+
+      S_CHECK_EXIT(nash_br_residual(ctr, &dat, &res));
+
+      printout(PO_INFO, "[nash] %5d  KKT residual %e\n", iter, res);
+
+      if (res <= tol) { converged = true; break; }
+   }
+
+   if (iter == 0) {
+      /* We have not even evaluated the function yet */
+      S_CHECK_EXIT(nash_br_residual(ctr, &dat, &res));
+   }
+
+   nash_br_report(ctr, &dat, jacdata->n_primal);
+
+   if (converged) {
+      printout(PO_INFO, "[nash] Converged after %d iteration(s)\n", iter);
+      S_CHECK_EXIT(mdl_setmodelstat(mdl, ModelStat_OptimalLocal));
+      S_CHECK_EXIT(mdl_setsolvestat(mdl, SolveStat_Normal));
+   } else {
+      printout(PO_INFO, "[nash] Iteration limit %d reached, KKT residual is %e\n",
+               iterlimit, res);
+      S_CHECK_EXIT(mdl_setmodelstat(mdl, ModelStat_Feasible));
+      S_CHECK_EXIT(mdl_setsolvestat(mdl, SolveStat_Iteration));
+   }
+
+_exit:
+   nash_br_free(&dat);
+
+   return status;
+}
@@ -0,0 +1,16 @@
+#ifndef NASH_BR_H
+#define NASH_BR_H
+
+#include "compat.h"
+#include "rhp_fwd.h"
+
+/** @file nash_br.h
+ *
+ * @brief Best-response (Jacobi / Gauss-Seidel) decomposition of Nash equilibria
+ */
+
+struct jacdata;
+
+int nash_br_solve(Model *mdl, struct jacdata *jacdata, int method) NONNULL;
+
+#endif /* NASH_BR_H  */
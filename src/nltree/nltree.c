@@ -2017,6 +2017,44 @@ int nltree_evalat(NlTree * restrict tree, const double * restrict x,
    return OK;
 }
 
+static void nlnode_evalfootprint(const NlNode *node, uint64_t *nnodes,
+                                 uint64_t *nbytes)
+{
+   (*nnodes)++;
+   *nbytes += sizeof(NlNode) + node->children_max * sizeof(NlNode*);
+
+   if (node->op == NlNode_Var || node->oparg == NLNODE_OPARG_VAR ||
+       node->op == NlNode_Cst || node->oparg == NLNODE_OPARG_CST) {
+      *nbytes += sizeof(double);
+   }
+
+   NlNode * const * children = node->children;
+   for (unsigned i = 0, len = node->children_max; i < len; ++i) {
+      if (!children[i]) { continue; }
+      nlnode_evalfootprint(children[i], nnodes, nbytes);
+   }
+}
+
+/**
+ *  @brief Compute the work of an evaluation of an expression tree
+ *
+ *  Only the nodes reachable from the root are counted. The number of bytes is
+ *  an estimate that includes the nodes, the children arrays and the variable
+ *  and constant values.
+ *
+ *  @param       tree    the expression tree
+ *  @param[out]  nnodes  the number of nodes visited
+ *  @param[out]  nbytes  the number of bytes touched
+ */
+void nltree_evalfootprint(const NlTree *tree, uint64_t *nnodes, uint64_t *nbytes)
+{
+   *nnodes = *nbytes = 0;
+
+   if (tree->root && tree->root->op < __OPCODE_LEN) {
+      nlnode_evalfootprint(tree->root, nnodes, nbytes);
+   }
+}
+
 /** 
  *  @brief Insert an ADD node in the expression tree
  *
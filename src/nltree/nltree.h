@@ -9,6 +9,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
 #include "compat.h"
@@ -152,6 +153,7 @@ int nltree_alloc_var_list(NlTree* tree) NONNULL;
 int nltree_reset_var_list(NlTree* tree) NONNULL;
 int nltree_eval(Container *ctr, NlTree *tree, double *val);
 int nltree_evalat(NlTree *tree, const double *x, double *arr, double *val) NONNULL;
+void nltree_evalfootprint(const NlTree *tree, uint64_t *nnodes, uint64_t *nbytes) NONNULL;
 int nltree_find_add_node(NlTree *tree, NlNode ***raddr, NlPool *pool, double *coeff);
 
 void nltree_print_dot(const NlTree* tree, FILE *f, const Model *mdl) NONNULL_AT(1,2);
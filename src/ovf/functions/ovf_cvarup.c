@@ -46,6 +46,7 @@ const struct ovf_genops OVF_cvarup_datagen = {
    .set_cones_nonbox = cvar_gen_set_cones_nonbox,
    .size_u = u_size_same,
    .u_shift = cvar_u_shift,
+   .vrepr = NULL,
    .var = cvarup_gen_var,
    .var_ppty = &cvarup_varfill,
    .name = xstr(OVF_NAME),
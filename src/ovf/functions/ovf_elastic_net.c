@@ -223,6 +223,7 @@ const struct ovf_genops OVF_elastic_net_datagen = {
    .set_cones_nonbox = NULL,
    .size_u = elastic_net_size_u,
    .u_shift = NULL,
+   .vrepr = NULL,
    .var = elastic_net_gen_var,
    .var_ppty = &elastic_net_varfill,
    .name = xstr(OVF_NAME),
@@ -40,6 +40,18 @@ static int expectation_gen_b(unsigned n, const void* env, double **vals)
    return OK;
 }
 
+/* The set is the singleton {p}, with p the probabilities */
+static int expectation_vrepr(unsigned n, const void *env, struct generators **gen)
+{
+   double *p;
+   S_CHECK(expectation_gen_b(n, env, &p));
+
+   int status = generators_point(n, p, gen);
+   FREE(p);
+
+   return status;
+}
+
 static enum cone expectation_gen_set_cones(unsigned n, const void* env, unsigned idx,
                                      void **cone_data)
 {
@@ -109,6 +121,7 @@ const struct ovf_genops OVF_expectation_datagen = {
    .set_cones_nonbox = expectation_gen_set_cones,
    .size_u = u_size_same,
    .u_shift = expectation_u_shift,
+   .vrepr = expectation_vrepr,
    .var = expectation_gen_var,
    .var_ppty = &expectation_varfill,
    .name = xstr(OVF_NAME),
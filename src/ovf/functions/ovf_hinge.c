@@ -50,6 +50,11 @@ static enum cone hinge_gen_set_cones(unsigned n, const void* env, unsigned idx,
    return CONE_R_MINUS;
 }
 
+static int hinge_vrepr(unsigned n, const void *env, struct generators **gen)
+{
+   return generators_box(SIZE_U(n), 0., 1., gen);
+}
+
 static double hinge_var_lb(const void* env, unsigned indx)
 {
    return 0.;
@@ -97,6 +102,7 @@ const struct ovf_genops OVF_hinge_datagen = {
    .set_cones_nonbox = NULL,
    .size_u = hinge_size_u,
    .u_shift = NULL,
+   .vrepr = hinge_vrepr,
    .var = hinge_gen_var,
    .var_ppty = &hinge_varfill,
    .name = xstr(OVF_NAME),
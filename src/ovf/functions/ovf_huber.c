@@ -77,6 +77,7 @@ const struct ovf_genops OVF_huber_datagen = {
    .set_cones_nonbox = NULL,
    .size_u = huber_size_u,
    .u_shift = NULL,
+   .vrepr = NULL,
    .var = huber_gen_var,
    .var_ppty = &huber_varfill,
    .name = xstr(OVF_NAME),
@@ -99,6 +99,7 @@ const struct ovf_genops OVF_huber_scaled_datagen = {
    .set_cones_nonbox = NULL,
    .size_u = huber_scaled_size_u,
    .u_shift = NULL,
+   .vrepr = NULL,
    .var = huber_scaled_gen_var,
    .var_ppty = &huber_scaled_varfill,
    .name = xstr(OVF_NAME),
@@ -195,6 +195,7 @@ const struct ovf_genops OVF_hubnik_datagen = {
    .set_cones_nonbox = NULL,
    .size_u = hubnik_size_u,
    .u_shift = NULL,
+   .vrepr = NULL,
    .var = hubnik_gen_var,
    .var_ppty = &hubnik_varfill,
    .name = xstr(OVF_NAME),
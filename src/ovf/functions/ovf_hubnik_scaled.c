@@ -174,6 +174,7 @@ const struct ovf_genops OVF_hubnik_scaled_datagen = {
    .set_cones_nonbox = NULL,
    .size_u = hubnik_scaled_size_u,
    .u_shift = NULL,
+   .vrepr = NULL,
    .var = hubnik_scaled_gen_var,
    .var_ppty = &hubnik_scaled_varfill,
    .name = xstr(OVF_NAME),
@@ -51,6 +51,11 @@ static enum cone l1_gen_set_cones(unsigned n, const void* env, unsigned idx,
    return CONE_R_MINUS;
 }
 
+static int l1_vrepr(unsigned n, const void *env, struct generators **gen)
+{
+   return generators_box(SIZE_U(n), -1., 1., gen);
+}
+
 static double l1_var_lb(const void* env, unsigned indx)
 {
    return -1.;
@@ -97,6 +102,7 @@ const struct ovf_genops OVF_l1_datagen = {
    .set_cones_nonbox = NULL,
    .size_u = l1_size_u,
    .u_shift = NULL,
+   .vrepr = l1_vrepr,
    .var = l1_gen_var,
    .var_ppty = &l1_varfill,
    .name = xstr(OVF_NAME),
@@ -55,6 +55,7 @@ const struct ovf_genops OVF_l2_datagen = {
    .set_cones_nonbox = NULL,
    .size_u = l2_size_u,
    .u_shift = NULL,
+   .vrepr = NULL,
    .var = l2_gen_var,
    .var_ppty = &l2_varfill,
    .name = xstr(OVF_NAME),
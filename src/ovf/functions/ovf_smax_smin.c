@@ -128,6 +128,11 @@ static enum cone unit_simplex_gen_set_cones_nonbox(unsigned n, const void* env,
    return CONE_NONE;
 }
 
+static int unit_simplex_vrepr(unsigned n, const void *env, struct generators **gen)
+{
+   return generators_unit_simplex(n, gen);
+}
+
 static double unit_simplex_var_lb(const void* env, unsigned indx)
 {
    return 0;
@@ -173,6 +178,7 @@ const struct ovf_genops OVF_smax_datagen = {
    .set_cones_nonbox = unit_simplex_gen_set_cones_nonbox,
    .size_u = u_size_same,
    .u_shift = NULL,
+   .vrepr = unit_simplex_vrepr,
    .var = unit_simplex_gen_var,
    .var_ppty = &unit_simplex_varfill,
    .name = "smax",
@@ -194,6 +200,7 @@ const struct ovf_genops OVF_smin_datagen = {
    .set_cones_nonbox = unit_simplex_gen_set_cones_nonbox,
    .size_u = u_size_same,
    .u_shift = NULL,
+   .vrepr = unit_simplex_vrepr,
    .var = unit_simplex_gen_var,
    .var_ppty = &unit_simplex_varfill,
    .name = "smin",
@@ -76,6 +76,7 @@ const struct ovf_genops OVF_soft_hinge_datagen = {
    .set_cones_nonbox = NULL,
    .size_u = soft_hinge_size_u,
    .u_shift = NULL,
+   .vrepr = NULL,
    .var = soft_hinge_gen_var,
    .var_ppty = &soft_hinge_varfill,
    .name = xstr(OVF_NAME),
@@ -58,6 +58,11 @@ static enum cone sum_pos_part_gen_set_cones(unsigned n, const void* env, unsigne
    return CONE_R_MINUS;
 }
 
+static int sum_pos_part_vrepr(unsigned n, const void *env, struct generators **gen)
+{
+   return generators_box(SIZE_U(n), 0., 1., gen);
+}
+
 static double sum_pos_part_var_lb(const void* env, unsigned indx)
 {
    return 0;
@@ -105,6 +110,7 @@ const struct ovf_genops OVF_sum_pos_part_datagen = {
    .set_cones_nonbox = NULL,
    .size_u = sum_pos_part_size_u,
    .u_shift = NULL,
+   .vrepr = sum_pos_part_vrepr,
    .var = sum_pos_part_gen_var,
    .var_ppty = &sum_pos_part_varfill,
    .name = xstr(OVF_NAME),
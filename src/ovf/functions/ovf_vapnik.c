@@ -87,7 +87,7 @@ static int vapnik_gen_A(unsigned n, const void *env, SpMat *mat)
       rhpmat_set_csr(mat);
       mat->csr = ovf_speye_mat(SIZE_U(n), 2*SIZE_U(n), 1.);
       if (!mat->csr) return Error_InsufficientMemory;
-      for (size_t i = n; i < 2*n; ++i) {
+      for (size_t i = SIZE_U(n); i < 2*SIZE_U(n); ++i) {
          mat->csr->x[i] = -1.;
       }
    }
@@ -106,6 +106,11 @@ static int vapnik_gen_b(unsigned n, const void* env, double **vals)
 }
 
 
+static int vapnik_vrepr(unsigned n, const void *env, struct generators **gen)
+{
+   return generators_box(SIZE_U(n), 0., 1., gen);
+}
+
 static enum cone vapnik_gen_set_cones(unsigned n, const void* env, unsigned idx,
                                 void **cone_data)
 {
@@ -160,6 +165,7 @@ const struct ovf_genops OVF_vapnik_datagen = {
    .set_cones_nonbox = NULL,
    .size_u = vapnik_size_u,
    .u_shift = NULL,
+   .vrepr = vapnik_vrepr,
    .var = vapnik_gen_var,
    .var_ppty = &vapnik_varfill,
    .name = xstr(OVF_NAME),
@@ -2,6 +2,7 @@
 #define OVF_GENERATOR_H
 
 #include "cones.h"
+#include "generators.h"
 #include "rhp_fwd.h"
 #include "rhp_LA.h"
 /*  For var_genops */
@@ -20,6 +21,8 @@ typedef int (*gen_variable)(Container* ctr, unsigned nb_vars,
 typedef int (*gen_set_b_0)(unsigned n, const void* env, SpMat* mat,
                            double *u_shift, double **vals) NONNULL;
 typedef int (*gen_k)(unsigned n, const void* env, Equ *e) NONNULL;
+typedef int (*gen_vrepr)(unsigned n, const void* env,
+                         struct generators **gen) NONNULL;
 typedef enum cone (*gen_cones)(unsigned n, const void* env, unsigned idx,
                                 void **cone_data) NONNULL;
 
@@ -39,6 +42,7 @@ typedef struct ovf_genops {
    gen_cones set_cones_nonbox;
    size_t (*size_u)(size_t n_args);
    gen_vec u_shift;
+   gen_vrepr vrepr;          /**< closed-form V-representation of the set */
    gen_variable var;
    const struct var_genops *var_ppty;
    const char *name;
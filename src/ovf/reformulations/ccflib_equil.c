@@ -25,11 +25,21 @@ typedef struct {
    NlNode *nodes[] __counted_by(size);
 } DualObjEquNlNodes;
 
+/** Stack-like workspace for the DFS. It is sized by the counting pass */
 typedef struct {
    size_t size;
+   size_t used;
    void *mem;
 } DfsWorkspace;
 
+/** Sizes computed by the counting pass, before any modification of the model */
+typedef struct {
+   unsigned n_duals;       /**< Number of dual MPs to instantiate          */
+   unsigned n_vars;        /**< Number of new variables                    */
+   unsigned n_equs;        /**< Number of new equations                    */
+   size_t ws_size;         /**< Maximum workspace size along a DFS path    */
+} CcflibEquilSizes;
+
 typedef struct {
    RhpSense path_sense;
    mpid_t mpid_primal;           /* mpid of the active primal node */
@@ -48,6 +58,7 @@ static int ccflib_equil_dfs_dual(dagid_t mpid, DfsData *dfsdat, DagMpArray *mps,
                                  const DagMpArray *mps_old);
 static int ccflib_equil_dfs_primal(dagid_t mpid, DfsData *dfsdat, DagMpArray *mps,
                                    const DagMpArray *mps_old);
+static int ccflib_equil_dfs(Model *mdl, DfsWorkspace *wksp);
 
 
 
@@ -63,10 +74,10 @@ static int ccflib_equil_dfs_primal(dagid_t mpid, DfsData *dfsdat, DagMpArray *mp
 
 #endif
 
-#ifdef UNUSED_AS_OF_20240320
 static void ws_init(DfsWorkspace *ws)
 {
    ws->size = 0;
+   ws->used = 0;
    ws->mem = NULL;
 }
 
@@ -75,16 +86,181 @@ static void ws_fini(DfsWorkspace *ws)
    FREE(ws->mem);
 }
 
-static void* ws_getmem(DfsWorkspace *ws, size_t size)
+static inline size_t ws_align(size_t size)
 {
+   return (size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+}
+
+/* This must only be called before the DFS, as it invalidates the memory */
+static int ws_reserve(DfsWorkspace *ws, size_t size)
+{
+   assert(ws->used == 0);
    if (size > ws->size) {
-      REALLOC_NULL(ws->mem, uint8_t, size);
+      REALLOC_(ws->mem, uint8_t, size);
       ws->size = size;
    }
 
-   return ws->mem;
+   return OK;
+}
+
+/**
+ * @brief Get memory from the workspace
+ *
+ * If the workspace is too small, which should not happen when it is sized by
+ * the counting pass, the memory is allocated on the heap.
+ *
+ * @param       ws       the workspace
+ * @param       size     the requested size
+ * @param[out]  on_heap  true if the memory has been allocated on the heap
+ *
+ * @return               the memory, or NULL on allocation failure
+ */
+static void* ws_push(DfsWorkspace *ws, size_t size, bool *on_heap)
+{
+   size = ws_align(MAX(size, 1));
+
+   if (ws->used + size > ws->size) {
+      *on_heap = true;
+      return malloc(size);
+   }
+
+   *on_heap = false;
+   void *mem = (uint8_t*)ws->mem + ws->used;
+   ws->used += size;
+
+   return mem;
+}
+
+static void ws_pop(DfsWorkspace *ws, void *mem, size_t size, bool on_heap)
+{
+   if (on_heap) { free(mem); return; }
+
+   size = ws_align(MAX(size, 1));
+   assert(ws->used >= size && (uint8_t*)ws->mem + ws->used - size == mem);
+   ws->used -= size;
+}
+
+static inline size_t ws_dual_size(unsigned n_args, unsigned size_y)
+{
+   return ws_align(MAX(n_args * sizeof(NlNode**), 1)) + ws_align(MAX(size_y * sizeof(rhp_idx), 1));
+}
+
+static int ccflib_equil_count_dual(mpid_t mpid_dual, RhpSense path_sense,
+                                   const DagMpArray *mps_old, const EmpDagCsr *csr,
+                                   CcflibEquilSizes *sizes, size_t ws_path);
+
+/**
+ * @brief Counting pass for a primal MP: mirror of ccflib_equil_dfs_primal()
+ *
+ * @param mpid_primal  the primal MP
+ * @param path_sense   the sense of the saddle path
+ * @param mps_old      the MPs of the upstream EMPDAG
+ * @param csr          the adjacency of the upstream EMPDAG
+ * @param sizes        the sizes to update
+ * @param ws_path      the workspace used by the ancestors
+ *
+ * @return             the error code
+ */
+static int ccflib_equil_count_primal(mpid_t mpid_primal, RhpSense path_sense,
+                                     const DagMpArray *mps_old, const EmpDagCsr *csr,
+                                     CcflibEquilSizes *sizes, size_t ws_path)
+{
+   const MathPrgm *mp = mps_old->arr[mpid_primal];
+   unsigned n_arcs;
+   const Varc *Varcs = empdag_csr_Varcs(csr, mpid_primal, &n_arcs);
+
+   /* An objective equation may have to be created */
+   if (n_arcs > 0 && !valid_ei(mp_getobjequ(mp))) { sizes->n_equs++; }
+
+   for (unsigned i = 0; i < n_arcs; ++i) {
+      mpid_t mpid_child = Varcs[i].mpid_child;
+      assert(mpid_child < mps_old->len);
+
+      if (mp_getsense(mps_old->arr[mpid_child]) != path_sense) {
+         S_CHECK(ccflib_equil_count_dual(mpid_child, path_sense, mps_old, csr, sizes, ws_path));
+      }
+   }
+
+   return OK;
+}
+
+/**
+ * @brief Counting pass for a dual MP: mirror of ccflib_equil_dfs_dual()
+ *
+ * @param mpid_dual   the dual MP
+ * @param path_sense  the sense of the saddle path
+ * @param mps_old     the MPs of the upstream EMPDAG
+ * @param csr         the adjacency of the upstream EMPDAG
+ * @param sizes       the sizes to update
+ * @param ws_path     the workspace used by the ancestors
+ *
+ * @return            the error code
+ */
+static int ccflib_equil_count_dual(mpid_t mpid_dual, RhpSense path_sense,
+                                   const DagMpArray *mps_old, const EmpDagCsr *csr,
+                                   CcflibEquilSizes *sizes, size_t ws_path)
+{
+   const MathPrgm *mp_ccflib = mps_old->arr[mpid_dual];
+
+   /* Errors are reported by the DFS proper */
+   if (mp_ccflib->type != MpTypeCcflib) { return OK; }
+
+   OvfOpsData ovfd = {.ovf = mp_ccflib->ccflib.ccf};
+   unsigned n_arcs;
+   const Varc *Varcs = empdag_csr_Varcs(csr, mpid_dual, &n_arcs);
+   unsigned n_args = n_arcs + avar_size(ovfd.ovf->args);
+   unsigned size_y = ovfdef_ops.size_y(ovfd, n_args);
+
+   sizes->n_duals++;
+   sizes->n_vars += size_y;
+   sizes->n_equs++;                     /* objective equation of the dual MP */
+
+   ws_path += ws_dual_size(n_args, size_y);
+   sizes->ws_size = MAX(sizes->ws_size, ws_path);
+
+   for (unsigned i = 0; i < n_arcs; ++i) {
+      mpid_t mpid_child = Varcs[i].mpid_child;
+      assert(mpid_child < mps_old->len);
+
+      if (mp_getsense(mps_old->arr[mpid_child]) == path_sense) {
+         S_CHECK(ccflib_equil_count_primal(mpid_child, path_sense, mps_old, csr, sizes, ws_path));
+      }
+   }
+
+   return OK;
+}
+
+/**
+ * @brief Compute the size of the equilibrium reformulation of the CCFLIB MPs
+ *
+ * This allows to reserve the container, the EMPDAG and the DFS workspace just
+ * once, before the reformulation.
+ *
+ * @param       empdag_up  the upstream EMPDAG
+ * @param[out]  sizes      the sizes
+ *
+ * @return                 the error code
+ */
+static int ccflib_equil_count(const EmpDag *empdag_up, CcflibEquilSizes *sizes)
+{
+   memset(sizes, 0, sizeof(*sizes));
+
+   const mpid_t *saddle_path_start_mps = empdag_up->minimaxi.saddle_path_starts.arr;
+   const DagMpArray *mps_old = &empdag_up->mps;
+   const EmpDagCsr *csr;
+   S_CHECK(empdag_csr_get(empdag_up, &csr));
+
+   for (unsigned i = 0, len = empdag_up->minimaxi.saddle_path_starts.len; i < len; ++i) {
+      mpid_t mpid = saddle_path_start_mps[i];
+      assert(mpid < mps_old->len);
+
+      RhpSense path_sense = mp_getsense(mps_old->arr[mpid]);
+
+      S_CHECK(ccflib_equil_count_primal(mpid, path_sense, mps_old, csr, sizes, 0));
+   }
+
+   return OK;
 }
-#endif
 
 /**
  * @brief Instanciate the CCFLIB node whose children are EMPDAG nodes
@@ -521,7 +697,8 @@ static int ccflib_equil_dfs_primal(mpid_t mpid_primal, DfsData *dfsdat, DagMpArr
    }
 
    /* Reset the Varcs in the new EMPDAG */
-   mps->Varcs[mpid_primal].len = 0;
+   assert(mps == &empdag->mps);
+   empdag_mpVFresetarcs(empdag, mpid_primal);
 
   /* ----------------------------------------------------------------------
    * Iterate over the children. 
@@ -657,8 +834,8 @@ static int ccflib_equil_dfs_dual(mpid_t mpid_dual, DfsData *dfsdat, DagMpArray *
    /* EMPDAG: reset VF children of dual node */
    unsigned n_arcs = mps_old->Varcs[mpid_dual].len;
    const ArcVFData *arcVFs_old = mps_old->Varcs[mpid_dual].arr;
-   VarcArray *Varcs = &mps->Varcs[mpid_dual];
-   Varcs->len = 0;
+   assert(mps == &dfsdat->empdag->mps);
+   empdag_mpVFresetarcs(dfsdat->empdag, mpid_dual);
 
    RhpSense path_sense = dfsdat->path_sense;
 
@@ -676,14 +853,22 @@ static int ccflib_equil_dfs_dual(mpid_t mpid_dual, DfsData *dfsdat, DagMpArray *
    }
 
    unsigned n_args = n_arcs + n_maps;
-   CALLOC_(child_nlnodes, NlNode**, n_args);
+   size_t child_nlnodes_size = n_args * sizeof(NlNode**);
+   size_t workY_size = dualdat.y.size * sizeof(rhp_idx);
+   bool child_nlnodes_heap, workY_heap;
+
+   child_nlnodes = ws_push(&dfsdat->wksp, child_nlnodes_size, &child_nlnodes_heap);
+   if (!child_nlnodes) { return Error_InsufficientMemory; }
+   memset((void*)child_nlnodes, 0, child_nlnodes_size);
+
+   /* workspace similar to y */
+   workY = ws_push(&dfsdat->wksp, workY_size, &workY_heap);
+   if (!workY) { status = Error_InsufficientMemory; goto _exit; }
+
    S_CHECK_EXIT(ccflib_equil_setup_dual_objequ(dfsdat, mp_dual, &dualdat.B, mps_old, child_nlnodes));
    rhp_idx objei_dual = dfsdat->dual_objequ_dat.ei_dst;
    assert(valid_ei(objei_dual));
 
-   /* workspace similar to y */
-   MALLOC_(workY, rhp_idx, dualdat.y.size);
-
    UIntArray *rarcs = mps->rarcs;
 
    /* save our dual information */
@@ -813,9 +998,12 @@ static int ccflib_equil_dfs_dual(mpid_t mpid_dual, DfsData *dfsdat, DagMpArray *
 
 _exit:
 
-   free((void*)child_nlnodes);
+   /* Release in the reverse order of the allocation */
+   if (workY) {
+      ws_pop(&dfsdat->wksp, workY, workY_size, workY_heap);
+   }
 
-   free(workY);
+   ws_pop(&dfsdat->wksp, (void*)child_nlnodes, child_nlnodes_size, child_nlnodes_heap);
 
    DEBUG_DISPLAY_OBJEQU(dfsdat->mdl, mp_dual)
 
@@ -824,6 +1012,41 @@ _exit:
 
 
 int ccflib_equil(Model *mdl)
+{
+   int status = OK;
+   EmpDag *empdag = &mdl->empinfo.empdag;
+   const EmpDag *empdag_up = empdag->empdag_up;
+   DfsWorkspace wksp;
+   ws_init(&wksp);
+
+  /* ----------------------------------------------------------------------
+   * Counting pass: the new variables, equations, MPs and the workspace are
+   * sized beforehand. The reformulation then writes each contribution in
+   * place, without growing the container or the workspace along the way.
+   * ---------------------------------------------------------------------- */
+
+   CcflibEquilSizes sizes;
+   S_CHECK(ccflib_equil_count(empdag_up, &sizes));
+
+   trace_process("[ccflib/equil] reserving %u vars, %u equs for %u dual MPs; "
+                 "workspace of %zu bytes\n", sizes.n_vars, sizes.n_equs,
+                 sizes.n_duals, sizes.ws_size);
+
+   Container *ctr = &mdl->ctr;
+   S_CHECK(rctr_reserve_vars(ctr, sizes.n_vars));
+   S_CHECK(rctr_reserve_equs(ctr, sizes.n_equs));
+   S_CHECK(mpidarray_reserve(&empdag->mps_newly_created, sizes.n_duals));
+   S_CHECK(ws_reserve(&wksp, sizes.ws_size));
+
+   S_CHECK_EXIT(ccflib_equil_dfs(mdl, &wksp));
+
+_exit:
+   ws_fini(&wksp);
+
+   return status;
+}
+
+static int ccflib_equil_dfs(Model *mdl, DfsWorkspace *wksp)
 {
    EmpDag *empdag = &mdl->empinfo.empdag;
    const EmpDag *empdag_up = empdag->empdag_up;
@@ -841,7 +1064,7 @@ int ccflib_equil(Model *mdl)
       trace_process("[ccflib/equil] processing saddle path starting at MP(%s)\n",
                     empdag_getmpname(empdag, mpid));
       DfsData dfsdat = {.mpid_primal = MpId_NA, .mpid_dual = MpId_NA, 
-                        .vi_dual = IdxNA, .empdag = empdag, .mdl = mdl};
+                        .vi_dual = IdxNA, .wksp = *wksp, .empdag = empdag, .mdl = mdl};
 
       dfsdat.dual_objequ_dat.ei_dst = IdxNA;
       dfsdat.dual_objequ_dat.nlnode_addr = NULL;
@@ -915,7 +1138,7 @@ int ccflib_equil(Model *mdl)
 
          mpid_t mpid_parent = uid2id(uid);
 
-         UIntArray * restrict Carcs_parent = &empdag->mps.Carcs[mpid_parent];
+         const UIntArray *Carcs_parent = &empdag->mps.Carcs[mpid_parent];
          unsigned idx = rhp_uint_find(Carcs_parent, mpid2uid(mpid));
 
          if (idx == UINT_MAX) {
@@ -936,7 +1159,7 @@ int ccflib_equil(Model *mdl)
                return Error_BugPleaseReport;
             }
 
-            Carcs_parent->arr[idx] = nashid2uid(equil->id);
+            empdag_mpCTRLsetarc(empdag, mpid_parent, idx, nashid2uid(equil->id));
 
          }
 
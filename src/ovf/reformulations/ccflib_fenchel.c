@@ -6,6 +6,7 @@
 #include "mathprgm.h"
 #include "mdl.h"
 #include "ctrdat_rhp.h"
+#include "mdl_timings.h"
 #include "ovf_common.h"
 #include "rhp_fwd.h"
 #include "timings.h"
@@ -112,6 +113,7 @@ int ccflib_dualize_fenchel_empdag(Model *mdl, CcflibPrimalDualData *ccfprimaldua
 {
    int status = OK;
    double start = get_thrdtime();
+   unsigned span = mdl_prof_begin(mdl, "CCF Fenchel");
 
    /* ----------------------------------------------------------------------
     * Analyze the conic QP structure:
@@ -180,6 +182,7 @@ _exit:
 
    ops->trimmem(ovfd);
 
+   mdl_prof_end(mdl, span);
    simple_timing_add(&mdl->timings->reformulation.CCF.fenchel, get_thrdtime() - start);
 
    return status;
@@ -174,6 +174,13 @@ static int ccflib_get_set_0(OvfOpsData ovfd, SpMat *A_0, double **b_0, double **
    return ovfgen_get_set_0(ovf, A_0, b_0, shift_u);
 }
 
+static int ccflib_get_vrepr(OvfOpsData ovfd, struct generators **gen)
+{
+   OvfDef *ovf = ovfd.ccfdat->mp_primal->ccflib.ccf;
+
+   return ovfgen_get_vrepr(ovf, gen);
+}
+
 static void ccflib_get_ppty(OvfOpsData ovfd, struct ovf_ppty *ovf_ppty)
 {
    OvfDef *ovf = ovfd.ccfdat->mp_primal->ccflib.ccf;
@@ -268,6 +275,7 @@ const struct ovf_ops ccflib_ops = {
    .get_set = ccflib_get_set,
    .get_set_nonbox = ccflib_get_set_nonbox,
    .get_set_0 = ccflib_get_set_0,
+   .get_vrepr = ccflib_get_vrepr,
    .create_uvar = ccflib_create_uvar,
    .get_var_lb = ccflib_get_var_lb,
    .get_var_ub = ccflib_get_var_ub,
@@ -844,7 +844,7 @@ int fenchel_edit_empdag(CcfFenchelData * restrict fdat, Model * restrict mdl)
    switch (fdat->type) {
    /* All outgoing arcs are replaced. Just zero them here */
    case OvfType_Ccflib:
-      empdag->mps.Varcs[mpid_dual].len = 0;
+      empdag_mpVFresetarcs(empdag, mpid_dual);
       break;
    /* arcs are substituted between the primal MP and the child */
    // FIXME: can we just zero?
@@ -855,7 +855,7 @@ int fenchel_edit_empdag(CcfFenchelData * restrict fdat, Model * restrict mdl)
    }
 
    daguid_t rarc_primal = rarcVFuid(mpid2uid(mpid_primal));
-   empdag->mps.Varcs[mpid_primal].len = 0;
+   empdag_mpVFresetarcs(empdag, mpid_primal);
 
    for (unsigned j = 0; j < nVF; ++j, ++Varcs_primal) {
 
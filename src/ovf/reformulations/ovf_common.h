@@ -8,6 +8,8 @@
 #include "mathprgm_data.h"
 #include "ovfinfo.h"
 
+struct generators;
+
 /** @file ovf_common.h
  *
  *  @brief common part for OVF reformulation
@@ -90,6 +92,7 @@ typedef struct ovf_ops {
    int (*get_set)(OvfOpsData ovfd, SpMat *At, double** b, bool trans);
    int (*get_set_nonbox)(OvfOpsData ovfd, SpMat *A, double** b, bool trans);
    int (*get_set_0)(OvfOpsData ovfd, SpMat *At, double** b, double ** u_shift);
+   int (*get_vrepr)(OvfOpsData ovfd, struct generators **gen);
    int (*create_uvar)(OvfOpsData ovfd, Container *ctr, char *name, Avar *uvar);
    double (*get_var_lb)(OvfOpsData ovfd, size_t vidx);
    double (*get_var_ub)(OvfOpsData ovfd, size_t vidx);
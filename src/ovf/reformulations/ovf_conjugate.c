@@ -10,7 +10,6 @@
 #include "container.h"
 #include "ctr_rhp.h"
 #include "equ_modif.h"
-#include "mdl_timings.h"
 #include "nltree.h"
 #include "nltree_priv.h"
 #include "filter_ops.h"
@@ -19,6 +18,7 @@
 #include "macros.h"
 #include "mathprgm.h"
 #include "mdl.h"
+#include "mdl_timings.h"
 #include "ctrdat_rhp.h"
 #include "ctr_rhp_add_vars.h"
 #include "open_lib.h"
@@ -198,6 +198,7 @@ static int _add_gen_type(struct gen_data * restrict dat, rhp_idx vi, enum cone c
 int ovf_conjugate(Model *mdl, enum OVF_TYPE type, union ovf_ops_data ovfd)
 {
    double start = get_thrdtime();
+   unsigned span = mdl_prof_begin(mdl, "CCF conjugate");
 
    const struct ovf_ops *op;
    int status = OK;
@@ -267,11 +268,25 @@ int ovf_conjugate(Model *mdl, enum OVF_TYPE type, union ovf_ops_data ovfd)
     *   of the set Y.
     * --------------------------------------------------------------------- */
 
-   /* We look for A and s such that Ax - s belongs to K */
-   S_CHECK_EXIT(op->get_set(ovfd, &A, &s, false));
+   /* ---------------------------------------------------------------------
+    * Use the closed-form V-representation of the set if there is one.
+    * Otherwise, we look for A and s such that Ax - s belongs to K, and
+    * compute the generators with vrepr.
+    * --------------------------------------------------------------------- */
+   S_CHECK_EXIT(op->get_vrepr(ovfd, &gen));
    S_CHECK_EXIT(op->get_D(ovfd, &D, &J));
 
-   if (A.ppty) {
+   if (!gen) {
+      S_CHECK_EXIT(op->get_set(ovfd, &A, &s, false));
+   }
+
+   if (gen) {
+      has_set = true;
+      n_u = gen->dim;
+      trace_process("[conjugate] closed-form V-representation with %u vertices, "
+                    "%u rays and %u lines\n", gen->vertices.size, gen->rays.size,
+                    gen->lines.size);
+   } else if (A.ppty) {
       has_set = true;
       S_CHECK_EXIT(rhpmat_get_size(&A, &n_u, &n_constr));
       struct ctrmem CTRMEM working_mem = {.ptr = NULL, .ctr = ctr};
@@ -746,6 +761,7 @@ _exit:
    FREE(les);
    FREE(trees);
 
+   mdl_prof_end(mdl, span);
    simple_timing_add(&mdl->timings->reformulation.CCF.conjugate.stats, get_thrdtime() - start);
 
    return status;
@@ -7,12 +7,12 @@
 #include "equ_modif.h"
 #include "equil_common.h"
 #include "equvar_helpers.h"
-#include "mdl_timings.h"
 #include "nltree.h"
 #include "nltree_priv.h"
 #include "macros.h"
 #include "mathprgm.h"
 #include "mdl.h"
+#include "mdl_timings.h"
 #include "ctrdat_rhp.h"
 #include "printout.h"
 #include "ovf_common.h"
@@ -166,6 +166,7 @@ _exit:
 int ovf_equil(Model *mdl, enum OVF_TYPE type, union ovf_ops_data ovfd)
 {
    double start = get_thrdtime();
+   unsigned span = mdl_prof_begin(mdl, "CCF equilibrium");
 
    int status = OK;
 
@@ -319,6 +320,7 @@ _exit:
    rhpmat_free(&B);
    FREE(b);
 
+   mdl_prof_end(mdl, span);
    simple_timing_add(&mdl->timings->reformulation.CCF.equilibrium, get_thrdtime() - start);
 
    return status;
@@ -12,8 +12,8 @@
 #include "filter_ops.h"
 #include "macros.h"
 #include "mdl.h"
-#include "ctrdat_rhp.h"
 #include "mdl_timings.h"
+#include "ctrdat_rhp.h"
 #include "ovf_common.h"
 #include "ovf_fenchel.h"
 #include "ovf_options.h"
@@ -28,6 +28,7 @@
 int ovf_fenchel(Model *mdl, OvfType type, OvfOpsData ovfd)
 {
    double start = get_thrdtime();
+   unsigned span = mdl_prof_begin(mdl, "CCF Fenchel");
    int status = OK;
    const OvfOps *ops;
 
@@ -220,7 +221,9 @@ int ovf_fenchel(Model *mdl, OvfType type, OvfOpsData ovfd)
    S_CHECK(fenchel_gen_cons(&fdat, mdl));
 
    bool *equ_gen = fdat.cons_gen; assert(equ_gen);
-   rhp_idx ei = aequ_fget(&fdat.dual.cons, 0);
+
+   /* For a singleton set (e.g. expectation), no constraint is generated */
+   rhp_idx ei = aequ_size(&fdat.dual.cons) > 0 ? aequ_fget(&fdat.dual.cons, 0) : IdxNA;
 
    for (unsigned i = 0; i < n_y; ++i) {
       if (!equ_gen[i]) { continue; } /* No generated equation */
@@ -310,6 +313,7 @@ _exit:
 
    ops->trimmem(ovfd);
 
+   mdl_prof_end(mdl, span);
    simple_timing_add(&mdl->timings->reformulation.CCF.fenchel, get_thrdtime() - start);
 
    return status;
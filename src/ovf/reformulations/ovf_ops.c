@@ -118,6 +118,13 @@ static int ovfdef_get_set_0(OvfOpsData ovfd, SpMat *A_0, double **b_0, double **
    return ovfgen_get_set_0(ovf, A_0, b_0, shift_u);
 }
 
+static int ovfdef_get_vrepr(OvfOpsData ovfd, struct generators **gen)
+{
+   OvfDef *ovf = ovfd.ovf;
+
+   return ovfgen_get_vrepr(ovf, gen);
+}
+
 static void ovfdef_get_ppty(OvfOpsData ovfd, struct ovf_ppty *ovf_ppty)
 {
    OvfDef *ovf = ovfd.ovf;
@@ -200,6 +207,7 @@ const OvfOps ovfdef_ops = {
    .get_set = ovfdef_get_set,
    .get_set_nonbox = ovfdef_get_set_nonbox,
    .get_set_0 = ovfdef_get_set_0,
+   .get_vrepr = ovfdef_get_vrepr,
    .create_uvar = ovfdef_create_uvar,
    .get_var_lb = ovfdef_get_var_lb,
    .get_var_ub = ovfdef_get_var_ub,
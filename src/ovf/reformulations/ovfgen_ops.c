@@ -121,6 +121,25 @@ int ovfgen_get_set_nonbox(OvfDef *ovf, SpMat *A, double** b, bool trans)
    return OK;
 }
 
+/**
+ * @brief Get the closed-form V-representation of the OVF set, if any
+ *
+ * @param      ovf  the OVF
+ * @param[out] gen  the generators, or NULL if no closed form is known
+ *
+ * @return          the error code
+ */
+int ovfgen_get_vrepr(OvfDef *ovf, struct generators **gen)
+{
+   *gen = NULL;
+
+   if (ovf->generator->vrepr) {
+      S_CHECK(ovf->generator->vrepr(ovf_argsize(ovf), ovf->params, gen));
+   }
+
+   return OK;
+}
+
 int ovfgen_get_set_0(OvfDef *ovf, SpMat *A_0, double **b_0, double **shift_u)
 {
    rhpmat_reset(A_0);
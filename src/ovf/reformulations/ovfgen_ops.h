@@ -6,6 +6,7 @@
 #include "cones.h"
 #include "rhp_fwd.h"
 struct ovf_ppty;
+struct generators;
 
 int ovfgen_add_k(OvfDef *ovf, Model *mdl, Equ *e, Avar *y) NONNULL;
 int ovfgen_create_uvar(OvfDef *ovf, Container *ctr, char* name, Avar *uvar) NONNULL;
@@ -15,6 +16,7 @@ int ovfgen_get_M(OvfDef *ovf, SpMat *M) NONNULL;
 int ovfgen_get_set(OvfDef *ovf, SpMat *A, double** b, bool trans) NONNULL;
 int ovfgen_get_set_nonbox(OvfDef *ovf, SpMat *A, double** b, bool trans) NONNULL;
 int ovfgen_get_set_0(OvfDef *ovf, SpMat *A_0, double **b_0, double **shift_u) NONNULL;
+int ovfgen_get_vrepr(OvfDef *ovf, struct generators **gen) NONNULL;
 void ovfgen_get_ppty(OvfDef *ovf, struct ovf_ppty *ovf_ppty) NONNULL;
 int ovfgen_get_cone(OvfDef *ovf, unsigned idx, enum cone *cone, void **cone_data) NONNULL;
 int ovfgen_get_cone_nonbox(OvfDef *ovf, unsigned idx, enum cone *cone, void **cone_data) NONNULL;
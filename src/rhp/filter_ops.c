@@ -740,20 +740,17 @@ struct aequ_list {
 #define RHP_ELT_INVALID ((Aequ){.size = UINT_MAX, .type = EquVar_Unset})
 #include "list_generic.inc"
 
-static int dfs_equvar(EmpDag *empdag, daguid_t uid, struct avar_list *vars,
-                      struct aequ_list *equs)
+static int dfs_equvar(const EmpDag *empdag, const EmpDagCsr *csr, daguid_t uid,
+                      struct avar_list *vars, struct aequ_list *equs)
 {
-   daguid_t * restrict children;
-   struct VFedges * restrict Varcs;
-   unsigned num_children;
+   const daguid_t * restrict children;
+   const Varc * restrict Vlist;
+   unsigned num_children, num_Varcs;
 
    if (uidisMP(uid)) {
       mpid_t id = uid2id(uid);
-      UIntArray *Carcs = &empdag->mps.Carcs[id];
-      children = Carcs->arr;
-      num_children = Carcs->len;
-
-      Varcs = &empdag->mps.Varcs[id];
+      children = empdag_csr_Carcs(csr, id, &num_children);
+      Vlist = empdag_csr_Varcs(csr, id, &num_Varcs);
 
       MathPrgm *mp = empdag->mps.arr[id];
 
@@ -770,43 +767,37 @@ static int dfs_equvar(EmpDag *empdag, daguid_t uid, struct avar_list *vars,
    } else {
 
       nashid_t id = uid2id(uid);
-      UIntArray *mpe_children = &empdag->nashs.arcs[id];
-      children = mpe_children->arr;
-      num_children = mpe_children->len;
+      children = empdag_csr_nasharcs(csr, id, &num_children);
 
       assert(num_children > 0);
 
-      Varcs = NULL;
+      Vlist = NULL;
+      num_Varcs = 0;
    }
 
 
    for (unsigned i = 0; i < num_children; ++i) {
-      S_CHECK(dfs_equvar(empdag, children[i], vars, equs));
+      S_CHECK(dfs_equvar(empdag, csr, children[i], vars, equs));
    }
 
-   if (!Varcs) { return OK; }
-
-   struct rhp_empdag_arcVF *Vlist = Varcs->arr;
-   for (unsigned i = 0, len = Varcs->len; i < len; ++i) {
-      S_CHECK(dfs_equvar(empdag, mpid2uid(Vlist[i].mpid_child), vars, equs));
+   for (unsigned i = 0; i < num_Varcs; ++i) {
+      S_CHECK(dfs_equvar(empdag, csr, mpid2uid(Vlist[i].mpid_child), vars, equs));
    }
 
    return OK;
 }
 
-static int dfs_equ(EmpDag *empdag, daguid_t uid, struct aequ_list *equs)
+static int dfs_equ(const EmpDag *empdag, const EmpDagCsr *csr, daguid_t uid,
+                   struct aequ_list *equs)
 {
-   daguid_t * restrict children;
-   struct VFedges * restrict Varcs;
-   unsigned num_children;
+   const daguid_t * restrict children;
+   const Varc * restrict Vlist;
+   unsigned num_children, num_Varcs;
 
    if (uidisMP(uid)) {
       mpid_t id = uid2id(uid);
-      UIntArray *Carcs = &empdag->mps.Carcs[id];
-      children = Carcs->arr;
-      num_children = Carcs->len;
-
-      Varcs = &empdag->mps.Varcs[id];
+      children = empdag_csr_Carcs(csr, id, &num_children);
+      Vlist = empdag_csr_Varcs(csr, id, &num_Varcs);
 
       MathPrgm *mp = empdag->mps.arr[id];
 
@@ -818,25 +809,21 @@ static int dfs_equ(EmpDag *empdag, daguid_t uid, struct aequ_list *equs)
    } else {
 
       nashid_t id = uid2id(uid);
-      UIntArray *mpe_children = &empdag->nashs.arcs[id];
-      children = mpe_children->arr;
-      num_children = mpe_children->len;
+      children = empdag_csr_nasharcs(csr, id, &num_children);
 
       assert(num_children > 0);
 
-      Varcs = NULL;
+      Vlist = NULL;
+      num_Varcs = 0;
    }
 
 
    for (unsigned i = 0; i < num_children; ++i) {
-      S_CHECK(dfs_equ(empdag, children[i], equs));
+      S_CHECK(dfs_equ(empdag, csr, children[i], equs));
    }
 
-   if (!Varcs) { return OK; }
-
-   struct rhp_empdag_arcVF *Vlist = Varcs->arr;
-   for (unsigned i = 0, len = Varcs->len; i < len; ++i) {
-      S_CHECK(dfs_equ(empdag, mpid2uid(Vlist[i].mpid_child), equs));
+   for (unsigned i = 0; i < num_Varcs; ++i) {
+      S_CHECK(dfs_equ(empdag, csr, mpid2uid(Vlist[i].mpid_child), equs));
    }
 
    return OK;
@@ -905,7 +892,10 @@ Fops* fops_subdag_new(Model *mdl, daguid_t uid)
    avar_list_init(&vars);
    aequ_list_init(&equs);
 
-   S_CHECK_EXIT(dfs_equvar(empdag, uid, &vars, &equs));
+   const EmpDagCsr *csr;
+   S_CHECK_EXIT(empdag_csr_get(empdag, &csr));
+
+   S_CHECK_EXIT(dfs_equvar(empdag, csr, uid, &vars, &equs));
    assert(vars.list && equs.list);
 
    struct mp_descr mp_d;
@@ -977,7 +967,10 @@ Fops* fops_subdag_activevars_new(Model *mdl, daguid_t uid)
    struct aequ_list equs;
    aequ_list_init(&equs);
 
-   S_CHECK_EXIT(dfs_equ(empdag, uid, &equs));
+   const EmpDagCsr *csr;
+   S_CHECK_EXIT(empdag_csr_get(empdag, &csr));
+
+   S_CHECK_EXIT(dfs_equ(empdag, csr, uid, &equs));
    assert(equs.list);
 
    struct mp_descr mp_d;
@@ -24,6 +24,7 @@
 #include "rmdl_gams.h"
 #include "rmdl_data.h"
 #include "rmdl_options.h"
+#include "rmdl_reduce.h"
 #include "str2idx.h"
 
 static int err_hop_mdl(const Model *mdl, const char *fn)
@@ -53,6 +54,7 @@ static int rmdl_allocdata(Model *mdl)
    MALLOC_EXIT(mdldata, RhpModelData, 1);
    mdldata->solver = RMDL_SOLVER_UNSET;
    mdldata->status = Rmdl_NoStatus;
+   mdldata->reduce = NULL;
 
    A_CHECK_EXIT(mdldata->options, rmdl_set_options());
 
@@ -70,6 +72,7 @@ static void rmdl_deallocdata(Model *mdl)
    if (mdl->data) {
       RhpModelData *data = mdl->data;
       FREE(data->options);
+      rmdl_reduce_free(data->reduce);
       FREE(data);
       mdl->data = NULL;
    }
@@ -591,15 +594,20 @@ static int rmdl_reportvalues(Model *mdl, const Model *mdl_src)
    BackendType backend = mdl_src->backend;
    switch (backend) {
    case RhpBackendGamsGmo:
-      return rctr_reporvalues_from_gams(&mdl->ctr, &mdl_src->ctr);
+      S_CHECK(rctr_reporvalues_from_gams(&mdl->ctr, &mdl_src->ctr));
+      break;
    case RhpBackendReSHOP:
    case RhpBackendJulia:
-      return rmdl_reportvalues_from_rhp(&mdl->ctr, &mdl_src->ctr);
+      S_CHECK(rmdl_reportvalues_from_rhp(&mdl->ctr, &mdl_src->ctr));
+      break;
    default:
       error("%s :: not implement for container of type %s\n",
                          __func__, backend2str(backend));
       return Error_NotImplemented;
    }
+
+   /* Recover the values of the rows and variables removed by the presolve */
+   return rmdl_reduce_postsolve(mdl);
 }
 
 int rmdl_setobjsense(Model *mdl, RhpSense objsense)
@@ -1032,6 +1040,9 @@ int rmdl_mp_objequ2objfun(Model *mdl, MathPrgm *mp, rhp_idx objvar, rhp_idx obje
       S_CHECK(arcVF_subei(&varcs_arr[i], objequ_old, objequ));
    }
 
+   /* The frozen adjacency has copies of the arcs */
+   empdag_csr_invalidate(&empdag->csr);
+
    return OK;
 }
 
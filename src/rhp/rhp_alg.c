@@ -15,12 +15,22 @@
 #include "filter_ops.h"
 #include "macros.h"
 #include "mdl.h"
+#include "mdl_gams.h"
+#include "reshop.h"
+#include "reshop_solvers.h"
 #include "rhp_alg.h"
 #include "pool.h"
 #include "printout.h"
 #include "status.h"
 #include "timings.h"
 
+/* Same condition as in tlsdef.h for the availability of threads.h */
+#if __STDC_VERSION__ >= 201112L && !defined(_WIN32) && !(defined __APPLE__) && \
+    (!defined(__STDC_NO_THREADS__) || __STDC_NO_THREADS__ == 0)
+#   include <threads.h>
+#   define PRESOLVE_HAS_THREADS
+#endif
+
 int ctr_compress_equs_check(const Container *ctr_src, Container *ctr_dst, size_t skip_equ)
 {
    return ctr_compress_equs_check_x(ctr_src, ctr_dst, skip_equ,  ctr_src->fops);
@@ -437,38 +447,36 @@ static int nlpool_inject_varvals(Container *ctr)
    return OK;
 }
 
+/**
+ * @brief Report the values of a solved presolve submodel into the original model
+ *
+ * Only the variables and equations kept by the export are updated, as given by
+ * the rosetta arrays. Since the submodels of distinct MPs have disjoint variables
+ * and equations, this function can be called concurrently for those.
+ *
+ * @param ctr                 the container of the original model
+ * @param ctr_subsolver       the container of the solved submodel
+ * @param rosetta_vars        the variable rosetta of the export
+ * @param rosetta_equs        the equation rosetta of the export
+ * @param nlpool_data         the pool data
+ * @param pool_varvals_start  the start of the variable values in the pool
+ *
+ * @return                    the error code
+ */
 NONNULL static int
-presolve_submodel_solve(Model *mdl, Model *mdl_subsolver, double * restrict nlpool_data,
-                        unsigned pool_varvals_start)
+presolve_submodel_report(Container *ctr, Container *ctr_subsolver,
+                         const rhp_idx * restrict rosetta_vars,
+                         const rhp_idx * restrict rosetta_equs,
+                         double * restrict nlpool_data, unsigned pool_varvals_start)
 {
-   /* TODO: add option for selection subsolver */
-
-   mdl_subsolver->ctr.n = mdl_subsolver->ctr.m = 0;
-   mdl_subsolver->status &= MdlPreSolve;
-   mdl_subsolver->ctr.status = 0;
-
-   Container * restrict ctr = &mdl->ctr;
-   Container * restrict ctr_subsolver = &mdl_subsolver->ctr;
-
-   S_CHECK(mdl_export(mdl, mdl_subsolver));
-
-   S_CHECK(mdl_solve(mdl_subsolver));
-
-   /* Phase 1: report the values from the solver to the RHP */
    /* TODO(xhub) optimize and iterate over the valid equations */
 
    int status = OK;
 
-   /* We read those here, since they may not exist at the beginning  */
-   rhp_idx * restrict rosetta_vars = ctr->rosetta_vars;
-   rhp_idx * restrict rosetta_equs = ctr->rosetta_equs;
-
-
-   struct ctrmem CTRMEM working_mem = {.ptr = NULL, .ctr = ctr};
+   /* The container workspace is not used, as this may run in a worker thread */
    size_t arrsize = MAX(ctr_subsolver->n, ctr_subsolver->m);
-   A_CHECK(working_mem.ptr, ctr_getmem_old(ctr, 2*arrsize*sizeof(double)));
-
-   double * restrict vals = (double*)working_mem.ptr;
+   double *vals;
+   MALLOC_(vals, double, 2*MAX(arrsize, 1));
    double * restrict mults = &vals[arrsize];
 
    S_CHECK_EXIT(ctr_getallvarslevel(ctr_subsolver, vals));
@@ -497,7 +505,6 @@ presolve_submodel_solve(Model *mdl, Model *mdl_subsolver, double * restrict nlpo
       }
    }
 
-   S_CHECK_EXIT(ctr_getallequslevel(ctr_subsolver, vals));
    S_CHECK_EXIT(ctr_getallequslevel(ctr_subsolver, vals));
    S_CHECK_EXIT(ctr_getallequsdual(ctr_subsolver, mults));
 
@@ -519,16 +526,52 @@ presolve_submodel_solve(Model *mdl, Model *mdl_subsolver, double * restrict nlpo
    }
 
 _exit:
+   free(vals);
 
-   /* TODO(Xhub) this doesn't look good, but now we hardcheck this.
-    * Find a way to improve this. If we solve multiple time a subset
-    * of a model, we might want to not allocate all the time*/
-   FREE(ctr->rosetta_vars);
-   FREE(ctr->rosetta_equs);
+   return status;
+}
 
+NONNULL static int presolve_submodel_export(Model *mdl, Model *mdl_subsolver)
+{
+   /* TODO: add option for selection subsolver */
+
+   mdl_subsolver->ctr.n = mdl_subsolver->ctr.m = 0;
+   mdl_subsolver->status &= MdlPreSolve;
+   mdl_subsolver->ctr.status = 0;
+
+   return mdl_export(mdl, mdl_subsolver);
+}
+
+NONNULL static void presolve_submodel_unlink(Model *mdl, Model *mdl_subsolver)
+{
    /* mdl_export links mdl and mdl_solver */
    mdl_release(mdl);
    mdl_subsolver->mdl_up = NULL;
+}
+
+NONNULL static int
+presolve_submodel_solve(Model *mdl, Model *mdl_subsolver, double * restrict nlpool_data,
+                        unsigned pool_varvals_start)
+{
+   int status = OK;
+   Container *ctr = &mdl->ctr;
+
+   S_CHECK(presolve_submodel_export(mdl, mdl_subsolver));
+
+   S_CHECK_EXIT(mdl_solve(mdl_subsolver));
+
+   /* We read the rosettas here, since they may not exist before the export */
+   S_CHECK_EXIT(presolve_submodel_report(ctr, &mdl_subsolver->ctr, ctr->rosetta_vars,
+                                         ctr->rosetta_equs, nlpool_data,
+                                         pool_varvals_start));
+
+_exit:
+
+   /* The rosettas must be removed before the next export */
+   FREE(ctr->rosetta_vars);
+   FREE(ctr->rosetta_equs);
+
+   presolve_submodel_unlink(mdl, mdl_subsolver);
 
    return status;
 }
@@ -596,11 +639,309 @@ _exit:
    return status;
 }
 
+/**
+ * @brief Activate the filter of an MP and create its presolve submodel
+ *
+ * @param mdl                 the model
+ * @param mp                  the MP
+ * @param backend             the backend of the submodel
+ * @param pool_varvals_start  the start of the variable values in the pool
+ * @param[in,out] fs          on input, the filter of the previous MP. On output,
+ *                            the (active) filter for this MP
+ * @param[out] mdl_subsolver  the submodel
+ *
+ * @return                    the error code
+ */
+NONNULL static int
+presolve_mp_setup(Model *mdl, MathPrgm *mp, BackendType backend,
+                  unsigned pool_varvals_start, FilterSubset **fs,
+                  Model **mdl_subsolver)
+{
+   int status = OK;
+   char *mdlname = NULL;
+   const char *mp_name = mp_getname(mp);
+   trace_process("[presolve] Init new variables and equations in MP(%s)\n", mp_name);
+
+   /* The filter of the last MP is kept, as it is still referenced by the fops */
+   filter_subset_release(*fs);
+
+   *fs = filter_subset_new_from_mp(mp);
+   if (!*fs) {
+      error("[presolve] ERROR: could not create filter subset for MP(%s)\n", mp_name);
+      return Error_RuntimeError;
+   }
+
+   S_CHECK(filter_subset_activate(*fs, mdl, pool_varvals_start));
+
+   A_CHECK(*mdl_subsolver, mdl_new(backend));
+
+   IO_PRINT_EXIT(asprintf(&mdlname, "MP_%s_presolve", mdl_getname(mdl)));
+   gams_fix_symbol_name(mdlname);
+   S_CHECK_EXIT(mdl_setname(*mdl_subsolver, mdlname));
+
+_exit:
+   free(mdlname);
+
+   return status;
+}
+
+/* --------------------------------------------------------------------------
+ * Concurrent presolve of the MPs
+ *
+ * The exports are done sequentially, as they modify the original model, and
+ * each submodel keeps the rosettas of its export. The solves and reports are
+ * then performed concurrently: the MPs have disjoint variables and equations,
+ * hence every report writes a distinct slice of the pool and of the level and
+ * multiplier arrays. Contrary to the sequential presolve, an MP does not see
+ * the values computed for the previous ones.
+ *
+ * Only GAMS submodels are supported, since a ReSHOP submodel reads its data
+ * from the original model when solved. Each GAMS submodel has its own GMO and
+ * GEV handles. The solves are only concurrent when the subsolver is loaded in
+ * the process (solvelink=5): the other solvelinks go through the scratch
+ * directory, which is shared by all submodels. This assumes that the subsolver
+ * itself is reentrant.
+ *
+ * The worker threads inherit the thread-local state of the calling thread:
+ * options, printing operators, GAMS directory, control file and handles, and
+ * the filename of the PATH library. They release it before exiting.
+ *
+ * mdl_export links the timings of the submodel to the ones of the original
+ * model. Each submodel gets its own timings instead, and these are merged
+ * after the join.
+ * -------------------------------------------------------------------------- */
+
+/* Value of the GAMS constant gevSolveLinkLoadLibrary */
+#define PRESOLVE_SOLVELINK_LOADLIBRARY 5
+
+#ifdef PRESOLVE_HAS_THREADS
+
+typedef struct {
+   Model *mdl_subsolver;         /**< The submodel of the MP          */
+   rhp_idx *rosetta_vars;        /**< Variable rosetta of its export  */
+   rhp_idx *rosetta_equs;        /**< Equation rosetta of its export  */
+   int status;                   /**< Status of the solve and report  */
+} PresolveMpTask;
+
+typedef struct {
+   Container *ctr;                        /**< Container of the original model  */
+   PresolveMpTask *tasks;                 /**< Tasks                            */
+   unsigned ntasks;                       /**< Number of tasks                  */
+   unsigned nthreads;                     /**< Number of threads                */
+   unsigned tid;                          /**< Index of the thread              */
+   bool inherit_env;                      /**< If true, copy the thread-local state */
+   unsigned pool_varvals_start;           /**< Start of the values in the pool  */
+   double *nlpool_data;                   /**< Pool data                        */
+   const struct option *options;          /**< Options of the calling thread    */
+   const struct printout_ops *printops;   /**< Printing ops of the calling thread */
+   GamsTls gams_tls;                      /**< GAMS state of the calling thread */
+   const char *pathlib_fname;             /**< PATH library of the calling thread */
+} PresolveMpWorker;
+
+static int presolve_mp_worker(void *arg)
+{
+   PresolveMpWorker *w = arg;
+   int status = OK;
+
+   /* Options, printing operators, the GAMS state and the PATH library are
+    * thread-local. A GAMS subsolver loaded in the process may use all of them */
+   if (w->inherit_env) {
+      memcpy(rhp_options, w->options, (Options_Last+1)*sizeof(struct option));
+      printout_setops(w->printops);
+
+      status = gams_tls_inherit(&w->gams_tls);
+      if (status == OK && w->pathlib_fname) {
+         status = rhp_PATH_setfname(w->pathlib_fname);
+      }
+   }
+
+   for (unsigned i = w->tid, len = w->ntasks; i < len; i += w->nthreads) {
+      PresolveMpTask *task = &w->tasks[i];
+
+      if (status != OK) { task->status = status; continue; }
+
+      task->status = mdl_solve(task->mdl_subsolver);
+      if (task->status != OK) { continue; }
+
+      task->status = presolve_submodel_report(w->ctr, &task->mdl_subsolver->ctr,
+                                              task->rosetta_vars, task->rosetta_equs,
+                                              w->nlpool_data, w->pool_varvals_start);
+   }
+
+   if (w->inherit_env) {
+      gams_tls_release();
+      path_tls_release();
+   }
+
+   return OK;
+}
+
+NONNULL static int presolve_mp_runworkers(PresolveMpWorker *workers, unsigned nthreads)
+{
+   unsigned nstarted = 1;
+   thrd_t *threads;
+   MALLOC_(threads, thrd_t, nthreads);
+
+   for (; nstarted < nthreads; ++nstarted) {
+      workers[nstarted].inherit_env = true;
+      if (thrd_create(&threads[nstarted], presolve_mp_worker, &workers[nstarted]) != thrd_success) {
+         printout(PO_INFO, "[presolve] Could not create thread #%u, its tasks are "
+                  "performed by the calling thread\n", nstarted);
+         break;
+      }
+   }
+
+   /* The calling thread takes the first share of the tasks */
+   presolve_mp_worker(&workers[0]);
+
+   for (unsigned i = nstarted; i < nthreads; ++i) {
+      workers[i].inherit_env = false;
+      presolve_mp_worker(&workers[i]);
+   }
+
+   for (unsigned i = 1; i < nstarted; ++i) {
+      thrd_join(threads[i], NULL);
+   }
+
+   free(threads);
+
+   return OK;
+}
+
+static int presolve_mp_concurrent(Model *mdl, BackendType backend,
+                                  unsigned pool_varvals_start, unsigned nthreads)
+{
+   int status = OK;
+   Container *ctr = &mdl->ctr;
+   EmpDag *empdag = &mdl->empinfo.empdag;
+   MathPrgm ** restrict mpsarr = empdag->mps.arr;
+   mpid_t * restrict mpidarr = empdag->mps_newly_created.arr;
+   unsigned ntasks = empdag->mps_newly_created.len, nlinked = 0;
+
+   FilterSubset *fs = NULL;
+   PresolveMpTask *tasks = NULL;
+   PresolveMpWorker *workers = NULL;
+   CALLOC_(tasks, PresolveMpTask, ntasks);
+
+   trace_process("[presolve] Presolving %u MPs with %u threads\n", ntasks, nthreads);
+
+   for (unsigned i = 0; i < ntasks; ++i, ++nlinked) {
+
+      mpid_t mpid = mpidarr[i];    assert(mpid < empdag->mps.len);
+      MathPrgm *mp = mpsarr[mpid]; assert(mp);
+      PresolveMpTask *task = &tasks[i];
+
+      S_CHECK_EXIT(presolve_mp_setup(mdl, mp, backend, pool_varvals_start, &fs,
+                                     &task->mdl_subsolver));
+
+      trace_process("[presolve] Exporting MP(%s)\n", mp_getname(mp));
+      S_CHECK_EXIT(presolve_submodel_export(mdl, task->mdl_subsolver));
+
+      /* The timings are updated during the solve: they must not be shared */
+      mdl_timings_rel(task->mdl_subsolver->timings);
+      task->mdl_subsolver->timings = NULL;
+      S_CHECK_EXIT(mdl_timings_alloc(task->mdl_subsolver));
+
+      /* The submodel takes ownership of the rosettas of its export */
+      task->rosetta_vars = ctr->rosetta_vars;
+      task->rosetta_equs = ctr->rosetta_equs;
+      ctr->rosetta_vars = NULL;
+      ctr->rosetta_equs = NULL;
+   }
+
+   MALLOC_EXIT(workers, PresolveMpWorker, nthreads);
+
+   /* The pool may have been reallocated during the exports */
+   double *nlpool_data = ctr->nlpool->data;
+   const struct printout_ops *printops = printout_getops();
+   const char *pathlib_fname = path_getfname();
+   GamsTls gams_tls;
+   gams_tls_get(&gams_tls);
+
+   /* The submodels may read the adjacency of this EMPDAG: rebuild it now
+    * rather than concurrently in the workers */
+   const EmpDagCsr *csr;
+   S_CHECK_EXIT(empdag_csr_get(empdag, &csr));
+
+   for (unsigned i = 0; i < nthreads; ++i) {
+      workers[i] = (PresolveMpWorker) {
+         .ctr = ctr, .tasks = tasks, .ntasks = ntasks, .nthreads = nthreads,
+         .tid = i, .inherit_env = false, .pool_varvals_start = pool_varvals_start,
+         .nlpool_data = nlpool_data, .options = rhp_options, .printops = printops,
+         .gams_tls = gams_tls, .pathlib_fname = pathlib_fname,
+      };
+   }
+
+   S_CHECK_EXIT(presolve_mp_runworkers(workers, nthreads));
+
+   for (unsigned i = 0; i < ntasks; ++i) {
+      mdl_timings_merge(mdl->timings, tasks[i].mdl_subsolver->timings);
+   }
+
+   for (unsigned i = 0; i < ntasks; ++i) {
+      if (tasks[i].status != OK) {
+         error("[presolve] ERROR: presolve of MP(%s) failed with status %s\n",
+               mp_getname(mpsarr[mpidarr[i]]), rhp_status_descr(tasks[i].status));
+         status = tasks[i].status;
+         break;
+      }
+   }
+
+_exit:
+   if (tasks) {
+      for (unsigned i = 0; i < ntasks; ++i) {
+         PresolveMpTask *task = &tasks[i];
+         if (!task->mdl_subsolver) { continue; }
+         /* the export of the last task may have failed before linking the models */
+         if (i < nlinked) { presolve_submodel_unlink(mdl, task->mdl_subsolver); }
+         mdl_release(task->mdl_subsolver);
+         free(task->rosetta_vars);
+         free(task->rosetta_equs);
+      }
+   }
+
+   free(tasks);
+   free(workers);
+
+   return status;
+}
+
+#endif /* PRESOLVE_HAS_THREADS */
+
+NONNULL static unsigned presolve_mp_nthreads(Model *mdl, BackendType backend)
+{
+   int nthreads = optvali(mdl, Options_Presolve_Threads);
+   unsigned nmps = mdl->empinfo.empdag.mps_newly_created.len;
+
+   if (nthreads <= 1 || nmps <= 1) { return 1; }
+
+#ifndef PRESOLVE_HAS_THREADS
+   printout(PO_INFO, "[presolve] Option 'presolve_threads' is ignored: no thread "
+            "support in this build\n");
+   return 1;
+#else
+   if (backend != RhpBackendGamsGmo) {
+      printout(PO_INFO, "[presolve] Option 'presolve_threads' is ignored with %s "
+               "submodels\n", backend2str(backend));
+      return 1;
+   }
+
+   int solvelink = optvali(mdl, Options_SolveLink);
+   if (solvelink != PRESOLVE_SOLVELINK_LOADLIBRARY) {
+      printout(PO_INFO, "[presolve] Option 'presolve_threads' is ignored with "
+               "solvelink=%d, it requires solvelink=%d\n", solvelink,
+               PRESOLVE_SOLVELINK_LOADLIBRARY);
+      return 1;
+   }
+
+   return MIN((unsigned)nthreads, nmps);
+#endif
+}
+
 static int rmdl_presolve_mp(Model *mdl, BackendType backend, unsigned pool_varvals_start)
 {
    int status = OK;
    Container *ctr = &mdl->ctr;
-   char *mdlname = NULL;
 
    /* Ensure that the pool size is large enough to hold the values of all variables. */
    if (pool_varvals_start == UINT_MAX) {
@@ -610,10 +951,18 @@ static int rmdl_presolve_mp(Model *mdl, BackendType backend, unsigned pool_varva
       S_CHECK(nlpool_inject_varvals(ctr));
    }
 
+#ifdef PRESOLVE_HAS_THREADS
+   unsigned nthreads = presolve_mp_nthreads(mdl, backend);
+   if (nthreads > 1) {
+      return presolve_mp_concurrent(mdl, backend, pool_varvals_start, nthreads);
+   }
+#else
+   presolve_mp_nthreads(mdl, backend);
+#endif
+
    double * restrict nlpool_data = ctr->nlpool->data;
 
    Model *mdl_subsolver = NULL;
-   const char *mdl_name = mdl_getname(mdl);
 
    EmpDag *empdag = &mdl->empinfo.empdag;
    MathPrgm ** restrict mpsarr = empdag->mps.arr;
@@ -625,31 +974,10 @@ static int rmdl_presolve_mp(Model *mdl, BackendType backend, unsigned pool_varva
       mpid_t mpid = mpidarr[i];    assert(mpid < empdag->mps.len);
       MathPrgm *mp = mpsarr[mpid]; assert(mp);
 
-      const char *mp_name = mp_getname(mp);
-      trace_process("[presolve] Init new variables and equations in MP(%s)\n", mp_name);
-
-      /* We need to avoid a double free for the last submodule */
-      if (fs) {
-         filter_subset_release(fs);
-      }
-
-      fs = filter_subset_new_from_mp(mp);
-      if (!fs) {
-         error("[presolve] ERROR: could not create filter subset for MP(%s)\n", mp_name);
-         status = Error_RuntimeError;
-         goto _exit;
-      }
-
-      S_CHECK_EXIT(filter_subset_activate(fs, mdl, pool_varvals_start));
-
-      mdl_subsolver = mdl_new(backend);
+      S_CHECK_EXIT(presolve_mp_setup(mdl, mp, backend, pool_varvals_start, &fs,
+                                     &mdl_subsolver));
 
-      IO_PRINT_EXIT(asprintf(&mdlname, "MP_%s_presolve", mdl_name));
-      gams_fix_symbol_name(mdlname);
-      S_CHECK_EXIT(mdl_setname(mdl_subsolver, mdlname));
-      FREE(mdlname);
-
-      trace_process("[presolve] Presolving MP(%s)\n", mp_name);
+      trace_process("[presolve] Presolving MP(%s)\n", mp_getname(mp));
       S_CHECK_EXIT(presolve_submodel_solve(mdl, mdl_subsolver, nlpool_data, pool_varvals_start));
 
       mdl_release(mdl_subsolver);
@@ -658,7 +986,6 @@ static int rmdl_presolve_mp(Model *mdl, BackendType backend, unsigned pool_varva
 
 _exit:
    mdl_release(mdl_subsolver);
-   free(mdlname);
 
    return status;
 }
@@ -745,6 +1072,9 @@ _exit:
     * restore the model
     * ---------------------------------------------------------------------- */
 
+   /* The adjacency may have been rebuilt in place: keep the current arrays */
+   empdag_orig.csr = mdl->empinfo.empdag.csr;
+   empdag_orig.csr.valid = false;
    memcpy(&mdl->empinfo.empdag, &empdag_orig, sizeof(EmpDag));
    S_CHECK(mdl_settype(mdl, mdltype));
    mdl->status = mdl_status;
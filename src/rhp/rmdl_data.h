@@ -28,6 +28,7 @@ typedef struct rmdl_data {
    RmdlStatus status;
    RhpSolver solver;               /**< Solver for this model                */
    struct rmdl_option *options;    /**< Options                              */
+   struct rmdl_reduce *reduce;     /**< Presolve reductions, for postsolve   */
 } RhpModelData;
 
 #endif
@@ -12,10 +12,13 @@
 #include "empdag_mpe.h"
 #include "mathprgm.h"
 #include "mdl.h"
+#include "mdl_timings.h"
 #include "nltree.h"
 #include "rhp_model.h"
+#include "printout.h"
 #include "rmdl_priv.h"
 #include "status.h"
+#include "timings.h"
 
 /** @file rmdl_empdag.c
 *
@@ -663,12 +666,15 @@ int rmdl_contract_subtrees(Model *mdl, VFContractions *contractions)
 
    for (unsigned i = 0; i < num_mp_big; ++i) {
 
+      double start = get_thrdtime();
+      unsigned span = mdl_prof_begin(mdl, "subtree contraction");
       mpid_t mpid_subtree_root = vfdag_root_arr[i];
 
       trace_empdag("[empdag/contract] Contracting subtree starting at MP(%s)\n",
                    empdag_getmpname(empdag, mpid_subtree_root));
 
       /* Reset the working arrays */
+      unsigned num_newcons = 0;
       VFdag_mpids->len = 0;
       mpidarray_add(VFdag_mpids, mpid_subtree_root);
 
@@ -784,9 +790,12 @@ int rmdl_contract_subtrees(Model *mdl, VFContractions *contractions)
             if (arc_cons == UINT_MAX) {
                error("[empdag/contract] ERROR while processing arcVF %u of MP(%s). "
                      "Please open a bug report\n", k, empdag_getmpname(empdag, mpid_));
-               return Error_RuntimeError;
+               status = Error_RuntimeError;
+               goto _exit;
             }
 
+            num_newcons += arc_cons;
+
             mpid_t mpid_child = arc->mpid_child;
             MathPrgm *mp_child = mps->arr[mpid_child];
 
@@ -820,7 +829,7 @@ int rmdl_contract_subtrees(Model *mdl, VFContractions *contractions)
                S_CHECK_EXIT(cpydat_initfrom_arcVF(cpydat_child, mdl));
             }
 
-            S_CHECK(mp_claimequvar_from_mp(mp_big, mp_child));
+            S_CHECK_EXIT(mp_claimequvar_from_mp(mp_big, mp_child));
 
 
          }
@@ -838,7 +847,8 @@ int rmdl_contract_subtrees(Model *mdl, VFContractions *contractions)
 
          if (mpid_ >= mpid_max) {
             error("[empdag] ERROR: MPID %u larger than maximum %u\n", mpid_, mpid_max);
-            return Error_RuntimeError;
+            status = Error_RuntimeError;
+            goto _exit;
          }
 
          S_CHECK_EXIT(dagmp_array_remove_at(mps, mpid_));
@@ -871,6 +881,16 @@ int rmdl_contract_subtrees(Model *mdl, VFContractions *contractions)
 
          emeta[ei].mp_id = mpid_big;
       }
+
+      double subtree_time = get_thrdtime() - start;
+      mdl_prof_additems(mdl, span, VFdag_mpids->len);
+      mdl_prof_end(mdl, span);
+      simple_timing_add(&mdl->timings->reformulation.empdag.subtree_contraction,
+                        subtree_time);
+
+      trace_process("[empdag/contract] subtree MP(%s): %u MPs, %u new constraints; "
+                    "contracted in %.3e s\n", mp_getname(mp_big), VFdag_mpids->len,
+                    num_newcons, subtree_time);
    }
 
    S_CHECK_EXIT(dagmp_array_trimmem(mps));
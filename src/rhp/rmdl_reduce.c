@@ -0,0 +1,1034 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "cmat.h"
+#include "container.h"
+#include "ctr_rhp.h"
+#include "ctrdat_rhp.h"
+#include "empdag.h"
+#include "equ.h"
+#include "macros.h"
+#include "mdl.h"
+#include "mdl_rhp.h"
+#include "printout.h"
+#include "rmdl_data.h"
+#include "rmdl_reduce.h"
+#include "status.h"
+#include "var.h"
+
+/** @file rmdl_reduce.c
+ *
+ *  @brief Presolve reductions of a ReSHOP model
+ *
+ *  The following reductions are performed on the linear constraints of an
+ *  optimization model:
+ *  - empty, redundant and duplicate rows are removed
+ *  - singleton rows are turned into variable bounds
+ *  - forcing rows fix all their variables at the bounds
+ *  - free column singletons are removed along with their row
+ *  - free variables in a doubleton equality are aggregated out
+ *
+ *  Each reduction is recorded, and the postsolve replays them in reverse order
+ *  to recover the primal and dual values in the original indices. The
+ *  multipliers follow the convention d = ∇f - Aᵀλ, with λ ≥ 0 for a binding
+ *  R+ row in a minimization problem.
+ */
+
+/** Tolerance on the activity and bounds comparisons */
+#define REDUCE_TOL            1e-9
+/** Minimal absolute value of a pivot in an aggregation */
+#define REDUCE_PIVOT_TOL      1e-6
+/** Maximum number of sweeps over the rows and columns */
+#define REDUCE_MAXPASSES      8
+/** Maximum number of rows rewritten by a doubleton aggregation */
+#define REDUCE_MAXFILL        8
+/** Maximum number of comparisons per row in the duplicate detection */
+#define REDUCE_MAXDUPCMP      32
+
+typedef enum {
+   ReduceRowRedundant,   /**< empty, redundant or duplicate row                 */
+   ReduceRowSingleton,   /**< singleton row turned into variable bound(s)       */
+   ReduceRowForcing,     /**< forcing row: all its variables are fixed          */
+   ReduceColSingleton,   /**< free column singleton and its row removed         */
+   ReduceColEmpty,       /**< variable without any row after a reduction        */
+   ReduceDoubleton,      /**< free variable aggregated out of an equality       */
+   ReduceRowMoved,       /**< row copied to a new index by an aggregation       */
+} ReduceOpType;
+
+enum {
+   ReduceSideLb = 1,
+   ReduceSideUb = 2,
+};
+
+/** Reduction record */
+typedef struct {
+   ReduceOpType type;
+   Cone cone;             /**< cone of the row                                   */
+   bool at_max;           /**< forcing row: variables at the maximum activity    */
+   unsigned sides;        /**< singleton row: bound(s) given by the row          */
+   rhp_idx ei;            /**< removed (or moved) row                            */
+   rhp_idx ei_new;        /**< moved row: the new index                          */
+   rhp_idx vi;            /**< variable in the singleton or eliminated variable  */
+   double coeff;          /**< coefficient of vi in the row                      */
+   double cst;            /**< constant of the row, or shift of a moved row      */
+   double val;            /**< implied bound or value of an empty column         */
+   unsigned start;        /**< start of the row terms in the pool                */
+   unsigned len;          /**< number of row terms                               */
+   unsigned start2;       /**< doubleton: start of the (row, coeff) pairs of vi  */
+   unsigned len2;         /**< doubleton: number of (row, coeff) pairs           */
+} ReduceOp;
+
+/** Presolve reductions of a model */
+typedef struct rmdl_reduce {
+   RhpSense sense;        /**< objective sense                                   */
+   unsigned len;          /**< number of reductions                              */
+   unsigned max;          /**< capacity of ops                                   */
+   ReduceOp *ops;         /**< reductions, in the order they were applied        */
+   unsigned pool_len;     /**< number of terms in the pool                       */
+   unsigned pool_max;     /**< capacity of the pool                              */
+   rhp_idx *pool_idx;     /**< variable (or row) indices of the terms            */
+   double *pool_vals;     /**< coefficients of the terms                         */
+} RmdlReduce;
+
+typedef struct {
+   unsigned empty;
+   unsigned redundant;
+   unsigned duplicate;
+   unsigned singleton;
+   unsigned forcing;
+   unsigned colsingleton;
+   unsigned doubleton;
+} ReduceStats;
+
+typedef struct {
+   uint64_t hash;
+   unsigned nnz;
+   rhp_idx ei;
+} ReduceRowKey;
+
+void rmdl_reduce_free(RmdlReduce *red)
+{
+   if (!red) { return; }
+
+   FREE(red->ops);
+   FREE(red->pool_idx);
+   FREE(red->pool_vals);
+   FREE(red);
+}
+
+static inline bool reduce_iszero(double val, double ref)
+{
+   return fabs(val) <= REDUCE_TOL*(1. + fabs(ref));
+}
+
+static inline bool reduce_equ_supported(const Equ *e)
+{
+   if (e->object != ConeInclusion || e->is_quad) { return false; }
+
+   switch (e->cone) {
+   case CONE_R_PLUS:
+   case CONE_R_MINUS:
+   case CONE_0:
+      return true;
+   default:
+      return false;
+   }
+}
+
+static inline bool reduce_var_supported(const Var *v)
+{
+   return v->type == VAR_X && !v->is_conic;
+}
+
+static inline bool reduce_var_isfree(const Var *v)
+{
+   return reduce_var_supported(v) && v->bnd.lb == -INFINITY && v->bnd.ub == INFINITY;
+}
+
+/* Return true if a row with activity plus constant equal to val is feasible */
+static inline bool reduce_cone_contains(Cone cone, double val, double ref)
+{
+   switch (cone) {
+   case CONE_R_PLUS:  return val >= -REDUCE_TOL*(1. + fabs(ref));
+   case CONE_R_MINUS: return val <= REDUCE_TOL*(1. + fabs(ref));
+   case CONE_0:       return reduce_iszero(val, ref);
+   default:           return false;
+   }
+}
+
+/** @brief Check that all the variables of a row appear linearly */
+static bool reduce_row_islinear(const CMatElt *cme, unsigned *nnz)
+{
+   unsigned cnt = 0;
+   for (; cme; cme = cme->next_var, cnt++) {
+      if (cme->type != CMatEltLin) { return false; }
+   }
+
+   *nnz = cnt;
+   return true;
+}
+
+static int reduce_newop(RmdlReduce *red, ReduceOpType type, rhp_idx ei, ReduceOp **op)
+{
+   if (red->len >= red->max) {
+      red->max = MAX(2*red->max, 32);
+      REALLOC_(red->ops, ReduceOp, red->max);
+   }
+
+   ReduceOp *o = &red->ops[red->len++];
+   o->type = type;
+   o->cone = CONE_NONE;
+   o->at_max = false;
+   o->sides = 0;
+   o->ei = ei;
+   o->ei_new = IdxNA;
+   o->vi = IdxNA;
+   o->coeff = NAN;
+   o->cst = 0.;
+   o->val = NAN;
+   o->start = red->pool_len;
+   o->len = 0;
+   o->start2 = red->pool_len;
+   o->len2 = 0;
+
+   *op = o;
+
+   return OK;
+}
+
+static int reduce_pool_add(RmdlReduce *red, rhp_idx idx, double val)
+{
+   if (red->pool_len >= red->pool_max) {
+      red->pool_max = MAX(2*red->pool_max, 128);
+      REALLOC_(red->pool_idx, rhp_idx, red->pool_max);
+      REALLOC_(red->pool_vals, double, red->pool_max);
+   }
+
+   red->pool_idx[red->pool_len] = idx;
+   red->pool_vals[red->pool_len] = val;
+   red->pool_len++;
+
+   return OK;
+}
+
+/** @brief Record a removed row: its cone, constant and linear terms */
+static int reduce_newrowop(RmdlReduce *red, Container *ctr, ReduceOpType type,
+                           rhp_idx ei, ReduceOp **op)
+{
+   RhpContainerData *cdat = (RhpContainerData *)ctr->data;
+   Equ *e = &ctr->equs[ei];
+
+   ReduceOp *o;
+   S_CHECK(reduce_newop(red, type, ei, &o));
+   o->cone = e->cone;
+   o->cst = equ_get_cst(e);
+
+   unsigned start = red->pool_len;
+   for (CMatElt *cme = cdat->cmat.equs[ei]; cme; cme = cme->next_var) {
+      if (cme->type == CMatEltCstEqu) { break; }
+      S_CHECK(reduce_pool_add(red, cme->vi, cme->value));
+   }
+
+   /* The pool may have been reallocated, but not the ops */
+   o->start = start;
+   o->len = red->pool_len - start;
+   o->start2 = red->pool_len;
+
+   *op = o;
+
+   return OK;
+}
+
+/**
+ * @brief Remove a row and record the variables that no longer appear in the model
+ *
+ * @param mdl      the model
+ * @param red      the reductions
+ * @param ei       the row to remove
+ * @param vi_skip  variable whose value is recovered by the caller
+ *
+ * @return         the error code
+ */
+static int reduce_rm_equ(Model *mdl, RmdlReduce *red, rhp_idx ei, rhp_idx vi_skip)
+{
+   Container *ctr = &mdl->ctr;
+   RhpContainerData *cdat = (RhpContainerData *)ctr->data;
+
+   unsigned start = red->ops[red->len-1].start, len = red->ops[red->len-1].len;
+   assert(red->ops[red->len-1].ei == ei);
+
+   S_CHECK(rmdl_rm_equ(mdl, ei));
+
+   for (unsigned i = 0; i < len; ++i) {
+      rhp_idx vi = red->pool_idx[start+i];
+      if (vi == vi_skip || cdat->cmat.vars[vi]) { continue; }
+
+      /* The variable only has bounds left: keep its level in the bounds */
+      Var *v = &ctr->vars[vi];
+      double val = isfinite(v->value) ? v->value : 0.;
+      if (reduce_var_supported(v)) {
+         val = MAX(v->bnd.lb, MIN(val, v->bnd.ub));
+      }
+
+      ReduceOp *op;
+      S_CHECK(reduce_newop(red, ReduceColEmpty, IdxNA, &op));
+      op->vi = vi;
+      op->val = val;
+   }
+
+   return OK;
+}
+
+/**
+ * @brief Try to reduce a row
+ *
+ * @param mdl     the model
+ * @param red     the reductions
+ * @param ei      the row
+ * @param objequ  the objective equation
+ * @param stats   the statistics
+ *
+ * @return        the error code
+ */
+static int reduce_row(Model *mdl, RmdlReduce *red, rhp_idx ei, rhp_idx objequ,
+                      ReduceStats *stats)
+{
+   Container *ctr = &mdl->ctr;
+   RhpContainerData *cdat = (RhpContainerData *)ctr->data;
+   CMatElt *cme = cdat->cmat.equs[ei];
+
+   if (!cme || ei == objequ) { return OK; }
+
+   Equ *e = &ctr->equs[ei];
+   if (!reduce_equ_supported(e)) { return OK; }
+
+   double cst = equ_get_cst(e);
+   ReduceOp *op;
+
+   /* ----------------------------------------------------------------------
+    * Empty row: check the feasibility and remove it
+    * ---------------------------------------------------------------------- */
+
+   if (cme->type == CMatEltCstEqu) {
+      if (!reduce_cone_contains(e->cone, cst, cst)) {
+         trace_process("[presolve] empty row '%s' is infeasible\n",
+                       ctr_printequname(ctr, ei));
+         return OK;
+      }
+
+      S_CHECK(reduce_newrowop(red, ctr, ReduceRowRedundant, ei, &op));
+      S_CHECK(reduce_rm_equ(mdl, red, ei, IdxNA));
+      stats->empty++;
+      return OK;
+   }
+
+   unsigned nnz;
+   if (!reduce_row_islinear(cme, &nnz)) { return OK; }
+
+   /* ----------------------------------------------------------------------
+    * Compute the activity bounds of the row
+    * ---------------------------------------------------------------------- */
+
+   double lmin = 0., lmax = 0.;
+   unsigned ninf_min = 0, ninf_max = 0;
+
+   for (CMatElt *c = cme; c; c = c->next_var) {
+      const Var *v = &ctr->vars[c->vi];
+      if (!reduce_var_supported(v)) { return OK; }
+
+      double a = c->value, lb = v->bnd.lb, ub = v->bnd.ub;
+      if (a == 0.) { continue; }
+
+      double lo = a > 0 ? lb : ub, up = a > 0 ? ub : lb;
+      if (isfinite(lo)) { lmin += a*lo; } else { ninf_min++; }
+      if (isfinite(up)) { lmax += a*up; } else { ninf_max++; }
+   }
+
+   /* ----------------------------------------------------------------------
+    * Singleton row: a x + cst ∈ K becomes a bound on x
+    * ---------------------------------------------------------------------- */
+
+   if (nnz == 1 && cme->value != 0.) {
+      rhp_idx vi = cme->vi;
+      Var *v = &ctr->vars[vi];
+      double a = cme->value, bnd = -cst/a;
+      bool set_lb, set_ub;
+
+      switch (e->cone) {
+      case CONE_R_PLUS:  set_lb = a > 0; set_ub = !set_lb; break;
+      case CONE_R_MINUS: set_ub = a > 0; set_lb = !set_ub; break;
+      default:           set_lb = set_ub = true;
+      }
+
+      double tol = REDUCE_TOL*(1. + fabs(bnd));
+      if ((set_lb && bnd > v->bnd.ub + tol) || (set_ub && bnd < v->bnd.lb - tol)) {
+         trace_process("[presolve] singleton row '%s' is incompatible with the "
+                       "bounds of '%s'\n", ctr_printequname(ctr, ei),
+                       ctr_printvarname(ctr, vi));
+         return OK;
+      }
+
+      S_CHECK(reduce_newrowop(red, ctr, ReduceRowSingleton, ei, &op));
+      op->vi = vi;
+      op->coeff = a;
+      op->val = bnd;
+
+      if (set_lb && bnd >= v->bnd.lb - tol) {
+         v->bnd.lb = MIN(MAX(v->bnd.lb, bnd), v->bnd.ub);
+         op->sides |= ReduceSideLb;
+      }
+      if (set_ub && bnd <= v->bnd.ub + tol) {
+         v->bnd.ub = MAX(MIN(v->bnd.ub, bnd), v->bnd.lb);
+         op->sides |= ReduceSideUb;
+      }
+
+      S_CHECK(reduce_rm_equ(mdl, red, ei, IdxNA));
+      stats->singleton++;
+      return OK;
+   }
+
+   /* ----------------------------------------------------------------------
+    * Redundant row: the activity bounds imply the row
+    * ---------------------------------------------------------------------- */
+
+   double ref = MAX(fabs(cst), MAX(fabs(lmin), fabs(lmax)));
+   bool lmin_ok = ninf_min == 0 && reduce_cone_contains(CONE_R_PLUS, lmin + cst, ref);
+   bool lmax_ok = ninf_max == 0 && reduce_cone_contains(CONE_R_MINUS, lmax + cst, ref);
+   bool redundant;
+
+   switch (e->cone) {
+   case CONE_R_PLUS:  redundant = lmin_ok; break;
+   case CONE_R_MINUS: redundant = lmax_ok; break;
+   default:           redundant = lmin_ok && lmax_ok;
+   }
+
+   if (redundant) {
+      S_CHECK(reduce_newrowop(red, ctr, ReduceRowRedundant, ei, &op));
+      S_CHECK(reduce_rm_equ(mdl, red, ei, IdxNA));
+      stats->redundant++;
+      return OK;
+   }
+
+   /* ----------------------------------------------------------------------
+    * Forcing row: the row can only be satisfied at one of its activity bounds
+    * ---------------------------------------------------------------------- */
+
+   bool at_max = ninf_max == 0 && e->cone != CONE_R_MINUS
+              && reduce_iszero(lmax + cst, ref);
+   bool at_min = ninf_min == 0 && e->cone != CONE_R_PLUS
+              && reduce_iszero(lmin + cst, ref);
+
+   if (!at_max && !at_min) { return OK; }
+
+   S_CHECK(reduce_newrowop(red, ctr, ReduceRowForcing, ei, &op));
+   op->at_max = at_max;
+
+   for (CMatElt *c = cme; c; c = c->next_var) {
+      Var *v = &ctr->vars[c->vi];
+      double a = c->value;
+      if (a == 0.) { continue; }
+
+      double val = (a > 0) == at_max ? v->bnd.ub : v->bnd.lb;
+      v->bnd.lb = v->bnd.ub = val;
+   }
+
+   S_CHECK(reduce_rm_equ(mdl, red, ei, IdxNA));
+   stats->forcing++;
+
+   return OK;
+}
+
+static inline uint64_t reduce_hash_idx(rhp_idx idx)
+{
+   uint64_t h = (uint64_t)idx + 0x9e3779b97f4a7c15ULL;
+   h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+   h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+   return h ^ (h >> 31);
+}
+
+static int reduce_rowkey_cmp(const void *a, const void *b)
+{
+   const ReduceRowKey *ka = a, *kb = b;
+   if (ka->nnz != kb->nnz) { return ka->nnz < kb->nnz ? -1 : 1; }
+   if (ka->hash != kb->hash) { return ka->hash < kb->hash ? -1 : 1; }
+   return ka->ei < kb->ei ? -1 : (ka->ei > kb->ei);
+}
+
+/**
+ * @brief Compare a row with the one loaded in the work array
+ *
+ * @param cdat   the container data
+ * @param ei     the row to compare
+ * @param work   the coefficients of the loaded row
+ * @param[out] t the ratio between the rows
+ *
+ * @return       true if the row is a multiple of the loaded one
+ */
+static bool reduce_row_isparallel(RhpContainerData *cdat, rhp_idx ei,
+                                  const double *work, double *t)
+{
+   double ratio = NAN;
+
+   for (CMatElt *c = cdat->cmat.equs[ei]; c; c = c->next_var) {
+      double a_ref = work[c->vi];
+      if (a_ref == 0. || c->value == 0.) { return false; }
+
+      if (isnan(ratio)) {
+         ratio = c->value/a_ref;
+      } else if (!reduce_iszero(c->value - ratio*a_ref, c->value)) {
+         return false;
+      }
+   }
+
+   *t = ratio;
+   return isfinite(ratio) && ratio != 0.;
+}
+
+/**
+ * @brief Decide which of two parallel rows is implied by the other one
+ *
+ * The row s is t times the row r in its linear part.
+ *
+ * @return  the row to drop, or IdxNA
+ */
+static rhp_idx reduce_parallel_drop(Container *ctr, rhp_idx r, rhp_idx s, double t)
+{
+   const Equ *er = &ctr->equs[r], *es = &ctr->equs[s];
+
+   /* Both rows written as  a_r x ∈ b + K */
+   double br = -equ_get_cst(er), bs = -equ_get_cst(es)/t;
+   Cone kr = er->cone, ks = es->cone;
+   if (t < 0 && ks != CONE_0) {
+      ks = ks == CONE_R_PLUS ? CONE_R_MINUS : CONE_R_PLUS;
+   }
+
+   double diff = br - bs;
+   double tol = REDUCE_TOL*(1. + MAX(fabs(br), fabs(bs)));
+
+   if (kr == CONE_0 && ks == CONE_0) {
+      return fabs(diff) <= tol ? s : IdxNA;
+   }
+
+   if (kr == CONE_0) {
+      /* s holds at the value of r */
+      return reduce_cone_contains(ks, diff, br) ? s : IdxNA;
+   }
+
+   if (ks == CONE_0) {
+      return reduce_cone_contains(kr, -diff, bs) ? r : IdxNA;
+   }
+
+   if (kr != ks) { return IdxNA; }
+
+   /* Same direction: drop the looser row */
+   if (kr == CONE_R_PLUS) {
+      return diff >= 0 ? s : r;
+   }
+
+   return diff <= 0 ? s : r;
+}
+
+/**
+ * @brief Remove duplicate rows, that is rows whose linear parts are parallel
+ *
+ * @param mdl     the model
+ * @param red     the reductions
+ * @param objequ  the objective equation
+ * @param stats   the statistics
+ *
+ * @return        the error code
+ */
+static int reduce_duplicates(Model *mdl, RmdlReduce *red, rhp_idx objequ,
+                             ReduceStats *stats)
+{
+   int status = OK;
+   Container *ctr = &mdl->ctr;
+   RhpContainerData *cdat = (RhpContainerData *)ctr->data;
+   size_t total_m = cdat->total_m;
+   ReduceRowKey *keys = NULL;
+   double *work = NULL;
+   unsigned nkeys = 0;
+
+   MALLOC_EXIT(keys, ReduceRowKey, total_m);
+
+   for (rhp_idx ei = 0; ei < total_m; ++ei) {
+      CMatElt *cme = cdat->cmat.equs[ei];
+      if (!cme || ei == objequ || !reduce_equ_supported(&ctr->equs[ei])) { continue; }
+
+      unsigned nnz;
+      if (cme->type == CMatEltCstEqu || !reduce_row_islinear(cme, &nnz) || nnz < 2) {
+         continue;
+      }
+
+      uint64_t hash = 0;
+      for (; cme; cme = cme->next_var) { hash += reduce_hash_idx(cme->vi); }
+
+      keys[nkeys].hash = hash;
+      keys[nkeys].nnz = nnz;
+      keys[nkeys].ei = ei;
+      nkeys++;
+   }
+
+   if (nkeys < 2) { goto _exit; }
+
+   qsort(keys, nkeys, sizeof(ReduceRowKey), reduce_rowkey_cmp);
+
+   CALLOC_EXIT(work, double, cdat->total_n);
+
+   for (unsigned i = 0; i < nkeys; ) {
+      unsigned end = i + 1;
+      while (end < nkeys && keys[end].nnz == keys[i].nnz && keys[end].hash == keys[i].hash) {
+         end++;
+      }
+
+      for (unsigned k = i; k + 1 < end; ++k) {
+         rhp_idx r = keys[k].ei;
+         if (!cdat->cmat.equs[r]) { continue; }
+
+         for (CMatElt *c = cdat->cmat.equs[r]; c; c = c->next_var) {
+            work[c->vi] = c->value;
+         }
+
+         for (unsigned l = k + 1, ncmp = 0; l < end && ncmp < REDUCE_MAXDUPCMP; ++l, ++ncmp) {
+            rhp_idx s = keys[l].ei;
+            double t;
+            if (!cdat->cmat.equs[s] || !reduce_row_isparallel(cdat, s, work, &t)) {
+               continue;
+            }
+
+            rhp_idx ei_drop = reduce_parallel_drop(ctr, r, s, t);
+            if (!valid_ei(ei_drop)) { continue; }
+
+            trace_process("[presolve] row '%s' is implied by the parallel row '%s'\n",
+                          ctr_printequname(ctr, ei_drop),
+                          ctr_printequname2(ctr, ei_drop == r ? s : r));
+
+            ReduceOp *op;
+            S_CHECK_EXIT(reduce_newrowop(red, ctr, ReduceRowRedundant, ei_drop, &op));
+
+            /* The row has to be unloaded before being removed */
+            if (ei_drop == r) {
+               for (CMatElt *c = cdat->cmat.equs[r]; c; c = c->next_var) {
+                  work[c->vi] = 0.;
+               }
+            }
+
+            S_CHECK_EXIT(reduce_rm_equ(mdl, red, ei_drop, IdxNA));
+            stats->duplicate++;
+
+            if (ei_drop == r) { break; }
+         }
+
+         if (cdat->cmat.equs[r]) {
+            for (CMatElt *c = cdat->cmat.equs[r]; c; c = c->next_var) {
+               work[c->vi] = 0.;
+            }
+         }
+      }
+
+      i = end;
+   }
+
+_exit:
+   FREE(keys);
+   FREE(work);
+
+   return status;
+}
+
+/**
+ * @brief Aggregate a free variable out of a doubleton equality
+ *
+ * The row r reads a1 x1 + a2 x2 + c = 0. In every other row i, x2 is replaced
+ * by -(c + a1 x1)/a2, then r and x2 are removed.
+ *
+ * @param mdl     the model
+ * @param red     the reductions
+ * @param ei      the doubleton row
+ * @param vi      the eliminated variable
+ * @param cme2    the element of vi in the doubleton row
+ * @param cme1    the element of the other variable in the doubleton row
+ * @param nrows   the number of rows with vi, including the doubleton one
+ *
+ * @return        the error code
+ */
+static int reduce_doubleton(Model *mdl, RmdlReduce *red, rhp_idx ei, rhp_idx vi,
+                            const CMatElt *cme2, const CMatElt *cme1, unsigned nrows)
+{
+   Container *ctr = &mdl->ctr;
+   RhpContainerData *cdat = (RhpContainerData *)ctr->data;
+
+   rhp_idx rows[REDUCE_MAXFILL];
+   double coeffs[REDUCE_MAXFILL];
+   unsigned nothers = 0;
+
+   rhp_idx x1 = cme1->vi;
+   double a1 = cme1->value, a2 = cme2->value;
+   double cst = equ_get_cst(&ctr->equs[ei]);
+
+   for (CMatElt *c = cdat->cmat.vars[vi]; c; c = c->next_equ) {
+      if (c->ei == ei) { continue; }
+      assert(nothers + 1 < nrows);
+      rows[nothers] = c->ei;
+      coeffs[nothers] = c->value;
+      nothers++;
+   }
+
+   /* Rewrite the other rows. The rows are copied since they might be shared */
+   for (unsigned i = 0; i < nothers; ++i) {
+      rhp_idx ei_new = rows[i];
+      S_CHECK(rmdl_equ_dup_except(mdl, &ei_new, 1, vi));
+
+      Equ *e_new = &ctr->equs[ei_new];
+      S_CHECK(rctr_equ_addlvar(ctr, e_new, x1, -coeffs[i]*a1/a2));
+      equ_add_cst(e_new, -coeffs[i]*cst/a2);
+
+      ReduceOp *op;
+      S_CHECK(reduce_newop(red, ReduceRowMoved, rows[i], &op));
+      op->ei_new = ei_new;
+      op->cst = -coeffs[i]*cst/a2;
+      rows[i] = ei_new;
+   }
+
+   ReduceOp *op;
+   S_CHECK(reduce_newrowop(red, ctr, ReduceDoubleton, ei, &op));
+   op->vi = vi;
+   op->coeff = a2;
+
+   unsigned start2 = red->pool_len;
+   for (unsigned i = 0; i < nothers; ++i) {
+      S_CHECK(reduce_pool_add(red, rows[i], coeffs[i]));
+   }
+
+   op->start2 = start2;
+   op->len2 = nothers;
+
+   return reduce_rm_equ(mdl, red, ei, vi);
+}
+
+/**
+ * @brief Try to reduce a column
+ *
+ * @param mdl     the model
+ * @param red     the reductions
+ * @param vi      the variable
+ * @param objequ  the objective equation
+ * @param objvar  the objective variable
+ * @param stats   the statistics
+ *
+ * @return        the error code
+ */
+static int reduce_col(Model *mdl, RmdlReduce *red, rhp_idx vi, rhp_idx objequ,
+                      rhp_idx objvar, ReduceStats *stats)
+{
+   Container *ctr = &mdl->ctr;
+   RhpContainerData *cdat = (RhpContainerData *)ctr->data;
+   CMatElt *cme = cdat->cmat.vars[vi];
+
+   if (!cme || vi == objvar || cme_isplaceholder(cme)) { return OK; }
+   if (!reduce_var_isfree(&ctr->vars[vi])) { return OK; }
+
+   /* ----------------------------------------------------------------------
+    * The variable must appear linearly in linear rows, outside the objective
+    * ---------------------------------------------------------------------- */
+
+   unsigned nrows = 0;
+   const CMatElt *pivot = NULL, *other = NULL;
+
+   for (const CMatElt *c = cme; c; c = c->next_equ) {
+      rhp_idx ei = c->ei;
+      unsigned nnz;
+
+      if (ei == objequ || c->type != CMatEltLin || nrows >= REDUCE_MAXFILL) {
+         return OK;
+      }
+
+      const Equ *e = &ctr->equs[ei];
+      if (!reduce_equ_supported(e) || !reduce_row_islinear(cdat->cmat.equs[ei], &nnz)) {
+         return OK;
+      }
+
+      nrows++;
+
+      if (pivot || nnz != 2 || e->cone != CONE_0) { continue; }
+
+      const CMatElt *c1 = cdat->cmat.equs[ei];
+      if (c1->vi == vi) { c1 = c1->next_var; }
+
+      if (c1->vi != objvar && fabs(c->value) >= REDUCE_PIVOT_TOL*MAX(1., fabs(c1->value))) {
+         pivot = c;
+         other = c1;
+      }
+   }
+
+   /* ----------------------------------------------------------------------
+    * Free column singleton: the row is always satisfied by adjusting vi
+    * ---------------------------------------------------------------------- */
+
+   if (nrows == 1) {
+      if (fabs(cme->value) < REDUCE_PIVOT_TOL) { return OK; }
+
+      ReduceOp *op;
+      rhp_idx ei = cme->ei;
+      S_CHECK(reduce_newrowop(red, ctr, ReduceColSingleton, ei, &op));
+      op->vi = vi;
+      op->coeff = cme->value;
+
+      S_CHECK(reduce_rm_equ(mdl, red, ei, vi));
+      stats->colsingleton++;
+
+      return OK;
+   }
+
+   if (!pivot) { return OK; }
+
+   S_CHECK(reduce_doubleton(mdl, red, pivot->ei, vi, pivot, other, nrows));
+   stats->doubleton++;
+
+   return OK;
+}
+
+/**
+ * @brief Check whether the presolve reductions can be applied to a model
+ *
+ * Only optimization problems without EMPDAG are supported: the reductions and
+ * their postsolve rely on the first-order conditions of a single problem.
+ *
+ * @param mdl  the model
+ *
+ * @return     true if the model is supported
+ */
+bool rmdl_reduce_supported(const Model *mdl)
+{
+   const EmpDag *empdag = &mdl->empinfo.empdag;
+
+   if (!empdag_isset(empdag) || !empdag_isempty(empdag)) { return false; }
+
+   switch (mdl->commondata.mdltype) {
+   case MdlType_lp:
+   case MdlType_nlp:
+   case MdlType_dnlp:
+   case MdlType_qcp:
+      return true;
+   default:
+      return false;
+   }
+}
+
+/**
+ * @brief Apply the presolve reductions to a model
+ *
+ * The reductions are recorded in the model data for the postsolve.
+ *
+ * @param mdl  the model
+ *
+ * @return     the error code
+ */
+int rmdl_reduce(Model *mdl)
+{
+   assert(mdl_is_rhp(mdl));
+
+   if (!rmdl_reduce_supported(mdl)) {
+      error("[presolve] ERROR: %s model '%.*s' #%u is not supported. Only "
+            "optimization problems without EMPDAG are supported\n", mdl_fmtargs(mdl));
+      return Error_NotImplemented;
+   }
+
+   Container *ctr = &mdl->ctr;
+   RhpContainerData *cdat = (RhpContainerData *)ctr->data;
+   RhpModelData *mdldat = (RhpModelData *)mdl->data;
+
+   rhp_idx objequ, objvar;
+   RhpSense sense;
+   S_CHECK(rmdl_getobjequ(mdl, &objequ));
+   S_CHECK(rmdl_getobjvar(mdl, &objvar));
+   S_CHECK(rmdl_getsense(mdl, &sense));
+
+   if (!mdldat->reduce) {
+      CALLOC_(mdldat->reduce, RmdlReduce, 1);
+   }
+
+   RmdlReduce *red = mdldat->reduce;
+   red->sense = sense;
+
+   /* Copied equations get a new name */
+   S_CHECK(rmdl_incstage(mdl));
+
+   unsigned m_start = ctr->m, n_start = ctr->n;
+   ReduceStats stats = {0};
+
+   for (unsigned pass = 0; pass < REDUCE_MAXPASSES; ++pass) {
+      unsigned nops = red->len;
+
+      for (rhp_idx ei = 0; ei < cdat->total_m; ++ei) {
+         S_CHECK(reduce_row(mdl, red, ei, objequ, &stats));
+      }
+
+      S_CHECK(reduce_duplicates(mdl, red, objequ, &stats));
+
+      for (rhp_idx vi = 0; vi < cdat->total_n; ++vi) {
+         S_CHECK(reduce_col(mdl, red, vi, objequ, objvar, &stats));
+      }
+
+      if (red->len == nops) { break; }
+   }
+
+   trace_process("[presolve] %s model '%.*s' #%u: removed %u rows and %u variables\n"
+                 "           - %u empty, %u redundant and %u duplicate rows\n"
+                 "           - %u singleton and %u forcing rows\n"
+                 "           - %u free column singletons and %u doubleton aggregations\n",
+                 mdl_fmtargs(mdl), m_start - ctr->m, n_start - ctr->n, stats.empty,
+                 stats.redundant, stats.duplicate, stats.singleton, stats.forcing,
+                 stats.colsingleton, stats.doubleton);
+
+   return OK;
+}
+
+/**
+ * @brief Recover the values of the reduced rows and variables
+ *
+ * The reductions are replayed in reverse order, after the values of the
+ * reduced model have been reported.
+ *
+ * @param mdl  the model
+ *
+ * @return     the error code
+ */
+int rmdl_reduce_postsolve(Model *mdl)
+{
+   RhpModelData *mdldat = (RhpModelData *)mdl->data;
+   RmdlReduce *red = mdldat->reduce;
+
+   if (!red || red->len == 0) { return OK; }
+
+   Var * restrict vars = mdl->ctr.vars;
+   Equ * restrict equs = mdl->ctr.equs;
+   double s = red->sense == RhpMax ? -1. : 1.;
+
+   for (unsigned k = red->len; k-- > 0; ) {
+      const ReduceOp *op = &red->ops[k];
+      const rhp_idx *idx = &red->pool_idx[op->start];
+      const double *vals = &red->pool_vals[op->start];
+      unsigned len = op->len;
+
+      switch (op->type) {
+      case ReduceColEmpty: {
+         Var *v = &vars[op->vi];
+         v->value = op->val;
+         v->multiplier = 0.;
+         v->basis = BasisSuperBasic;
+         if (reduce_var_supported(v)) {
+            if (v->value == v->bnd.lb) { v->basis = BasisLower; }
+            else if (v->value == v->bnd.ub) { v->basis = BasisUpper; }
+         }
+         continue;
+      }
+      case ReduceRowMoved: {
+         const Equ *e_new = &equs[op->ei_new];
+         Equ *e = &equs[op->ei];
+         e->value = e_new->value + op->cst;
+         e->multiplier = e_new->multiplier;
+         e->basis = e_new->basis;
+         continue;
+      }
+      default: ;
+      }
+
+      Equ *e = &equs[op->ei];
+      double pi = 0.;
+
+      switch (op->type) {
+      case ReduceRowRedundant:
+         break;
+      case ReduceRowSingleton: {
+         /* The bound given by the row carries the reduced cost */
+         Var *v = &vars[op->vi];
+         double d = v->multiplier;
+         bool at_bnd = reduce_iszero(v->value - op->val, op->val);
+         bool active = op->cone == CONE_0 || (at_bnd &&
+                       (((op->sides & ReduceSideLb) && s*d > 0) ||
+                        ((op->sides & ReduceSideUb) && s*d < 0)));
+
+         if (active && isfinite(d)) {
+            pi = d/op->coeff;
+            v->multiplier = 0.;
+            v->basis = BasisBasic;
+         }
+         break;
+      }
+      case ReduceRowForcing: {
+         /* Smallest multiplier making every reduced cost dual feasible */
+         double sigma = op->at_max ? s : -s;
+         double t = op->cone == CONE_0 ? -INFINITY : 0.;
+         for (unsigned j = 0; j < len; ++j) {
+            if (vals[j] == 0.) { continue; }
+            t = MAX(t, sigma*vars[idx[j]].multiplier/vals[j]);
+         }
+
+         pi = isfinite(t) ? sigma*t : 0.;
+         for (unsigned j = 0; j < len; ++j) {
+            vars[idx[j]].multiplier -= vals[j]*pi;
+         }
+         break;
+      }
+      case ReduceColSingleton: {
+         double val = op->cst;
+         for (unsigned j = 0; j < len; ++j) {
+            if (idx[j] == op->vi) { continue; }
+            val += vals[j]*vars[idx[j]].value;
+         }
+
+         Var *v = &vars[op->vi];
+         v->value = -val/op->coeff;
+         v->multiplier = 0.;
+         v->basis = BasisBasic;
+         break;
+      }
+      case ReduceDoubleton: {
+         double val = op->cst;
+         for (unsigned j = 0; j < len; ++j) {
+            if (idx[j] == op->vi) { continue; }
+            val += vals[j]*vars[idx[j]].value;
+         }
+
+         Var *v = &vars[op->vi];
+         v->value = -val/op->coeff;
+         v->multiplier = 0.;
+         v->basis = BasisBasic;
+
+         /* The reduced cost of the eliminated variable must vanish */
+         const rhp_idx *rows = &red->pool_idx[op->start2];
+         const double *coeffs = &red->pool_vals[op->start2];
+         double sum = 0.;
+         for (unsigned j = 0; j < op->len2; ++j) {
+            sum += coeffs[j]*equs[rows[j]].multiplier;
+         }
+
+         pi = -sum/op->coeff;
+         break;
+      }
+      default:
+         error("[presolve] ERROR: unexpected reduction type %d\n", op->type);
+         return Error_RuntimeError;
+      }
+
+      double level = 0.;
+      for (unsigned j = 0; j < len; ++j) {
+         level += vals[j]*vars[idx[j]].value;
+      }
+
+      e->value = level;
+      e->multiplier = pi;
+      if (pi == 0.) {
+         e->basis = BasisBasic;
+      } else {
+         e->basis = op->cone == CONE_R_MINUS ? BasisUpper : BasisLower;
+      }
+
+      trace_solreport("[postsolve] equ '%s': value % 2.3e, multiplier % 2.3e\n",
+                      ctr_printequname(&mdl->ctr, op->ei), e->value, e->multiplier);
+   }
+
+   return OK;
+}
@@ -0,0 +1,21 @@
+#ifndef RMDL_REDUCE_H
+#define RMDL_REDUCE_H
+
+#include <stdbool.h>
+
+#include "compat.h"
+#include "rhp_fwd.h"
+
+/** @file rmdl_reduce.h
+ *
+ *  @brief Presolve reductions of a ReSHOP model and the matching postsolve
+ */
+
+struct rmdl_reduce;
+
+bool rmdl_reduce_supported(const Model *mdl) NONNULL;
+int rmdl_reduce(Model *mdl) NONNULL;
+int rmdl_reduce_postsolve(Model *mdl) NONNULL;
+void rmdl_reduce_free(struct rmdl_reduce *red);
+
+#endif
@@ -1,6 +1,7 @@
 #include "reshop_config.h"
 
 #include <assert.h>
+#include <limits.h>
 #include <string.h>
 
 #include "container.h"
@@ -10,6 +11,7 @@
 #include "nltree.h"
 #include "gams_option.h"
 #include "hdf5_logger.h"
+#include "lequ.h"
 #include "mdl.h"
 #include "mdl_timings.h"
 #include "rmdl_options.h" 
@@ -332,35 +334,150 @@ static unsigned path_eval_jacobian(Container * restrict ctr,
    return 0;
 }
 
+/**
+ * @brief Evaluate the jacobian of a sub-MCP
+ *
+ * The variables outside of the subset keep their values in sub->x.
+ */
+static unsigned path_eval_subjacobian(Container * restrict ctr,
+                                      struct jacdata * restrict jacdata,
+                                      struct path_submcp * restrict sub,
+                                      int * restrict col,
+                                      int * restrict len,
+                                      int * restrict row,
+                                      double * restrict vals)
+{
+   for (size_t k = 0; k < sub->nnz; ++k) {
+      S_CHECK(rctr_evalfuncat(ctr, &jacdata->equs[sub->nzidx[k]], sub->x, &vals[k]));
+      row[k] = sub->i[k] + 1;
+
+      assert(row[k] >= 1 && row[k] <= sub->n && isfinite(vals[k]));
+   }
+
+   for (size_t k = 0; k < sub->n; ++k) {
+      col[k] = sub->p[k] + 1;
+      len[k] = sub->p[k+1] - sub->p[k];
+   }
+
+   return 0;
+}
+
 static void (path_problem_size)(void *id, path_int *size, path_int *nnz)
 {
    struct path_env *env = (struct path_env *)id;
+
+   if (env->sub) {
+      *size = env->sub->n;
+      *nnz = MAX(env->sub->nnz, 1);
+      return;
+   }
+
    *size = env->ctr->n;
    *nnz = env->jacdata->nnzmax;
 }
 
+/** @brief Index of the i-th variable of the MCP given to PATH */
+static inline size_t path_vi(const struct path_env *env, size_t i)
+{
+   return env->sub ? env->sub->vis[i] : i;
+}
+
 static void (path_bounds)(void *id, path_int size, double * restrict x, double * restrict l, double * restrict u)
 {
    struct path_env *env = (struct path_env *)id;
    Var * restrict vars = env->ctr->vars;
-   assert(size == env->ctr->n);
+   assert(size == (env->sub ? env->sub->n : env->ctr->n));
 
    for (size_t i = 0; i < size; ++i) {
-      assert(isfinite(vars[i].value) || isnan(vars[i].value));
-      assert(!isnan(vars[i].bnd.lb) && !isnan(vars[i].bnd.ub));
+      size_t vi = path_vi(env, i);
+      assert(isfinite(vars[vi].value) || isnan(vars[vi].value));
+      assert(!isnan(vars[vi].bnd.lb) && !isnan(vars[vi].bnd.ub));
 
-      double val = vars[i].value;
+      double val = env->sub ? env->sub->x[vi] : vars[vi].value;
       x[i] = isfinite(val) ? val : 0.;
 
-      if (isfinite(vars[i].bnd.lb)) { l[i] = vars[i].bnd.lb; }
-      if (isfinite(vars[i].bnd.ub)) { u[i] = vars[i].bnd.ub; }
+      if (isfinite(vars[vi].bnd.lb)) { l[i] = vars[vi].bnd.lb; }
+      if (isfinite(vars[vi].bnd.ub)) { u[i] = vars[vi].bnd.ub; }
+   }
+}
+
+/**
+ * @brief Compute the work of evaluating a list of equations
+ *
+ * The nonzeros are the linear terms, the nodes those reachable in the
+ * expression trees. The bytes are an estimate of the memory read and written.
+ *
+ * @param      equs  the equations
+ * @param      idx   if not NULL, the indices in equs of the equations
+ * @param      len   the number of equations
+ * @param[out] work  the work of one evaluation
+ */
+static void path_equs_work(const Equ * restrict equs, const unsigned * restrict idx,
+                           size_t len, struct path_callback_work *work)
+{
+   uint64_t nnz = 0, nlnodes = 0, bytes = 0;
+
+   for (size_t i = 0; i < len; ++i) {
+      const Equ *e = &equs[idx ? idx[i] : i];
+
+      if (e->lequ) {
+         nnz += e->lequ->len;
+         bytes += e->lequ->len * (2*sizeof(double) + sizeof(rhp_idx));
+      }
+
+      if (e->tree) {
+         uint64_t tree_nodes, tree_bytes;
+         nltree_evalfootprint(e->tree, &tree_nodes, &tree_bytes);
+         nlnodes += tree_nodes;
+         bytes += tree_bytes;
+      }
+
+      bytes += sizeof(double);
+   }
+
+   work->nnz = nnz;
+   work->nlnodes = nlnodes;
+   work->bytes = bytes;
+   work->computed = true;
+}
+
+static path_int path_eval_func(struct path_env *env, double *x, double *f)
+{
+   Container *ctr = env->ctr;
+   struct path_submcp *sub = env->sub;
+   double wall_start = get_walltime(), thrd_start = get_thrdtime();
+
+   path_int num_err = 0;
+
+   if (sub) {
+      for (size_t k = 0; k < sub->n; ++k) { sub->x[sub->vis[k]] = x[k]; }
+      for (size_t k = 0; k < sub->n; ++k) {
+         num_err += rctr_evalfuncat(ctr, &ctr->equs[sub->vis[k]], sub->x, &f[k]);
+      }
+   } else {
+      num_err = env->eval_func(ctr, x, f);
+   }
+
+   env->timings.func_evals += get_thrdtime() - thrd_start;
+   double wall = get_walltime() - wall_start;
+
+   /* The expression trees may only be available after the first evaluation */
+   struct path_callback_work *work = &env->func_work;
+   if (!work->computed) {
+      if (sub) { path_equs_work(ctr->equs, sub->vis, sub->n, work); }
+      else     { path_equs_work(ctr->equs, NULL, ctr->m, work); }
    }
+
+   callback_stats_add(&env->timings.func, wall, num_err, work->nnz, work->nlnodes,
+                      work->bytes);
+
+   return num_err;
 }
 
 static path_int (path_function_evaluation)(void *id, path_int n, double *x, double *f)
 {
    struct path_env *env = (struct path_env *)id;
-   return env->eval_func(env->ctr, x, f);
+   return path_eval_func(env, x, f);
 }
 
 static path_int (path_jacobian_evaluation)(void *id, path_int n, double *x,
@@ -369,20 +486,44 @@ static path_int (path_jacobian_evaluation)(void *id, path_int n, double *x,
                                     path_int *row, double *data)
 {
    struct path_env *env = (struct path_env *)id;
-   assert(env->ctr->n == n);
+   struct path_submcp *sub = env->sub;
+   assert((sub ? sub->n : env->ctr->n) == n);
    path_int num_err = 0;
 
    if (wantf) {
-      double start = get_thrdtime();
-      num_err = env->eval_func(env->ctr, x, f);
-      env->timings.func_evals += start - get_thrdtime();
+      num_err = path_eval_func(env, x, f);
+   } else if (sub) {
+      for (size_t k = 0; k < sub->n; ++k) { sub->x[sub->vis[k]] = x[k]; }
+   }
+
+   double wall_start = get_walltime(), thrd_start = get_thrdtime();
+
+   path_int jac_err;
+   if (sub) {
+      jac_err = path_eval_subjacobian(env->ctr, env->jacdata, sub, col, len, row, data);
+   } else {
+      jac_err = path_eval_jacobian(env->ctr, env->jacdata, x, f, col, len, row, data);
+   }
+
+   env->timings.jacobian_evals += get_thrdtime() - thrd_start;
+   double wall = get_walltime() - wall_start;
+
+   size_t jac_nnz = sub ? sub->nnz : env->jacdata->nnz;
+
+   struct path_callback_work *work = &env->jacobian_work;
+   if (!work->computed) {
+      if (sub) { path_equs_work(env->jacdata->equs, sub->nzidx, sub->nnz, work); }
+      else     { path_equs_work(env->jacdata->equs, NULL, env->jacdata->nnz, work); }
+      /* The outputs are the values, the row indices and the column pointers */
+      work->bytes += jac_nnz * sizeof(path_int) + 2 * n * sizeof(path_int);
    }
-   double start = get_thrdtime();
-   num_err += path_eval_jacobian(env->ctr, env->jacdata, x, f, col, len, row, data);
-   env->timings.jacobian_evals += start - get_thrdtime();
 
-   *nnz = env->jacdata->nnz;
-   assert(env->jacdata->p[n] == *nnz);
+   callback_stats_add(&env->timings.jacobian, wall, jac_err, jac_nnz,
+                      work->nlnodes, work->bytes);
+   num_err += jac_err;
+
+   *nnz = jac_nnz;
+   assert(sub || env->jacdata->p[n] == *nnz);
 
    if (env->logh5) {
       logh5_inc_iter(env->logh5);
@@ -419,24 +560,24 @@ static void (path_varname)(void *id, path_int vi, char *buffer, path_int buf_siz
 {
    struct path_env *env = (struct path_env *)id;
    /* PATH indices are 1-based  */
-   ctr_copyvarname(env->ctr, vi-1, buffer, buf_size);
+   ctr_copyvarname(env->ctr, path_vi(env, vi-1), buffer, buf_size);
 }
 
 static void (path_equname)(void *id, path_int ei, char *buffer, path_int buf_size)
 {
    struct path_env *env = (struct path_env *)id;
    /* PATH indices are 1-based  */
-   ctr_copyequname(env->ctr, ei-1, buffer, buf_size);
+   ctr_copyequname(env->ctr, path_vi(env, ei-1), buffer, buf_size);
 }
 
 static void path_basis(void *id, path_int size, path_int * restrict basX)
 {
    struct path_env *env = (struct path_env *)id;
    Var * restrict vars = env->ctr->vars;
-   assert(size == env->ctr->n);
+   assert(size == (env->sub ? env->sub->n : env->ctr->n));
 
    for (size_t i = 0; i < size; ++i) {
-    switch (vars[i].basis) {
+    switch (vars[path_vi(env, i)].basis) {
     case BasisLower:
        basX[i] = Basis_LowerBound;
        break;
@@ -501,6 +642,43 @@ static void path_presolve_cons(void *id, int n, int *type)
    }
 }
 
+static void path_report_idx(Container * restrict ctr, size_t i, double x, double F,
+                            int basis, size_t n_primal)
+{
+   ctr->vars[i].value = x;
+   ctr->vars[i].basis = basis_path_to_rhp(basis);
+   ctr->equs[i].value = F - ctr->equs[i].p.cst;
+
+   /*  Report multiplier on x (primal value) */
+   if (i < n_primal) {
+      ctr->vars[i].multiplier = F;
+      return;
+   }
+
+   /*  Report multiplier on constraints */
+   ctr->equs[i].multiplier = x;
+   switch (ctr->vars[i].basis) {
+   case BasisLower:
+   case BasisUpper:
+      ctr->equs[i].basis = BasisBasic;
+      break;
+   case BasisBasic:
+   case BasisSuperBasic: {
+      const struct var_bnd *bnd = &ctr->vars[i].bnd;
+      /* Seems that if we have an equality constraint, we set the basis status to upper */
+      if (bnd->lb == 0.) {
+         ctr->equs[i].basis = BasisLower;
+      } else {
+         ctr->equs[i].basis = BasisUpper;
+      }
+      break;
+   }
+   case BasisFixed:
+   default:
+      ctr->equs[i].basis = BasisUnset;
+   }
+}
+
 static void _path_report_sol(Container * restrict ctr, double * restrict x,
                              double * restrict F, int * restrict basis, size_t n_primal)
 {
@@ -516,41 +694,22 @@ static void _path_report_sol(Container * restrict ctr, double * restrict x,
     * ---------------------------------------------------------------------- */
 
    for (size_t i = 0; i < ctr->n; ++i) {
-      ctr->vars[i].value = x[i];
-      ctr->vars[i].basis = basis_path_to_rhp(basis[i]);
-      ctr->equs[i].value = F[i] - ctr->equs[i].p.cst;
+      path_report_idx(ctr, i, x[i], F[i], basis[i], n_primal);
    }
+}
 
-   /*  Report multiplier on x (primal value) */
-   for (size_t i = 0; i < n_primal; ++i) {
-      ctr->vars[i].multiplier = F[i];
+/**
+ * @brief Report the solution of a sub-MCP in the container and in sub->x
+ */
+static void path_report_subsol(Container * restrict ctr, struct path_submcp * restrict sub,
+                               double * restrict x, double * restrict F,
+                               int * restrict basis, size_t n_primal)
+{
+   for (size_t k = 0; k < sub->n; ++k) {
+      size_t vi = sub->vis[k];
+      sub->x[vi] = x[k];
+      path_report_idx(ctr, vi, x[k], F[k], basis[k], n_primal);
    }
-
-   /*  Report multiplier on constraints */
-   for (size_t i = n_primal; i < (size_t)ctr->n; ++i) {
-      ctr->equs[i].multiplier = x[i];
-    switch (ctr->vars[i].basis) {
-    case BasisLower:
-    case BasisUpper:
-      ctr->equs[i].basis = BasisBasic;
-      break;
-    case BasisBasic:
-    case BasisSuperBasic:
-        {
-      const struct var_bnd *bnd = &ctr->vars[i].bnd;
-      /* Seems that if we have an equality constraint, we set the basis status to upper */
-      if (bnd->lb == 0.) {
-        ctr->equs[i].basis = BasisLower;
-      } else {
-        ctr->equs[i].basis = BasisUpper;
-      }
-      break;
-        }
-    case BasisFixed:
-      default:
-        ctr->equs[i].basis = BasisUnset;
-    }
-  }
 }
 
 static void flush_dummy(void *data, int mode)
@@ -606,7 +765,8 @@ static tlsvar void* presolve_iface[] = {
 _Pragma("GCC diagnostic pop")
 #endif
 
-int solver_path(Model * restrict mdl, struct jacdata * restrict jac)
+static int path_run(Model * restrict mdl, struct jacdata * restrict jac,
+                    struct path_submcp *sub)
 {
    int status = OK;
    bool export_hdf5 = false;
@@ -631,8 +791,16 @@ int solver_path(Model * restrict mdl, struct jacdata * restrict jac)
    struct path_env env;
    env.ctr = &mdl->ctr;
    env.jacdata = jac;
+   env.sub = sub;
    env.eval_func = ge_eval_func;
    env.eval_jacobian = NULL;
+   env.timings.func_evals = 0.;
+   env.timings.jacobian_evals = 0.;
+   env.timings.path_solve = 0.;
+   callback_stats_init(&env.timings.func);
+   callback_stats_init(&env.timings.jacobian);
+   env.func_work.computed = false;
+   env.jacobian_work.computed = false;
 
    if (export_hdf5) {
       char buf[256];
@@ -691,7 +859,11 @@ int solver_path(Model * restrict mdl, struct jacdata * restrict jac)
 //   Options_Set(opt, "crash_perturb no");
    Options_Display(opt);
 
-   m = MCP_Create(mdl->ctr.n, jac->nnzmax);
+   if (sub) {
+      m = MCP_Create(sub->n, MAX(sub->nnz, 1));
+   } else {
+      m = MCP_Create(mdl->ctr.n, jac->nnzmax);
+   }
    if (!m) {
       errormsg("[PATH] ERROR: cannot create MCP object\n");
       status = Error_SolverCreateFailed;
@@ -701,11 +873,11 @@ int solver_path(Model * restrict mdl, struct jacdata * restrict jac)
 
    /* ----------------------------------------------------------------------
     * Set the MCP interface, then the presolve one, and set some jacobian
-    * properties
+    * properties. The presolve interface describes the full jacobian.
     * ---------------------------------------------------------------------- */
 
    MCP_SetInterface(m, &mcp_iface);
-   MCP_SetPresolveInterface(m, &presolve_iface);
+   if (!sub) { MCP_SetPresolveInterface(m, &presolve_iface); }
    MCP_Jacobian_Structure_Constant(m, 1);
    MCP_Jacobian_Data_Contiguous(m, 1);
    MCP_Jacobian_Diagonal(m, 1);
@@ -717,7 +889,7 @@ int solver_path(Model * restrict mdl, struct jacdata * restrict jac)
 
    double solve_start = get_walltime();
    int path_rc = Path_Solve(m, &path_info);
-   env.timings.path_solve = solve_start - get_walltime();
+   env.timings.path_solve = get_walltime() - solve_start;
    struct _status stats = _path_rc2status(path_rc);
 
    S_CHECK_EXIT(mdl_setmodelstat(mdl, stats.model));
@@ -737,11 +909,25 @@ int solver_path(Model * restrict mdl, struct jacdata * restrict jac)
     double * restrict F = MCP_GetF(m);
     int * restrict basis = MCP_GetB(m);
 
-    _path_report_sol(&mdl->ctr, x, F, basis, jac->n_primal);
+    if (sub) {
+       path_report_subsol(&mdl->ctr, sub, x, F, basis, jac->n_primal);
+    } else {
+       _path_report_sol(&mdl->ctr, x, F, basis, jac->n_primal);
+    }
 
 _exit:
+   if (mdl->timings) {
+      Timings *t = mdl->timings;
+      t->solve.solver_wall += env.timings.path_solve;
+      callback_stats_merge(&t->solve.func_evals, &env.timings.func);
+      callback_stats_merge(&t->solve.jacobian_evals, &env.timings.jacobian);
+   }
+
    if (env.logh5) {
       logh5_end_iter(env.logh5);
+      logh5_callback_stats(env.logh5, &env.timings.func, "func_evals");
+      logh5_callback_stats(env.logh5, &env.timings.jacobian, "jacobian_evals");
+      logh5_scalar_double(env.logh5, env.timings.path_solve, "path_solve");
       int h5status = logh5_end(env.logh5);
       status = status != OK ? status : h5status;
    }
@@ -757,6 +943,98 @@ _exit:
    return status;
 }
 
+int solver_path(Model * restrict mdl, struct jacdata * restrict jac)
+{
+   return path_run(mdl, jac, NULL);
+}
+
+/**
+ * @brief Solve the MCP restricted to a subset of its variables
+ *
+ * The other variables are fixed at their values in sub->x. The equations of
+ * the sub-MCP are those matched with the variables of the subset.
+ *
+ * @param mdl  the MCP model
+ * @param jac  the jacobian data of the full MCP
+ * @param sub  the sub-MCP, see path_submcp_init()
+ *
+ * @return     the error code
+ */
+int solver_path_submcp(Model * restrict mdl, struct jacdata * restrict jac,
+                       struct path_submcp * restrict sub)
+{
+   assert(sub->x);
+   return path_run(mdl, jac, sub);
+}
+
+/**
+ * @brief Extract the jacobian structure of a sub-MCP
+ *
+ * @param sub  the sub-MCP
+ * @param jac  the jacobian data of the full MCP
+ * @param n    the number of variables in the subset
+ * @param vis  the variables of the subset, in increasing order
+ *
+ * @return     the error code
+ */
+int path_submcp_init(struct path_submcp *sub, const struct jacdata *jac, unsigned n,
+                     const unsigned *vis)
+{
+   int status = OK;
+   unsigned *pos = NULL;
+   memset(sub, 0, sizeof(*sub));
+
+   size_t n_full = jac->n;
+   MALLOC_(pos, unsigned, n_full);
+   for (size_t i = 0; i < n_full; ++i) { pos[i] = UINT_MAX; }
+   for (unsigned k = 0; k < n; ++k) {
+      assert(vis[k] < n_full && (k == 0 || vis[k] > vis[k-1]));
+      pos[vis[k]] = k;
+   }
+
+   unsigned nnz = 0;
+   for (unsigned k = 0; k < n; ++k) {
+      for (RHP_INT j = jac->p[vis[k]], end = jac->p[vis[k]+1]; j < end; ++j) {
+         if (pos[jac->i[j]] != UINT_MAX) { nnz++; }
+      }
+   }
+
+   sub->n = n;
+   sub->nnz = nnz;
+   MALLOC_EXIT(sub->vis, unsigned, n);
+   MALLOC_EXIT(sub->p, unsigned, n+1);
+   MALLOC_EXIT(sub->i, unsigned, MAX(nnz, 1));
+   MALLOC_EXIT(sub->nzidx, unsigned, MAX(nnz, 1));
+   memcpy(sub->vis, vis, n * sizeof(unsigned));
+
+   nnz = 0;
+   for (unsigned k = 0; k < n; ++k) {
+      sub->p[k] = nnz;
+      for (RHP_INT j = jac->p[vis[k]], end = jac->p[vis[k]+1]; j < end; ++j) {
+         unsigned row = pos[jac->i[j]];
+         if (row == UINT_MAX) { continue; }
+         sub->i[nnz] = row;
+         sub->nzidx[nnz] = (unsigned)j;
+         nnz++;
+      }
+   }
+   sub->p[n] = nnz;
+
+_exit:
+   FREE(pos);
+   if (status != OK) { path_submcp_free(sub); }
+
+   return status;
+}
+
+void path_submcp_free(struct path_submcp *sub)
+{
+   FREE(sub->vis);
+   FREE(sub->p);
+   FREE(sub->i);
+   FREE(sub->nzidx);
+}
+
 /**
  * @brief Set the filename of the PATH library
  *
@@ -783,3 +1061,31 @@ int rhp_PATH_setfname(const char* fname)
 
    return OK;
 }
+
+/**
+ * @brief Get the filename of the PATH library set in the calling thread
+ *
+ * @return  the filename, or NULL if none was set
+ */
+const char *path_getfname(void)
+{
+   return libpath_fname;
+}
+
+/**
+ * @brief Release the PATH library and filename of a worker thread
+ *
+ * The cleanup function only runs for the main thread.
+ */
+void path_tls_release(void)
+{
+#if defined(_WIN32) && !defined(__CYGWIN__)
+   if (libpath_handle) { FreeLibrary(libpath_handle); }
+#elif defined(__GNUC__) & !defined(__APPLE__)
+   if (libpath_handle) { dlclose(libpath_handle); }
+#endif
+   libpath_handle = NULL;
+
+   free((void*)libpath_fname);
+   libpath_fname = NULL;
+}
@@ -7,11 +7,14 @@
 #include "mdl.h"
 #include "mdl_gams.h"
 #include "mdl_rhp.h"
+#include "nash_br.h"
 #include "open_lib.h"
 #include "printout.h"
 /* for RMDL_SOLVER_GAMS */
 #include "reshop.h"
 #include "reshop_solvers.h"
+#include "rhp_options.h"
+#include "rhp_options_data.h"
 #include "rmdl_data.h"
 #include "solver_eval.h"
 #include "status.h"
@@ -154,7 +157,17 @@ int rmdl_solve_asmcp(Model *mdl)
    jacdata.n_primal = mcpdata->n_primalvars;
    S_CHECK_EXIT(ge_prep_jacdata(&mdl->ctr, &jacdata));
 
-   S_CHECK_EXIT(solve_mcp(mdl, &jacdata));
+   /* Equilibria can be solved by best-response iterations, only with PATH */
+   RhpModelData *mdldata = (RhpModelData *)mdl->data;
+   int nash_solver = optvali(mdl, Options_Nash_Solver);
+
+   if (nash_solver != Opt_NashSolverMcp && mdldata->solver != RMDL_SOLVER_GAMS) {
+      S_CHECK_EXIT(rmdl_export_latex(mdl, __func__));
+      S_CHECK_EXIT(mdl_export_gms(mdl, __func__));
+      S_CHECK_EXIT(nash_br_solve(mdl, &jacdata, nash_solver));
+   } else {
+      S_CHECK_EXIT(solve_mcp(mdl, &jacdata));
+   }
 
 _exit:
    jacdata_free(&jacdata);
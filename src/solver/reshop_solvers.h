@@ -1,6 +1,9 @@
 #ifndef RESHOP_SOLVERS_H
 #define RESHOP_SOLVERS_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include "mdl_timings.h"
 #include "rhp_fwd.h"
 
@@ -14,11 +17,34 @@ struct pathvi_env {
    int (*eval_jacobian)(Container *ctr, struct jacdata *jacdata, double *x, double *F, int *p, int *i, double *vals);
 };
 
+/** Work of one call of a callback, computed after the first call */
+struct path_callback_work {
+   bool computed;
+   uint64_t nnz;
+   uint64_t nlnodes;
+   uint64_t bytes;
+};
+
+/** Restriction of an MCP to a subset of its variables, the others being fixed */
+struct path_submcp {
+   unsigned n;            /**< Number of variables in the subset             */
+   unsigned nnz;          /**< Number of nonzeros of the restricted jacobian */
+   unsigned *vis;         /**< Variables of the subset, in increasing order  */
+   unsigned *p;           /**< Column pointers of the restricted jacobian    */
+   unsigned *i;           /**< Row indices, relative to the subset           */
+   unsigned *nzidx;       /**< Index of each nonzero in the full jacobian    */
+   double *x;             /**< Full point, not owned. Gives the values of the
+                               fixed variables and receives the solution     */
+};
+
 struct path_env {
    Container *ctr;
    struct jacdata *jacdata;
+   struct path_submcp *sub;   /**< If not NULL, only this subset is solved */
    struct logh5 *logh5;
    struct path_timings timings;
+   struct path_callback_work func_work;
+   struct path_callback_work jacobian_work;
    int (*eval_func)(Container *ctr, double *x, double *F);
    int (*eval_jacobian)(Container *ctr, struct jacdata *jacdata, double *x, double *F, int *p, int *i, double *vals);
 };
@@ -26,6 +52,15 @@ struct path_env {
 int rmdl_solve_asmcp(Model *mdl) NONNULL;
 
 int solver_path(Model * restrict mdl, struct jacdata * restrict jac);
+int solver_path_submcp(Model * restrict mdl, struct jacdata * restrict jac,
+                       struct path_submcp * restrict sub) NONNULL;
+
+int path_submcp_init(struct path_submcp *sub, const struct jacdata *jac, unsigned n,
+                     const unsigned *vis) NONNULL;
+void path_submcp_free(struct path_submcp *sub) NONNULL;
+
+const char *path_getfname(void);
+void path_tls_release(void);
 
 
 #endif /* RESHOP_SOLVERS_H  */
@@ -16,6 +16,7 @@
 #include "mdl_ops.h"
 #include "mdl_rhp.h"
 #include "mdl.h"
+#include "mdl_warmstart.h"
 #include "printout.h"
 #include "reshop.h"
 #include "tlsdef.h"
@@ -160,6 +161,7 @@ static void mdl_free(Model *mdl)
       FREE(mdl->commondata.exports_dir_parent);
    }
    mdl_timings_rel(mdl->timings);
+   mdl_warmstart_free(&mdl->warmstart);
 
    mdl->ops->deallocdata(mdl);
    ctr_fini(&mdl->ctr);
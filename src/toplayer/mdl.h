@@ -72,6 +72,7 @@ typedef struct rhp_mdl {
    const ModelOps *ops;         /**< Backend-specific operations             */
    void *data;                  /**< Backend-specific data                   */
    Model *mdl_up;               /**< Upstream model                          */
+   struct mdl_warmstart *warmstart; /**< Values kept between solves          */
 } Model;
 
 void mdl_release(Model *mdl);
@@ -8,6 +8,8 @@
 #include "mdl_timings.h"
 #include "printout.h"
 #include "print_utils.h"
+#include "profiler.h"
+#include "rhp_options.h"
 #include "timings.h"
 
 static void simple_timing_init(SimpleTiming *t)
@@ -28,6 +30,80 @@ void simple_timing_add(SimpleTiming *t, double newtime)
    t->number++;
 }
 
+static void simple_timing_merge(SimpleTiming * restrict dst, const SimpleTiming * restrict src)
+{
+   if (src->number == 0) { return; }
+
+   if (src->min < dst->min) { dst->min = src->min; }
+   if (src->max > dst->max) { dst->max = src->max; }
+
+   unsigned number = dst->number + src->number;
+
+   dst->mean = (dst->mean * dst->number + src->mean * src->number)/number;
+   dst->number = number;
+}
+
+void callback_stats_init(CallbackStats *s)
+{
+   memset(s, 0, sizeof(*s));
+}
+
+/**
+ * @brief Record a call of a solver callback
+ *
+ * @param s        the statistics of the callback
+ * @param wall     the wall time of the call
+ * @param errors   the number of evaluation errors
+ * @param nnz      the number of nonzeros evaluated
+ * @param nlnodes  the number of expression nodes visited
+ * @param bytes    the estimated number of bytes touched
+ */
+void callback_stats_add(CallbackStats *s, double wall, unsigned errors,
+                        uint64_t nnz, uint64_t nlnodes, uint64_t bytes)
+{
+   s->calls++;
+   s->errors += errors;
+   s->nnz += nnz;
+   s->nlnodes += nlnodes;
+   s->bytes += bytes;
+   s->wall += wall;
+
+   unsigned bucket = 0;
+   for (double us = wall * 1e6; us >= 1. && bucket < CALLBACK_HIST_LEN-1; us /= 2.) {
+      bucket++;
+   }
+
+   s->hist[bucket]++;
+}
+
+void callback_stats_merge(CallbackStats * restrict dst, const CallbackStats * restrict src)
+{
+   dst->calls += src->calls;
+   dst->errors += src->errors;
+   dst->nnz += src->nnz;
+   dst->nlnodes += src->nlnodes;
+   dst->bytes += src->bytes;
+   dst->wall += src->wall;
+
+   for (unsigned i = 0; i < CALLBACK_HIST_LEN; ++i) {
+      dst->hist[i] += src->hist[i];
+   }
+}
+
+/* Upper bound, in microseconds, of the bucket containing the given quantile */
+static double callback_stats_quantile(const CallbackStats *s, double q)
+{
+   double target = q * s->calls;
+   uint64_t cumul = 0;
+
+   for (unsigned i = 0; i < CALLBACK_HIST_LEN; ++i) {
+      cumul += s->hist[i];
+      if ((double)cumul >= target) { return ldexp(1., (int)i); }
+   }
+
+   return INFINITY;
+}
+
 UNUSED static const char* simple_timing_print(const SimpleTiming *t, int *ret)
 {
    if (t->number == 0) { return NULL; }
@@ -68,12 +144,15 @@ int mdl_timings_alloc(Model *mdl)
    t->reformulation.CCF.total = 0.;
 
    t->reformulation.empdag.total = 0.;
+   simple_timing_init(&t->reformulation.empdag.subtree_contraction);
 
    t->gmo_creation = 0.;
 
    t->solve.presolve_wall = 0.;
    t->solve.fooc = 0.;
    t->solve.solver_wall = 0.;
+   callback_stats_init(&t->solve.func_evals);
+   callback_stats_init(&t->solve.jacobian_evals);
 
    t->postprocessing = 0.;
 
@@ -81,11 +160,37 @@ int mdl_timings_alloc(Model *mdl)
    t->thrd_start = get_thrdtime();
    t->proc_start = get_proctime();
 
+   prof_init(&t->prof);
+
    t->refcnt = 1;
 
    return OK;
 }
 
+/**
+ * @brief Add the solve timings of a model to another one
+ *
+ * This is used when a model had its own timings while being solved on another
+ * thread. The profiling spans are not merged.
+ *
+ * @param dst  the timings to update
+ * @param src  the timings to add
+ */
+void mdl_timings_merge(Timings * restrict dst, const Timings * restrict src)
+{
+   simple_timing_merge(&dst->rhp.mdl_creation, &src->rhp.mdl_creation);
+   simple_timing_merge(&dst->empdag.analysis, &src->empdag.analysis);
+
+   dst->gmo_creation += src->gmo_creation;
+
+   dst->solve.fooc += src->solve.fooc;
+   dst->solve.solver_wall += src->solve.solver_wall;
+   callback_stats_merge(&dst->solve.func_evals, &src->solve.func_evals);
+   callback_stats_merge(&dst->solve.jacobian_evals, &src->solve.jacobian_evals);
+
+   dst->postprocessing += src->postprocessing;
+}
+
 NONNULL static void printsimple(struct lineppty *l, const char *str, const SimpleTiming *t)
 {
    if (t->number == 0) { return; }
@@ -103,6 +208,20 @@ NONNULL static void printsimple(struct lineppty *l, const char *str, const Simpl
 
 }
 
+NONNULL static void printcallback(struct lineppty *l, const char *str, const CallbackStats *s)
+{
+   if (s->calls == 0) { return; }
+
+   printdbl(l, str, s->wall);
+   printout(l->mode, "%*s#calls = %llu; #errors = %llu; nnz = %llu; nodes = %llu; "
+            "MB = %.1f\n", l->ident + 2, "", (unsigned long long)s->calls,
+            (unsigned long long)s->errors, (unsigned long long)s->nnz,
+            (unsigned long long)s->nlnodes, s->bytes / 1e6);
+   printout(l->mode, "%*slatency (us): avg = %.2f; p50 < %.0f; p90 < %.0f; p99 < %.0f\n",
+            l->ident + 2, "", s->wall * 1e6 / s->calls, callback_stats_quantile(s, .5),
+            callback_stats_quantile(s, .9), callback_stats_quantile(s, .99));
+}
+
 void mdl_timings_print(const Model *mdl, unsigned mode)
 {
    Timings *t = mdl->timings;
@@ -152,13 +271,29 @@ void mdl_timings_print(const Model *mdl, unsigned mode)
       l.ident -= 2*offset;
    }
    
+   printsimple(&l, "EmpDag subtree contraction", &t->reformulation.empdag.subtree_contraction);
+
    printdbl(&l, "Presolve (wall)", t->solve.presolve_wall);
    printdbl(&l, "First-order OC", t->solve.fooc);
    printdbl(&l, "GMO creation (cumul.)", t->gmo_creation);
    printdbl(&l, "Solver time (wall)", t->solve.solver_wall);
+
+   double callbacks_wall = t->solve.func_evals.wall + t->solve.jacobian_evals.wall;
+   if (callbacks_wall > 0) {
+      l.ident += offset;
+      printcallback(&l, "Function evaluations", &t->solve.func_evals);
+      printcallback(&l, "Jacobian evaluations", &t->solve.jacobian_evals);
+      if (t->solve.solver_wall > 0) {
+         printout(mode, "%*sShare of the solver time in the callbacks: %.1f%%\n",
+                  l.ident, "", 100. * callbacks_wall / t->solve.solver_wall);
+      }
+      l.ident -= offset;
+   }
    
    printdbl(&l, "Postprocessing", t->postprocessing);
 
+   prof_print_summary(&t->prof, mode);
+
    printstr(mode, "\n");
    
 }
@@ -168,6 +303,7 @@ void mdl_timings_rel(Timings *t)
    if (!t) { return; }
 
    if (t->refcnt <= 1) {
+      prof_free(&t->prof);
       FREE(t);
       return;
    }
@@ -186,3 +322,60 @@ Timings* mdl_timings_borrow(Timings *t)
 
    return t;
 }
+
+/**
+ * @brief Open a profiling span for a model
+ *
+ * The span is recorded in the timings of the model, which are shared with the
+ * models linked to it.
+ *
+ * @param mdl   the model
+ * @param name  the name of the span (a string literal)
+ *
+ * @return      the span index
+ */
+unsigned mdl_prof_begin(const Model *mdl, const char *name)
+{
+   if (!mdl->timings) { return ProfSpanNone; }
+
+   return prof_begin(&mdl->timings->prof, name);
+}
+
+void mdl_prof_end(const Model *mdl, unsigned span)
+{
+   if (!mdl->timings) { return; }
+
+   prof_end(&mdl->timings->prof, span);
+}
+
+void mdl_prof_additems(const Model *mdl, unsigned span, uint64_t nitems)
+{
+   if (!mdl->timings) { return; }
+
+   prof_additems(&mdl->timings->prof, span, nitems);
+}
+
+/**
+ * @brief Write the profile of a model to the file given by the option profile_file
+ *
+ * @param mdl  the model
+ *
+ * @return     the error code
+ */
+int mdl_prof_write(const Model *mdl)
+{
+   if (!mdl->timings) { return OK; }
+
+   int status = OK;
+   char *fname = optvals(mdl, Options_Profile_File);
+
+   if (fname && fname[0] != '\0') {
+      trace_process("[process] Writing the profile of %s model '%.*s' #%u to '%s'\n",
+                    mdl_fmtargs(mdl), fname);
+      status = prof_write(&mdl->timings->prof, fname);
+   }
+
+   free(fname);
+
+   return status;
+}
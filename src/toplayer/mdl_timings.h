@@ -1,6 +1,9 @@
 #ifndef MDL_TIMINGS_H
 #define MDL_TIMINGS_H
 
+#include <stdint.h>
+
+#include "profiler.h"
 #include "rhp_fwd.h"
 
 typedef struct ccf_timings {
@@ -15,10 +18,31 @@ typedef struct conj_ccf_timings {
    SimpleTiming PPL;
 } ConjugateCcfTiming;
 
+/** Number of buckets in the latency histograms of the solver callbacks */
+#define CALLBACK_HIST_LEN 32
+
+/** Statistics on the calls of a solver callback
+ *
+ *  The latency histogram uses log2 buckets in microseconds: bucket 0 counts
+ *  the calls faster than 1us, bucket k those in [2^(k-1), 2^k) us and the last
+ *  bucket all the slower ones.
+ */
+typedef struct callback_stats {
+   uint64_t calls;                   /**< Number of calls                       */
+   uint64_t errors;                  /**< Number of evaluation errors           */
+   uint64_t nnz;                     /**< Number of nonzeros evaluated          */
+   uint64_t nlnodes;                 /**< Number of expression nodes visited    */
+   uint64_t bytes;                   /**< Estimated number of bytes touched     */
+   double wall;                      /**< Total wall time                       */
+   uint64_t hist[CALLBACK_HIST_LEN]; /**< Latency histogram                     */
+} CallbackStats;
+
 typedef struct path_timings {
    double func_evals;
    double jacobian_evals;
    double path_solve;
+   CallbackStats func;
+   CallbackStats jacobian;
 } PathTiming;
 
 typedef struct mdl_timings {
@@ -52,6 +76,7 @@ typedef struct mdl_timings {
       } CCF;
       struct {
          double total;
+         SimpleTiming subtree_contraction;
       } empdag;
    } reformulation;
 
@@ -61,6 +86,8 @@ typedef struct mdl_timings {
       double presolve_wall;
       double fooc;
       double solver_wall;
+      CallbackStats func_evals;
+      CallbackStats jacobian_evals;
    } solve;
 
    double postprocessing;
@@ -72,16 +99,30 @@ typedef struct mdl_timings {
    double proc_start;
    double proc_end;
 
+   Profiler prof;             /**< Spans of the processing phases */
+
    unsigned refcnt;
 
 } Timings;
 
 void simple_timing_add(SimpleTiming *t, double newtime) NONNULL;
 
+void callback_stats_init(CallbackStats *s) NONNULL;
+void callback_stats_add(CallbackStats *s, double wall, unsigned errors,
+                        uint64_t nnz, uint64_t nlnodes, uint64_t bytes) NONNULL;
+void callback_stats_merge(CallbackStats * restrict dst,
+                          const CallbackStats * restrict src) NONNULL;
+
 int mdl_timings_alloc(Model *mdl) NONNULL;
 void mdl_timings_print(const Model *mdl, unsigned mode) NONNULL;
+void mdl_timings_merge(Timings * restrict dst, const Timings * restrict src) NONNULL;
 
 Timings* mdl_timings_borrow(Timings *t) NONNULL;
 void mdl_timings_rel(Timings *t);
 
+unsigned mdl_prof_begin(const Model *mdl, const char *name) NONNULL;
+void mdl_prof_end(const Model *mdl, unsigned span) NONNULL;
+void mdl_prof_additems(const Model *mdl, unsigned span, uint64_t nitems) NONNULL;
+int mdl_prof_write(const Model *mdl) NONNULL;
+
 #endif
@@ -0,0 +1,293 @@
+#include "reshop_config.h"
+
+#include <string.h>
+
+#include "container.h"
+#include "equ.h"
+#include "equvar_metadata.h"
+#include "lequ.h"
+#include "macros.h"
+#include "mdl.h"
+#include "mdl_warmstart.h"
+#include "nltree.h"
+#include "printout.h"
+#include "status.h"
+#include "var.h"
+
+/* 64-bit FNV-1a */
+#define FNV_OFFSET  UINT64_C(14695981039346656037)
+#define FNV_PRIME   UINT64_C(1099511628211)
+
+static inline uint64_t sig_add(uint64_t h, uint64_t v)
+{
+   for (unsigned i = 0; i < 8; ++i, v >>= 8) {
+      h = (h ^ (v & 0xff)) * FNV_PRIME;
+   }
+
+   return h;
+}
+
+static void warmstart_freevals(MdlWarmStart *ws)
+{
+   FREE(ws->varvals);
+   FREE(ws->varmults);
+   FREE(ws->varbasis);
+   FREE(ws->equvals);
+   FREE(ws->equmults);
+   FREE(ws->equbasis);
+   ws->n_new = ws->m_new = 0;
+   ws->signature = 0;
+}
+
+/**
+ * @brief Compute the signature of the variables and equations created by the
+ * reformulations
+ *
+ * Only the structure enters the signature, not the data: the coefficients,
+ * bounds and constants may change between two solves.
+ *
+ * @param ctr   the container of the reformulated model
+ * @param n_up  the number of variables of the user model
+ * @param m_up  the number of equations of the user model
+ *
+ * @return      the signature
+ */
+static uint64_t warmstart_signature(const Container *ctr, unsigned n_up, unsigned m_up)
+{
+   unsigned n = ctr_nvars_total(ctr), m = ctr_nequs_total(ctr);
+   const VarMeta *varmeta = ctr->varmeta;
+   const EquMeta *equmeta = ctr->equmeta;
+
+   uint64_t h = FNV_OFFSET;
+   h = sig_add(h, n_up);
+   h = sig_add(h, m_up);
+   h = sig_add(h, n);
+   h = sig_add(h, m);
+
+   for (unsigned vi = n_up; vi < n; ++vi) {
+      const Var *v = &ctr->vars[vi];
+      h = sig_add(h, v->type);
+      h = sig_add(h, v->is_conic);
+      h = sig_add(h, v->is_deleted);
+
+      if (varmeta) {
+         h = sig_add(h, varmeta[vi].type);
+         h = sig_add(h, varmeta[vi].ppty);
+         h = sig_add(h, varmeta[vi].mp_id);
+      }
+   }
+
+   for (unsigned ei = m_up; ei < m; ++ei) {
+      const Equ *e = &ctr->equs[ei];
+      h = sig_add(h, e->object);
+      h = sig_add(h, e->cone);
+      h = sig_add(h, e->tree && e->tree->root);
+
+      const Lequ *lequ = e->lequ;
+      unsigned len = lequ ? lequ->len : 0;
+      h = sig_add(h, len);
+      for (unsigned j = 0; j < len; ++j) {
+         h = sig_add(h, (uint64_t)lequ->vis[j]);
+      }
+
+      if (equmeta) {
+         h = sig_add(h, equmeta[ei].role);
+         h = sig_add(h, equmeta[ei].ppty);
+         h = sig_add(h, equmeta[ei].mp_id);
+      }
+   }
+
+   return h;
+}
+
+void mdl_warmstart_free(MdlWarmStart **ws)
+{
+   if (!*ws) { return; }
+
+   warmstart_freevals(*ws);
+   FREE(*ws);
+}
+
+/**
+ * @brief Activate or deactivate the warm-start of a model
+ *
+ * @param mdl     the (user) model
+ * @param active  if true, the values of a solve are used to start the next one
+ *
+ * @return        the error code
+ */
+int mdl_warmstart_setactive(Model *mdl, bool active)
+{
+   if (!mdl->warmstart) {
+      if (!active) { return OK; }
+
+      CALLOC_(mdl->warmstart, MdlWarmStart, 1);
+      mdl->warmstart->local_id = UINT_MAX;
+   }
+
+   mdl->warmstart->active = active;
+
+   if (!active) { warmstart_freevals(mdl->warmstart); }
+
+   return OK;
+}
+
+/**
+ * @brief Discard the values saved from the previous solve
+ *
+ * @param mdl  the (user) model
+ */
+void mdl_warmstart_reset(Model *mdl)
+{
+   if (!mdl->warmstart) { return; }
+
+   warmstart_freevals(mdl->warmstart);
+   mdl->warmstart->local_id = UINT_MAX;
+}
+
+bool mdl_warmstart_isactive(const Model *mdl)
+{
+   return mdl->warmstart && mdl->warmstart->active;
+}
+
+/**
+ * @brief Record the reformulated model, whose values are saved after the solve
+ *
+ * The signature is computed right after the reformulation, before the export
+ * to the solver modifies the model.
+ *
+ * @param mdl        the (user) model
+ * @param mdl_local  the reformulated model
+ */
+void mdl_warmstart_setlocal(Model *mdl, const Model *mdl_local)
+{
+   if (!mdl_warmstart_isactive(mdl)) { return; }
+
+   MdlWarmStart *ws = mdl->warmstart;
+   unsigned n_up = ctr_nvars_total(&mdl->ctr), m_up = ctr_nequs_total(&mdl->ctr);
+
+   ws->local_id = mdl_local->id;
+   ws->local_signature = warmstart_signature(&mdl_local->ctr, n_up, m_up);
+}
+
+/**
+ * @brief Save the values of the variables and equations created by the
+ * reformulations, once the solution has been reported
+ *
+ * @param mdl         the (user) model
+ * @param mdl_solver  the solver model
+ *
+ * @return            the error code
+ */
+int mdl_warmstart_save(Model *mdl, const Model *mdl_solver)
+{
+   if (!mdl_warmstart_isactive(mdl)) { return OK; }
+
+   MdlWarmStart *ws = mdl->warmstart;
+   const Model *mdl_local = mdl_solver;
+   while (mdl_local && mdl_local->id != ws->local_id) { mdl_local = mdl_local->mdl_up; }
+
+   /* No reformulation: all the values are already in the user model */
+   if (!mdl_local || mdl_local == mdl) {
+      warmstart_freevals(ws);
+      return OK;
+   }
+
+   const Container *ctr = &mdl_local->ctr;
+   unsigned n_up = ctr_nvars_total(&mdl->ctr), m_up = ctr_nequs_total(&mdl->ctr);
+   unsigned n = ctr_nvars_total(ctr), m = ctr_nequs_total(ctr);
+
+   if (n < n_up || m < m_up) {
+      printout(PO_DEBUG, "[warmstart] %s model '%.*s' #%u is smaller than the user "
+               "model, not saving the values\n", mdl_fmtargs(mdl_local));
+      warmstart_freevals(ws);
+      return OK;
+   }
+
+   unsigned n_new = n - n_up, m_new = m - m_up;
+
+   if (n_new != ws->n_new || m_new != ws->m_new || !ws->varvals) {
+      warmstart_freevals(ws);
+      MALLOC_(ws->varvals, double, n_new+1);
+      MALLOC_(ws->varmults, double, n_new+1);
+      MALLOC_(ws->varbasis, BasisStatus, n_new+1);
+      MALLOC_(ws->equvals, double, m_new+1);
+      MALLOC_(ws->equmults, double, m_new+1);
+      MALLOC_(ws->equbasis, BasisStatus, m_new+1);
+      ws->n_new = n_new; ws->m_new = m_new;
+   }
+
+   ws->signature = ws->local_signature;
+
+   for (unsigned i = 0; i < n_new; ++i) {
+      const Var *v = &ctr->vars[n_up+i];
+      ws->varvals[i] = v->value;
+      ws->varmults[i] = v->multiplier;
+      ws->varbasis[i] = v->basis;
+   }
+
+   for (unsigned i = 0; i < m_new; ++i) {
+      const Equ *e = &ctr->equs[m_up+i];
+      ws->equvals[i] = e->value;
+      ws->equmults[i] = e->multiplier;
+      ws->equbasis[i] = e->basis;
+   }
+
+   trace_process("[warmstart] %s model '%.*s' #%u: saved %u variable and %u equation "
+                 "values\n", mdl_fmtargs(mdl), n_new, m_new);
+
+   return OK;
+}
+
+/**
+ * @brief Restore the values of the variables and equations created by the
+ * reformulations from the previous solve
+ *
+ * The values are only restored when the new variables and equations of the
+ * reformulated model have the same structure as in the previous solve.
+ *
+ * @param       mdl        the (user) model
+ * @param       mdl_local  the reformulated model
+ * @param[out]  restored   true if the values have been restored
+ *
+ * @return                 the error code
+ */
+int mdl_warmstart_restore(const Model *mdl, Model *mdl_local, bool *restored)
+{
+   *restored = false;
+
+   if (!mdl_warmstart_isactive(mdl)) { return OK; }
+
+   const MdlWarmStart *ws = mdl->warmstart;
+   if (!ws->varvals) { return OK; }
+
+   Container *ctr = &mdl_local->ctr;
+   unsigned n_up = ctr_nvars_total(&mdl->ctr), m_up = ctr_nequs_total(&mdl->ctr);
+   unsigned n = ctr_nvars_total(ctr), m = ctr_nequs_total(ctr);
+
+   if (n < n_up || m < m_up || n - n_up != ws->n_new || m - m_up != ws->m_new ||
+       ws->local_signature != ws->signature) {
+      printout(PO_INFO, "[warmstart] The reformulation of %s model '%.*s' #%u changed "
+               "since the last solve, the new variables are not warm-started\n",
+               mdl_fmtargs(mdl));
+      return OK;
+   }
+
+   for (unsigned i = 0, len = n - n_up; i < len; ++i) {
+      Var *v = &ctr->vars[n_up+i];
+      v->value = ws->varvals[i];
+      v->multiplier = ws->varmults[i];
+      v->basis = ws->varbasis[i];
+   }
+
+   for (unsigned i = 0, len = m - m_up; i < len; ++i) {
+      Equ *e = &ctr->equs[m_up+i];
+      e->value = ws->equvals[i];
+      e->multiplier = ws->equmults[i];
+      e->basis = ws->equbasis[i];
+   }
+
+   *restored = true;
+
+   return OK;
+}
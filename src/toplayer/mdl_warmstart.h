@@ -0,0 +1,51 @@
+#ifndef MDL_WARMSTART_H
+#define MDL_WARMSTART_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "compat.h"
+#include "equvar_data.h"
+#include "rhp_fwd.h"
+
+/** @file mdl_warmstart.h
+ *
+ *  @brief Warm-start data carried from one solve of a model to the next one
+ *
+ *  The values of the user model are copied into the reformulated model, then
+ *  into the solver model via the rosettas and the FOOC multipliers. The
+ *  variables and equations created by the reformulations (OVF dual variables,
+ *  objective variables, ...) do not exist in the user model: their values
+ *  are saved after a solve and restored into the next reformulated model.
+ *
+ *  The new variables and equations are those after the ones of the user model.
+ *  They are identified by a signature of their structure: type, role, owning
+ *  MP and sparsity pattern. The values are only restored if the reformulated
+ *  model has the same signature as the one of the previous solve.
+ */
+
+typedef struct mdl_warmstart {
+   bool active;           /**< If true, save and restore the values          */
+   unsigned local_id;     /**< ID of the reformulated model of the last solve */
+   unsigned n_new;        /**< Number of new variables                        */
+   unsigned m_new;        /**< Number of new equations                        */
+   uint64_t signature;    /**< Structure of the new variables and equations   */
+   uint64_t local_signature; /**< Signature of the current reformulated model */
+   double *varvals;       /**< Levels of the new variables                    */
+   double *varmults;      /**< Multipliers of the new variables               */
+   BasisStatus *varbasis; /**< Basis status of the new variables              */
+   double *equvals;       /**< Levels of the new equations                    */
+   double *equmults;      /**< Multipliers of the new equations               */
+   BasisStatus *equbasis; /**< Basis status of the new equations              */
+} MdlWarmStart;
+
+int mdl_warmstart_setactive(Model *mdl, bool active) NONNULL;
+void mdl_warmstart_reset(Model *mdl) NONNULL;
+void mdl_warmstart_free(MdlWarmStart **ws);
+
+bool mdl_warmstart_isactive(const Model *mdl) NONNULL;
+void mdl_warmstart_setlocal(Model *mdl, const Model *mdl_local) NONNULL;
+int mdl_warmstart_save(Model *mdl, const Model *mdl_solver) NONNULL;
+int mdl_warmstart_restore(const Model *mdl, Model *mdl_local, bool *restored) NONNULL;
+
+#endif /* MDL_WARMSTART_H */
@@ -6,11 +6,15 @@
 #include "macros.h"
 #include "mdl.h"
 #include "mdl_rhp.h"
+#include "mdl_timings.h"
+#include "mdl_warmstart.h"
 #include "rhp_alg.h"
 #include "printout.h"
 #include "reshop.h"
 #include "rhp_ipc.h"
 #include "rhp_process.h"
+#include "rhp_options.h"
+#include "rmdl_reduce.h"
 #include "status.h"
 #include "timings.h"
 
@@ -68,6 +72,7 @@ int rhp_postprocess(Model *mdl_solver)
       return OK;
    }
  
+   unsigned span = mdl_prof_begin(mdl_solver, "postprocess");
 
    Model *mdl = mdl_solver;
    Model *mdl_up = mdl_solver->mdl_up;
@@ -89,14 +94,19 @@ int rhp_postprocess(Model *mdl_solver)
 
    S_CHECK(mdl_postprocess(mdl));
 
+   /* Keep the values of the reformulation for the next solve */
+   S_CHECK(mdl_warmstart_save(mdl, mdl_solver));
+
    S_CHECK(mdl_copystatsfromsolver(mdl, mdl_solver));
 
    mdl->timings->postprocessing = get_thrdtime() - start;
+   mdl_prof_end(mdl_solver, span);
 
    if (optvalb(mdl, Options_Display_Timings)) {
       mdl_timings_print(mdl, PO_INFO);
    }
-   return OK;
+
+   return mdl_prof_write(mdl);
 }
 
 /**
@@ -123,7 +133,11 @@ int rhp_solve(Model *mdl)
    S_CHECK(mdl_check(mdl->mdl_up));
    S_CHECK(mdl_solvable(mdl->mdl_up));
 
-   return mdl_solve(mdl);
+   unsigned span = mdl_prof_begin(mdl, "solve");
+   int status = mdl_solve(mdl);
+   mdl_prof_end(mdl, span);
+
+   return status;
 }
 
 /** @brief Process the input model into a model for the solver
@@ -164,9 +178,12 @@ int rhp_process(Model *mdl, Model *mdl_solver)
    ctr_setneednames(&mdl->ctr);
 
    Model *mdl_local = NULL;
+   unsigned span = mdl_prof_begin(mdl, "process"), span_phase;
 
+   span_phase = mdl_prof_begin(mdl, "check");
    S_CHECK_EXIT(mdl_check(mdl));
    S_CHECK_EXIT(mdl_checkmetadata(mdl));
+   mdl_prof_end(mdl, span_phase);
 
    const char *no_solve = mygetenv("RHP_TEST_PARSER");
    if (no_solve) {
@@ -191,7 +208,33 @@ int rhp_process(Model *mdl, Model *mdl_solver)
     * PART I: Perform any kind of reformulation
     * --------------------------------------------------------------------- */
 
+   span_phase = mdl_prof_begin(mdl, "reformulate");
    S_CHECK_EXIT(rhp_reformulate(mdl, &mdl_local));
+   mdl_prof_end(mdl, span_phase);
+
+   /* ---------------------------------------------------------------------
+    * Warm-start the variables and equations added by the reformulation
+    * --------------------------------------------------------------------- */
+
+   bool warmstarted = false;
+   if (mdl_local) {
+      mdl_warmstart_setlocal(mdl, mdl_local);
+      S_CHECK_EXIT(mdl_warmstart_restore(mdl, mdl_local, &warmstarted));
+   }
+
+   /* ---------------------------------------------------------------------
+    * The presolve reductions are applied on a copy of the model
+    * --------------------------------------------------------------------- */
+
+   if (!mdl_local && optvalb(mdl, Options_Presolve_Reductions) && rmdl_reduce_supported(mdl)) {
+      trace_process("[process] %s model %.*s #%u: Copying model for presolve "
+                    "reductions.\n", mdl_fmtargs(mdl));
+
+      A_CHECK_EXIT(mdl_local, mdl_new(RhpBackendReSHOP));
+      S_CHECK_EXIT(rmdl_initfromfullmdl(mdl_local, mdl));
+      S_CHECK_EXIT(empdag_fini(&mdl_local->empinfo.empdag));
+      S_CHECK_EXIT(mdl_recompute_modeltype(mdl_local));
+   }
 
    /* ----------------------------------------------------------------------
     * PART II: prepare the mdl_solver object
@@ -212,8 +255,24 @@ int rhp_process(Model *mdl, Model *mdl_solver)
        * TODO(Xhub) URG add option for that?
        * ------------------------------------------------------------------- */
 
-      if (optvalb(mdl_local, Options_Presolve)) {
+      if (warmstarted) {
+         trace_process("[process] %s model %.*s #%u: skipping presolve, the new "
+                       "variables are warm-started\n", mdl_fmtargs(mdl_local));
+      } else if (optvalb(mdl_local, Options_Presolve)) {
+         span_phase = mdl_prof_begin(mdl, "presolve");
          S_CHECK_EXIT(rmdl_presolve(mdl_local, mdl_solver->backend));
+         mdl_prof_end(mdl, span_phase);
+      }
+
+      /* -------------------------------------------------------------------
+       * Remove the structure that is cheap to detect: the postsolve is
+       * performed when reporting the solution values
+       * ------------------------------------------------------------------- */
+
+      if (optvalb(mdl_local, Options_Presolve_Reductions) && rmdl_reduce_supported(mdl_local)) {
+         span_phase = mdl_prof_begin(mdl, "presolve reductions");
+         S_CHECK_EXIT(rmdl_reduce(mdl_local));
+         mdl_prof_end(mdl, span_phase);
       }
 
       S_CHECK(rmdl_export_latex(mdl_local, "transformed"));
@@ -223,9 +282,14 @@ int rhp_process(Model *mdl, Model *mdl_solver)
    /* TODO: GITLAB #87  refactor the following mess */
    Model *mdl4export = mdl_local ? mdl_local : mdl;
 
+   span_phase = mdl_prof_begin(mdl, "export");
    S_CHECK_EXIT(mdl_copyassolvable(mdl_solver, mdl4export));
+   mdl_prof_additems(mdl, span_phase, ctr_nvars(&mdl_solver->ctr) + ctr_nequs(&mdl_solver->ctr));
+   mdl_prof_end(mdl, span_phase);
 
 _exit:
+   mdl_prof_end(mdl, span);
+
    if (mdl_local) {
       mdl_release(mdl_local);
    }
@@ -24,13 +24,19 @@ tlsvar struct option rhp_options[] = {
    [Options_Dump_Scalar_Models]    = { "dump_scalar_model",   "Dump every scalar model via convert",                                                                                      OptBoolean, { .b = false } },
    [Options_Expensive_Checks]      = { "expensive_checks",    "Perform time consuming consistency checks",                                                                                OptBoolean, { .b = false} },
    [Options_EMPInfoFile]           = { "EMPInfoFile",         "EMPinfo file to use",                                                                                                      OptString,  { .s = "empinfo.dat" } },
+   [Options_EMPInfo_CacheDir]      = { "empinfo_cachedir",    "Directory where the EMP interpreter caches the sets and parameters read from the GDX file",                                OptString,  { .s = ""} },
    [Options_GUI]                   = { "gui",                 "Start GUI",                                                                                                                OptBoolean, { .b = false } },
+   [Options_Nash_Iteration_Limit]  = { "nash_iteration_limit","Maximum number of sweeps of the best-response Nash solvers",                                                            OptInteger, { .i = 100} },
+   [Options_Nash_Solver]           = { "nash_solver",         "How to solve an equilibrium: as one MCP, or by Jacobi or Gauss-Seidel best-response iterations",                         OptChoice,  { .i = Opt_NashSolverMcp} },
    [Options_Output]                = { "output",              "Output level",                                                                                                             OptInteger, { .i = PO_INFO } },
    [Options_Output_Presolve_Log]   = { "output_presolve_log" ,"during presolve, whether to output subsolver log",                                                                         OptBoolean, { .b = false } },
    [Options_Output_Subsolver_Log]  = { "output_subsolver_log","whether to output subsolver log",                                                                                          OptBoolean, { .b = false } },
    [Options_Pathlib_Name]          = { "pathlib_name",        "path of the PATH library",                                                                                                 OptString,  { .s = "" } },
    [Options_Png_Viewer]            = { "png_viewer",          "Executable to display png",                                                                                                OptString,  { .s = "" } },
    [Options_Presolve]              = { "presolve",            "Compute initial values for new variables and equations",                                                                   OptBoolean, { .b = true} },
+   [Options_Presolve_Reductions]   = { "presolve_reductions", "Remove singleton, redundant and forcing rows, free column singletons and doubletons before the export",                    OptBoolean, { .b = false} },
+   [Options_Presolve_Threads]      = { "presolve_threads",    "Number of threads to solve the MP presolve submodels concurrently (GAMS subsolvers with solvelink=5 only)",                OptInteger, { .i = 1} },
+   [Options_Profile_File]          = { "profile_file",        "Write the profile of the processing phases to this file (CSV if it ends with .csv, Chrome trace JSON otherwise)",          OptString,  { .s = ""} },
    [Options_SolveLink]             = { "solvelink",           "Solvelink for calling subsolver",                                                                                          OptInteger, { .i = 5} },
    [Options_SolveSingleOptAs]      = { "solve_single_opt_as", "How to solve an empdag with a single MP",                                                                                  OptChoice,  { .i = Opt_SolveSingleOptAsOpt} },
    [Options_Subsolveropt]          = { "subsolveropt",        "Subsolver option file number",                                                                                             OptInteger, { .i = 0     } },
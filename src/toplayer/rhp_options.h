@@ -13,14 +13,20 @@ enum rhp_options_enum {
    Options_Display_Timings,
    Options_Dump_Scalar_Models,
    Options_EMPInfoFile,
+   Options_EMPInfo_CacheDir,
    Options_Expensive_Checks,
    Options_GUI,
+   Options_Nash_Iteration_Limit,
+   Options_Nash_Solver,
    Options_Output,
    Options_Output_Presolve_Log,
    Options_Output_Subsolver_Log,
    Options_Pathlib_Name,
    Options_Png_Viewer,
    Options_Presolve,
+   Options_Presolve_Reductions,
+   Options_Presolve_Threads,
+   Options_Profile_File,
    Options_Save_EmpDag,
    Options_Save_OvfDag,
    Options_SolveLink,
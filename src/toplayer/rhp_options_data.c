@@ -45,3 +45,47 @@ void optsingleopt_getdata(const char *const (**strs)[2], unsigned *len)
    *strs = singleopt_names;
    *len = ARRAY_SIZE(singleopt_names);
 }
+
+static const char *const nashsolver_names[][2] = {
+   {"mcp", "Solve the equilibrium as a single MCP"},
+   {"jacobi", "Jacobi best-response iterations over the agents"},
+   {"gauss_seidel", "Gauss-Seidel best-response iterations over the agents"},
+};
+
+const char* optnashsolver_getcurstr(unsigned i)
+{
+   if (i < ARRAY_SIZE(nashsolver_names)) {
+      return nashsolver_names[i][0];
+   }
+
+   return "unknown";
+}
+
+int optnashsolver_getidxfromstr(const char *buf)
+{
+   for (size_t i = 0; i < ARRAY_SIZE(nashsolver_names); ++i) {
+      if (!strcasecmp(buf, nashsolver_names[i][0])) { return (int)i; }
+   }
+
+   return -1;
+}
+
+int optnashsolver_set(struct option *opt, const char *optval)
+{
+   assert(!strcasecmp(opt->name, "nash_solver"));
+
+   int val = optnashsolver_getidxfromstr(optval);
+   if (val >= 0) {
+      opt->value.i = val;
+      return OK;
+   }
+
+   error("%s ERROR: cannot set option %s to value '%s'\n", __func__, opt->name, optval);
+   return Error_WrongOptionValue;
+}
+
+void optnashsolver_getdata(const char *const (**strs)[2], unsigned *len)
+{
+   *strs = nashsolver_names;
+   *len = ARRAY_SIZE(nashsolver_names);
+}
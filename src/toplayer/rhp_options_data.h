@@ -17,4 +17,15 @@ int optsingleopt_set(struct option *optovf_reformulation, const char *optval);
 void optsingleopt_getdata(const char *const (**strs)[2], unsigned *len) NONNULL;
 int optsingleopt_getidxfromstr(const char *buf) NONNULL;
 
+typedef enum {
+   Opt_NashSolverMcp         = 0,
+   Opt_NashSolverJacobi      = 1,
+   Opt_NashSolverGaussSeidel = 2,
+} Opt_NashSolverMethod;
+
+const char* optnashsolver_getcurstr(unsigned i);
+int optnashsolver_set(struct option *opt, const char *optval);
+void optnashsolver_getdata(const char *const (**strs)[2], unsigned *len) NONNULL;
+int optnashsolver_getidxfromstr(const char *buf) NONNULL;
+
 #endif
@@ -3,6 +3,7 @@
 #include "macros.h"
 #include "mdl.h"
 #include "mdl_rhp.h"
+#include "mdl_timings.h"
 #include "mdl_transform.h"
 #include "ovf_transform.h"
 #include "rhp_fwd.h"
@@ -35,6 +36,7 @@ int rhp_reformulate(Model *mdl_user, Model **mdl_reformulated)
    if (ctr_needtransformations(&mdl_user->ctr)) {
 
       double start = get_thrdtime();
+      unsigned span = mdl_prof_begin(mdl_user, "container transformations");
       trace_process("[process] %s model %.*s #%u: container will be transformed:\n"
                     "          - %u flipped equations\n",
                     mdl_fmtargs(mdl_user),
@@ -47,12 +49,15 @@ int rhp_reformulate(Model *mdl_user, Model **mdl_reformulated)
 
       S_CHECK(rmdl_ctr_transform(mdl_reform));
       mdl_user->timings->reformulation.equvar.total = get_thrdtime() - start;
+      mdl_prof_additems(mdl_user, span, mdl_user->ctr.transformations.flipped_equs.size);
+      mdl_prof_end(mdl_user, span);
 
    }
 
    if (empinfo_has_ovf(empinfo)) {
 
       double start = get_thrdtime();
+      unsigned span = mdl_prof_begin(mdl_user, "OVF/CCF reformulations");
 
       pr_info("%s model %.*s #%u: OVF/CCF detected. Performing reformulations\n",
               mdl_fmtargs(mdl_user));
@@ -69,11 +74,13 @@ int rhp_reformulate(Model *mdl_user, Model **mdl_reformulated)
       S_CHECK(ovf_transform(mdl_reform));
 
       mdl_reform->timings->reformulation.CCF.total = get_thrdtime() - start;
+      mdl_prof_end(mdl_user, span);
    }
 
    if (empinfo_has_marginal_vars(&mdl_user->empinfo)) {
 
       double start = get_thrdtime();
+      unsigned span = mdl_prof_begin(mdl_user, "marginal variables");
 
       pr_info("%s model %.*s #%u: Performing marginal (dualvar) transformations.\n",
            mdl_fmtargs(mdl_user));
@@ -89,11 +96,13 @@ int rhp_reformulate(Model *mdl_user, Model **mdl_reformulated)
       S_CHECK(rmdl_marginalVars(mdl_reform));
 
       mdl_user->timings->reformulation.equvar.total = get_thrdtime() - start;
+      mdl_prof_end(mdl_user, span);
     }
 
    if (empdag_needs_transformations(&mdl_user->empinfo.empdag)) {
 
       double start = get_thrdtime();
+      unsigned span = mdl_prof_begin(mdl_user, "EMPDAG transformations");
 
       pr_info("%s model %.*s #%u: Performing EMPDAG transformations.\n",
            mdl_fmtargs(mdl_user));
@@ -110,6 +119,7 @@ int rhp_reformulate(Model *mdl_user, Model **mdl_reformulated)
       S_CHECK(rmdl_empdag_transform(mdl_reform));
 
       mdl_user->timings->reformulation.empdag.total = get_thrdtime() - start;
+      mdl_prof_end(mdl_user, span);
    }
 
    if (mdl_reform) {
@@ -18,6 +18,10 @@
 
 tlsvar u64 pagesize = M_ARENA_COMMIT_SIZE;
 
+/* Allocation statistics of the calling thread, used by the profiler */
+static tlsvar u64 arena_num_allocs = 0;
+static tlsvar u64 arena_allocated_bytes = 0;
+
 #if defined(HAS_UNISTD) && !defined(_WIN32)
 #include <unistd.h>
 #endif
@@ -104,12 +108,27 @@ void* arena_alloc(M_Arena* arena, u64 size)
    memory = arena->memory + arena->allocated_size;
    arena->allocated_size += size;
 
+   arena_num_allocs++;
+   arena_allocated_bytes += size;
+
    MEMORY_UNPOISON(memory, size);
    MEMORY_UNDEF(memory, size);
 
    return memory;
 }
 
+/**
+ * @brief Get the arena allocation statistics of the calling thread
+ *
+ * @param[out] num_allocs  the number of arena allocations
+ * @param[out] bytes       the number of bytes allocated in arenas
+ */
+void arena_stats_get(u64 *num_allocs, u64 *bytes)
+{
+   *num_allocs = arena_num_allocs;
+   *bytes = arena_allocated_bytes;
+}
+
 void* arena_alloc_zero(M_Arena* arena, u64 size)
 {
    void *mem = arena_alloc(arena, size);
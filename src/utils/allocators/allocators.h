@@ -43,6 +43,7 @@ int arena_init(M_Arena* arena);
 int arena_init_sized(M_Arena* arena, u64 max);
 M_Arena* arena_create(u64 max) MALLOC_ATTR(arena_free, 1);
 void arena_clear(M_Arena* arena);
+void arena_stats_get(u64 *num_allocs, u64 *bytes) NONNULL;
 
 /** Arena for temporary objects / workspaces / objects refered by pointers
  *
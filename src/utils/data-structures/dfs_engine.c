@@ -0,0 +1,124 @@
+#include <string.h>
+
+#include "dfs_engine.h"
+#include "macros.h"
+#include "printout.h"
+#include "status.h"
+
+void dfs_engine_init(DfsEngine *dfs, const DfsOps *ops, void *ctx, size_t state_size)
+{
+   assert(ops->pre && ops->next);
+
+   dfs->ops = ops;
+   dfs->ctx = ctx;
+   dfs->state_size = state_size;
+   dfs->len = 0;
+   dfs->max = 0;
+   dfs->max_depth = 0;
+   dfs->frames = NULL;
+   dfs->states = NULL;
+}
+
+void dfs_engine_free(DfsEngine *dfs)
+{
+   FREE(dfs->frames);
+   FREE(dfs->states);
+   dfs->len = dfs->max = 0;
+}
+
+static inline void* dfs_state(DfsEngine *dfs, unsigned i)
+{
+   return &dfs->states[(size_t)i * dfs->state_size];
+}
+
+/* Make sure that there is room for one more frame */
+static int dfs_reserve(DfsEngine *dfs)
+{
+   if (dfs->len < dfs->max) { return OK; }
+
+   unsigned max = MAX(2*dfs->max, 64);
+   REALLOC_(dfs->frames, DfsFrame, max);
+   /* Always allocate something, even for an empty state */
+   REALLOC_(dfs->states, unsigned char, (size_t)max * MAX(dfs->state_size, 1));
+   dfs->max = max;
+
+   return OK;
+}
+
+/**
+ * @brief Run a depth-first traversal from a root
+ *
+ * @param dfs         the DFS engine
+ * @param root_state  the state of the root node
+ *
+ * @return            the return code of the root node
+ */
+int dfs_engine_run(DfsEngine *dfs, const void *root_state)
+{
+   const DfsOps *ops = dfs->ops;
+   void *ctx = dfs->ctx;
+   int rc;
+   bool visit;
+
+   dfs->len = 0;
+   S_CHECK(dfs_reserve(dfs));
+
+   memcpy(dfs_state(dfs, 0), root_state, dfs->state_size);
+   dfs->frames[0] = (DfsFrame){ .pos = 0, .depth = 0 };
+   dfs->len = 1;
+
+   rc = ops->pre(ctx, &dfs->frames[0], dfs_state(dfs, 0), &visit);
+   if (rc != OK || !visit) { dfs->len = 0; return rc; }
+
+   bool returning = false;
+   int rc_child = OK;
+
+   while (dfs->len > 0) {
+      unsigned top = dfs->len-1;
+      DfsFrame *frame = &dfs->frames[top];
+      void *state = dfs_state(dfs, top);
+
+      /* A child has just been processed: its state is still above the top */
+      if (returning) {
+         returning = false;
+         rc = ops->in ? ops->in(ctx, frame, state, dfs_state(dfs, top+1), rc_child)
+                      : rc_child;
+         if (rc != OK) { goto _pop; }
+      }
+
+      S_CHECK(dfs_reserve(dfs));
+      frame = &dfs->frames[top];
+      state = dfs_state(dfs, top);
+
+      bool has_child = false;
+      void *child_state = dfs_state(dfs, top+1);
+      rc = ops->next(ctx, frame, state, &has_child, child_state);
+      if (rc != OK) { goto _pop; }
+
+      if (!has_child) {
+         rc = ops->post ? ops->post(ctx, frame, state) : OK;
+         goto _pop;
+      }
+
+      /* Push the child */
+      unsigned depth = frame->depth + 1;
+      DfsFrame *child = &dfs->frames[top+1];
+      child->pos = 0;
+      child->depth = depth;
+      dfs->len++;
+      dfs->max_depth = MAX(dfs->max_depth, depth);
+
+      rc = ops->pre(ctx, child, child_state, &visit);
+      if (rc == OK && visit) { continue; }
+
+      /* The child does not need to be visited, or failed */
+      top = dfs->len-1;
+
+_pop:
+      dfs->len = top;
+      rc_child = rc;
+      returning = true;
+   }
+
+   return rc_child;
+}
@@ -0,0 +1,61 @@
+#ifndef DFS_ENGINE_H
+#define DFS_ENGINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "compat.h"
+
+/** @file dfs_engine.h
+ *
+ *  @brief Depth-first traversal with an explicit stack
+ *
+ *  The engine only manages the stack: the graph, the visited marks and the
+ *  state carried along the path (depth, path type, ...) are given by the
+ *  hooks. Each frame has a user state of fixed size, which contains at least
+ *  the node. The child state is written by the next hook.
+ *
+ *  The return code of a node is given to the in hook of its parent. Any
+ *  non-zero code returned by a hook stops the processing of the node, which
+ *  returns this code to its parent.
+ */
+
+/** Frame of the DFS stack */
+typedef struct dfs_frame {
+   unsigned pos;         /**< Cursor for the next hook, starts at 0         */
+   unsigned depth;       /**< Depth of the node (0 for the root)             */
+} DfsFrame;
+
+/** Hooks of the DFS */
+typedef struct dfs_ops {
+   /** Called when a node is reached. If *visit is false, the node returns OK
+    * without calling the other hooks */
+   int (*pre)(void *ctx, DfsFrame *frame, void *state, bool *visit);
+   /** Give the next child of the node. Set *has_child to false when done */
+   int (*next)(void *ctx, DfsFrame *frame, void *state, bool *has_child,
+               void *child_state);
+   /** Called after a child has been processed, with its return code. Returns
+    * the code to continue with. Optional: by default, any error is returned */
+   int (*in)(void *ctx, DfsFrame *frame, void *state, const void *child_state,
+             int rc);
+   /** Called once all the children have been processed. Optional */
+   int (*post)(void *ctx, DfsFrame *frame, void *state);
+} DfsOps;
+
+typedef struct dfs_engine {
+   const DfsOps *ops;
+   void *ctx;
+   size_t state_size;
+   unsigned len;
+   unsigned max;
+   unsigned max_depth;   /**< Maximum depth reached since the init */
+   DfsFrame *frames;
+   unsigned char *states;
+} DfsEngine;
+
+void dfs_engine_init(DfsEngine *dfs, const DfsOps *ops, void *ctx,
+                     size_t state_size) NONNULL_AT(1,2);
+void dfs_engine_free(DfsEngine *dfs) NONNULL;
+int dfs_engine_run(DfsEngine *dfs, const void *root_state) NONNULL;
+
+#endif /* DFS_ENGINE_H */
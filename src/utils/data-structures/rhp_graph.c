@@ -3,6 +3,7 @@
 #include <assert.h>
 
 
+#include "dfs_engine.h"
 #include "macros.h"
 #include "mdl.h"
 #include "ovfinfo.h"
@@ -68,9 +69,11 @@ int rhp_graph_gen_set_children(struct rhp_graph_gen *node,
   return OK;
 }
 
-static int rhp_graph_gen_visit(struct rhp_graph_gen * restrict node,
-                               ObjArray * restrict dat)
+static int rhp_graph_gen_pre(void *ctx, DfsFrame *frame, void *state, bool *visit)
 {
+  struct rhp_graph_gen *node = *(struct rhp_graph_gen **)state;
+  *visit = false;
+
   switch (node->state) {
   case InProgress:
     error("%s :: A circular dependency situation has been detected! "
@@ -85,14 +88,7 @@ static int rhp_graph_gen_visit(struct rhp_graph_gen * restrict node,
     * ---------------------------------------------------------------------- */
 
     rhp_graph_gen_dfs_init_node(node);
-
-    for (size_t i = 0; i < node->len; ++i) {
-      S_CHECK(rhp_graph_gen_visit(node->children[i].child, dat));
-    }
-
-    S_CHECK(rhp_obj_add(dat, node->obj));
-    rhp_graph_gen_dfs_fini_node(node);
-
+    *visit = true;
     return OK;
 
   default:
@@ -100,25 +96,59 @@ static int rhp_graph_gen_visit(struct rhp_graph_gen * restrict node,
                        __func__, node->state);
     return Error_RuntimeError;
   }
+}
+
+static int rhp_graph_gen_next(void *ctx, DfsFrame *frame, void *state,
+                              bool *has_child, void *child_state)
+{
+  struct rhp_graph_gen *node = *(struct rhp_graph_gen **)state;
+
+  *has_child = frame->pos < node->len;
+  if (*has_child) {
+    *(struct rhp_graph_gen **)child_state = node->children[frame->pos++].child;
+  }
 
+  return OK;
 }
 
+static int rhp_graph_gen_post(void *ctx, DfsFrame *frame, void *state)
+{
+  struct rhp_graph_gen *node = *(struct rhp_graph_gen **)state;
+  ObjArray *dat = ctx;
+
+  S_CHECK(rhp_obj_add(dat, node->obj));
+  rhp_graph_gen_dfs_fini_node(node);
+
+  return OK;
+}
+
+static const DfsOps rhp_graph_gen_ops = {
+  .pre  = rhp_graph_gen_pre,
+  .next = rhp_graph_gen_next,
+  .post = rhp_graph_gen_post,
+};
+
 int rhp_graph_gen_dfs(struct rhp_graph_gen ** restrict nodes, unsigned n_nodes,
                       ObjArray * restrict dat)
 {
+  int status = OK;
+  DfsEngine dfs;
+  dfs_engine_init(&dfs, &rhp_graph_gen_ops, dat, sizeof(struct rhp_graph_gen *));
+
   for (size_t i = 0; i < n_nodes; ++i) {
     struct rhp_graph_gen *node = nodes[i];
 
     switch (node->state) {
     case NotExplored:
-      S_CHECK(rhp_graph_gen_visit(node, dat));
+      S_CHECK_EXIT(dfs_engine_run(&dfs, &node));
       break;
     case Processed:
       break;
     case InProgress:
       error("%s :: node #%zu is already being processed\n",
                          __func__, i);
-      return Error_RuntimeError;
+      status = Error_RuntimeError;
+      goto _exit;
     default:
       error("%s :: node #%zu has an non-standard state %d\n",
                          __func__, i, node->state);
@@ -126,7 +156,10 @@ int rhp_graph_gen_dfs(struct rhp_graph_gen ** restrict nodes, unsigned n_nodes,
 
   }
 
-  return OK;
+_exit:
+  dfs_engine_free(&dfs);
+
+  return status;
 }
 
 static const char * const nodestyle_ovf  = "style=filled,color=lightblue1";
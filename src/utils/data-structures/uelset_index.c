@@ -0,0 +1,130 @@
+#include <limits.h>
+#include <string.h>
+
+#include "macros.h"
+#include "printout.h"
+#include "status.h"
+#include "uelset_index.h"
+
+void uelset_index_init(UelSetIndex *index, uint8_t dim)
+{
+   index->dim = dim;
+   index->len = 0;
+   index->uel_min = 0;
+   index->range = 0;
+   index->bitmap = NULL;
+   index->mask = 0;
+   index->slots = NULL;
+}
+
+void uelset_index_free(UelSetIndex *index)
+{
+   if (!index) { return; }
+
+   FREE(index->bitmap);
+   FREE(index->slots);
+   index->len = index->range = index->mask = 0;
+}
+
+static int uelset_index_buildbitmap(UelSetIndex *index, unsigned len, const int *uels,
+                                    int uel_min, unsigned range)
+{
+   CALLOC_(index->bitmap, uint64_t, (range + 63) / 64);
+   index->uel_min = uel_min;
+   index->range = range;
+
+   for (unsigned i = 0; i < len; ++i) {
+      unsigned pos = (unsigned)(uels[i] - uel_min);
+      uint64_t bit = UINT64_C(1) << (pos % 64);
+
+      if (!(index->bitmap[pos / 64] & bit)) {
+         index->bitmap[pos / 64] |= bit;
+         index->len++;
+      }
+   }
+
+   return OK;
+}
+
+static int uelset_index_buildhash(UelSetIndex *index, unsigned len, const int *tuples)
+{
+   uint8_t dim = index->dim;
+
+   /* Keep the load factor at most 1/2 */
+   unsigned nslots = 4;
+   while (nslots < 2 * (size_t)len) {
+      if (nslots > UINT_MAX / 2) {
+         error("[uelset_index] ERROR: the set with %u tuples is too large\n", len);
+         return Error_SizeTooLarge;
+      }
+      nslots *= 2;
+   }
+
+   CALLOC_(index->slots, int, (size_t)nslots * dim);
+   index->mask = nslots - 1;
+
+   for (unsigned i = 0; i < len; ++i) {
+      const int *uels = &tuples[(size_t)i * dim];
+
+      for (uint32_t s = uelset_hash(uels, dim) & index->mask; ; s = (s + 1) & index->mask) {
+         int *slot = &index->slots[(size_t)s * dim];
+
+         if (slot[0] == 0) {
+            memcpy(slot, uels, dim * sizeof(int));
+            index->len++;
+            break;
+         }
+
+         if (!memcmp(slot, uels, dim * sizeof(int))) { break; }
+      }
+   }
+
+   return OK;
+}
+
+/**
+ * @brief Build the membership index of a set
+ *
+ * A bitmap is used for one-dimensional sets when it is not larger than the
+ * hash set, that is when the UELs span at most 64 times the cardinality of
+ * the set. Duplicated tuples are allowed.
+ *
+ * @param index   the membership index, initialized with uelset_index_init()
+ * @param len     the number of tuples
+ * @param tuples  the tuples, stored contiguously (len * dim UELs)
+ *
+ * @return        the error code
+ */
+int uelset_index_build(UelSetIndex *index, unsigned len, const int *tuples)
+{
+   uint8_t dim = index->dim;
+
+   if (dim == 0) {
+      errormsg("[uelset_index] ERROR: cannot index a set of dimension 0\n");
+      return Error_InvalidValue;
+   }
+
+   uelset_index_free(index);
+
+   int uel_min = INT_MAX, uel_max = 0;
+   for (size_t i = 0, n = (size_t)len * dim; i < n; ++i) {
+      int uel = tuples[i];
+      if (uel <= 0) {
+         error("[uelset_index] ERROR: invalid UEL %d at position %zu\n", uel, i);
+         return Error_InvalidValue;
+      }
+
+      uel_min = MIN(uel_min, uel);
+      uel_max = MAX(uel_max, uel);
+   }
+
+   if (len == 0) { return OK; }
+
+   unsigned range = (unsigned)(uel_max - uel_min) + 1;
+
+   if (dim == 1 && range / 64 <= len) {
+      return uelset_index_buildbitmap(index, len, tuples, uel_min, range);
+   }
+
+   return uelset_index_buildhash(index, len, tuples);
+}
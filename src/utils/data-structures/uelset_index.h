@@ -0,0 +1,77 @@
+#ifndef UELSET_INDEX_H
+#define UELSET_INDEX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "compat.h"
+
+/** @file uelset_index.h
+ *
+ *  @brief Membership index for sets of UEL tuples
+ *
+ *  The index answers in constant time whether a tuple of UELs belongs to a
+ *  set. One-dimensional sets whose UELs span a range that is small compared
+ *  to their cardinality use a bitmap, all other sets use an open-addressing
+ *  hash set. UELs must be positive.
+ */
+
+/** Membership index of a set of UEL tuples */
+typedef struct uelset_index {
+   uint8_t dim;            /**< Dimension of the tuples                  */
+   unsigned len;           /**< Number of (distinct) tuples              */
+   int uel_min;            /**< Bitmap: smallest UEL                     */
+   unsigned range;         /**< Bitmap: number of bits                   */
+   uint64_t *bitmap;       /**< Bitmap, or NULL                          */
+   unsigned mask;          /**< Hash set: number of slots minus one      */
+   int *slots;             /**< Hash set: dim UELs per slot, 0 if empty  */
+} UelSetIndex;
+
+void uelset_index_init(UelSetIndex *index, uint8_t dim) NONNULL;
+int uelset_index_build(UelSetIndex *index, unsigned len, const int *tuples) NONNULL;
+void uelset_index_free(UelSetIndex *index);
+
+NONNULL static inline uint32_t uelset_hash(const int *uels, uint8_t dim)
+{
+   uint32_t h = 2166136261u;
+   for (uint8_t i = 0; i < dim; ++i) {
+      h = (h ^ (uint32_t)uels[i]) * 16777619u;
+   }
+
+   h ^= h >> 15;
+   h *= 0x2c1b3c6du;
+   h ^= h >> 12;
+
+   return h;
+}
+
+/**
+ * @brief Test whether a tuple belongs to the set
+ *
+ * @param index  the membership index
+ * @param uels   the tuple of UELs
+ *
+ * @return       true if the tuple belongs to the set
+ */
+NONNULL static inline bool uelset_index_has(const UelSetIndex *index, const int *uels)
+{
+   if (index->bitmap) {
+      unsigned pos = (unsigned)uels[0] - (unsigned)index->uel_min;
+      return uels[0] >= index->uel_min && pos < index->range &&
+             (index->bitmap[pos / 64] >> (pos % 64)) & 1;
+   }
+
+   if (!index->slots) { return false; }
+
+   uint8_t dim = index->dim;
+   for (uint32_t s = uelset_hash(uels, dim) & index->mask; ; s = (s + 1) & index->mask) {
+      const int *slot = &index->slots[(size_t)s * dim];
+      if (slot[0] == 0) { return false; }
+
+      uint8_t i = 0;
+      while (i < dim && slot[i] == uels[i]) { i++; }
+      if (i == dim) { return true; }
+   }
+}
+
+#endif
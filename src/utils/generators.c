@@ -3,6 +3,8 @@
 #include "printout.h"
 #include "status.h"
 
+#include <string.h>
+
 
 static int _alloc_gen_data(struct gen_data *gd)
 {
@@ -62,9 +64,128 @@ void generators_dealloc(struct generators *gen)
       FREE(gen->rays.val[i]);
    }
    FREE(gen->rays.val);
+
+   for (unsigned i = 0; i < gen->lines.size; ++i) {
+      FREE(gen->lines.val[i]);
+   }
+   FREE(gen->lines.val);
    FREE(gen);
 }
 
+/* Above this dimension, the 2^dim vertices of a box are not enumerated */
+#define GENERATORS_BOX_MAXDIM 16
+
+/**
+ * @brief Generators of the singleton {pt}
+ *
+ * @param      dim  the dimension of the space
+ * @param      pt   the point
+ * @param[out] gen  the generators
+ *
+ * @return          the error code
+ */
+int generators_point(unsigned dim, const double *pt, struct generators **gen)
+{
+   int status = OK;
+   double *v;
+   struct generators *lgen;
+   A_CHECK(lgen, generators_alloc(dim));
+
+   MALLOC_EXIT(v, double, dim);
+   memcpy(v, pt, dim*sizeof(double));
+
+   S_CHECK_EXIT(generators_add_vertex(lgen, v));
+   *gen = lgen;
+
+   return OK;
+
+_exit:
+   generators_dealloc(lgen);
+   return status;
+}
+
+/**
+ * @brief Generators of the unit simplex { u ≥ 0 : sum_i u_i = 1 }
+ *
+ * The vertices are the elements of the canonical basis.
+ *
+ * @param      dim  the dimension of the space
+ * @param[out] gen  the generators
+ *
+ * @return          the error code
+ */
+int generators_unit_simplex(unsigned dim, struct generators **gen)
+{
+   int status = OK;
+   struct generators *lgen;
+   A_CHECK(lgen, generators_alloc(dim));
+
+   for (unsigned i = 0; i < dim; ++i) {
+      double *v;
+      CALLOC_EXIT(v, double, dim);
+      v[i] = 1.;
+      S_CHECK_EXIT(generators_add_vertex(lgen, v));
+   }
+
+   *gen = lgen;
+
+   return OK;
+
+_exit:
+   generators_dealloc(lgen);
+   return status;
+}
+
+/**
+ * @brief Generators of the box [lb, ub]^dim
+ *
+ * The 2^dim vertices are enumerated: the ith one has ub in the positions
+ * given by the bits set in i. Above GENERATORS_BOX_MAXDIM, the vertices are
+ * not enumerated and gen is set to NULL, so that the caller can fall back to
+ * computing the V-representation.
+ *
+ * @param      dim  the dimension of the space
+ * @param      lb   the lower bound
+ * @param      ub   the upper bound
+ * @param[out] gen  the generators, or NULL if the box has too many vertices
+ *
+ * @return          the error code
+ */
+int generators_box(unsigned dim, double lb, double ub, struct generators **gen)
+{
+   if (dim > GENERATORS_BOX_MAXDIM) {
+      *gen = NULL;
+      return OK;
+   }
+
+   int status = OK;
+   struct generators *lgen;
+   A_CHECK(lgen, generators_alloc(dim));
+
+   size_t n_vertices = ((size_t)1) << dim;
+   lgen->vertices.max = n_vertices;
+   REALLOC_EXIT(lgen->vertices.val, double *, n_vertices);
+
+   for (size_t i = 0; i < n_vertices; ++i) {
+      double *v;
+      MALLOC_EXIT(v, double, dim);
+
+      for (unsigned j = 0; j < dim; ++j) {
+         v[j] = (i >> j) & 1 ? ub : lb;
+      }
+
+      lgen->vertices.val[lgen->vertices.size++] = v;
+   }
+
+   *gen = lgen;
+
+   return OK;
+
+_exit:
+   generators_dealloc(lgen);
+   return status;
+}
+
 int generators_add_vertex(struct generators *gen, double *v)
 {
    S_CHECK(_add_gen_data(&gen->vertices, v));
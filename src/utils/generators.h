@@ -27,6 +27,11 @@ void generators_dealloc(struct generators *gen);
  */
 struct generators* generators_alloc(unsigned space_dim) MALLOC_ATTR(generators_dealloc,1);
 
+/* Closed-form V-representations of common polyhedra */
+int generators_point(unsigned dim, const double *pt, struct generators **gen) NONNULL;
+int generators_unit_simplex(unsigned dim, struct generators **gen) NONNULL;
+int generators_box(unsigned dim, double lb, double ub, struct generators **gen) NONNULL;
+
 int generators_add_vertex(struct generators *gen, double *v ) NONNULL;
 int generators_add_ray(struct generators *gen, double *r ) NONNULL;
 int generators_add_line(struct generators *gen, double *l ) NONNULL;
@@ -36,6 +36,7 @@
 #include <math.h>
 
 #include "macros.h"
+#include "mdl_timings.h"
 #include "rhp_LA.h"
 
 bool logh5_check_gzip(void)
@@ -396,6 +397,43 @@ int logh5_sparse(struct logh5* logger, struct sp_matrix* mat, const char* name)
 }
 
 
+int logh5_callback_stats(struct logh5* logger, const struct callback_stats* stats, const char* name)
+{
+  int result = OK;
+  hid_t loc_id = logger->group > 0 ? logger->group : logger->file;
+  hid_t cb_group = H5Gcreate(loc_id, name, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+  if (cb_group < 0) { return Error_HDF5_IO; }
+
+  const struct { uint64_t val; const char *name; } counters[] = {
+    {stats->calls,   "calls"},
+    {stats->errors,  "errors"},
+    {stats->nnz,     "nnz"},
+    {stats->nlnodes, "nlnodes"},
+    {stats->bytes,   "bytes"},
+  };
+
+  for (unsigned i = 0; i < ARRAY_SIZE(counters); ++i) {
+    int rc = _logh5_scalar_uinteger(counters[i].val, counters[i].name, cb_group);
+    if (rc != OK) { result = rc; }
+  }
+
+  hsize_t dims[1] = {CALLBACK_HIST_LEN};
+  hid_t space = H5Screate_simple(1, dims, NULL);
+  herr_t status = logh5_write_dset(cb_group, "latency_hist_log2_us", H5T_NATIVE_UINT_LEAST64,
+                                   space, (void*)stats->hist);
+  if (status < 0) { result = Error_HDF5_IO; }
+  H5Sclose(space);
+
+  space = H5Screate(H5S_SCALAR);
+  status = logh5_write_dset(cb_group, "wall", H5T_NATIVE_DOUBLE, space, (void*)&stats->wall);
+  if (status < 0) { result = Error_HDF5_IO; }
+  H5Sclose(space);
+
+  if (H5Gclose(cb_group) < 0) { result = Error_HDF5_IO; }
+
+  return result;
+}
+
 int logh5_mat_dense(struct logh5* logger, size_t size0, size_t size1, double* mat, const char* name)
 {
   hid_t loc_id = logger->group > 0 ? logger->group : logger->file;
@@ -499,6 +537,13 @@ int logh5_sparse(struct logh5* logger, struct sp_matrix* mat, const char* name)
 }
 
 
+int logh5_callback_stats(struct logh5* logger, const struct callback_stats* stats, const char* name)
+{
+  errormsg("logh5 :: ReSHOP has been compiled with no HDF5 support!\n");
+  return Error_RuntimeError;
+}
+
+
 int logh5_mat_dense(struct logh5* logger, size_t size0, size_t size1, double* mat, const char* name)
 {
   errormsg("logh5 :: ReSHOP has been compiled with no HDF5 support!\n");
@@ -41,6 +41,7 @@
 
 #endif /* WITH_HDF5 */
 
+struct callback_stats;
 struct sp_matrix;
 
 /** HDF5 logger (for full debug purposes) */
@@ -92,6 +93,14 @@ int logh5_mat_dense(struct logh5* logger, size_t size0, size_t size1, double* ma
 
 int logh5_sparse(struct logh5* logh5, struct sp_matrix* mat, const char* name);
 
+/** Write the statistics of a solver callback in a group
+ * \param logger the struct related to logging
+ * \param stats the statistics of the callback
+ * \param name the name of the group
+ * \return the error code
+ */
+int logh5_callback_stats(struct logh5* logger, const struct callback_stats* stats, const char* name);
+
 int logh5_vec_int32(struct logh5* logger, size_t size, int32_t* vec, const char* name);
 
 int logh5_vec_int64(struct logh5* logger, size_t size, int64_t* vec, const char* name);
@@ -57,6 +57,7 @@ typedef struct {
 } OptChoiceData;
 
 static const OptChoiceData optchoices[] = {
+   { "nash_solver", optnashsolver_set, optnashsolver_getdata, optnashsolver_getcurstr},
    { "ovf_reformulation", optovf_setreformulation, optovf_getreformulationdata, ovf_getreformulationstr},
    { "solve_single_opt_as", optsingleopt_set, optsingleopt_getdata, optsingleopt_getcurstr},
 };
@@ -5,6 +5,7 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "crash_reporter.h"
 
@@ -665,6 +666,28 @@ void rhp_set_printopsdefault(void)
    print_ops.nostdouterr = printops_default.nostdouterr;
 }
 
+/**
+ * @brief Get the printing operators of the current thread
+ *
+ * @return  the printing operators
+ */
+const struct printout_ops* printout_getops(void)
+{
+   return &print_ops;
+}
+
+/**
+ * @brief Set the printing operators of the current thread
+ *
+ * This is used to propagate the printing operators to a worker thread
+ *
+ * @param ops  the printing operators, typically obtained from printout_getops()
+ */
+void printout_setops(const struct printout_ops *ops)
+{
+   memcpy(&print_ops, ops, sizeof(print_ops));
+}
+
 /**
  * @brief Print a fatal error user message
  *
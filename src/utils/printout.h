@@ -18,6 +18,10 @@ void printstr(unsigned mode, const char *str);
 void logging_syncenv(void);
 void set_log_fd(rhpfd_t fd);
 
+struct printout_ops;
+const struct printout_ops* printout_getops(void);
+void printout_setops(const struct printout_ops *ops) NONNULL;
+
 #define error(format, ...)   printout(PO_ERROR, format, __VA_ARGS__)
 #define errormsg(msg)        printstr(PO_ERROR, msg)
 #define errbug(format, ...)  printout(PO_ERROR, format " Please report this as a bug\n", __VA_ARGS__)
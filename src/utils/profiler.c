@@ -0,0 +1,323 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "allocators.h"
+#include "macros.h"
+#include "printout.h"
+#include "profiler.h"
+#include "status.h"
+#include "timings.h"
+
+/** Maximum number of spans recorded by a profiler */
+#define PROF_MAX_SPANS (1U << 20)
+
+/** Aggregated spans for the summary */
+typedef struct {
+   const char *name;        /**< Name of the spans               */
+   unsigned parent;         /**< Parent aggregate                */
+   unsigned count;          /**< Number of spans                 */
+   double wall;             /**< Total wall time                 */
+   double thrd;             /**< Total thread CPU time           */
+   uint64_t allocs;         /**< Total number of allocations     */
+   uint64_t alloc_bytes;    /**< Total bytes allocated           */
+   uint64_t items;          /**< Total number of items           */
+} ProfAggr;
+
+void prof_init(Profiler *prof)
+{
+   prof->len = 0;
+   prof->max = 0;
+   prof->cur = ProfSpanNone;
+   prof->dropped = 0;
+   prof->wall_origin = get_walltime();
+   prof->spans = NULL;
+}
+
+void prof_free(Profiler *prof)
+{
+   FREE(prof->spans);
+   prof->len = prof->max = 0;
+   prof->cur = ProfSpanNone;
+}
+
+/**
+ * @brief Open a span
+ *
+ * The span is a child of the innermost open span. If the span cannot be
+ * recorded, ProfSpanNone is returned, which is a valid argument for the other
+ * functions.
+ *
+ * @param prof  the profiler
+ * @param name  the name of the span. It must outlive the profiler
+ *
+ * @return      the span index
+ */
+unsigned prof_begin(Profiler *prof, const char *name)
+{
+   if (prof->len >= prof->max) {
+      unsigned max = prof->max == 0 ? 64 : 2*prof->max;
+      ProfSpan *spans = prof->len < PROF_MAX_SPANS ?
+                        realloc(prof->spans, MIN(max, PROF_MAX_SPANS)*sizeof(ProfSpan)) : NULL;
+
+      if (!spans) { prof->dropped++; return ProfSpanNone; }
+
+      prof->spans = spans;
+      prof->max = MIN(max, PROF_MAX_SPANS);
+   }
+
+   unsigned idx = prof->len++;
+   ProfSpan *span = &prof->spans[idx];
+   unsigned parent = prof->cur;
+
+   span->name = name;
+   span->parent = parent;
+   span->depth = parent == ProfSpanNone ? 0 : prof->spans[parent].depth + 1;
+   span->closed = false;
+   span->items = 0;
+
+   /* The fields for the durations store the starting values until prof_end() */
+   arena_stats_get(&span->allocs, &span->alloc_bytes);
+   span->thrd = get_thrdtime();
+   span->wall_start = span->wall = get_walltime();
+
+   prof->cur = idx;
+
+   return idx;
+}
+
+NONNULL static void prof_close(ProfSpan *span, double wall, double thrd)
+{
+   uint64_t allocs, alloc_bytes;
+   arena_stats_get(&allocs, &alloc_bytes);
+
+   span->wall = wall - span->wall_start;
+   span->thrd = thrd - span->thrd;
+   span->allocs = allocs - span->allocs;
+   span->alloc_bytes = alloc_bytes - span->alloc_bytes;
+   span->closed = true;
+}
+
+/**
+ * @brief Close a span
+ *
+ * The descendants of the span that are still open, for instance because of an
+ * early return on error, are closed as well.
+ *
+ * @param prof  the profiler
+ * @param span  the span index
+ */
+void prof_end(Profiler *prof, unsigned span)
+{
+   if (span == ProfSpanNone || span >= prof->len || prof->spans[span].closed) { return; }
+
+   double wall = get_walltime(), thrd = get_thrdtime();
+
+   unsigned cur = prof->cur;
+   while (cur != ProfSpanNone && cur != span) {
+      prof_close(&prof->spans[cur], wall, thrd);
+      cur = prof->spans[cur].parent;
+   }
+
+   prof_close(&prof->spans[span], wall, thrd);
+   prof->cur = prof->spans[span].parent;
+}
+
+void prof_additems(Profiler *prof, unsigned span, uint64_t nitems)
+{
+   if (span == ProfSpanNone || span >= prof->len) { return; }
+
+   prof->spans[span].items += nitems;
+}
+
+static void json_putstr(FILE *f, const char *str)
+{
+   fputc('"', f);
+   for (const char *c = str; *c; ++c) {
+      if (*c == '"' || *c == '\\') { fputc('\\', f); }
+      if ((unsigned char)*c < 0x20) { fprintf(f, "\\u%04x", (unsigned char)*c); continue; }
+      fputc(*c, f);
+   }
+   fputc('"', f);
+}
+
+/**
+ * @brief Write the spans in the Chrome trace event format
+ *
+ * The output can be loaded in chrome://tracing or https://ui.perfetto.dev.
+ * Spans that are still open are not written.
+ *
+ * @param prof  the profiler
+ * @param f     the output file
+ *
+ * @return      the error code
+ */
+int prof_write_chrome(const Profiler *prof, FILE *f)
+{
+   bool first = true;
+
+   fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", f);
+
+   for (unsigned i = 0, len = prof->len; i < len; ++i) {
+      const ProfSpan *span = &prof->spans[i];
+      if (!span->closed) { continue; }
+
+      fputs(first ? "\n" : ",\n", f);
+      first = false;
+
+      fputs("{\"name\":", f);
+      json_putstr(f, span->name);
+      fprintf(f, ",\"cat\":\"reshop\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,"
+              "\"dur\":%.3f,\"args\":{\"thread_us\":%.3f,\"allocs\":%llu,"
+              "\"alloc_bytes\":%llu,\"items\":%llu}}",
+              (span->wall_start - prof->wall_origin)*1e6, span->wall*1e6, span->thrd*1e6,
+              (unsigned long long)span->allocs, (unsigned long long)span->alloc_bytes,
+              (unsigned long long)span->items);
+   }
+
+   fputs("\n]}\n", f);
+
+   return ferror(f) ? Error_SystemError : OK;
+}
+
+/**
+ * @brief Write the spans as a flat CSV table
+ *
+ * Spans that are still open are not written.
+ *
+ * @param prof  the profiler
+ * @param f     the output file
+ *
+ * @return      the error code
+ */
+int prof_write_csv(const Profiler *prof, FILE *f)
+{
+   fputs("id,parent,depth,name,start,wall,thread,allocs,alloc_bytes,items\n", f);
+
+   for (unsigned i = 0, len = prof->len; i < len; ++i) {
+      const ProfSpan *span = &prof->spans[i];
+      if (!span->closed) { continue; }
+
+      if (span->parent == ProfSpanNone) {
+         fprintf(f, "%u,,", i);
+      } else {
+         fprintf(f, "%u,%u,", i, span->parent);
+      }
+
+      fprintf(f, "%u,\"%s\",%.9f,%.9f,%.9f,%llu,%llu,%llu\n", span->depth, span->name,
+              span->wall_start - prof->wall_origin, span->wall, span->thrd,
+              (unsigned long long)span->allocs, (unsigned long long)span->alloc_bytes,
+              (unsigned long long)span->items);
+   }
+
+   return ferror(f) ? Error_SystemError : OK;
+}
+
+/**
+ * @brief Write the spans to a file
+ *
+ * The format is CSV if the filename ends with ".csv", and Chrome trace JSON
+ * otherwise.
+ *
+ * @param prof   the profiler
+ * @param fname  the filename
+ *
+ * @return       the error code
+ */
+int prof_write(const Profiler *prof, const char *fname)
+{
+   FILE *f = fopen(fname, "w");
+   if (!f) {
+      error("[profiler] ERROR: could not open file '%s' for writing\n", fname);
+      return Error_FileOpenFailed;
+   }
+
+   size_t len = strlen(fname);
+   bool csv = len >= 4 && !strcmp(&fname[len-4], ".csv");
+
+   int status = csv ? prof_write_csv(prof, f) : prof_write_chrome(prof, f);
+
+   if (fclose(f) && status == OK) { status = Error_SystemError; }
+
+   if (status != OK) {
+      error("[profiler] ERROR: could not write the profile to '%s'\n", fname);
+   }
+
+   return status;
+}
+
+static void prof_print_aggr(const ProfAggr *aggrs, unsigned naggrs, unsigned parent,
+                            unsigned ident, unsigned mode)
+{
+   for (unsigned i = 0; i < naggrs; ++i) {
+      const ProfAggr *a = &aggrs[i];
+      if (a->parent != parent) { continue; }
+
+      printout(mode, "%*s%-*s %6u %10.3f %10.3f %10llu %12llu %10llu\n", ident, "",
+               MAX(36 - (int)ident, 1), a->name, a->count, a->wall, a->thrd,
+               (unsigned long long)a->allocs, (unsigned long long)a->alloc_bytes,
+               (unsigned long long)a->items);
+
+      prof_print_aggr(aggrs, naggrs, i, ident + 2, mode);
+   }
+}
+
+/**
+ * @brief Print a summary of the spans
+ *
+ * Closed spans with the same name and the same chain of parent names are
+ * aggregated.
+ *
+ * @param prof  the profiler
+ * @param mode  the print mode
+ */
+void prof_print_summary(const Profiler *prof, unsigned mode)
+{
+   unsigned len = prof->len, naggrs = 0;
+   if (len == 0) { return; }
+
+   ProfAggr *aggrs = NULL;
+   unsigned *span2aggr = NULL;
+   MALLOC_EXIT_NULL(aggrs, ProfAggr, len);
+   MALLOC_EXIT_NULL(span2aggr, unsigned, len);
+
+   for (unsigned i = 0; i < len; ++i) {
+      const ProfSpan *span = &prof->spans[i];
+      span2aggr[i] = ProfSpanNone;
+      if (!span->closed) { continue; }
+
+      /* The parent of a span is always recorded before it */
+      unsigned parent = span->parent == ProfSpanNone ? ProfSpanNone : span2aggr[span->parent];
+      if (span->parent != ProfSpanNone && parent == ProfSpanNone) { continue; }
+
+      unsigned a = 0;
+      for (; a < naggrs; ++a) {
+         if (aggrs[a].parent == parent && !strcmp(aggrs[a].name, span->name)) { break; }
+      }
+
+      if (a == naggrs) {
+         aggrs[naggrs++] = (ProfAggr){.name = span->name, .parent = parent};
+      }
+
+      ProfAggr *aggr = &aggrs[a];
+      aggr->count++;
+      aggr->wall += span->wall;
+      aggr->thrd += span->thrd;
+      aggr->allocs += span->allocs;
+      aggr->alloc_bytes += span->alloc_bytes;
+      aggr->items += span->items;
+      span2aggr[i] = a;
+   }
+
+   printout(mode, "\nProfile (times in sec)\n%-36s %6s %10s %10s %10s %12s %10s\n",
+            "Phase", "#", "wall", "thread", "allocs", "alloc bytes", "items");
+
+   prof_print_aggr(aggrs, naggrs, ProfSpanNone, 0, mode);
+
+   if (prof->dropped > 0) {
+      printout(mode, "%u spans were not recorded\n", prof->dropped);
+   }
+
+_exit:
+   FREE(aggrs);
+   FREE(span2aggr);
+}
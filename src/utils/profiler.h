@@ -0,0 +1,62 @@
+#ifndef RHP_PROFILER_H
+#define RHP_PROFILER_H
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "rhp_compiler_defines.h"
+
+/** @file profiler.h
+ *
+ *  @brief Span-based profiler for the processing phases of a model
+ *
+ *  A span is a named phase, opened with prof_begin() and closed with
+ *  prof_end(). Spans nest: a span opened while another one is open becomes
+ *  its child. For each span, the wall and thread CPU time, the number of arena
+ *  allocations and a user-defined number of items are recorded.
+ *
+ *  A profiler is not thread-safe: spans must be recorded by the thread
+ *  processing the model.
+ */
+
+#define ProfSpanNone UINT_MAX
+
+/** Recorded span */
+typedef struct prof_span {
+   const char *name;        /**< Name of the span (not owned)              */
+   unsigned parent;         /**< Parent span, or ProfSpanNone              */
+   unsigned depth;          /**< Nesting depth                             */
+   bool closed;             /**< True if the span has been closed          */
+   double wall_start;       /**< Wall time at the start                    */
+   double wall;             /**< Wall time duration                        */
+   double thrd;             /**< Thread CPU time duration                  */
+   uint64_t allocs;         /**< Number of arena allocations               */
+   uint64_t alloc_bytes;    /**< Bytes allocated in arenas                 */
+   uint64_t items;          /**< Number of items processed                 */
+} ProfSpan;
+
+/** Profiler */
+typedef struct profiler {
+   unsigned len;            /**< Number of recorded spans                  */
+   unsigned max;            /**< Size of the spans array                   */
+   unsigned cur;            /**< Innermost open span, or ProfSpanNone      */
+   unsigned dropped;        /**< Number of spans that were not recorded    */
+   double wall_origin;      /**< Wall time origin for the exports          */
+   ProfSpan *spans;         /**< Spans, in order of creation               */
+} Profiler;
+
+void prof_init(Profiler *prof) NONNULL;
+void prof_free(Profiler *prof) NONNULL;
+
+unsigned prof_begin(Profiler *prof, const char *name) NONNULL;
+void prof_end(Profiler *prof, unsigned span) NONNULL;
+void prof_additems(Profiler *prof, unsigned span, uint64_t nitems) NONNULL;
+
+int prof_write_chrome(const Profiler *prof, FILE *f) NONNULL;
+int prof_write_csv(const Profiler *prof, FILE *f) NONNULL;
+int prof_write(const Profiler *prof, const char *fname) NONNULL;
+void prof_print_summary(const Profiler *prof, unsigned mode) NONNULL;
+
+#endif
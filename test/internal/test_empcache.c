@@ -0,0 +1,289 @@
+#include "reshop_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "empinterp.h"
+#include "empinterp_cache.h"
+#include "lequ.h"
+#include "reshop.h"
+#include "status.h"
+
+/* ---------------------------------------------------------------------------
+ * On-disk cache of the global table of the EMP interpreter:
+ * - a saved table is loaded back identically
+ * - the cache is disabled without a cache directory
+ * - a corrupt, truncated or stale cache file is rejected and leaves the global
+ *   table empty
+ *
+ * Any file can stand for the GMD file: the cache only hashes its content.
+ * --------------------------------------------------------------------------- */
+
+#define GMD_FNAME   "empcache_test.gdx"
+#define CACHEDIR    "."
+
+#define CHK(EXPR) { int rc_ = (EXPR); if (rc_ != OK) { \
+   (void)fprintf(stderr, "ERROR: %s failed with %s\n", #EXPR, rhp_status_descr(rc_)); \
+   return rc_; } }
+
+#define EXPECT(COND, ...) { if (!(COND)) { \
+   (void)fprintf(stderr, "ERROR line %d: %s: ", __LINE__, #COND); \
+   (void)fprintf(stderr, __VA_ARGS__); (void)fputc('\n', stderr); \
+   return Error_RuntimeError; } }
+
+static void globals_init(CompilerGlobals *globals)
+{
+   namedints_init(&globals->sets);
+   namedscalar_init(&globals->scalars);
+   namedvec_init(&globals->vectors);
+}
+
+static void globals_free(CompilerGlobals *globals)
+{
+   namedints_freeall(&globals->sets);
+   namedscalar_free(&globals->scalars);
+   namedvec_freeall(&globals->vectors);
+}
+
+static int globals_fill(CompilerGlobals *globals)
+{
+   int uels[] = { 3, 1, 4, 100000 };
+   IntArray set;
+
+   rhp_int_init(&set);
+   for (unsigned i = 0; i < 4; ++i) { CHK(rhp_int_add(&set, uels[i])); }
+   CHK(namedints_add(&globals->sets, set, strdup("i")));
+
+   rhp_int_init(&set);
+   CHK(namedints_add(&globals->sets, set, strdup("empty")));
+
+   CHK(namedscalar_add(&globals->scalars, 2.5, strdup("alpha")));
+   CHK(namedscalar_add(&globals->scalars, -1e300, strdup("beta")));
+
+   Lequ v;
+   lequ_init(&v);
+   CHK(lequ_reserve(&v, 3));
+   for (unsigned i = 0; i < 3; ++i) {
+      v.vis[i] = uels[i];
+      v.coeffs[i] = 0.5 * (double)i - 1.;
+   }
+   v.len = 3;
+   CHK(namedvec_add(&globals->vectors, v, strdup("p")));
+
+   return OK;
+}
+
+static int globals_equal(const CompilerGlobals *a, const CompilerGlobals *b)
+{
+   EXPECT(a->sets.len == b->sets.len, "%u vs %u sets", a->sets.len, b->sets.len);
+   for (unsigned i = 0; i < a->sets.len; ++i) {
+      const IntArray *sa = &a->sets.list[i], *sb = &b->sets.list[i];
+      EXPECT(!strcmp(a->sets.names[i], b->sets.names[i]), "set %u", i);
+      EXPECT(sa->len == sb->len, "set %s: %u vs %u UELs", a->sets.names[i], sa->len, sb->len);
+      EXPECT(sa->len == 0 || !memcmp(sa->arr, sb->arr, sa->len * sizeof(int)),
+             "set %s", a->sets.names[i]);
+   }
+
+   EXPECT(a->scalars.len == b->scalars.len, "%u vs %u scalars", a->scalars.len,
+          b->scalars.len);
+   for (unsigned i = 0; i < a->scalars.len; ++i) {
+      EXPECT(!strcmp(a->scalars.names[i], b->scalars.names[i]), "scalar %u", i);
+      EXPECT(a->scalars.list[i] == b->scalars.list[i], "scalar %s", a->scalars.names[i]);
+   }
+
+   EXPECT(a->vectors.len == b->vectors.len, "%u vs %u vectors", a->vectors.len,
+          b->vectors.len);
+   for (unsigned i = 0; i < a->vectors.len; ++i) {
+      const Lequ *va = &a->vectors.list[i], *vb = &b->vectors.list[i];
+      EXPECT(!strcmp(a->vectors.names[i], b->vectors.names[i]), "vector %u", i);
+      EXPECT(va->len == vb->len, "vector %s", a->vectors.names[i]);
+      EXPECT(!memcmp(va->vis, vb->vis, va->len * sizeof(rhp_idx)) &&
+             !memcmp(va->coeffs, vb->coeffs, va->len * sizeof(double)),
+             "vector %s", a->vectors.names[i]);
+   }
+
+   return OK;
+}
+
+static int write_file(const char *fname, const void *data, size_t len)
+{
+   FILE *f = fopen(fname, "wb");
+   if (!f) { perror("fopen"); return Error_FileOpenFailed; }
+
+   size_t n = len > 0 ? fwrite(data, 1, len, f) : 0;
+   if (fclose(f) || n != len) { return Error_SystemError; }
+
+   return OK;
+}
+
+static int read_file(const char *fname, unsigned char **data, size_t *len)
+{
+   FILE *f = fopen(fname, "rb");
+   if (!f) { perror("fopen"); return Error_FileOpenFailed; }
+
+   size_t max = 1024, n = 0, nread;
+   unsigned char *buf = malloc(max);
+
+   while (buf && (nread = fread(&buf[n], 1, max - n, f)) > 0) {
+      n += nread;
+      if (n == max) {
+         max *= 2;
+         unsigned char *buf_ = realloc(buf, max);
+         if (!buf_) { free(buf); }
+         buf = buf_;
+      }
+   }
+   fclose(f);
+
+   if (!buf) { return Error_InsufficientMemory; }
+
+   *data = buf;
+   *len = n;
+
+   return OK;
+}
+
+/* Load the cache into a fresh interpreter and check whether it was accepted */
+static int load(EmpInterpCache *cache, Interpreter *interp, bool expected)
+{
+   bool loaded;
+   globals_init(&interp->globals);
+   CHK(empcache_load(cache, interp, &loaded));
+   EXPECT(loaded == expected, "the cache file was %s", loaded ? "accepted" : "rejected");
+
+   if (!loaded) {
+      EXPECT(interp->globals.sets.len == 0 && interp->globals.scalars.len == 0 &&
+             interp->globals.vectors.len == 0, "the global table was modified");
+   }
+
+   return OK;
+}
+
+static int test_roundtrip(Interpreter *ref, Interpreter *interp)
+{
+   EmpInterpCache cache;
+
+   /* Disabled cache */
+   empcache_init(&cache, "", GMD_FNAME);
+   EXPECT(!cache.fname, "the cache should be disabled");
+   CHK(empcache_save(&cache, ref));
+   CHK(load(&cache, interp, false));
+   globals_free(&interp->globals);
+   empcache_free(&cache);
+
+   empcache_init(&cache, CACHEDIR, GMD_FNAME);
+   EXPECT(cache.fname, "the cache should be enabled");
+
+   /* No file yet */
+   CHK(load(&cache, interp, false));
+   globals_free(&interp->globals);
+
+   CHK(empcache_save(&cache, ref));
+   CHK(load(&cache, interp, true));
+   int status = globals_equal(&ref->globals, &interp->globals);
+   globals_free(&interp->globals);
+
+   empcache_free(&cache);
+
+   return status;
+}
+
+static int test_corrupt(Interpreter *interp)
+{
+   EmpInterpCache cache;
+   unsigned char *data = NULL;
+   size_t len;
+   int status = OK;
+
+   empcache_init(&cache, CACHEDIR, GMD_FNAME);
+   EXPECT(cache.fname, "the cache should be enabled");
+   S_CHECK_EXIT(read_file(cache.fname, &data, &len));
+
+   /* Header fields: magic, version, key, payload size */
+   size_t offsets[] = { 0, 8, 16, 24 };
+   for (unsigned i = 0; i < 4; ++i) {
+      data[offsets[i]] ^= 0x5a;
+      S_CHECK_EXIT(write_file(cache.fname, data, len));
+      S_CHECK_EXIT(load(&cache, interp, false));
+      globals_free(&interp->globals);
+      data[offsets[i]] ^= 0x5a;
+   }
+
+   /* Payload: a UEL and the last coefficient of the vector */
+   data[len - 30] ^= 0x01;
+   S_CHECK_EXIT(write_file(cache.fname, data, len));
+   S_CHECK_EXIT(load(&cache, interp, false));
+   globals_free(&interp->globals);
+   data[len - 30] ^= 0x01;
+
+   data[len - 1] ^= 0x80;
+   S_CHECK_EXIT(write_file(cache.fname, data, len));
+   S_CHECK_EXIT(load(&cache, interp, false));
+   globals_free(&interp->globals);
+   data[len - 1] ^= 0x80;
+
+   /* Truncated file, trailing garbage, empty file */
+   S_CHECK_EXIT(write_file(cache.fname, data, len - 1));
+   S_CHECK_EXIT(load(&cache, interp, false));
+   globals_free(&interp->globals);
+
+   S_CHECK_EXIT(write_file(cache.fname, data, len));
+   FILE *f = fopen(cache.fname, "ab");
+   if (!f || fputc(0, f) == EOF || fclose(f)) { status = Error_SystemError; goto _exit; }
+   S_CHECK_EXIT(load(&cache, interp, false));
+   globals_free(&interp->globals);
+
+   S_CHECK_EXIT(write_file(cache.fname, data, 0));
+   S_CHECK_EXIT(load(&cache, interp, false));
+   globals_free(&interp->globals);
+
+   /* The original file is still valid */
+   S_CHECK_EXIT(write_file(cache.fname, data, len));
+   S_CHECK_EXIT(load(&cache, interp, true));
+   globals_free(&interp->globals);
+
+   /* A cache file for another GMD file, renamed to the one of this GMD */
+   EmpInterpCache other;
+   char gmd2[] = "another gmd file";
+   S_CHECK_EXIT(write_file(GMD_FNAME, gmd2, sizeof(gmd2)));
+   empcache_init(&other, CACHEDIR, GMD_FNAME);
+   EXPECT(other.fname && strcmp(other.fname, cache.fname), "the key did not change");
+   if (rename(cache.fname, other.fname)) { perror("rename"); status = Error_SystemError; }
+   else { status = load(&other, interp, false); }
+   globals_free(&interp->globals);
+   remove(other.fname);
+   empcache_free(&other);
+
+_exit:
+   remove(cache.fname);
+   empcache_free(&cache);
+   free(data);
+
+   return status;
+}
+
+int main(void)
+{
+   int status = OK;
+   Interpreter *ref = calloc(1, sizeof(Interpreter));
+   Interpreter *interp = calloc(1, sizeof(Interpreter));
+   if (!ref || !interp) { free(ref); free(interp); return EXIT_FAILURE; }
+
+   globals_init(&ref->globals);
+
+   char gmd[] = "stands for the content of a GMD file";
+   S_CHECK_EXIT(write_file(GMD_FNAME, gmd, sizeof(gmd)));
+
+   S_CHECK_EXIT(globals_fill(&ref->globals));
+   S_CHECK_EXIT(test_roundtrip(ref, interp));
+   S_CHECK_EXIT(test_corrupt(interp));
+
+_exit:
+   remove(GMD_FNAME);
+   globals_free(&ref->globals);
+   free(ref);
+   free(interp);
+
+   return status == OK ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,252 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "empdag.h"
+#include "empdag_alg.h"
+#include "mathprgm.h"
+#include "mdl.h"
+#include "reshop.h"
+#include "status.h"
+
+/* ---------------------------------------------------------------------------
+ * EMPDAG analysis of a Nash equilibrium where an MP uses several variables of
+ * another MP
+ *
+ *   MP(a):  min  x + y1 + y2 + x^2    over x
+ *   MP(b):  min  y1^2 + y2^2 - x y1   over y1, y2
+ *
+ * The analysis is performed twice: the second run reuses the results of the
+ * first one for the MPs that did not change.
+ *
+ * Then MPs are modified without changing the size of the container, and the
+ * incremental analysis is compared with a full one:
+ * - X and Y2 change owner in the Nash equilibrium
+ * - in a VF chain MP(p) -> MP(c), the variables of the 2 MPs are swapped, or
+ *   the variable of MP(c) is added to the objective of MP(p). Both are errors
+ * --------------------------------------------------------------------------- */
+
+#define CHK(EXPR) { int rc_ = (EXPR); if (rc_ != OK) { \
+   (void)fprintf(stderr, "ERROR: %s failed with %s\n", #EXPR, rhp_status_descr(rc_)); \
+   return rc_; } }
+
+#define CHK_NULL(EXPR) { if (!(EXPR)) { \
+   (void)fprintf(stderr, "ERROR: %s failed\n", #EXPR); \
+   return Error_RuntimeError; } }
+
+enum { X, Y1, Y2, NVARS };
+
+static int build_nash(Model *mdl)
+{
+   rhp_idx vi, ei;
+   unsigned row[2], col[2];
+   double coeffs[2] = { 1., 1. };
+
+   for (unsigned i = 0; i < NVARS; ++i) {
+      CHK(rhp_add_var(mdl, &vi));
+   }
+
+   struct rhp_nash_equilibrium *nash = rhp_empdag_newnash(mdl);
+   CHK_NULL(nash);
+   CHK(rhp_empdag_rootsetnash(mdl, nash));
+
+   struct rhp_mathprgm *mp_a = rhp_empdag_newmp(mdl, RHP_MIN);
+   CHK_NULL(mp_a);
+   CHK(rhp_mp_addvar(mp_a, X));
+
+   CHK(rhp_add_func(mdl, &ei));
+   CHK(rhp_equ_addnewlvar(mdl, ei, X, 1.));
+   CHK(rhp_equ_addnewlvar(mdl, ei, Y1, 1.));
+   CHK(rhp_equ_addnewlvar(mdl, ei, Y2, 1.));
+   row[0] = col[0] = X;
+   CHK(rhp_equ_addquadabsolute(mdl, ei, 1, row, col, coeffs, 1.));
+   CHK(rhp_mp_setobjequ(mp_a, ei));
+   CHK(rhp_empdag_nashaddmp(mdl, nash, mp_a));
+
+   struct rhp_mathprgm *mp_b = rhp_empdag_newmp(mdl, RHP_MIN);
+   CHK_NULL(mp_b);
+   CHK(rhp_mp_addvar(mp_b, Y1));
+   CHK(rhp_mp_addvar(mp_b, Y2));
+
+   CHK(rhp_add_func(mdl, &ei));
+   row[0] = col[0] = Y1;
+   row[1] = col[1] = Y2;
+   CHK(rhp_equ_addquadabsolute(mdl, ei, 2, row, col, coeffs, 1.));
+   row[0] = X; col[0] = Y1;
+   CHK(rhp_equ_addquadabsolute(mdl, ei, 1, row, col, coeffs, -1.));
+   CHK(rhp_mp_setobjequ(mp_b, ei));
+   CHK(rhp_empdag_nashaddmp(mdl, nash, mp_b));
+
+   return OK;
+}
+
+static int mp_movevar(MathPrgm *mp_src, MathPrgm *mp_dst, rhp_idx vi)
+{
+   CHK(mp_rm_var(mp_src, vi));
+   CHK(mp_addvar(mp_dst, vi));
+
+   return OK;
+}
+
+/* Analyze again, then from scratch, and compare the results */
+static int check_incremental(Model *mdl, const char *name)
+{
+   EmpDag *empdag = &mdl->empinfo.empdag;
+   unsigned num_nodes = empdag->mps.len + empdag->nashs.len;
+   unsigned *res;
+   int status = OK;
+
+   MALLOC_(res, unsigned, 3*num_nodes);
+
+   int status_inc = empdag_analysis(empdag);
+
+   for (unsigned i = 0; i < num_nodes && status_inc == OK; ++i) {
+      daguid_t uid = i < empdag->mps.len ? mpid2uid(i) : nashid2uid(i - empdag->mps.len);
+      S_CHECK_EXIT(empdag_analysis_getnode(empdag, uid, &res[3*i], &res[3*i+1], &res[3*i+2]));
+   }
+
+   empdag_analysis_cache_free(&empdag->analysis_cache);
+   int status_full = empdag_analysis(empdag);
+
+   if ((status_inc == OK) != (status_full == OK)) {
+      (void)fprintf(stderr, "ERROR: %s: the incremental analysis returned %s, the full "
+                    "one %s\n", name, rhp_status_descr(status_inc),
+                    rhp_status_descr(status_full));
+      status = Error_RuntimeError;
+      goto _exit;
+   }
+
+   for (unsigned i = 0; i < num_nodes && status_full == OK; ++i) {
+      daguid_t uid = i < empdag->mps.len ? mpid2uid(i) : nashid2uid(i - empdag->mps.len);
+      unsigned level, preorder, postorder;
+      S_CHECK_EXIT(empdag_analysis_getnode(empdag, uid, &level, &preorder, &postorder));
+
+      if (level != res[3*i] || preorder != res[3*i+1] || postorder != res[3*i+2]) {
+         (void)fprintf(stderr, "ERROR: %s: node #%u differs between the incremental "
+                       "and the full analysis\n", name, i);
+         status = Error_RuntimeError;
+         goto _exit;
+      }
+   }
+
+_exit:
+   FREE(res);
+
+   return status;
+}
+
+static int test_nash_modified(Model *mdl)
+{
+   MathPrgm *mp_a = mdl->empinfo.empdag.mps.arr[0], *mp_b = mdl->empinfo.empdag.mps.arr[1];
+
+   CHK(mp_movevar(mp_a, mp_b, X));
+   CHK(mp_movevar(mp_b, mp_a, Y2));
+   CHK(check_incremental(mdl, "nash"));
+   CHK_NULL(mdl->empinfo.empdag.analysis_cache);
+
+   return OK;
+}
+
+/* MP(p): min x_p + ...  over x_p,  MP(c): min x_c + x_p  over x_c */
+static int build_VFchain(Model *mdl, MathPrgm **mp_p, MathPrgm **mp_c, rhp_idx *vi_p,
+                         rhp_idx *vi_c, rhp_idx *ei_p)
+{
+   rhp_idx ei_c;
+   struct rhp_empdag_arcVF *arcVF;
+
+   CHK(rhp_add_var(mdl, vi_p));
+   CHK(rhp_add_var(mdl, vi_c));
+
+   *mp_p = rhp_empdag_newmp(mdl, RHP_MIN);
+   CHK_NULL(*mp_p);
+   CHK(rhp_mp_addvar(*mp_p, *vi_p));
+   CHK(rhp_add_func(mdl, ei_p));
+   CHK(rhp_equ_addnewlvar(mdl, *ei_p, *vi_p, 1.));
+   CHK(rhp_mp_setobjequ(*mp_p, *ei_p));
+   CHK(rhp_empdag_rootsetmp(mdl, *mp_p));
+
+   *mp_c = rhp_empdag_newmp(mdl, RHP_MIN);
+   CHK_NULL(*mp_c);
+   CHK(rhp_mp_addvar(*mp_c, *vi_c));
+   CHK(rhp_add_func(mdl, &ei_c));
+   CHK(rhp_equ_addnewlvar(mdl, ei_c, *vi_c, 1.));
+   CHK(rhp_equ_addnewlvar(mdl, ei_c, *vi_p, 1.));
+   CHK(rhp_mp_setobjequ(*mp_c, ei_c));
+
+   CHK_NULL(arcVF = rhp_arcVF_new());
+   int rc = rhp_arcVF_init(arcVF, *ei_p);
+   if (rc == OK) { rc = rhp_empdag_mpaddmpVF(mdl, *mp_p, *mp_c, arcVF); }
+   rhp_arcVF_free(arcVF);
+
+   return rc;
+}
+
+static int test_VFchain_modified(bool swap)
+{
+   int status = OK;
+   MathPrgm *mp_p, *mp_c;
+   rhp_idx vi_p, vi_c, ei_p;
+   const char *name = swap ? "VF chain with swapped variables" : "VF chain with a new term";
+
+   Model *mdl = rhp_mdl_new(RhpBackendReSHOP);
+   CHK_NULL(mdl);
+
+   S_CHECK_EXIT(build_VFchain(mdl, &mp_p, &mp_c, &vi_p, &vi_c, &ei_p));
+   S_CHECK_EXIT(mdl_checkmetadata(mdl));
+   S_CHECK_EXIT(empdag_analysis(&mdl->empinfo.empdag));
+
+   if (swap) {
+      S_CHECK_EXIT(mp_movevar(mp_p, mp_c, vi_p));
+      S_CHECK_EXIT(mp_movevar(mp_c, mp_p, vi_c));
+   } else {
+      S_CHECK_EXIT(rhp_equ_addnewlvar(mdl, ei_p, vi_c, 1.));
+   }
+
+   S_CHECK_EXIT(check_incremental(mdl, name));
+
+   if (mdl->empinfo.empdag.analysis_cache) {
+      (void)fprintf(stderr, "ERROR: %s: the analysis should have failed\n", name);
+      status = Error_RuntimeError;
+   }
+
+_exit:
+   rhp_mdl_free(mdl);
+
+   return status;
+}
+
+int main(void)
+{
+   int status = OK;
+   Model *mdl = rhp_mdl_new(RhpBackendReSHOP);
+   if (!mdl) { return EXIT_FAILURE; }
+
+   S_CHECK_EXIT(build_nash(mdl));
+   S_CHECK_EXIT(mdl_checkmetadata(mdl));
+
+   EmpDag *empdag = &mdl->empinfo.empdag;
+
+   for (unsigned i = 0; i < 2; ++i) {
+      status = empdag_analysis(empdag);
+      if (status != OK) {
+         (void)fprintf(stderr, "ERROR: EMPDAG analysis #%u failed with %s\n", i+1,
+                       rhp_status_descr(status));
+         goto _exit;
+      }
+
+      if (!empdag->analysis_cache) {
+         (void)fprintf(stderr, "ERROR: EMPDAG analysis #%u did not keep its results\n",
+                       i+1);
+         status = Error_RuntimeError;
+         goto _exit;
+      }
+   }
+
+   S_CHECK_EXIT(test_nash_modified(mdl));
+   S_CHECK_EXIT(test_VFchain_modified(true));
+   S_CHECK_EXIT(test_VFchain_modified(false));
+
+_exit:
+   rhp_mdl_free(mdl);
+
+   return status == OK ? EXIT_SUCCESS : EXIT_FAILURE;
+}
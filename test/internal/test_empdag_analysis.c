@@ -0,0 +1,223 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "empdag.h"
+#include "empdag_alg.h"
+#include "mdl.h"
+#include "reshop.h"
+#include "status.h"
+
+/* ---------------------------------------------------------------------------
+ * Results of the EMPDAG analysis compared with known values:
+ * - a small DAG with VF and CTRL arcs. The root is reached first, and the
+ *   children of an MP are visited in the order of its arcs, VF arcs first
+ *   except for an MP reached via a CTRL arc:
+ *
+ *         MP0 (min)
+ *        VF/     \CTRL
+ *     MP1 (max)  MP3 (min)
+ *      VF|      CTRL/   \VF
+ *     MP2 (min)  MP4 (max)  MP5 (max)
+ *
+ *   MP1 and MP5 are adversarial, on the saddle paths starting at MP0 and MP3
+ *
+ * - a chain of MPs linked by VF arcs, deep enough to overflow the stack of a
+ *   recursive DFS
+ * --------------------------------------------------------------------------- */
+
+#define CHK(EXPR) { int rc_ = (EXPR); if (rc_ != OK) { \
+   (void)fprintf(stderr, "ERROR: %s failed with %s\n", #EXPR, rhp_status_descr(rc_)); \
+   return rc_; } }
+
+#define CHK_NULL(EXPR) { if (!(EXPR)) { \
+   (void)fprintf(stderr, "ERROR: %s failed\n", #EXPR); \
+   return Error_RuntimeError; } }
+
+#define EXPECT(COND, ...) { if (!(COND)) { \
+   (void)fprintf(stderr, "ERROR line %d: %s: ", __LINE__, #COND); \
+   (void)fprintf(stderr, __VA_ARGS__); (void)fputc('\n', stderr); \
+   return Error_RuntimeError; } }
+
+/* Add an MP with a variable and an objective function in this variable */
+static int add_mp(Model *mdl, unsigned sense, struct rhp_mathprgm **mp, rhp_idx *objequ)
+{
+   rhp_idx vi;
+
+   *mp = rhp_empdag_newmp(mdl, sense);
+   CHK_NULL(*mp);
+
+   CHK(rhp_add_var(mdl, &vi));
+   CHK(rhp_mp_addvar(*mp, vi));
+   CHK(rhp_add_func(mdl, objequ));
+   CHK(rhp_equ_addnewlvar(mdl, *objequ, vi, 1.));
+   CHK(rhp_mp_setobjequ(*mp, *objequ));
+
+   return OK;
+}
+
+/* Add child to the objective function of mp via a VF arc */
+static int add_VFarc(Model *mdl, struct rhp_mathprgm *mp, rhp_idx objequ,
+                     struct rhp_mathprgm *child, struct rhp_empdag_arcVF *arcVF)
+{
+   CHK(rhp_arcVF_init(arcVF, objequ));
+   CHK(rhp_empdag_mpaddmpVF(mdl, mp, child, arcVF));
+
+   return OK;
+}
+
+static int analyze(Model *mdl)
+{
+   CHK(mdl_checkmetadata(mdl));
+   CHK(empdag_analysis(&mdl->empinfo.empdag));
+
+   return OK;
+}
+
+static int check_array(const char *name, const MpIdArray *arr, const unsigned *expected,
+                       unsigned len)
+{
+   EXPECT(arr->len == len, "%s has %u elements, expected %u", name, arr->len, len);
+
+   for (unsigned i = 0; i < len; ++i) {
+      EXPECT(arr->arr[i] == expected[i], "%s[%u] = %u, expected %u", name, i,
+             arr->arr[i], expected[i]);
+   }
+
+   return OK;
+}
+
+static int test_small(void)
+{
+   enum { NMPS = 6 };
+   static const unsigned senses[NMPS] = {RHP_MIN, RHP_MAX, RHP_MIN, RHP_MIN, RHP_MAX, RHP_MAX};
+
+   /* Timestamps: the postorder one of a node follows the ones of its children */
+   static const unsigned levels[NMPS]     = {0, 0, 0, 1, 2, 1};
+   static const unsigned preorders[NMPS]  = {1, 2, 3, 6, 7, 9};
+   static const unsigned postorders[NMPS] = {12, 5, 4, 11, 8, 10};
+
+   /* Adversarial MPs are sorted by topological order, that is by postorder */
+   static const unsigned adversarial[] = {1, 5};
+   static const unsigned saddle_starts[] = {0, 3};
+
+   int status = OK;
+   struct rhp_mathprgm *mps[NMPS];
+   rhp_idx objequs[NMPS];
+   struct rhp_empdag_arcVF *arcVF = NULL;
+
+   Model *mdl = rhp_mdl_new(RhpBackendReSHOP);
+   CHK_NULL(mdl);
+
+   for (unsigned i = 0; i < NMPS; ++i) {
+      S_CHECK_EXIT(add_mp(mdl, senses[i], &mps[i], &objequs[i]));
+   }
+
+   A_CHECK_EXIT(arcVF, rhp_arcVF_new());
+
+   S_CHECK_EXIT(rhp_empdag_rootsetmp(mdl, mps[0]));
+   S_CHECK_EXIT(add_VFarc(mdl, mps[0], objequs[0], mps[1], arcVF));
+   S_CHECK_EXIT(add_VFarc(mdl, mps[1], objequs[1], mps[2], arcVF));
+   S_CHECK_EXIT(rhp_empdag_mpaddmpCTRL(mdl, mps[0], mps[3]));
+   S_CHECK_EXIT(rhp_empdag_mpaddmpCTRL(mdl, mps[3], mps[4]));
+   S_CHECK_EXIT(add_VFarc(mdl, mps[3], objequs[3], mps[5], arcVF));
+
+   S_CHECK_EXIT(analyze(mdl));
+
+   const EmpDag *empdag = &mdl->empinfo.empdag;
+
+   for (unsigned i = 0; i < NMPS; ++i) {
+      unsigned level, preorder, postorder;
+      S_CHECK_EXIT(empdag_analysis_getnode(empdag, mpid2uid(i), &level, &preorder,
+                                           &postorder));
+
+      if (level != levels[i] || preorder != preorders[i] || postorder != postorders[i]) {
+         (void)fprintf(stderr, "ERROR: MP%u has level %u, preorder %u, postorder %u; "
+                       "expected %u, %u, %u\n", i, level, preorder, postorder,
+                       levels[i], preorders[i], postorders[i]);
+         status = Error_RuntimeError;
+         goto _exit;
+      }
+   }
+
+   S_CHECK_EXIT(check_array("mps2reformulate", &empdag->minimaxi.mps2reformulate,
+                            adversarial, ARRAY_SIZE(adversarial)));
+   S_CHECK_EXIT(check_array("saddle_path_starts", &empdag->minimaxi.saddle_path_starts,
+                            saddle_starts, ARRAY_SIZE(saddle_starts)));
+
+   if (!empdag->features.istree || !empdag->features.hasVFpath) {
+      (void)fprintf(stderr, "ERROR: the EMPDAG should be a tree with VF paths\n");
+      status = Error_RuntimeError;
+   }
+
+_exit:
+   rhp_arcVF_free(arcVF);
+   rhp_mdl_free(mdl);
+
+   return status;
+}
+
+static int test_deep_chain(void)
+{
+   enum { NMPS = 200000 };
+
+   int status = OK;
+   struct rhp_mathprgm *mp, *mp_parent;
+   rhp_idx objequ, objequ_parent;
+   struct rhp_empdag_arcVF *arcVF = NULL;
+
+   Model *mdl = rhp_mdl_new(RhpBackendReSHOP);
+   CHK_NULL(mdl);
+
+   A_CHECK_EXIT(arcVF, rhp_arcVF_new());
+
+   S_CHECK_EXIT(add_mp(mdl, RHP_MIN, &mp_parent, &objequ_parent));
+   S_CHECK_EXIT(rhp_empdag_rootsetmp(mdl, mp_parent));
+
+   for (unsigned i = 1; i < NMPS; ++i) {
+      S_CHECK_EXIT(add_mp(mdl, RHP_MIN, &mp, &objequ));
+      S_CHECK_EXIT(add_VFarc(mdl, mp_parent, objequ_parent, mp, arcVF));
+      mp_parent = mp;
+      objequ_parent = objequ;
+   }
+
+   S_CHECK_EXIT(analyze(mdl));
+
+   const EmpDag *empdag = &mdl->empinfo.empdag;
+   if (empdag->minimaxi.mps2reformulate.len > 0) {
+      (void)fprintf(stderr, "ERROR: %u adversarial MPs in a chain of minimizations\n",
+                    empdag->minimaxi.mps2reformulate.len);
+      status = Error_RuntimeError;
+      goto _exit;
+   }
+
+   /* The DFS goes down the chain, then back up */
+   for (unsigned i = 0; i < NMPS; i += NMPS/10 - 1) {
+      unsigned level, preorder, postorder;
+      S_CHECK_EXIT(empdag_analysis_getnode(empdag, mpid2uid(i), &level, &preorder,
+                                           &postorder));
+
+      if (level != 0 || preorder != i+1 || postorder != 2*NMPS-i) {
+         (void)fprintf(stderr, "ERROR: MP%u has level %u, preorder %u, postorder %u\n",
+                       i, level, preorder, postorder);
+         status = Error_RuntimeError;
+         goto _exit;
+      }
+   }
+
+_exit:
+   rhp_arcVF_free(arcVF);
+   rhp_mdl_free(mdl);
+
+   return status;
+}
+
+int main(void)
+{
+   int status = OK;
+
+   S_CHECK_EXIT(test_small());
+   S_CHECK_EXIT(test_deep_chain());
+
+_exit:
+   return status == OK ? EXIT_SUCCESS : EXIT_FAILURE;
+}
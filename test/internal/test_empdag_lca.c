@@ -0,0 +1,295 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "empdag_lca.h"
+#include "macros.h"
+#include "reshop.h"
+#include "status.h"
+
+/* ---------------------------------------------------------------------------
+ * LCA queries of the EMPDAG analysis, compared with naive climbing on:
+ * - random forests
+ * - random DAGs: a node with several parents is the top of its tree, as in
+ *   the analysis, which only follows the arcs to a unique parent
+ * - random parent graphs with cycles: exactly one arc per cycle is cut
+ * - a deep chain, with branches
+ * --------------------------------------------------------------------------- */
+
+#define CHK(EXPR) { int rc_ = (EXPR); if (rc_ != OK) { \
+   (void)fprintf(stderr, "ERROR: %s failed with %s\n", #EXPR, rhp_status_descr(rc_)); \
+   return rc_; } }
+
+#define EXPECT(COND, ...) { if (!(COND)) { \
+   (void)fprintf(stderr, "ERROR line %d: %s: ", __LINE__, #COND); \
+   (void)fprintf(stderr, __VA_ARGS__); (void)fputc('\n', stderr); \
+   return Error_RuntimeError; } }
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ULL;
+
+static unsigned rng(unsigned bound)
+{
+   /* xorshift64* */
+   rng_state ^= rng_state >> 12;
+   rng_state ^= rng_state << 25;
+   rng_state ^= rng_state >> 27;
+   return (unsigned)((rng_state * 0x2545f4914f6cdd1dULL) >> 33) % bound;
+}
+
+/* Mark the nodes on a cycle of the original parent graph, self-loops excluded */
+static int mark_cycles(const unsigned *parent, unsigned n, bool *cycle)
+{
+   int status = OK;
+   unsigned *walk = NULL;
+   CALLOC_EXIT(walk, unsigned, n);
+
+   for (unsigned i = 0; i < n; ++i) {
+      cycle[i] = false;
+   }
+
+   /* walk[k] is 1 + the index of the walk which reached node k */
+   for (unsigned i = 0; i < n; ++i) {
+      unsigned cur = i;
+      while (!walk[cur]) {
+         walk[cur] = i+1;
+         cur = parent[cur];
+      }
+
+      /* A node reached in this walk again closes a new cycle */
+      if (walk[cur] == i+1 && parent[cur] != cur) {
+         unsigned start = cur;
+         do {
+            cycle[cur] = true;
+            cur = parent[cur];
+         } while (cur != start);
+      }
+   }
+
+_exit:
+   FREE(walk);
+
+   return status;
+}
+
+/* Smallest node of the cycle containing node */
+static unsigned cycle_min(const unsigned *parent, unsigned node)
+{
+   unsigned res = node;
+   for (unsigned cur = parent[node]; cur != node; cur = parent[cur]) {
+      res = MIN(res, cur);
+   }
+   return res;
+}
+
+/**
+ * Check the forest of the index against the original parent graph: only arcs
+ * on a cycle are cut, one per cycle, and the depths and tops are consistent.
+ */
+static int check_forest(const LcaIndex *idx, const unsigned *parent, unsigned n,
+                        bool *cycle, bool *cycle_cut)
+{
+   const unsigned *cut = idx->up;
+
+   CHK(mark_cycles(parent, n, cycle));
+   memset(cycle_cut, 0, n * sizeof(bool));
+
+   for (unsigned i = 0; i < n; ++i) {
+      unsigned p = cut[i];
+      EXPECT(p == parent[i] || p == i, "node %u: parent %u, was %u", i, p, parent[i]);
+
+      if (p == i) {
+         EXPECT(idx->depth[i] == 0 && idx->top[i] == i, "top %u: depth %u, top %u",
+                i, idx->depth[i], idx->top[i]);
+
+         if (parent[i] != i) {
+            EXPECT(cycle[i], "arc %u -> %u is cut, but not on a cycle",
+                   i, parent[i]);
+            unsigned c = cycle_min(parent, i);
+            EXPECT(!cycle_cut[c], "cycle of node %u is cut twice", c);
+            cycle_cut[c] = true;
+         }
+      } else {
+         EXPECT(idx->depth[i] == idx->depth[p] + 1 && idx->top[i] == idx->top[p],
+                "node %u: depth %u, top %u; parent %u: depth %u, top %u", i,
+                idx->depth[i], idx->top[i], p, idx->depth[p], idx->top[p]);
+      }
+   }
+
+   for (unsigned i = 0; i < n; ++i) {
+      if (cycle[i]) {
+         EXPECT(cycle_cut[cycle_min(parent, i)], "cycle of node %u is not cut", i);
+      }
+   }
+
+   return OK;
+}
+
+static unsigned naive_lca(const unsigned *cut, unsigned *mark, unsigned stamp,
+                          unsigned u, unsigned v)
+{
+   for (;;) {
+      mark[u] = stamp;
+      if (cut[u] == u) { break; }
+      u = cut[u];
+   }
+
+   for (;;) {
+      if (mark[v] == stamp) { return v; }
+      if (cut[v] == v) { return LCA_NONE; }
+      v = cut[v];
+   }
+}
+
+/**
+ * Build the index of the parent graph and compare the queries with naive
+ * climbing, on all pairs if npairs is 0
+ */
+static int check_lca(const char *name, const unsigned *parent, unsigned n,
+                     unsigned npairs)
+{
+   int status = OK;
+   unsigned *cut = NULL, *mark = NULL;
+   bool *cycle = NULL, *cycle_cut = NULL;
+   LcaIndex idx;
+
+   lca_index_init(&idx);
+
+   MALLOC_EXIT(cut, unsigned, n);
+   memcpy(cut, parent, n * sizeof(unsigned));
+   /* The index takes ownership of the array */
+   status = lca_index_build(&idx, n, cut);
+   cut = NULL;
+   if (status != OK) { goto _exit; }
+
+   MALLOC_EXIT(cycle, bool, n);
+   MALLOC_EXIT(cycle_cut, bool, n);
+   S_CHECK_EXIT(check_forest(&idx, parent, n, cycle, cycle_cut));
+
+   CALLOC_EXIT(mark, unsigned, n);
+   unsigned stamp = 0;
+
+   unsigned npairs_ = npairs ? npairs : n * n;
+   for (unsigned k = 0; k < npairs_; ++k) {
+      unsigned u = npairs ? rng(n) : k / n, v = npairs ? rng(n) : k % n;
+      unsigned expected = naive_lca(idx.up, mark, ++stamp, u, v);
+      unsigned res = lca_index_query(&idx, u, v);
+
+      if (res != expected) {
+         (void)fprintf(stderr, "ERROR: %s: lca(%u, %u) = %u, naive climbing gives %u\n",
+                       name, u, v, res, expected);
+         status = Error_RuntimeError;
+         goto _exit;
+      }
+   }
+
+_exit:
+   FREE(cut);
+   FREE(mark);
+   FREE(cycle);
+   FREE(cycle_cut);
+   lca_index_free(&idx);
+
+   return status;
+}
+
+static int test_forests(void)
+{
+   enum { N = 300 };
+   unsigned parent[N];
+
+   for (unsigned s = 0; s < 20; ++s) {
+      /* Shuffle the labels so that parents are not always smaller */
+      unsigned perm[N];
+      for (unsigned i = 0; i < N; ++i) { perm[i] = i; }
+      for (unsigned i = N-1; i > 0; --i) {
+         unsigned j = rng(i+1), tmp = perm[i]; perm[i] = perm[j]; perm[j] = tmp;
+      }
+
+      for (unsigned i = 0; i < N; ++i) {
+         unsigned p = (i == 0 || rng(10) == 0) ? i : rng(i);
+         parent[perm[i]] = perm[p];
+      }
+
+      CHK(check_lca("forest", parent, N, 0));
+   }
+
+   return OK;
+}
+
+static int test_dags(void)
+{
+   enum { N = 300 };
+   unsigned parent[N];
+
+   for (unsigned s = 0; s < 20; ++s) {
+      /* Node i gets 0 to 3 parents among the previous nodes. Only a unique
+       * parent is kept: a node with several parents is a top */
+      for (unsigned i = 0; i < N; ++i) {
+         unsigned nparents = i == 0 ? 0 : rng(4);
+         parent[i] = nparents == 1 ? rng(i) : i;
+      }
+
+      CHK(check_lca("dag", parent, N, 0));
+   }
+
+   return OK;
+}
+
+static int test_cycles(void)
+{
+   enum { N = 300 };
+   unsigned parent[N];
+
+   for (unsigned s = 0; s < 20; ++s) {
+      /* Random parent graph: every component has at most one cycle */
+      for (unsigned i = 0; i < N; ++i) {
+         parent[i] = rng(20) == 0 ? i : rng(N);
+      }
+
+      CHK(check_lca("cycles", parent, N, 0));
+   }
+
+   /* A single loop over all the nodes */
+   for (unsigned i = 0; i < N; ++i) { parent[i] = (i + 1) % N; }
+   CHK(check_lca("loop", parent, N, 0));
+
+   return OK;
+}
+
+static int test_deep(void)
+{
+   enum { N = 200000 };
+   unsigned *parent;
+   int status = OK;
+
+   MALLOC_(parent, unsigned, N);
+
+   /* A chain of N/2 nodes, then branches hanging off random chain nodes */
+   parent[0] = 0;
+   for (unsigned i = 1; i < N/2; ++i) { parent[i] = i-1; }
+   for (unsigned i = N/2; i < N; ++i) {
+      parent[i] = rng(5) == 0 ? rng(N/2) : i-1;
+   }
+
+   S_CHECK_EXIT(check_lca("deep", parent, N, 300));
+
+_exit:
+   FREE(parent);
+
+   return status;
+}
+
+int main(void)
+{
+   int status = OK;
+
+   S_CHECK_EXIT(test_forests());
+   S_CHECK_EXIT(test_dags());
+   S_CHECK_EXIT(test_cycles());
+   S_CHECK_EXIT(test_deep());
+
+_exit:
+   return status == OK ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,250 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "empinterp.h"
+#include "empinterp_vm.h"
+#include "empinterp_vm_tape.h"
+#include "empinterp_vm_utils.h"
+#include "reshop.h"
+#include "status.h"
+
+/* ---------------------------------------------------------------------------
+ * EMP VM program beyond the 16-bit operands:
+ * - more than 65535 globals: the global indices need the GIDX_WIDE escape
+ * - a loop body longer than 65535 bytes: the forward jump over the dead code
+ *   and the jump back of the loop are JUMP_FAR operands
+ *
+ *   lvar@0 = 0                     loop index
+ *   lvar@1 = 0                     iteration counter
+ *   loop_start:
+ *     JUMP live                    far forward jump
+ *     LVAR_INC lvar@1  x NDEAD     never executed
+ *   live:
+ *     LVAR_INC lvar@1
+ *     lvar@2 = globals[gidx]       wide global index
+ *     LOOP_NEXT_VMUINT lvar@0      far jump back to loop_start
+ *   END
+ *
+ * The program is run, then disassembled and the printed jump targets are checked.
+ * --------------------------------------------------------------------------- */
+
+enum { NGLOBALS = 70000, NDEAD = 40000, NITERS = 3 };
+
+#define CHK(EXPR) { int rc_ = (EXPR); if (rc_ != OK) { \
+   (void)fprintf(stderr, "ERROR: %s failed with %s\n", #EXPR, rhp_status_descr(rc_)); \
+   return rc_; } }
+
+#define EXPECT(COND, ...) { if (!(COND)) { \
+   (void)fprintf(stderr, "ERROR line %d: %s: ", __LINE__, #COND); \
+   (void)fprintf(stderr, __VA_ARGS__); (void)fputc('\n', stderr); \
+   return Error_RuntimeError; } }
+
+typedef struct {
+   char *buf;
+   size_t len;
+   size_t max;
+} Output;
+
+static void print_tobuf(void *data, UNUSED unsigned mode, const char *str)
+{
+   Output *out = data;
+   size_t len = strlen(str);
+
+   if (out->len + len + 1 > out->max) {
+      size_t max = 2*(out->len + len + 1);
+      char *buf = realloc(out->buf, max);
+      if (!buf) { return; }
+      out->buf = buf;
+      out->max = max;
+   }
+
+   memcpy(&out->buf[out->len], str, len + 1);
+   out->len += len;
+}
+
+static void flush_none(UNUSED void *data)
+{
+}
+
+/* Copy in line the line of the disassembly with the instruction at addr */
+static int find_instr(const char *buf, unsigned addr, char *line, size_t len)
+{
+   char pattern[32];
+   (void)snprintf(pattern, sizeof(pattern), "]  [%5u]  ", addr);
+
+   const char *start = strstr(buf, pattern);
+   if (!start) {
+      (void)fprintf(stderr, "ERROR: no instruction at @%u in the disassembly\n", addr);
+      return Error_NotFound;
+   }
+
+   const char *end = strchr(start, '\n');
+   size_t n = end ? (size_t)(end - start) : strlen(start);
+   n = MIN(n, len - 1);
+   memcpy(line, start, n);
+   line[n] = '\0';
+
+   return OK;
+}
+
+static int assemble(EmpVm *vm, unsigned *gidx, unsigned *addrs)
+{
+   Tape tape_ = {.code = &vm->code, .linenr = 0};
+   Tape *tape = &tape_;
+
+   for (unsigned i = vm->globals.len; i < NGLOBALS; ++i) {
+      CHK(vmvals_add(&vm->globals, UINT_VAL(i)));
+   }
+   *gidx = vm->globals.len - 1;
+
+   CHK(rhp_uint_add(&vm->uints, NITERS));
+   unsigned uidx_max = vm->uints.len - 1;
+
+   for (unsigned i = 0; i < 2; ++i) {
+      CHK(emit_byte(tape, OP_LVAR_COPYFROM_GIDX));
+      CHK(emit_byte(tape, i));
+      CHK(emit_gidx(tape, CstZeroUInt));
+   }
+
+   unsigned loop_start = vm->code.len, jump_addr;
+   addrs[0] = loop_start;
+
+   CHK(emit_jump(tape, OP_JUMP, &jump_addr));
+
+   for (unsigned i = 0; i < NDEAD; ++i) {
+      CHK(emit_byte(tape, OP_LVAR_INC));
+      CHK(emit_byte(tape, 1));
+   }
+
+   CHK(patch_jump(tape, jump_addr));
+   addrs[1] = vm->code.len;
+
+   CHK(emit_byte(tape, OP_LVAR_INC));
+   CHK(emit_byte(tape, 1));
+
+   addrs[2] = vm->code.len;
+   CHK(emit_byte(tape, OP_LVAR_COPYFROM_GIDX));
+   CHK(emit_byte(tape, 2));
+   CHK(emit_gidx(tape, *gidx));
+
+   addrs[3] = vm->code.len;
+   CHK(emit_byte(tape, OP_LOOP_NEXT_VMUINT));
+   CHK(emit_byte(tape, 0));
+   CHK(emit_gidx(tape, uidx_max));
+   CHK(_emit_jumpback_len(tape, loop_start));
+
+   return emit_byte(tape, OP_END);
+}
+
+static int check_code(EmpVm *vm, unsigned gidx, const unsigned *addrs)
+{
+   unsigned loop_start = addrs[0], live = addrs[1];
+
+   EXPECT(vm->code.len > UINT16_MAX, "the loop body is only %u bytes long", vm->code.len);
+   EXPECT(vm->code.nfarjumps == 2, "%u far jumps, expected 2", vm->code.nfarjumps);
+   EXPECT(vm->code.ip[addrs[2]+2] == 0xff && vm->code.ip[addrs[2]+3] == 0xff,
+          "global index %u is not encoded with GIDX_WIDE", gidx);
+   EXPECT(vmcode_farjump_get(&vm->code, loop_start+1) == live - loop_start - 3,
+          "wrong offset for the forward jump");
+   EXPECT(vmcode_farjump_get(&vm->code, vm->code.len-3) == vm->code.len-1-loop_start,
+          "wrong offset for the jump back");
+   EXPECT(vmcode_farjump_get(&vm->code, loop_start) == UINT_MAX,
+          "unexpected far jump at @%u", loop_start);
+
+   return OK;
+}
+
+static int check_run(EmpVm *vm, unsigned gidx)
+{
+   CHK(empvm_run(vm));
+
+   EXPECT(AS_UINT(vm->locals[0]) == NITERS, "loop index is %u", AS_UINT(vm->locals[0]));
+   EXPECT(AS_UINT(vm->locals[1]) == NITERS, "%u iterations, expected %u",
+          AS_UINT(vm->locals[1]), NITERS);
+   EXPECT(AS_UINT(vm->locals[2]) == gidx, "global value is %u, expected %u",
+          AS_UINT(vm->locals[2]), gidx);
+
+   return OK;
+}
+
+static int check_disassembly(EmpVm *vm, unsigned gidx, const unsigned *addrs)
+{
+   Output out = {.buf = NULL, .len = 0, .max = 0};
+   char line[256], target[32], value[32];
+
+   rhp_set_printops(&out, print_tobuf, flush_none, 0);
+   int status = empvm_dissassemble(vm, PO_INFO);
+   rhp_set_printopsdefault();
+
+   if (status != OK) {
+      (void)fprintf(stderr, "ERROR: disassembly failed with %s\n", rhp_status_descr(status));
+      goto _exit;
+   }
+
+   if (!out.buf) {
+      (void)fprintf(stderr, "ERROR: empty disassembly\n");
+      status = Error_RuntimeError;
+      goto _exit;
+   }
+
+   /* The forward jump lands on the LVAR_INC after the dead code */
+   S_CHECK_EXIT(find_instr(out.buf, addrs[0], line, sizeof(line)));
+   (void)snprintf(target, sizeof(target), " @%u ", addrs[1]);
+   if (!strstr(line, " JUMP ") || !strstr(line, target) || !strstr(line, "LVAR_INC")) {
+      (void)fprintf(stderr, "ERROR: expecting a jump to @%u, got\n%s\n", addrs[1], line);
+      status = Error_RuntimeError;
+      goto _exit;
+   }
+
+   /* The wide global index is decoded */
+   S_CHECK_EXIT(find_instr(out.buf, addrs[2], line, sizeof(line)));
+   (void)snprintf(value, sizeof(value), " %u", gidx);
+   if (!strstr(line, "LVAR_COPYFROM_GIDX") || !strstr(line, value)) {
+      (void)fprintf(stderr, "ERROR: expecting the value %u, got\n%s\n", gidx, line);
+      status = Error_RuntimeError;
+      goto _exit;
+   }
+
+   /* The jump back lands on the forward jump at the loop start */
+   S_CHECK_EXIT(find_instr(out.buf, addrs[3], line, sizeof(line)));
+   (void)snprintf(target, sizeof(target), " @%u ", addrs[0]);
+   if (!strstr(line, "LOOP_NEXT_VMUINT") || !strstr(line, target) || !strstr(line, "JUMP")) {
+      (void)fprintf(stderr, "ERROR: expecting a jump back to @%u, got\n%s\n", addrs[0], line);
+      status = Error_RuntimeError;
+      goto _exit;
+   }
+
+_exit:
+   free(out.buf);
+
+   return status;
+}
+
+int main(void)
+{
+   int status = OK;
+   unsigned gidx, addrs[4];
+
+   /* The VM only needs the interpreter to report errors */
+   Interpreter *interp = calloc(1, sizeof(Interpreter));
+   if (!interp) { return EXIT_FAILURE; }
+   interp->buf = "";
+
+   EmpVm *vm = empvm_new(interp);
+   if (!vm) { free(interp); return EXIT_FAILURE; }
+
+   S_CHECK_EXIT(assemble(vm, &gidx, addrs));
+   S_CHECK_EXIT(check_code(vm, gidx, addrs));
+   S_CHECK_EXIT(check_run(vm, gidx));
+   S_CHECK_EXIT(check_disassembly(vm, gidx, addrs));
+
+   /* The bytecode is left as it was: it can be run again */
+   S_CHECK_EXIT(check_run(vm, gidx));
+
+_exit:
+   empvm_free(vm);
+   free(interp);
+
+   return status == OK ? EXIT_SUCCESS : EXIT_FAILURE;
+}
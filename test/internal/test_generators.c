@@ -0,0 +1,359 @@
+#include "reshop_config.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cones.h"
+#include "generators.h"
+#include "macros.h"
+#include "ovf_generator.h"
+#include "ovf_parameter.h"
+#include "ovfinfo.h"
+#include "reshop.h"
+#include "rhp_LA.h"
+#include "status.h"
+
+/* ---------------------------------------------------------------------------
+ * Closed-form V-representations of the OVF sets:
+ * - generators_box, generators_unit_simplex and generators_point have the
+ *   expected vertices
+ * - for each OVF with a vrepr hook, every vertex satisfies A v - b ∈ K, with
+ *   (A, b, K) the H-representation of set_A, set_b and set_cones, and has at
+ *   least dim(u) active constraints
+ * - the conjugate reformulation of these OVFs runs without libvrepr
+ * --------------------------------------------------------------------------- */
+
+#define N_ARGS 3
+#define TOL    1e-12
+
+#define CHK(EXPR) { int rc_ = (EXPR); if (rc_ != OK) { \
+   (void)fprintf(stderr, "ERROR: %s failed with %s\n", #EXPR, rhp_status_descr(rc_)); \
+   return rc_; } }
+
+#define EXPECT(COND, ...) { if (!(COND)) { \
+   (void)fprintf(stderr, "ERROR line %d: %s: ", __LINE__, #COND); \
+   (void)fprintf(stderr, __VA_ARGS__); (void)fputc('\n', stderr); \
+   return Error_RuntimeError; } }
+
+/* Branches of set_A: without the CSC flag, A is returned; with it, A^T */
+enum { SET_PLAIN = 1, SET_TRANS = 2 };
+
+typedef struct {
+   const char *name;
+   unsigned branches;
+   unsigned nvertices;
+} VreprCase;
+
+static const VreprCase vrepr_cases[] = {
+   {"l1",           SET_PLAIN | SET_TRANS, 1U << N_ARGS},
+   {"hinge",        SET_TRANS,             1U << N_ARGS},
+   {"sum_pos_part", SET_PLAIN,             1U << N_ARGS},
+   {"vapnik",       SET_PLAIN | SET_TRANS, 1U << (2*N_ARGS)},
+   {"smax",         SET_PLAIN | SET_TRANS, N_ARGS},
+   {"smin",         SET_PLAIN | SET_TRANS, N_ARGS},
+   {"expectation",  SET_PLAIN,             1},
+};
+
+static const double probabilities[N_ARGS] = {.2, .3, .5};
+
+static int test_box(void)
+{
+   struct generators *gen = NULL;
+   CHK(generators_box(3, -1., 2., &gen));
+   EXPECT(gen, "no box generators");
+   EXPECT(gen->dim == 3 && gen->vertices.size == 8 && gen->rays.size == 0
+          && gen->lines.size == 0, "box: dim %u, %u vertices", gen->dim,
+          gen->vertices.size);
+
+   /* The vertices are the 8 distinct corners */
+   unsigned seen = 0;
+   for (unsigned i = 0; i < gen->vertices.size; ++i) {
+      const double *v = gen->vertices.val[i];
+      unsigned corner = 0;
+      for (unsigned j = 0; j < 3; ++j) {
+         EXPECT(v[j] == -1. || v[j] == 2., "vertex %u: v[%u] = %e", i, j, v[j]);
+         if (v[j] == 2.) { corner |= 1U << j; }
+      }
+      EXPECT(!(seen & (1U << corner)), "vertex %u is a duplicate", i);
+      seen |= 1U << corner;
+   }
+   generators_dealloc(gen);
+
+   /* Above GENERATORS_BOX_MAXDIM, no closed form is returned */
+   gen = NULL;
+   CHK(generators_box(17, 0., 1., &gen));
+   EXPECT(!gen, "box of dimension 17 has generators");
+
+   return OK;
+}
+
+static int test_simplex_point(void)
+{
+   struct generators *gen = NULL;
+   CHK(generators_unit_simplex(4, &gen));
+   EXPECT(gen && gen->dim == 4 && gen->vertices.size == 4, "unit simplex");
+
+   for (unsigned i = 0; i < 4; ++i) {
+      const double *v = gen->vertices.val[i];
+      for (unsigned j = 0; j < 4; ++j) {
+         EXPECT(v[j] == (i == j ? 1. : 0.), "vertex %u: v[%u] = %e", i, j, v[j]);
+      }
+   }
+   generators_dealloc(gen);
+
+   double pt[] = {.5, -1., 3.};
+   gen = NULL;
+   CHK(generators_point(3, pt, &gen));
+   EXPECT(gen && gen->dim == 3 && gen->vertices.size == 1, "point");
+   EXPECT(!memcmp(gen->vertices.val[0], pt, sizeof(pt)), "point vertex");
+   generators_dealloc(gen);
+
+   return OK;
+}
+
+/* y = A v, with the CSR storage holding A^T when trans is set */
+static int set_matvec(const SpMat *A, bool trans, unsigned n_u, const double *v,
+                      double *y, unsigned *n_rows)
+{
+   const struct sp_matrix *spm = A->csr;
+   EXPECT(spm, "no CSR matrix");
+
+   if (A->ppty & EMPMAT_EYE) {
+      EXPECT(spm->n == n_u && spm->m == n_u, "identity of size %u", n_u);
+      for (unsigned i = 0; i < n_u; ++i) { y[i] = spm->x[0] * v[i]; }
+      *n_rows = n_u;
+      return OK;
+   }
+
+   if (!trans) {
+      EXPECT(spm->n == n_u, "A has %u columns, expected %u", (unsigned)spm->n, n_u);
+      *n_rows = spm->m;
+      for (unsigned i = 0; i < *n_rows; ++i) {
+         y[i] = 0.;
+         for (RHP_INT k = spm->p[i]; k < spm->p[i+1]; ++k) {
+            y[i] += spm->x[k] * v[spm->i[k]];
+         }
+      }
+   } else {
+      EXPECT(spm->m == n_u, "A^T has %u rows, expected %u", (unsigned)spm->m, n_u);
+      *n_rows = spm->n;
+      memset(y, 0, *n_rows * sizeof(double));
+      for (unsigned j = 0; j < n_u; ++j) {
+         for (RHP_INT k = spm->p[j]; k < spm->p[j+1]; ++k) {
+            y[spm->i[k]] += spm->x[k] * v[j];
+         }
+      }
+   }
+
+   return OK;
+}
+
+static int check_vertices(const OvfDef *ovf, const struct generators *gen,
+                          bool trans)
+{
+   const OvfGenOps *op = ovf->generator;
+   unsigned n_u = (unsigned)op->size_u(N_ARGS);
+   SpMat A;
+   double *b = NULL, *y = NULL;
+   int status = OK;
+
+   rhpmat_null(&A);
+   if (trans) { rhpmat_set_csc(&A); }
+   S_CHECK_EXIT(op->set_A(N_ARGS, ovf->params, &A));
+   S_CHECK_EXIT(op->set_b(N_ARGS, ovf->params, &b));
+
+   unsigned n_rows = A.csr->m > A.csr->n ? A.csr->m : A.csr->n;
+   MALLOC_EXIT(y, double, n_rows);
+
+   for (unsigned i = 0; i < gen->vertices.size; ++i) {
+      const double *v = gen->vertices.val[i];
+      unsigned n_active = 0;
+
+      S_CHECK_EXIT(set_matvec(&A, trans, n_u, v, y, &n_rows));
+
+      for (unsigned j = 0; j < n_rows; ++j) {
+         void *cone_data;
+         enum cone cone = op->set_cones(N_ARGS, ovf->params, j, &cone_data);
+         double r = y[j] - b[j];
+         bool feasible;
+
+         switch (cone) {
+         case CONE_R_PLUS:  feasible = r >= -TOL;      break;
+         case CONE_R_MINUS: feasible = r <= TOL;       break;
+         case CONE_0:       feasible = fabs(r) <= TOL; break;
+         case CONE_R:       feasible = true;           break;
+         default:
+            (void)fprintf(stderr, "ERROR: %s: unsupported cone %s\n", op->name,
+                          cone_name(cone));
+            status = Error_NotImplemented;
+            goto _exit;
+         }
+
+         if (!feasible) {
+            (void)fprintf(stderr, "ERROR: %s%s: vertex %u violates row %u: %e in %s\n",
+                          op->name, trans ? " (transposed)" : "", i, j, r,
+                          cone_name(cone));
+            status = Error_RuntimeError;
+            goto _exit;
+         }
+
+         if (cone != CONE_R && fabs(r) <= TOL) { n_active++; }
+      }
+
+      if (n_active < n_u) {
+         (void)fprintf(stderr, "ERROR: %s: vertex %u has only %u active constraints\n",
+                       op->name, i, n_active);
+         status = Error_RuntimeError;
+         goto _exit;
+      }
+   }
+
+_exit:
+   rhpmat_free(&A);
+   FREE(b);
+   FREE(y);
+
+   return status;
+}
+
+static int test_ovf_vrepr(const VreprCase *tc)
+{
+   OvfDef *ovf = ovfdef_new(ovf_findbyname(tc->name));
+   struct generators *gen = NULL;
+   int status = OK;
+
+   EXPECT(ovf, "OVF %s not found", tc->name);
+
+   if (!strcmp(tc->name, "expectation")) {
+      OvfParam *probs = &ovf->params->p[0];
+      MALLOC_EXIT(probs->vec, double, N_ARGS);
+      memcpy(probs->vec, probabilities, sizeof(probabilities));
+      probs->type = ARG_TYPE_VEC;
+      probs->size_vector = N_ARGS;
+   }
+
+   S_CHECK_EXIT(ovf->generator->vrepr(N_ARGS, ovf->params, &gen));
+
+   unsigned n_u = (unsigned)ovf->generator->size_u(N_ARGS);
+   if (!gen || gen->dim != n_u || gen->vertices.size != tc->nvertices
+       || gen->rays.size || gen->lines.size) {
+      (void)fprintf(stderr, "ERROR: %s: expected %u vertices in dimension %u\n",
+                    tc->name, tc->nvertices, n_u);
+      status = Error_RuntimeError;
+      goto _exit;
+   }
+
+   if (tc->branches & SET_PLAIN) { S_CHECK_EXIT(check_vertices(ovf, gen, false)); }
+   if (tc->branches & SET_TRANS) { S_CHECK_EXIT(check_vertices(ovf, gen, true)); }
+
+_exit:
+   if (gen) { generators_dealloc(gen); }
+   if (ovf) { ovfdef_free(ovf); }
+
+   return status;
+}
+
+/* Model: min/max  ovfvar + sum_i x_i,  s.t. arg_i = x_i - i,  ovfvar = ovf(arg) */
+static int conjugate_mdl(rhp_mdl_t *mdl, const char *ovf_name)
+{
+   int status = OK;
+   rhp_vars_t *x = rhp_avar_new(), *args = rhp_avar_new();
+   rhp_equs_t *defargs = rhp_aequ_new();
+   rhp_idx objequ, ovfvar;
+
+   if (!x || !args || !defargs) { status = Error_InsufficientMemory; goto _exit; }
+
+   S_CHECK_EXIT(rhp_add_varnamed(mdl, &ovfvar, "ovfvar"));
+   S_CHECK_EXIT(rhp_add_varsnamed(mdl, N_ARGS, x, "x"));
+   S_CHECK_EXIT(rhp_add_varsnamed(mdl, N_ARGS, args, "arg"));
+   S_CHECK_EXIT(rhp_add_funcnamed(mdl, &objequ, "objequ"));
+   S_CHECK_EXIT(rhp_equ_addnewlvar(mdl, objequ, ovfvar, 1.));
+   S_CHECK_EXIT(rhp_add_consnamed(mdl, N_ARGS, RHP_CON_EQ, defargs, "defarg"));
+
+   for (unsigned i = 0; i < N_ARGS; ++i) {
+      rhp_idx ei, xi, ai;
+      S_CHECK_EXIT(rhp_aequ_get(defargs, i, &ei));
+      S_CHECK_EXIT(rhp_avar_get(x, i, &xi));
+      S_CHECK_EXIT(rhp_avar_get(args, i, &ai));
+      S_CHECK_EXIT(rhp_equ_addnewlvar(mdl, objequ, xi, 1.));
+      S_CHECK_EXIT(rhp_equ_addnewlvar(mdl, ei, ai, 1.));
+      S_CHECK_EXIT(rhp_equ_addnewlvar(mdl, ei, xi, -1.));
+      S_CHECK_EXIT(rhp_mdl_setequrhs(mdl, ei, -(double)i));
+   }
+
+   struct rhp_ovfdef *ovf_def;
+   S_CHECK_EXIT(rhp_ovf_add(mdl, ovf_name, ovfvar, args, &ovf_def));
+   S_CHECK_EXIT(rhp_mdl_setobjequ(mdl, objequ));
+   S_CHECK_EXIT(rhp_mdl_setobjsense(mdl, ovf_def->sense == RHP_MAX ? RHP_MIN : RHP_MAX));
+
+   if (!strcmp(ovf_name, "expectation")) {
+      S_CHECK_EXIT(rhp_ovf_param_add_scalar(ovf_def, "probabilities", 1./N_ARGS));
+   } else if (!strcmp(ovf_name, "hinge") || !strcmp(ovf_name, "vapnik")) {
+      S_CHECK_EXIT(rhp_ovf_param_add_scalar(ovf_def, "epsilon", .1));
+   }
+
+   S_CHECK_EXIT(rhp_ovf_setreformulation(ovf_def, "conjugate"));
+   S_CHECK_EXIT(rhp_ovf_check(mdl, ovf_def));
+
+_exit:
+   rhp_avar_free(x);
+   rhp_avar_free(args);
+   rhp_aequ_free(defargs);
+
+   return status;
+}
+
+static int test_conjugate(const VreprCase *tc)
+{
+   rhp_mdl_t *mdl = rhp_mdl_new(RhpBackendReSHOP), *mdl_solver = NULL;
+   int status = OK;
+
+   EXPECT(mdl, "no model");
+
+   S_CHECK_EXIT(conjugate_mdl(mdl, tc->name));
+   mdl_solver = rhp_newsolvermdl(mdl);
+   if (!mdl_solver) { status = Error_InsufficientMemory; goto _exit; }
+
+   status = rhp_process(mdl, mdl_solver);
+   if (status != OK) {
+      (void)fprintf(stderr, "ERROR: conjugate reformulation of %s failed with %s\n",
+                    tc->name, rhp_status_descr(status));
+      goto _exit;
+   }
+
+   /* The conjugate has one constraint per vertex of the set, besides the
+    * objective function */
+   unsigned m = rhp_mdl_nequs(mdl_solver);
+   if (m != tc->nvertices + 1) {
+      (void)fprintf(stderr, "ERROR: conjugate reformulation of %s has %u equations, "
+                    "expected %u\n", tc->name, m, tc->nvertices + 1);
+      status = Error_RuntimeError;
+   }
+
+_exit:
+   rhp_mdl_free(mdl_solver);
+   rhp_mdl_free(mdl);
+
+   return status;
+}
+
+int main(void)
+{
+   int status = OK;
+
+   S_CHECK_EXIT(test_box());
+   S_CHECK_EXIT(test_simplex_point());
+
+   for (unsigned i = 0; i < ARRAY_SIZE(vrepr_cases); ++i) {
+      S_CHECK_EXIT(test_ovf_vrepr(&vrepr_cases[i]));
+   }
+
+   for (unsigned i = 0; i < ARRAY_SIZE(vrepr_cases); ++i) {
+      S_CHECK_EXIT(test_conjugate(&vrepr_cases[i]));
+   }
+
+_exit:
+   return status == OK ? EXIT_SUCCESS : EXIT_FAILURE;
+}
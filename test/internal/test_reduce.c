@@ -0,0 +1,203 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "asnan.h"
+#include "cmat.h"
+#include "container.h"
+#include "ctrdat_rhp.h"
+#include "empdag.h"
+#include "mdl.h"
+#include "mdl_rhp.h"
+#include "reshop.h"
+#include "rmdl_reduce.h"
+#include "status.h"
+
+/* ---------------------------------------------------------------------------
+ * Presolve reductions and postsolve on a small LP
+ *
+ *   min  x1 + 2 x2 - x3 + x4 + x5
+ *   s1:  2 x1            >= 2      singleton row       -> x1 >= 1
+ *   r1:  x2 + x3         >= 1
+ *   r2:  2 x2 + 2 x3     >= 2      duplicate of r1
+ *   f1:  x4 + x5         <= 0      forcing row         -> x4 = x5 = 0
+ *   c1:  x1 + x2 + y     =  5      free column singleton y
+ *   d1:  w - x3          =  1      doubleton, w free is aggregated out
+ *   r3:  w + x2          <= 10     becomes x2 + x3 <= 9
+ *   x1, ..., x5 >= 0
+ *
+ * The reduced model is solved by hand: x = (1, 0, 9, 0, 0), with multipliers
+ * π(r1) = 0 and π(r3) = -1.
+ * --------------------------------------------------------------------------- */
+
+#define TOL 1e-10
+
+enum { X1, X2, X3, X4, X5, Y, W, NVARS };
+enum { OBJ, S1, R1, R2, F1, C1, D1, R3, NEQUS };
+
+static const double xsol[NVARS]  = { 1., 0., 9., 0., 0., 4., 10. };
+static const double xdual[NVARS] = { 0., 3., 0., 1., 1., 0., 0. };
+static const double esol[NEQUS]  = { NAN, 2., 9., 18., 0., 5., 1., 10. };
+static const double edual[NEQUS] = { NAN, .5, 0., 0., 0., 0., 1., -1. };
+
+#define CHK(EXPR) { int rc_ = (EXPR); if (rc_ != OK) { \
+   (void)fprintf(stderr, "ERROR: %s failed with %s\n", #EXPR, rhp_status_descr(rc_)); \
+   return rc_; } }
+
+static int build_lp(Model *mdl)
+{
+   static const double obj[] = { 1., 2., -1., 1., 1. };
+   rhp_idx vi, ei;
+
+   for (unsigned i = 0; i < NVARS; ++i) {
+      CHK(rhp_add_var(mdl, &vi));
+      if (i <= X5) { CHK(rhp_mdl_setvarlb(mdl, vi, 0.)); }
+   }
+
+   CHK(rhp_add_func(mdl, &ei));
+   for (unsigned i = X1; i <= X5; ++i) {
+      CHK(rhp_equ_addnewlvar(mdl, ei, i, obj[i]));
+   }
+   CHK(rhp_mdl_setobjequ(mdl, ei));
+   CHK(rhp_mdl_setobjsense(mdl, RHP_MIN));
+
+   CHK(rhp_add_con(mdl, RHP_CON_GT, &ei));
+   CHK(rhp_equ_addnewlvar(mdl, ei, X1, 2.));
+   CHK(rhp_mdl_setequrhs(mdl, ei, 2.));
+
+   CHK(rhp_add_con(mdl, RHP_CON_GT, &ei));
+   CHK(rhp_equ_addnewlvar(mdl, ei, X2, 1.));
+   CHK(rhp_equ_addnewlvar(mdl, ei, X3, 1.));
+   CHK(rhp_mdl_setequrhs(mdl, ei, 1.));
+
+   CHK(rhp_add_con(mdl, RHP_CON_GT, &ei));
+   CHK(rhp_equ_addnewlvar(mdl, ei, X2, 2.));
+   CHK(rhp_equ_addnewlvar(mdl, ei, X3, 2.));
+   CHK(rhp_mdl_setequrhs(mdl, ei, 2.));
+
+   CHK(rhp_add_con(mdl, RHP_CON_LT, &ei));
+   CHK(rhp_equ_addnewlvar(mdl, ei, X4, 1.));
+   CHK(rhp_equ_addnewlvar(mdl, ei, X5, 1.));
+   CHK(rhp_mdl_setequrhs(mdl, ei, 0.));
+
+   CHK(rhp_add_con(mdl, RHP_CON_EQ, &ei));
+   CHK(rhp_equ_addnewlvar(mdl, ei, X1, 1.));
+   CHK(rhp_equ_addnewlvar(mdl, ei, X2, 1.));
+   CHK(rhp_equ_addnewlvar(mdl, ei, Y, 1.));
+   CHK(rhp_mdl_setequrhs(mdl, ei, 5.));
+
+   CHK(rhp_add_con(mdl, RHP_CON_EQ, &ei));
+   CHK(rhp_equ_addnewlvar(mdl, ei, W, 1.));
+   CHK(rhp_equ_addnewlvar(mdl, ei, X3, -1.));
+   CHK(rhp_mdl_setequrhs(mdl, ei, 1.));
+
+   CHK(rhp_add_con(mdl, RHP_CON_LT, &ei));
+   CHK(rhp_equ_addnewlvar(mdl, ei, W, 1.));
+   CHK(rhp_equ_addnewlvar(mdl, ei, X2, 1.));
+   CHK(rhp_mdl_setequrhs(mdl, ei, 10.));
+
+   return OK;
+}
+
+/* Report the solution of the reduced model, as a solver would do */
+static void report_reduced(Model *mdl)
+{
+   Container *ctr = &mdl->ctr;
+   RhpContainerData *cdat = (RhpContainerData *)ctr->data;
+   rhp_idx objequ;
+   rmdl_getobjequ(mdl, &objequ);
+
+   for (rhp_idx vi = 0; vi < (rhp_idx)ctr_nvars_total(ctr); ++vi) {
+      Var *v = &ctr->vars[vi];
+      if (v->is_deleted) {
+         v->value = SNAN;
+         v->multiplier = SNAN;
+         continue;
+      }
+      v->value = xsol[vi];
+      /* x1 is at the bound given by s1 */
+      v->multiplier = vi == X1 ? 1. : xdual[vi];
+   }
+
+   for (rhp_idx ei = 0; ei < (rhp_idx)ctr_nequs_total(ctr); ++ei) {
+      Equ *e = &ctr->equs[ei];
+      e->value = SNAN;
+      e->multiplier = SNAN;
+   }
+
+   /* The only rows left are the objective, r1 and the rewritten r3 */
+   unsigned nactive = 0;
+   for (rhp_idx ei = 0; ei < (rhp_idx)ctr_nequs_total(ctr); ++ei) {
+      if (!cdat->cmat.equs[ei] || ei == objequ) { continue; }
+      Equ *e = &ctr->equs[ei];
+      e->value = xsol[X2] + xsol[X3];
+      e->multiplier = ei == R1 ? 0. : -1.;
+      nactive++;
+   }
+
+   if (nactive != 2) {
+      (void)fprintf(stderr, "ERROR: expecting 2 constraints after presolve, got %u\n", nactive);
+   }
+}
+
+static unsigned check(const char *kind, unsigned i, double val, double ref)
+{
+   if (isnan(ref) || fabs(val - ref) <= TOL) { return 0; }
+
+   (void)fprintf(stderr, "ERROR: %s #%u: expected %e, got %e\n", kind, i, ref, val);
+   return 1;
+}
+
+int main(void)
+{
+   int status = OK;
+   unsigned err = 0;
+   Model *mdl = NULL, *mdl_reduced = NULL;
+
+   mdl = rhp_mdl_new(RhpBackendReSHOP);
+   mdl_reduced = mdl_new(RhpBackendReSHOP);
+   if (!mdl || !mdl_reduced) { status = Error_InsufficientMemory; goto _exit; }
+
+   S_CHECK_EXIT(build_lp(mdl));
+   S_CHECK_EXIT(mdl_check(mdl));
+   S_CHECK_EXIT(mdl_checkmetadata(mdl));
+
+   S_CHECK_EXIT(rmdl_initfromfullmdl(mdl_reduced, mdl));
+   S_CHECK_EXIT(empdag_fini(&mdl_reduced->empinfo.empdag));
+   S_CHECK_EXIT(mdl_recompute_modeltype(mdl_reduced));
+
+   if (!rmdl_reduce_supported(mdl_reduced)) {
+      (void)fprintf(stderr, "ERROR: the LP should be supported by the presolve\n");
+      status = Error_RuntimeError;
+      goto _exit;
+   }
+
+   S_CHECK_EXIT(rmdl_reduce(mdl_reduced));
+
+   Container *ctr = &mdl_reduced->ctr;
+   err += check("number of variables", 0, ctr->n, 5);
+   err += check("lower bound of x1", X1, ctr->vars[X1].bnd.lb, 1.);
+   err += check("upper bound of x4", X4, ctr->vars[X4].bnd.ub, 0.);
+   err += check("upper bound of x5", X5, ctr->vars[X5].bnd.ub, 0.);
+
+   report_reduced(mdl_reduced);
+   S_CHECK_EXIT(rmdl_reduce_postsolve(mdl_reduced));
+
+   for (unsigned i = 0; i < NVARS; ++i) {
+      err += check("variable level", i, ctr->vars[i].value, xsol[i]);
+      err += check("variable multiplier", i, ctr->vars[i].multiplier, xdual[i]);
+   }
+
+   for (unsigned i = 0; i < NEQUS; ++i) {
+      err += check("equation level", i, ctr->equs[i].value, esol[i]);
+      err += check("equation multiplier", i, ctr->equs[i].multiplier, edual[i]);
+   }
+
+   if (err > 0) { status = Error_RuntimeError; }
+
+_exit:
+   if (mdl_reduced) { mdl_release(mdl_reduced); }
+   rhp_mdl_free(mdl);
+
+   return status == OK ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,326 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "empinterp.h"
+#include "empinterp_vm.h"
+#include "empinterp_vm_tape.h"
+#include "empinterp_vm_utils.h"
+#include "reshop.h"
+#include "status.h"
+
+/* ---------------------------------------------------------------------------
+ * Loops filtered by a single set, as in loop((i,j)$s(j,i), ...):
+ * - the records of the join are those of the nested loops with a membership
+ *   test, in the same order, whatever the order of the indices of s
+ * - an empty join skips the loop
+ * - i.first and i.last in the loop body see the positions in the loop sets
+ *
+ * The loop is assembled with the instructions that the compiler emits for the
+ * join and for the .first and .last attributes.
+ * --------------------------------------------------------------------------- */
+
+#define CHK(EXPR) { int rc_ = (EXPR); if (rc_ != OK) { \
+   (void)fprintf(stderr, "ERROR: %s failed with %s\n", #EXPR, rhp_status_descr(rc_)); \
+   return rc_; } }
+
+#define EXPECT(COND, ...) { if (!(COND)) { \
+   (void)fprintf(stderr, "ERROR line %d: %s: ", __LINE__, #COND); \
+   (void)fprintf(stderr, __VA_ARGS__); (void)fputc('\n', stderr); \
+   return Error_RuntimeError; } }
+
+static bool has_tuple(unsigned len, const int *tuples, uint8_t dim, const int *tuple)
+{
+   for (unsigned r = 0; r < len; ++r) {
+      unsigned d = 0;
+      while (d < dim && tuples[r*dim + d] == tuple[d]) { d++; }
+      if (d == dim) { return true; }
+   }
+
+   return false;
+}
+
+/* Compare the join with the nested loops over the loop sets and a membership test */
+static int check_join(const VmSetJoin *join, unsigned len, const int *tuples,
+                      const IntArray * const *loopsets, const uint8_t *loop2set,
+                      uint8_t dim)
+{
+   unsigned pos[GMS_MAX_INDEX_DIM] = {0}, rec = 0;
+
+   for (uint8_t d = 0; d < dim; ++d) {
+      if (loopsets[d]->len == 0) {
+         EXPECT(join->nrecs == 0, "%u records with an empty loop set", join->nrecs);
+         return OK;
+      }
+   }
+
+   while (true) {
+      int tuple[GMS_MAX_INDEX_DIM];
+      for (uint8_t d = 0; d < dim; ++d) {
+         tuple[loop2set[d]] = loopsets[d]->arr[pos[d]];
+      }
+
+      if (has_tuple(len, tuples, dim, tuple)) {
+         EXPECT(rec < join->nrecs, "only %u records", join->nrecs);
+         for (uint8_t d = 0; d < dim; ++d) {
+            EXPECT(join->pos[rec*dim + d] == pos[d] &&
+                   join->uels[rec*dim + d] == loopsets[d]->arr[pos[d]],
+                   "record %u, loop set %u: position %u and UEL %d, expected %u and %d",
+                   rec, d, join->pos[rec*dim + d], join->uels[rec*dim + d], pos[d],
+                   loopsets[d]->arr[pos[d]]);
+         }
+         rec++;
+      }
+
+      /* Next tuple of the nested loops, the last loop set being the innermost */
+      uint8_t d = dim;
+      while (d > 0 && ++pos[d-1] == loopsets[d-1]->len) { pos[--d] = 0; }
+      if (d == 0) { break; }
+   }
+
+   EXPECT(rec == join->nrecs, "%u records, expected %u", join->nrecs, rec);
+
+   return OK;
+}
+
+static int test_build(void)
+{
+   int i_uels[] = { 10, 20, 30 }, j_uels[] = { 5, 6 };
+   IntArray i = {.len = 3, .max = 3, .arr = i_uels}, j = {.len = 2, .max = 2, .arr = j_uels};
+   const IntArray *loopsets[] = { &i, &j };
+   VmSetJoin join;
+
+   /* loop((i,j)$s(j,i), ...): records out of order, UELs outside of the loop sets */
+   int s[] = { 6, 30,   5, 10,   7, 20,   6, 10,   5, 30,   6, 99 };
+   uint8_t loop2set[] = { 1, 0 };
+
+   CHK(vm_setjoin_build(&join, 6, s, loopsets, loop2set, 2));
+   int status = check_join(&join, 6, s, loopsets, loop2set, 2);
+   EXPECT(status != OK || join.nrecs == 4, "%u records, expected 4", join.nrecs);
+   free(join.pos);
+   free(join.uels);
+   CHK(status);
+
+   /* Same set, with the indices in the order of the loop sets */
+   uint8_t identity[] = { 0, 1 };
+   int s2[] = { 30, 6,   10, 5,   20, 7,   10, 6,   30, 5 };
+   CHK(vm_setjoin_build(&join, 5, s2, loopsets, identity, 2));
+   status = check_join(&join, 5, s2, loopsets, identity, 2);
+   free(join.pos);
+   free(join.uels);
+   CHK(status);
+
+   /* Empty joins: no record in the loop sets, no record, empty loop set */
+   int none[] = { 7, 11,   8, 20 };
+   CHK(vm_setjoin_build(&join, 2, none, loopsets, loop2set, 2));
+   EXPECT(join.nrecs == 0, "%u records, expected 0", join.nrecs);
+   free(join.pos);
+   free(join.uels);
+
+   CHK(vm_setjoin_build(&join, 0, none, loopsets, loop2set, 2));
+   EXPECT(join.nrecs == 0, "%u records, expected 0", join.nrecs);
+   free(join.pos);
+   free(join.uels);
+
+   IntArray empty = {.len = 0, .max = 0, .arr = NULL};
+   const IntArray *loopsets_empty[] = { &i, &empty };
+   CHK(vm_setjoin_build(&join, 6, s, loopsets_empty, loop2set, 2));
+   EXPECT(join.nrecs == 0, "%u records, expected 0", join.nrecs);
+   free(join.pos);
+   free(join.uels);
+
+   /* 3 loop sets (i,j,k) and s(k,i,j), with the loop sets not sorted by UEL */
+   enum { N = 12 };
+   int k_uels[N], ij_uels[N];
+   for (int n = 0; n < N; ++n) { k_uels[n] = 100 - 7*n; ij_uels[n] = 3*n + 1; }
+   IntArray ij = {.len = N, .max = N, .arr = ij_uels}, k = {.len = N, .max = N, .arr = k_uels};
+   const IntArray *loopsets3[] = { &ij, &ij, &k };
+   uint8_t loop2set3[] = { 1, 2, 0 };
+
+   int *s3 = malloc(sizeof(int) * 3 * N * N * N);
+   if (!s3) { return Error_InsufficientMemory; }
+   unsigned len3 = 0;
+   for (int r = N*N*N; r-- > 0; ) {
+      int a = r % N, b = (r / N) % N, c = r / (N*N);
+      if ((a * 7 + b * 3 + c) % 5) { continue; }
+      s3[3*len3] = k_uels[c]; s3[3*len3+1] = ij_uels[a]; s3[3*len3+2] = ij_uels[b];
+      len3++;
+   }
+
+   status = vm_setjoin_build(&join, len3, s3, loopsets3, loop2set3, 3);
+   if (status == OK) {
+      status = check_join(&join, len3, s3, loopsets3, loop2set3, 3);
+      free(join.pos);
+      free(join.uels);
+   }
+   free(s3);
+
+   return status;
+}
+
+enum {
+   LVAR_REC, LVAR_IDX_I, LVAR_ELT_I, LVAR_IDX_J, LVAR_ELT_J,
+   LVAR_NRECS, LVAR_I_FIRST, LVAR_I_LAST, LVAR_J_LAST, LVAR_COUNT,
+};
+
+/* Jump over a counter increment if the condition on the stack is false */
+static int emit_count_if(Tape *tape, unsigned lidx)
+{
+   unsigned jump_addr;
+   CHK(emit_jump(tape, OP_JUMP_IF_FALSE, &jump_addr));
+   CHK(emit_byte(tape, OP_LVAR_INC));
+   CHK(emit_byte(tape, lidx));
+   return patch_jump(tape, jump_addr);
+}
+
+/* i.first, as compiled */
+static int emit_first(Tape *tape, unsigned idx_lidx)
+{
+   CHK(emit_byte(tape, OP_PUSH_LIDX));
+   CHK(emit_byte(tape, idx_lidx));
+   CHK(emit_byte(tape, OP_PUSH_BYTE));
+   CHK(emit_byte(tape, 0));
+   return emit_byte(tape, OP_EQUAL);
+}
+
+/* i.last, as compiled */
+static int emit_last(Tape *tape, unsigned idx_lidx, unsigned max_gidx)
+{
+   CHK(emit_byte(tape, OP_PUSH_VMUINT));
+   CHK(emit_gidx(tape, max_gidx));
+   CHK(emit_byte(tape, OP_PUSH_LIDX));
+   CHK(emit_byte(tape, idx_lidx));
+   CHK(emit_byte(tape, OP_STACKTOP_INC));
+   return emit_byte(tape, OP_EQUAL);
+}
+
+static int assemble_loop(EmpVm *vm, unsigned join_idx, const IntArray * const *loopsets)
+{
+   Tape tape_ = {.code = &vm->code, .linenr = 0};
+   Tape *tape = &tape_;
+   VmSetJoin *join = &vm->data.setjoins.arr[join_idx];
+   unsigned jump_end = UINT_MAX;
+
+   join->idx_lidx[0] = LVAR_IDX_I;
+   join->iter_lidx[0] = LVAR_ELT_I;
+   join->idx_lidx[1] = LVAR_IDX_J;
+   join->iter_lidx[1] = LVAR_ELT_J;
+
+   CHK(rhp_uint_add(&vm->uints, join->nrecs));
+   unsigned nrecs_gidx = vm->uints.len-1;
+   CHK(rhp_uint_add(&vm->uints, loopsets[0]->len));
+   unsigned ilen_gidx = vm->uints.len-1;
+   CHK(rhp_uint_add(&vm->uints, loopsets[1]->len));
+   unsigned jlen_gidx = vm->uints.len-1;
+
+   for (unsigned lidx = LVAR_REC; lidx <= LVAR_COUNT; ++lidx) {
+      CHK(emit_byte(tape, OP_LVAR_COPYFROM_GIDX));
+      CHK(emit_byte(tape, lidx));
+      CHK(emit_gidx(tape, CstZeroUInt));
+   }
+
+   /* Skip the loop if no record is left */
+   if (join->nrecs == 0) {
+      CHK(emit_jump(tape, OP_JUMP, &jump_end));
+   }
+
+   unsigned loop_start = vm->code.len;
+
+   CHK(emit_byte(tape, OP_LOOPVARS_SETFROM_JOIN));
+   CHK(emit_byte(tape, LVAR_REC));
+   CHK(emit_gidx(tape, join_idx));
+
+   CHK(emit_first(tape, LVAR_IDX_I));
+   CHK(emit_count_if(tape, LVAR_I_FIRST));
+   CHK(emit_last(tape, LVAR_IDX_I, ilen_gidx));
+   CHK(emit_count_if(tape, LVAR_I_LAST));
+   CHK(emit_last(tape, LVAR_IDX_J, jlen_gidx));
+   CHK(emit_count_if(tape, LVAR_J_LAST));
+   CHK(emit_byte(tape, OP_LVAR_INC));
+   CHK(emit_byte(tape, LVAR_COUNT));
+
+   CHK(emit_byte(tape, OP_LOOP_NEXT_VMUINT));
+   CHK(emit_byte(tape, LVAR_REC));
+   CHK(emit_gidx(tape, nrecs_gidx));
+   CHK(_emit_jumpback_len(tape, loop_start));
+
+   if (jump_end != UINT_MAX) { CHK(patch_jump(tape, jump_end)); }
+
+   return emit_byte(tape, OP_END);
+}
+
+static int run_loop(Interpreter *interp, unsigned len, const int *tuples,
+                    const IntArray * const *loopsets, const uint8_t *loop2set,
+                    const unsigned expected[4])
+{
+   int status = OK;
+   EmpVm *vm = empvm_new(interp);
+   if (!vm) { return Error_InsufficientMemory; }
+
+   VmSetJoins *joins = &vm->data.setjoins;
+   MALLOC_EXIT(joins->arr, VmSetJoin, 1);
+   joins->max = 1;
+   S_CHECK_EXIT(vm_setjoin_build(&joins->arr[0], len, tuples, loopsets, loop2set, 2));
+   joins->len = 1;
+
+   S_CHECK_EXIT(assemble_loop(vm, 0, loopsets));
+   S_CHECK_EXIT(empvm_run(vm));
+
+   unsigned counts[] = {
+      AS_UINT(vm->locals[LVAR_COUNT]), AS_UINT(vm->locals[LVAR_I_FIRST]),
+      AS_UINT(vm->locals[LVAR_I_LAST]), AS_UINT(vm->locals[LVAR_J_LAST]),
+   };
+   const char *names[] = { "iterations", "i.first", "i.last", "j.last" };
+
+   for (unsigned n = 0; n < 4; ++n) {
+      if (counts[n] != expected[n]) {
+         (void)fprintf(stderr, "ERROR: %s is true %u times, expected %u\n", names[n],
+                       counts[n], expected[n]);
+         status = Error_RuntimeError;
+      }
+   }
+
+_exit:
+   empvm_free(vm);
+
+   return status;
+}
+
+static int test_loop(void)
+{
+   int status = OK;
+   int i_uels[] = { 10, 20, 30 }, j_uels[] = { 5, 6 };
+   IntArray i = {.len = 3, .max = 3, .arr = i_uels}, j = {.len = 2, .max = 2, .arr = j_uels};
+   const IntArray *loopsets[] = { &i, &j };
+   uint8_t loop2set[] = { 1, 0 };
+
+   /* The VM only needs the interpreter to report errors */
+   Interpreter *interp = calloc(1, sizeof(Interpreter));
+   if (!interp) { return Error_InsufficientMemory; }
+   interp->buf = "";
+
+   /* loop((i,j)$s(j,i), ...) over (10,5), (10,6), (20,6), (30,5) */
+   int s[] = { 5, 30,   6, 20,   6, 10,   5, 10 };
+   unsigned expected[] = { 4, 2, 1, 2 };
+   S_CHECK_EXIT(run_loop(interp, 4, s, loopsets, loop2set, expected));
+
+   /* No record in the loop sets: the body is never run */
+   int none[] = { 7, 10,   5, 40 };
+   unsigned expected_none[] = { 0, 0, 0, 0 };
+   S_CHECK_EXIT(run_loop(interp, 2, none, loopsets, loop2set, expected_none));
+
+_exit:
+   free(interp);
+
+   return status;
+}
+
+int main(void)
+{
+   int status = OK;
+
+   S_CHECK_EXIT(test_build());
+   S_CHECK_EXIT(test_loop());
+
+_exit:
+   return status == OK ? EXIT_SUCCESS : EXIT_FAILURE;
+}
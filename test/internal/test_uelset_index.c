@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "reshop.h"
+#include "status.h"
+#include "uelset_index.h"
+
+/* ---------------------------------------------------------------------------
+ * Membership index of UEL sets:
+ * - one-dimensional sets switch from a bitmap to a hash set when their UELs
+ *   span more than 64 times their cardinality
+ * - invalid UELs and dimensions are rejected
+ * - multi-dimensional tuples are matched exactly, duplicates are merged
+ * --------------------------------------------------------------------------- */
+
+static unsigned nerrs = 0;
+
+#define EXPECT(COND, ...) { if (!(COND)) { \
+   (void)fprintf(stderr, "ERROR line %d: %s: ", __LINE__, #COND); \
+   (void)fprintf(stderr, __VA_ARGS__); (void)fputc('\n', stderr); nerrs++; } }
+
+#define CHK(EXPR) { int rc_ = (EXPR); if (rc_ != OK) { \
+   (void)fprintf(stderr, "ERROR: %s failed with %s\n", #EXPR, rhp_status_descr(rc_)); \
+   return rc_; } }
+
+static void test_bitmap_hash_switch(void)
+{
+   UelSetIndex index;
+   uelset_index_init(&index, 1);
+
+   /* 2 UELs spanning 128 values: still a bitmap, range/64 <= len */
+   int dense[] = { 10, 137, 10 };
+   EXPECT(uelset_index_build(&index, 3, dense) == OK, "dense build");
+   EXPECT(index.bitmap && !index.slots, "bitmap expected");
+   EXPECT(index.len == 2, "len is %u", index.len);
+   EXPECT(uelset_index_has(&index, &dense[0]), "10 is in the set");
+   EXPECT(uelset_index_has(&index, &dense[1]), "137 is in the set");
+
+   int absent[] = { 9, 11, 138, 1, 100000, -5, 0 };
+   for (unsigned i = 0; i < sizeof(absent)/sizeof(absent[0]); ++i) {
+      EXPECT(!uelset_index_has(&index, &absent[i]), "%d is not in the set", absent[i]);
+   }
+
+   /* 2 UELs spanning 192 values: range/64 > len, hash set */
+   int sparse[] = { 10, 201 };
+   EXPECT(uelset_index_build(&index, 2, sparse) == OK, "sparse build");
+   EXPECT(!index.bitmap && index.slots, "hash set expected");
+   EXPECT(index.len == 2, "len is %u", index.len);
+   EXPECT(uelset_index_has(&index, &sparse[0]), "10 is in the set");
+   EXPECT(uelset_index_has(&index, &sparse[1]), "201 is in the set");
+   for (unsigned i = 0; i < sizeof(absent)/sizeof(absent[0]); ++i) {
+      EXPECT(!uelset_index_has(&index, &absent[i]), "%d is not in the set", absent[i]);
+   }
+
+   /* Empty set */
+   EXPECT(uelset_index_build(&index, 0, sparse) == OK, "empty build");
+   EXPECT(!index.bitmap && !index.slots && index.len == 0, "empty index expected");
+   EXPECT(!uelset_index_has(&index, &sparse[0]), "10 is not in the empty set");
+
+   uelset_index_free(&index);
+}
+
+static void test_invalid(void)
+{
+   UelSetIndex index;
+
+   uelset_index_init(&index, 0);
+   int uels[] = { 1, 2 };
+   EXPECT(uelset_index_build(&index, 2, uels) == Error_InvalidValue, "dimension 0");
+
+   uelset_index_init(&index, 1);
+   int zero[] = { 3, 0, 4 };
+   EXPECT(uelset_index_build(&index, 3, zero) == Error_InvalidValue, "UEL 0");
+   EXPECT(!index.bitmap && !index.slots, "no index after a failure");
+
+   uelset_index_init(&index, 2);
+   int negative[] = { 3, 4, 5, -1 };
+   EXPECT(uelset_index_build(&index, 2, negative) == Error_InvalidValue, "negative UEL");
+   EXPECT(!index.bitmap && !index.slots, "no index after a failure");
+
+   uelset_index_free(&index);
+}
+
+static int test_multidim(void)
+{
+   UelSetIndex index;
+
+   /* 2D, with a duplicate: the tuples are ordered, (2,1) is not (1,2) */
+   uelset_index_init(&index, 2);
+   int pairs[] = { 1, 2,   2, 3,   1, 2,   5, 1 };
+   CHK(uelset_index_build(&index, 4, pairs));
+   EXPECT(!index.bitmap && index.slots, "hash set expected");
+   EXPECT(index.len == 3, "len is %u", index.len);
+
+   int in2[][2] = { {1, 2}, {2, 3}, {5, 1} };
+   int out2[][2] = { {2, 1}, {3, 2}, {1, 5}, {1, 3}, {5, 2} };
+   for (unsigned i = 0; i < 3; ++i) {
+      EXPECT(uelset_index_has(&index, in2[i]), "(%d,%d) is in the set", in2[i][0], in2[i][1]);
+   }
+   for (unsigned i = 0; i < 5; ++i) {
+      EXPECT(!uelset_index_has(&index, out2[i]), "(%d,%d) is not in the set",
+             out2[i][0], out2[i][1]);
+   }
+   uelset_index_free(&index);
+
+   /* 3D, large enough to have collisions in the probing */
+   enum { N = 20, NTUPLES = N*N*N/2 };
+   uelset_index_init(&index, 3);
+   int *triples = malloc(sizeof(int) * 3 * NTUPLES);
+   if (!triples) { return Error_InsufficientMemory; }
+
+   unsigned len = 0;
+   for (int i = 1; i <= N; ++i) {
+      for (int j = 1; j <= N; ++j) {
+         for (int k = 1; k <= N; ++k) {
+            if ((i + j + k) % 2) { continue; }
+            triples[3*len] = i; triples[3*len+1] = j; triples[3*len+2] = k;
+            len++;
+         }
+      }
+   }
+
+   int status = uelset_index_build(&index, len, triples);
+   free(triples);
+   CHK(status);
+   EXPECT(index.len == len, "len is %u, expected %u", index.len, len);
+
+   unsigned nfound = 0;
+   for (int i = 1; i <= N+1; ++i) {
+      for (int j = 1; j <= N+1; ++j) {
+         for (int k = 1; k <= N+1; ++k) {
+            int t[3] = { i, j, k };
+            bool expected = i <= N && j <= N && k <= N && (i + j + k) % 2 == 0;
+            bool has = uelset_index_has(&index, t);
+            EXPECT(has == expected, "(%d,%d,%d)", i, j, k);
+            nfound += has;
+         }
+      }
+   }
+   EXPECT(nfound == len, "found %u tuples, expected %u", nfound, len);
+
+   uelset_index_free(&index);
+
+   return OK;
+}
+
+int main(void)
+{
+   test_bitmap_hash_switch();
+   test_invalid();
+
+   int status = test_multidim();
+
+   if (status != OK || nerrs > 0) {
+      (void)fprintf(stderr, "%u error(s)\n", nerrs);
+      return EXIT_FAILURE;
+   }
+
+   return EXIT_SUCCESS;
+}
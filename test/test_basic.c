@@ -933,6 +933,98 @@ _exit:
   return status;
 }
 
+/* Cournot duopoly: player i solves max x_i (a - x_1 - x_2) - c x_i, x_i >= 0 */
+static int nash_cournot(struct rhp_mdl *mdl, struct rhp_mdl *mdl_solver)
+{
+#undef N_PLAYERS
+#define N_PLAYERS 2
+
+  int status = 0;
+  const double a = 10., c = 1.;
+
+  struct rhp_avar *v = rhp_avar_new();
+  struct rhp_nash_equilibrium *nash = rhp_empdag_newnash(mdl);
+
+  RESHOP_CHECK(rhp_mdl_resize(mdl, N_PLAYERS, N_PLAYERS));
+
+  RESHOP_CHECK(rhp_empdag_rootsetnash(mdl, nash));
+
+  RESHOP_CHECK(rhp_add_posvars(mdl, N_PLAYERS, v));
+
+  unsigned row[N_PLAYERS];
+  unsigned col[N_PLAYERS];
+  double ones[N_PLAYERS];
+  double xvals[N_PLAYERS];
+  double objvals[N_PLAYERS];
+
+  for (size_t i = 0; i < N_PLAYERS; ++i) {
+    rhp_avar_get(v, i, (rhp_idx*)&col[i]);
+    ones[i] = 1.;
+    xvals[i] = (a - c)/(N_PLAYERS+1.);
+    objvals[i] = xvals[i] * (a - c - N_PLAYERS*xvals[i]);
+  }
+
+  for (size_t i = 0; i < N_PLAYERS; ++i) {
+
+    rhp_idx var;
+    rhp_avar_get(v, i, &var);
+
+    for (size_t j = 0; j < N_PLAYERS; ++j) {
+      row[j] = var;
+    }
+
+    struct rhp_mathprgm *mp = rhp_empdag_newmp(mdl, RHP_MAX);
+    RESHOP_CHECK(rhp_mp_addvar(mp, var));
+
+    rhp_idx objequ;
+    RESHOP_CHECK(rhp_add_func(mdl, &objequ));
+
+    RESHOP_CHECK(rhp_equ_addquadabsolute(mdl, objequ, N_PLAYERS, row, col, ones, -1.));
+    RESHOP_CHECK(rhp_equ_addlvar(mdl, objequ, var, a - c));
+
+    RESHOP_CHECK(rhp_mp_setobjequ(mp, objequ));
+
+    RESHOP_CHECK(rhp_empdag_nashaddmp(mdl, nash, mp));
+  }
+
+  struct sol_vals solvals;
+  sol_vals_init(&solvals);
+  solvals.xvals = xvals;
+  solvals.objvals = objvals;
+  status = test_solve(mdl, mdl_solver, &solvals);
+
+_exit:
+  rhp_avar_free(v);
+
+  return status;
+}
+
+int nash_cournot_jacobi(struct rhp_mdl *mdl, struct rhp_mdl *mdl_solver)
+{
+  int status = 0;
+
+  RESHOP_CHECK(rhp_opt_setc("nash_solver", "jacobi"));
+  int rc = nash_cournot(mdl, mdl_solver);
+  RESHOP_CHECK(rhp_opt_setc("nash_solver", "mcp"));
+  status = rc;
+
+_exit:
+  return status;
+}
+
+int nash_cournot_gauss_seidel(struct rhp_mdl *mdl, struct rhp_mdl *mdl_solver)
+{
+  int status = 0;
+
+  RESHOP_CHECK(rhp_opt_setc("nash_solver", "gauss_seidel"));
+  int rc = nash_cournot(mdl, mdl_solver);
+  RESHOP_CHECK(rhp_opt_setc("nash_solver", "mcp"));
+  status = rc;
+
+_exit:
+  return status;
+}
+
 int mopec(struct rhp_mdl *mdl, struct rhp_mdl *mdl_solver)
 {
   int status = 0;
@@ -29,6 +29,8 @@ struct rhp_mdl;
 
 #define ALL_EMP_MODELS() \
     SOLVE(gnep_tragedy_common); \
+    SOLVE(nash_cournot_jacobi); \
+    SOLVE(nash_cournot_gauss_seidel); \
     SOLVE(mopec)
 
 
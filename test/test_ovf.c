@@ -42,8 +42,27 @@ static double* gen_gaussrand(unsigned n)
     return values;
 }
 
-int linear_quantile_regression(struct rhp_mdl *mdl, struct rhp_mdl *mdl_solver,
-                               const char *formulation, unsigned s, const double xsols[3])
+/* Solve the model a first time, with the warm-start active */
+static int solve_warmstart(struct rhp_mdl *mdl)
+{
+   int status = 0;
+   struct rhp_mdl *mdl_solver = rhp_mdl_new(RhpBackendReSHOP);
+   if (!mdl_solver) { return 1; }
+
+   RESHOP_CHECK(rhp_mdl_setwarmstart(mdl, true));
+   RESHOP_CHECK(rhp_process(mdl, mdl_solver));
+   RESHOP_CHECK(rhp_solve(mdl_solver));
+   RESHOP_CHECK(rhp_postprocess(mdl_solver));
+
+_exit:
+   rhp_mdl_free(mdl_solver);
+
+   return status;
+}
+
+static int linear_quantile_regression_(struct rhp_mdl *mdl, struct rhp_mdl *mdl_solver,
+                                       const char *formulation, unsigned s,
+                                       const double xsols[3], bool resolve)
 {
    int status = 0;
    double alpha = .5, *normals = NULL, *eta = NULL, *xsi = NULL;
@@ -104,6 +123,11 @@ int linear_quantile_regression(struct rhp_mdl *mdl, struct rhp_mdl *mdl_solver,
    RESHOP_CHECK(rhp_ovf_setreformulation(ovf_def, formulation));
    RESHOP_CHECK(rhp_ovf_check(mdl, ovf_def));
 
+   /* The second solve starts from the values of the first one */
+   if (resolve) {
+      RESHOP_CHECK(solve_warmstart(mdl));
+   }
+
    struct sol_vals solvals;
    sol_vals_init(&solvals);
 
@@ -132,6 +156,12 @@ _exit:
    return status;
 }
 
+int linear_quantile_regression(struct rhp_mdl *mdl, struct rhp_mdl *mdl_solver,
+                               const char *formulation, unsigned s, const double xsols[3])
+{
+   return linear_quantile_regression_(mdl, mdl_solver, formulation, s, xsols, false);
+}
+
 #ifdef __linux__
 
 const double xsols10000[] = { 5.397905e-01, 9.712997e-01, 4.058599543e+03 };
@@ -200,4 +230,15 @@ int test_s_linear_quantile_regression_fenchel(struct rhp_mdl *mdl, struct rhp_md
    return linear_quantile_regression(mdl, mdl_solver, "fenchel", s, xsols10);
 }
 
+int test_s_linear_quantile_regression_fenchel_resolve(struct rhp_mdl *mdl, struct rhp_mdl *mdl_solver)
+{
+   /* The first solve is done with PATH */
+   if (rhp_mdl_getbackend(mdl_solver) != RhpBackendReSHOP) {
+      rhp_mdl_free(mdl);
+      return 0;
+   }
+   unsigned s = 10;
+   return linear_quantile_regression_(mdl, mdl_solver, "fenchel", s, xsols10, true);
+}
+
 
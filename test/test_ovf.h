@@ -10,13 +10,15 @@ int linear_quantile_regression(struct rhp_mdl *mdl, struct rhp_mdl *mdl_solver,
 #define ALL_LP_MODELS() \
     SOLVE(test_linear_quantile_regression_fenchel); \
     SOLVE(test_s_linear_quantile_regression_fenchel); \
+    SOLVE(test_s_linear_quantile_regression_fenchel_resolve); \
     SOLVE(test_s_linear_quantile_regression_conjugate);
 
 #else
 
 #define ALL_LP_MODELS() \
     SOLVE(test_linear_quantile_regression_fenchel); \
-    SOLVE(test_s_linear_quantile_regression_fenchel);
+    SOLVE(test_s_linear_quantile_regression_fenchel); \
+    SOLVE(test_s_linear_quantile_regression_fenchel_resolve);
 
 #endif
 